@@ -29,6 +29,7 @@ LOCAL_SRC_FILES += \
 
 # AROMA LIBRARIES SOURCE FILES
 LOCAL_SRC_FILES += \
+    src/libs/aroma_arena.c \
     src/libs/aroma_array.c \
     src/libs/aroma_freetype.c \
     src/libs/aroma_graph.c \
@@ -36,7 +37,13 @@ LOCAL_SRC_FILES += \
     src/libs/aroma_languages.c \
     src/libs/aroma_libs.c \
     src/libs/aroma_memory.c \
+    src/libs/aroma_mount.c \
     src/libs/aroma_png.c \
+    src/libs/aroma_prefetch.c \
+    src/libs/aroma_prop.c \
+    src/libs/aroma_replay.c \
+    src/libs/aroma_task.c \
+    src/libs/aroma_trace.c \
     src/libs/aroma_zip.c
 
 # AROMA FRAMEBUFFER SOURCE FILES
@@ -45,6 +52,7 @@ LOCAL_SRC_FILES += \
     src/libs/fb/aroma_fbdev.c \
     src/libs/fb/aroma_drm.c \
     src/libs/fb/aroma_engine.c \
+    src/libs/fb/aroma_memfb.c \
     src/libs/fb/aroma_overlay.c
 
 # AROMA INSTALLER SOURCE FILES
@@ -54,6 +62,7 @@ LOCAL_SRC_FILES += \
     src/main/aroma.c
 
 # MODULE SETTINGS
+AROMA_INSTALLER_SRC_FILES := $(LOCAL_SRC_FILES)
 LOCAL_MODULE := aroma_installer
 LOCAL_MODULE_PATH := $(PRODUCT_OUT)
 LOCAL_MODULE_TAGS := eng
@@ -86,6 +95,9 @@ LOCAL_CFLAGS += -Wl,--gc-sections -fPIC -DPIC
 LOCAL_CFLAGS += -D_AROMA_NODEBUG
 #LOCAL_CFLAGS += -D_AROMA_VERBOSE_INFO
 
+# XRGB8888 canvas, for 32bpp panels (twice the canvas memory)
+#LOCAL_CFLAGS += -D_AROMA_CANVAS32
+
 # SET VERSION
 LOCAL_CFLAGS += -DAROMA_NAME="\"$(AROMA_NAME)\""
 LOCAL_CFLAGS += -DAROMA_VERSION="\"$(AROMA_VERSION)\""
@@ -109,16 +121,97 @@ include $(AROMA_INSTALLER_LOCALPATH)/libs/freetype/Android.mk
 # edify
 include $(AROMA_INSTALLER_LOCALPATH)/libs/edify/Android.mk
 
+# HOST BENCHMARK (opt-in: make AROMA_HOST_BENCH=true aroma_bench)
+# Runs on the headless memory framebuffer, needs host libpng, libz
+# and libminzip variants
+ifeq ($(AROMA_HOST_BENCH),true)
+include $(CLEAR_VARS)
+LOCAL_PATH := $(AROMA_INSTALLER_LOCALPATH)
+LOCAL_SRC_FILES := \
+    libs/minutf8/minutf8.c \
+    $(filter src/controls/% src/libs/aroma_%,$(AROMA_INSTALLER_SRC_FILES)) \
+    src/libs/fb/aroma_fb.c \
+    src/libs/fb/aroma_engine.c \
+    src/libs/fb/aroma_memfb.c \
+    src/main/aroma_bench.c
+LOCAL_MODULE := aroma_bench
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := \
+    $(AROMA_INSTALLER_LOCALPATH)/libs/minutf8 \
+    $(AROMA_INSTALLER_LOCALPATH)/src/libs/fb \
+    $(AROMA_INSTALLER_LOCALPATH)/src \
+    external/freetype/include \
+    external/png \
+    bootable/recovery
+LOCAL_CFLAGS := -O2 -D_AROMA_NODEBUG -D_AROMA_HOST
+LOCAL_CFLAGS += -DAROMA_NAME="\"$(AROMA_NAME)\""
+LOCAL_CFLAGS += -DAROMA_VERSION="\"$(AROMA_VERSION)\""
+LOCAL_CFLAGS += -DAROMA_BUILD="\"$(AROMA_BUILD)\""
+LOCAL_CFLAGS += -DAROMA_BUILD_CN="\"$(AROMA_CN)\""
+LOCAL_STATIC_LIBRARIES := libpng libminzip libft2_aroma_host libz
+LOCAL_LDLIBS := -lm -lpthread
+include $(BUILD_HOST_EXECUTABLE)
+
+# HOST REPLAY (opt-in: make AROMA_HOST_BENCH=true aroma_host)
+# Full installer on the headless framebuffer, driven by a replay script:
+#   AROMA_REPLAY=script.txt aroma_host 3 1 update.zip
+# AROMA_TRACE=trace.json also writes the Chrome trace on exit.
+include $(CLEAR_VARS)
+LOCAL_PATH := $(AROMA_INSTALLER_LOCALPATH)
+LOCAL_SRC_FILES := \
+    libs/minutf8/minutf8.c \
+    $(filter src/controls/% src/libs/aroma_% src/main/%,$(AROMA_INSTALLER_SRC_FILES)) \
+    src/libs/fb/aroma_fb.c \
+    src/libs/fb/aroma_engine.c \
+    src/libs/fb/aroma_memfb.c
+LOCAL_MODULE := aroma_host
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := \
+    $(AROMA_INSTALLER_LOCALPATH)/libs \
+    $(AROMA_INSTALLER_LOCALPATH)/libs/minutf8 \
+    $(AROMA_INSTALLER_LOCALPATH)/src/libs/fb \
+    $(AROMA_INSTALLER_LOCALPATH)/src \
+    external/freetype/include \
+    external/png \
+    bootable/recovery
+LOCAL_CFLAGS := -O2 -funsigned-char -D_AROMA_NODEBUG -D_AROMA_HOST
+LOCAL_CFLAGS += -DAROMA_NAME="\"$(AROMA_NAME)\""
+LOCAL_CFLAGS += -DAROMA_VERSION="\"$(AROMA_VERSION)\""
+LOCAL_CFLAGS += -DAROMA_BUILD="\"$(AROMA_BUILD)\""
+LOCAL_CFLAGS += -DAROMA_BUILD_CN="\"$(AROMA_CN)\""
+LOCAL_STATIC_LIBRARIES := libedify_aroma_host libpng libminzip libft2_aroma_host libz
+LOCAL_LDLIBS := -lm -lpthread
+include $(BUILD_HOST_EXECUTABLE)
+endif
+
+# HOST SCRIPT COMPILER
+# Precompiles aroma-config and *.edify into .bin trees for the zip,
+# stored uncompressed so the installer uses them straight from the package
+include $(CLEAR_VARS)
+LOCAL_PATH := $(AROMA_INSTALLER_LOCALPATH)
+LOCAL_SRC_FILES := src/main/aroma_compile.c
+LOCAL_MODULE := aroma_compile
+LOCAL_MODULE_TAGS := optional
+LOCAL_C_INCLUDES := $(AROMA_INSTALLER_LOCALPATH)/libs
+LOCAL_CFLAGS := -O2 -funsigned-char
+LOCAL_STATIC_LIBRARIES := libedify_aroma_host libz
+include $(BUILD_HOST_EXECUTABLE)
+
 include $(CLEAR_VARS)
 
 AROMA_ZIP_TARGET := $(PRODUCT_OUT)/aroma.zip
-$(AROMA_ZIP_TARGET):
+AROMA_COMPILE := $(HOST_OUT_EXECUTABLES)/aroma_compile
+AROMA_ZIP_SCRIPTS := META-INF/com/google/android/aroma-config
+AROMA_ZIP_SCRIPTS += $(patsubst $(AROMA_INSTALLER_LOCALPATH)/assets/%,%,\
+    $(shell find $(AROMA_INSTALLER_LOCALPATH)/assets/META-INF/com/google/android/aroma -name '*.edify'))
+$(AROMA_ZIP_TARGET): $(AROMA_COMPILE)
 	@echo "----- Making aroma zip installer ------"
 	$(hide) rm -rf $(PRODUCT_OUT)/assets
 	$(hide) rm -rf $(PRODUCT_OUT)/aroma.zip
 	$(hide) cp -R $(AROMA_INSTALLER_LOCALPATH)/assets/ $(PRODUCT_OUT)/assets/
 	$(hide) cp $(PRODUCT_OUT)/aroma_installer $(PRODUCT_OUT)/assets/META-INF/com/google/android/update-binary
-	$(hide) pushd $(PRODUCT_OUT)/assets/ && zip -r9 ../aroma.zip . && popd
+	$(hide) $(foreach f,$(AROMA_ZIP_SCRIPTS),$(AROMA_COMPILE) $(PRODUCT_OUT)/assets/$(f) &&) true
+	$(hide) pushd $(PRODUCT_OUT)/assets/ && zip -r9 ../aroma.zip . -x '*.bin' && zip -r0 ../aroma.zip . -i '*.bin' && popd
 	@echo "Made flashable aroma.zip: $@"
 
 .PHONY: aroma_installer_zip
@@ -3,6 +3,7 @@
 LOCAL_PATH := $(call my-dir)
 
 edify_src_files += \
+    bytecode.c \
     expr.c \
     lex.yy.c \
     parser.c
@@ -24,3 +25,13 @@ LOCAL_CFLAGS += -Wno-unused-parameter -Wno-unneeded-internal-declaration -Wno-un
 LOCAL_MODULE := libedify_aroma
 
 include $(BUILD_STATIC_LIBRARY)
+
+# host variant for aroma_compile and the aroma_host replay build
+include $(CLEAR_VARS)
+
+LOCAL_SRC_FILES := $(edify_src_files)
+
+LOCAL_CFLAGS := $(edify_cflags) -funsigned-char
+LOCAL_MODULE := libedify_aroma_host
+
+include $(BUILD_HOST_STATIC_LIBRARY)
@@ -0,0 +1,405 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "expr.h"
+#include "bytecode.h"
+
+// Operator functions, indexed by EXPR_OP_*
+static const Function expr_ops[] = {
+  Literal,
+  SequenceFn,
+  ConcatFn,
+  EqualityFn,
+  InequalityFn,
+  LogicalAndFn,
+  LogicalOrFn,
+  LogicalNotFn,
+  IfElseFn
+};
+#define EXPR_OPS_COUNT (sizeof(expr_ops) / sizeof(expr_ops[0]))
+
+static char blob_error[256] = "";
+
+const char * ExprBlobError() {
+  return blob_error;
+}
+
+static unsigned int BlobGet32(const unsigned char * p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static void BlobPut32(unsigned char * p, unsigned int v) {
+  p[0] = v;
+  p[1] = v >> 8;
+  p[2] = v >> 16;
+  p[3] = v >> 24;
+}
+
+// -----------------------------------------------------------------
+//   writer
+// -----------------------------------------------------------------
+
+typedef struct {
+  unsigned char * data;
+  size_t len;
+  size_t cap;
+} BlobBuf;
+
+typedef struct {
+  BlobBuf nodes;
+  BlobBuf args;
+  BlobBuf syms;
+  BlobBuf strings;
+  
+  // Interned strings, open addressing on string table offset + 1
+  unsigned int * hash;
+  unsigned int hash_size;
+  unsigned int hash_count;
+  int failed;
+} BlobWriter;
+
+// Reserve len bytes at the end of buf, return their offset.
+static size_t BlobReserve(BlobWriter * w, BlobBuf * buf, size_t len) {
+  size_t off = buf->len;
+  
+  if (buf->len + len > buf->cap) {
+    size_t cap = buf->cap ? buf->cap * 2 : 1024;
+    
+    while (cap < buf->len + len) {
+      cap *= 2;
+    }
+    
+    unsigned char * data = realloc(buf->data, cap);
+    
+    if (data == NULL) {
+      w->failed = 1;
+      return 0;
+    }
+    
+    buf->data = data;
+    buf->cap = cap;
+  }
+  
+  buf->len += len;
+  return off;
+}
+
+static unsigned int BlobStrHash(const char * s) {
+  unsigned int h = 2166136261u;
+  
+  while (*s) {
+    h ^= (unsigned char) * s++;
+    h *= 16777619u;
+  }
+  
+  return h;
+}
+
+static void BlobRehash(BlobWriter * w) {
+  unsigned int size = w->hash_size ? w->hash_size * 2 : 256;
+  unsigned int * hash = calloc(size, sizeof(unsigned int));
+  unsigned int i;
+  
+  if (hash == NULL) {
+    w->failed = 1;
+    return;
+  }
+  
+  for (i = 0; i < w->hash_size; i++) {
+    if (w->hash[i]) {
+      const char * s = (const char *) w->strings.data + w->hash[i] - 1;
+      unsigned int h = BlobStrHash(s) & (size - 1);
+      
+      while (hash[h]) {
+        h = (h + 1) & (size - 1);
+      }
+      
+      hash[h] = w->hash[i];
+    }
+  }
+  
+  free(w->hash);
+  w->hash = hash;
+  w->hash_size = size;
+}
+
+// Offset of s in the string table, added once.
+static unsigned int BlobString(BlobWriter * w, const char * s) {
+  if ((w->hash_count + 1) * 2 > w->hash_size) {
+    BlobRehash(w);
+    
+    if (w->failed) {
+      return 0;
+    }
+  }
+  
+  unsigned int h = BlobStrHash(s) & (w->hash_size - 1);
+  
+  while (w->hash[h]) {
+    if (strcmp((const char *) w->strings.data + w->hash[h] - 1, s) == 0) {
+      return w->hash[h] - 1;
+    }
+    
+    h = (h + 1) & (w->hash_size - 1);
+  }
+  
+  size_t len = strlen(s) + 1;
+  size_t off = BlobReserve(w, &w->strings, len);
+  
+  if (w->failed) {
+    return 0;
+  }
+  
+  memcpy(w->strings.data + off, s, len);
+  w->hash[h] = off + 1;
+  w->hash_count++;
+  return off;
+}
+
+// Index of the function name in the symbol table, added once.
+static unsigned int BlobSymbol(BlobWriter * w, const char * name) {
+  unsigned int str = BlobString(w, name);
+  size_t i;
+  
+  for (i = 0; i < w->syms.len; i += 4) {
+    if (BlobGet32(w->syms.data + i) == str) {
+      return i / 4;
+    }
+  }
+  
+  size_t off = BlobReserve(w, &w->syms, 4);
+  
+  if (w->failed) {
+    return 0;
+  }
+  
+  BlobPut32(w->syms.data + off, str);
+  return off / 4;
+}
+
+// Append e and its children in preorder, return the node index.
+static unsigned int BlobNode(BlobWriter * w, Expr * e) {
+  unsigned int op = EXPR_OP_CALL;
+  unsigned int i;
+  
+  for (i = 0; i < EXPR_OPS_COUNT; i++) {
+    if (e->fn == expr_ops[i]) {
+      op = i;
+      break;
+    }
+  }
+  
+  if (op == EXPR_OP_CALL) {
+    op += BlobSymbol(w, e->name);
+  }
+  
+  unsigned int name = BlobString(w, e->name);
+  size_t node = BlobReserve(w, &w->nodes, EXPR_BLOB_NODE);
+  size_t argv = BlobReserve(w, &w->args, e->argc * 4);
+  
+  if (w->failed) {
+    return 0;
+  }
+  
+  unsigned char * p = w->nodes.data + node;
+  BlobPut32(p, name);
+  BlobPut32(p + 4, op);
+  BlobPut32(p + 8, e->argc);
+  BlobPut32(p + 12, argv / 4);
+  BlobPut32(p + 16, e->start);
+  BlobPut32(p + 20, e->end);
+  
+  for (i = 0; i < (unsigned int) e->argc; i++) {
+    unsigned int child = BlobNode(w, e->argv[i]);
+    
+    if (w->failed) {
+      return 0;
+    }
+    
+    BlobPut32(w->args.data + argv + i * 4, child);
+  }
+  
+  return node / EXPR_BLOB_NODE;
+}
+
+char * SaveExprBlob(Expr * root, unsigned int source_crc, size_t * size) {
+  BlobWriter w;
+  memset(&w, 0, sizeof(w));
+  BlobNode(&w, root);
+  char * out = NULL;
+  
+  if (!w.failed) {
+    *size = EXPR_BLOB_HEAD + w.nodes.len + w.args.len + w.syms.len + w.strings.len;
+    out = malloc(*size);
+  }
+  
+  if (out != NULL) {
+    unsigned char * p = (unsigned char *) out;
+    memcpy(p, EXPR_BLOB_MAGIC, 4);
+    BlobPut32(p + 4, source_crc);
+    BlobPut32(p + 8, w.nodes.len / EXPR_BLOB_NODE);
+    BlobPut32(p + 12, w.args.len / 4);
+    BlobPut32(p + 16, w.syms.len / 4);
+    BlobPut32(p + 20, w.strings.len);
+    p += EXPR_BLOB_HEAD;
+    memcpy(p, w.nodes.data, w.nodes.len);
+    p += w.nodes.len;
+    memcpy(p, w.args.data, w.args.len);
+    p += w.args.len;
+    memcpy(p, w.syms.data, w.syms.len);
+    p += w.syms.len;
+    memcpy(p, w.strings.data, w.strings.len);
+  }
+  
+  free(w.nodes.data);
+  free(w.args.data);
+  free(w.syms.data);
+  free(w.strings.data);
+  free(w.hash);
+  return out;
+}
+
+// -----------------------------------------------------------------
+//   loader
+// -----------------------------------------------------------------
+
+static Expr * BlobFail(Function * fns, Expr * nodes, const char * msg) {
+  snprintf(blob_error, sizeof(blob_error), "%s", msg);
+  free(fns);
+  free(nodes);
+  return NULL;
+}
+
+Expr * LoadExprBlob(const char * data, size_t size,
+                    const unsigned int * source_crc) {
+  const unsigned char * p = (const unsigned char *) data;
+  
+  if ((size < EXPR_BLOB_HEAD) || (memcmp(p, EXPR_BLOB_MAGIC, 4) != 0)) {
+    return BlobFail(NULL, NULL, "not a compiled script");
+  }
+  
+  if ((source_crc != NULL) && (*source_crc != BlobGet32(p + 4))) {
+    return BlobFail(NULL, NULL, "compiled from a different source");
+  }
+  
+  size_t nodes = BlobGet32(p + 8);
+  size_t args = BlobGet32(p + 12);
+  size_t syms = BlobGet32(p + 16);
+  size_t strsize = BlobGet32(p + 20);
+  
+  //-- Each count is bounded by size first, so the sum cannot overflow
+  if ((nodes == 0) || (nodes > size / EXPR_BLOB_NODE) ||
+      (args > size / 4) || (syms > size / 4) || (strsize > size) ||
+      (EXPR_BLOB_HEAD + nodes * EXPR_BLOB_NODE + (args + syms) * 4 + strsize != size)) {
+    return BlobFail(NULL, NULL, "bad section sizes");
+  }
+  
+  const unsigned char * node_tab = p + EXPR_BLOB_HEAD;
+  const unsigned char * arg_tab = node_tab + nodes * EXPR_BLOB_NODE;
+  const unsigned char * sym_tab = arg_tab + args * 4;
+  const char * strings = (const char *) (sym_tab + syms * 4);
+  
+  if ((strsize == 0) || (strings[strsize - 1] != '\0')) {
+    return BlobFail(NULL, NULL, "bad string table");
+  }
+  
+  //-- Resolve each distinct function once
+  Function * fns = malloc((syms ? syms : 1) * sizeof(Function));
+  size_t i, k;
+  
+  if (fns == NULL) {
+    return BlobFail(NULL, NULL, "out of memory");
+  }
+  
+  for (i = 0; i < syms; i++) {
+    size_t off = BlobGet32(sym_tab + i * 4);
+    
+    if (off >= strsize) {
+      return BlobFail(fns, NULL, "bad symbol");
+    }
+    
+    fns[i] = FindFunction(strings + off);
+    
+    if (fns[i] == NULL) {
+      snprintf(blob_error, sizeof(blob_error), "unknown function \"%s\"", strings + off);
+      free(fns);
+      return NULL;
+    }
+  }
+  
+  //-- Nodes and argv arrays in one block
+  Expr * e = calloc(1, nodes * sizeof(Expr) + args * sizeof(Expr *));
+  
+  if (e == NULL) {
+    return BlobFail(fns, NULL, "out of memory");
+  }
+  
+  Expr ** slots = (Expr **) (e + nodes);
+  
+  for (i = 0; i < nodes; i++) {
+    const unsigned char * n = node_tab + i * EXPR_BLOB_NODE;
+    size_t name = BlobGet32(n);
+    size_t op = BlobGet32(n + 4);
+    size_t argc = BlobGet32(n + 8);
+    size_t argv = BlobGet32(n + 12);
+    
+    if ((name >= strsize) || (argc > args) || (argv > args - argc)) {
+      return BlobFail(fns, e, "bad node");
+    }
+    
+    if (op >= EXPR_OP_CALL) {
+      if (op - EXPR_OP_CALL >= syms) {
+        return BlobFail(fns, e, "bad node");
+      }
+      
+      e[i].fn = fns[op - EXPR_OP_CALL];
+    }
+    else if (op < EXPR_OPS_COUNT) {
+      e[i].fn = expr_ops[op];
+    }
+    else {
+      return BlobFail(fns, e, "bad node");
+    }
+    
+    //-- Children after their parent keeps the tree acyclic
+    for (k = argv; k < argv + argc; k++) {
+      size_t child = BlobGet32(arg_tab + k * 4);
+      
+      if ((child <= i) || (child >= nodes)) {
+        return BlobFail(fns, e, "bad node");
+      }
+      
+      slots[k] = e + child;
+    }
+    
+    e[i].name = (char *) strings + name;
+    e[i].argc = argc;
+    e[i].argv = argc ? slots + argv : NULL;
+    e[i].start = BlobGet32(n + 16);
+    e[i].end = BlobGet32(n + 20);
+  }
+  
+  free(fns);
+  return e;
+}
+
+void FreeExprBlob(Expr * root) {
+  free(root);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _BYTECODE_H
+#define _BYTECODE_H
+
+#include <stddef.h>
+#include "expr.h"
+
+// Precompiled script blob.  Position independent, every field is a
+// little-endian 32-bit word, offsets and indices are relative to the
+// blob so it can be used straight from a zip mapping:
+//
+//   header   magic "AEB1", source crc32, nodes, args, syms, strsize
+//   nodes    name, op, argc, argv, start, end    (6 words each)
+//   args     child node index                    (1 word each)
+//   syms     function name                       (1 word each)
+//   strings  NULL-terminated, interned
+//
+// Node 0 is the root.  Children always have a higher index than their
+// parent.  op is one of the EXPR_OP_* operators, or EXPR_OP_CALL + n
+// for a call of function syms[n].
+
+#define EXPR_BLOB_MAGIC   "AEB1"
+#define EXPR_BLOB_HEAD    24
+#define EXPR_BLOB_NODE    24
+
+#define EXPR_OP_LITERAL   0
+#define EXPR_OP_SEQUENCE  1
+#define EXPR_OP_CONCAT    2
+#define EXPR_OP_EQ        3
+#define EXPR_OP_NE        4
+#define EXPR_OP_AND       5
+#define EXPR_OP_OR        6
+#define EXPR_OP_NOT       7
+#define EXPR_OP_IFELSE    8
+#define EXPR_OP_CALL      16
+
+// Serialize a parsed tree.  source_crc is the crc32 of the script the
+// tree was parsed from.  Returns a malloc'd blob, or NULL on failure.
+char * SaveExprBlob(Expr * root, unsigned int source_crc, size_t * size);
+
+// Build an evaluable tree from a blob, resolving every function once
+// against the registered table.  All nodes share one allocation, names
+// point into the blob, which must stay valid while the tree is in use.
+// When source_crc is not NULL the blob must have been compiled from a
+// script with that crc32.  Returns NULL on a stale, corrupt or
+// unresolvable blob, see ExprBlobError().
+Expr * LoadExprBlob(const char * data, size_t size,
+                    const unsigned int * source_crc);
+
+// Free a tree returned by LoadExprBlob().
+void FreeExprBlob(Expr * root);
+
+// Reason of the last LoadExprBlob() failure.
+const char * ExprBlobError();
+
+#endif  // _BYTECODE_H
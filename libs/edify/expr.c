@@ -33,8 +33,9 @@ int BooleanString(const char * s) {
   return s[0] != '\0';
 }
 
-char * Evaluate(State * state, Expr * expr) {
-  Value * v = expr->fn(expr->name, state, expr->argc, expr->argv);
+// Evaluate expr, assert that it is a string.
+static Value * EvaluateString(State * state, Expr * expr) {
+  Value * v = EvaluateValue(state, expr);
   
   if (v == NULL) {
     return NULL;
@@ -46,15 +47,113 @@ char * Evaluate(State * state, Expr * expr) {
     return NULL;
   }
   
-  char * result = v->data;
-  free(v);
+  return v;
+}
+
+char * Evaluate(State * state, Expr * expr) {
+  Value * v = EvaluateString(state, expr);
+  
+  if (v == NULL) {
+    return NULL;
+  }
+  
+  // only copy when the data is shared or not ours
+  char * result;
+  
+  if (v->owned && v->refs == 1) {
+    result = v->data;
+    free(v);
+  }
+  else {
+    result = malloc(v->size + 1);
+    memcpy(result, v->data, v->size + 1);
+    FreeValue(v);
+  }
+  
   return result;
 }
 
 Value * EvaluateValue(State * state, Expr * expr) {
+  if (expr->fn == Literal && expr->value.data != NULL) {
+    return &expr->value;
+  }
+  
   return expr->fn(expr->name, state, expr->argc, expr->argv);
 }
 
+int EvaluateLong(State * state, Expr * expr, long * out) {
+  if (expr->flags & EXPR_NUM) {
+    *out = expr->num;
+    return 0;
+  }
+  
+  Value * v = EvaluateString(state, expr);
+  
+  if (v == NULL) {
+    return -1;
+  }
+  
+  *out = atol(v->data);
+  FreeValue(v);
+  return 0;
+}
+
+static int EqualityCompare(State * state, Expr * argv[], bool * equal);
+
+int EvaluateBool(State * state, Expr * expr) {
+  int b;
+  bool equal;
+  
+  if (expr->fn == Literal) {
+    return BooleanString(expr->name);
+  }
+  else if (expr->fn == LogicalNotFn) {
+    b = EvaluateBool(state, expr->argv[0]);
+    return b < 0 ? b : !b;
+  }
+  else if (expr->fn == LogicalAndFn || expr->fn == LogicalOrFn) {
+    // "a && b" is b when a holds, "a || b" is a; either way the
+    // condition is the one of the operand returned
+    b = EvaluateBool(state, expr->argv[0]);
+    
+    if (b < 0 || b == (expr->fn == LogicalOrFn)) {
+      return b;
+    }
+    
+    return EvaluateBool(state, expr->argv[1]);
+  }
+  else if (expr->fn == IfElseFn && (expr->argc == 2 || expr->argc == 3)) {
+    b = EvaluateBool(state, expr->argv[0]);
+    
+    if (b < 0) {
+      return b;
+    }
+    
+    if (b) {
+      return EvaluateBool(state, expr->argv[1]);
+    }
+    
+    return expr->argc == 3 ? EvaluateBool(state, expr->argv[2]) : 0;
+  }
+  else if (expr->fn == EqualityFn || expr->fn == InequalityFn) {
+    if (EqualityCompare(state, expr->argv, &equal) < 0) {
+      return -1;
+    }
+    
+    return equal == (expr->fn == EqualityFn);
+  }
+  
+  Value * v = EvaluateString(state, expr);
+  
+  if (v == NULL) {
+    return -1;
+  }
+  
+  b = BooleanString(v->data);
+  FreeValue(v);
+  return b;
+}
+
 Value * StringValue(char * str) {
   if (str == NULL) {
     return NULL;
@@ -64,59 +163,119 @@ Value * StringValue(char * str) {
   v->type = VAL_STRING;
   v->size = strlen(str);
   v->data = str;
+  v->refs = 1;
+  v->owned = 1;
+  return v;
+}
+
+// Shared by every empty string, never freed.
+static Value empty_value = { VAL_STRING, 0, "", 0, 0 };
+
+Value * StaticStringValue(const char * str) {
+  if (str[0] == '\0') {
+    return &empty_value;
+  }
+  
+  Value * v = malloc(sizeof(Value));
+  v->type = VAL_STRING;
+  v->size = strlen(str);
+  v->data = (char *) str;
+  v->refs = 1;
+  v->owned = 0;
+  return v;
+}
+
+Value * RetainValue(Value * v) {
+  if (v != NULL && v->refs > 0) {
+    ++v->refs;
+  }
+  
   return v;
 }
 
 void FreeValue(Value * v) {
-  if (v == NULL) {
+  if (v == NULL || v->refs == 0 || --v->refs > 0) {
     return;
   }
   
-  free(v->data);
+  if (v->owned) {
+    free(v->data);
+  }
+  
   free(v);
 }
 
-Value * ConcatFn(const char * name, State * state, int argc, Expr * argv[]) {
-  if (argc == 0) {
-    return StringValue(strdup(""));
+// Collect the operands of expr, looking through nested concatenations,
+// so a chain of '+' is joined once instead of once per operator.
+static void ConcatOperands(Expr * expr, Expr *** ops, int * count, int * size) {
+  int i;
+  
+  for (i = 0; i < expr->argc; ++i) {
+    if (expr->argv[i]->fn == ConcatFn) {
+      ConcatOperands(expr->argv[i], ops, count, size);
+      continue;
+    }
+    
+    if (*count == *size) {
+      *size = *size * 2 + 8;
+      *ops = realloc(*ops, *size * sizeof(Expr *));
+    }
+    
+    (*ops)[(*count)++] = expr->argv[i];
   }
+}
+
+Value * ConcatFn(const char * name, State * state, int argc, Expr * argv[]) {
+  Expr self;
+  self.argc = argc;
+  self.argv = argv;
+  Expr ** ops = NULL;
+  int count = 0;
+  int size = 0;
+  ConcatOperands(&self, &ops, &count, &size);
   
-  char ** strings = malloc(argc * sizeof(char *));
-  int i;
+  if (count == 0) {
+    return StaticStringValue("");
+  }
   
-  for (i = 0; i < argc; ++i) {
-    strings[i] = NULL;
+  if (count == 1) {
+    Value * v = EvaluateString(state, ops[0]);
+    free(ops);
+    return v;
   }
   
+  Value ** values = malloc(count * sizeof(Value *));
   char * result = NULL;
-  int length = 0;
+  ssize_t length = 0;
+  int i;
   
-  for (i = 0; i < argc; ++i) {
-    strings[i] = Evaluate(state, argv[i]);
+  for (i = 0; i < count; ++i) {
+    values[i] = EvaluateString(state, ops[i]);
     
-    if (strings[i] == NULL) {
+    if (values[i] == NULL) {
       goto done;
     }
     
-    length += strlen(strings[i]);
+    length += values[i]->size;
   }
   
   result = malloc(length + 1);
-  int p = 0;
+  char * p = result;
   
-  for (i = 0; i < argc; ++i) {
-    strcpy(result + p, strings[i]);
-    p += strlen(strings[i]);
+  for (i = 0; i < count; ++i) {
+    memcpy(p, values[i]->data, values[i]->size);
+    p += values[i]->size;
   }
   
-  result[p] = '\0';
+  *p = '\0';
 done:
 
-  for (i = 0; i < argc; ++i) {
-    free(strings[i]);
+  while (--i >= 0) {
+    FreeValue(values[i]);
   }
   
-  free(strings);
+  free(values);
+  free(ops);
   return StringValue(result);
 }
 
@@ -127,23 +286,22 @@ Value * IfElseFn(const char * name, State * state, int argc, Expr * argv[]) {
     return NULL;
   }
   
-  char * cond = Evaluate(state, argv[0]);
+  int cond = EvaluateBool(state, argv[0]);
   
-  if (cond == NULL) {
+  if (cond < 0) {
     return NULL;
   }
   
-  if (BooleanString(cond) == true) {
-    free(cond);
+  if (cond) {
     return EvaluateValue(state, argv[1]);
   }
   else {
     if (argc == 3) {
-      free(cond);
       return EvaluateValue(state, argv[2]);
     }
     else {
-      return StringValue(cond);
+      // a false condition is always ""
+      return StaticStringValue("");
     }
   }
 }
@@ -186,7 +344,15 @@ Value * AssertFn(const char * name, State * state, int argc, Expr * argv[]) {
       char * err_src = malloc(len + 20);
       strcpy(err_src, "assert failed: ");
       prefix_len = strlen(err_src);
-      memcpy(err_src + prefix_len, state->script + argv[i]->start, len);
+      
+      // precompiled scripts carry no source text
+      if (state->script != NULL) {
+        memcpy(err_src + prefix_len, state->script + argv[i]->start, len);
+      }
+      else {
+        len = 0;
+      }
+      
       err_src[prefix_len + len] = '\0';
       free(state->errmsg);
       state->errmsg = err_src;
@@ -194,7 +360,7 @@ Value * AssertFn(const char * name, State * state, int argc, Expr * argv[]) {
     }
   }
   
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 Value * SleepFn(const char * name, State * state, int argc, Expr * argv[]) {
@@ -223,115 +389,114 @@ Value * StdoutFn(const char * name, State * state, int argc, Expr * argv[]) {
     free(v);
   }
   
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 Value * LogicalAndFn(const char * name, State * state,
                      int argc, Expr * argv[]) {
-  char * left = Evaluate(state, argv[0]);
+  int left = EvaluateBool(state, argv[0]);
   
-  if (left == NULL) {
+  if (left < 0) {
     return NULL;
   }
   
-  if (BooleanString(left) == true) {
-    free(left);
+  if (left) {
     return EvaluateValue(state, argv[1]);
   }
   else {
-    return StringValue(left);
+    return StaticStringValue("");
   }
 }
 
 Value * LogicalOrFn(const char * name, State * state,
                     int argc, Expr * argv[]) {
-  char * left = Evaluate(state, argv[0]);
+  Value * left = EvaluateString(state, argv[0]);
   
   if (left == NULL) {
     return NULL;
   }
   
-  if (BooleanString(left) == false) {
-    free(left);
+  if (BooleanString(left->data) == false) {
+    FreeValue(left);
     return EvaluateValue(state, argv[1]);
   }
   else {
-    return StringValue(left);
+    return left;
   }
 }
 
 Value * LogicalNotFn(const char * name, State * state,
                      int argc, Expr * argv[]) {
-  char * val = Evaluate(state, argv[0]);
+  int bv = EvaluateBool(state, argv[0]);
   
-  if (val == NULL) {
+  if (bv < 0) {
     return NULL;
   }
   
-  bool bv = BooleanString(val);
-  free(val);
-  return StringValue(strdup(bv ? "" : "t"));
+  return StaticStringValue(bv ? "" : "t");
 }
 
 Value * SubstringFn(const char * name, State * state,
                     int argc, Expr * argv[]) {
-  char * needle = Evaluate(state, argv[0]);
+  Value * needle = EvaluateString(state, argv[0]);
   
   if (needle == NULL) {
     return NULL;
   }
   
-  char * haystack = Evaluate(state, argv[1]);
+  Value * haystack = EvaluateString(state, argv[1]);
   
   if (haystack == NULL) {
-    free(needle);
+    FreeValue(needle);
     return NULL;
   }
   
-  char * result = strdup(strstr(haystack, needle) ? "t" : "");
-  free(needle);
-  free(haystack);
-  return StringValue(result);
+  bool result = strstr(haystack->data, needle->data) != NULL;
+  FreeValue(needle);
+  FreeValue(haystack);
+  return StaticStringValue(result ? "t" : "");
 }
 
-Value * EqualityFn(const char * name, State * state, int argc, Expr * argv[]) {
-  char * left = Evaluate(state, argv[0]);
+// Evaluate both operands, and compare them by length first.
+static int EqualityCompare(State * state, Expr * argv[], bool * equal) {
+  Value * left = EvaluateString(state, argv[0]);
   
   if (left == NULL) {
-    return NULL;
+    return -1;
   }
   
-  char * right = Evaluate(state, argv[1]);
+  Value * right = EvaluateString(state, argv[1]);
   
   if (right == NULL) {
-    free(left);
-    return NULL;
+    FreeValue(left);
+    return -1;
   }
   
-  char * result = strdup(strcmp(left, right) == 0 ? "t" : "");
-  free(left);
-  free(right);
-  return StringValue(result);
+  *equal = left->size == right->size &&
+           memcmp(left->data, right->data, left->size) == 0;
+  FreeValue(left);
+  FreeValue(right);
+  return 0;
 }
 
-Value * InequalityFn(const char * name, State * state, int argc, Expr * argv[]) {
-  char * left = Evaluate(state, argv[0]);
+Value * EqualityFn(const char * name, State * state, int argc, Expr * argv[]) {
+  bool equal;
   
-  if (left == NULL) {
+  if (EqualityCompare(state, argv, &equal) < 0) {
     return NULL;
   }
   
-  char * right = Evaluate(state, argv[1]);
+  return StaticStringValue(equal ? "t" : "");
+}
   
-  if (right == NULL) {
-    free(left);
+Value * InequalityFn(const char * name, State * state, int argc, Expr * argv[]) {
+  bool equal;
+  
+  if (EqualityCompare(state, argv, &equal) < 0) {
     return NULL;
   }
   
-  char * result = strdup(strcmp(left, right) != 0 ? "t" : "");
-  free(left);
-  free(right);
-  return StringValue(result);
+  return StaticStringValue(equal ? "" : "t");
 }
 
 Value * SequenceFn(const char * name, State * state, int argc, Expr * argv[]) {
@@ -379,7 +544,7 @@ Value * LessThanIntFn(const char * name, State * state, int argc, Expr * argv[])
 done:
   free(left);
   free(right);
-  return StringValue(strdup(result ? "t" : ""));
+  return StaticStringValue(result ? "t" : "");
 }
 
 Value * GreaterThanIntFn(const char * name, State * state,
@@ -396,14 +561,16 @@ Value * GreaterThanIntFn(const char * name, State * state,
   return LessThanIntFn(name, state, 2, temp);
 }
 
+// The name outlives every evaluation of its tree, so it is not copied.
+// Resolved trees skip this and return the node's own Value.
 Value * Literal(const char * name, State * state, int argc, Expr * argv[]) {
-  return StringValue(strdup(name));
+  return StaticStringValue(name);
 }
 
 Expr * Build(Function fn, YYLTYPE loc, int count, ...) {
   va_list v;
   va_start(v, count);
-  Expr * e = malloc(sizeof(Expr));
+  Expr * e = calloc(1, sizeof(Expr));
   e->fn = fn;
   e->name = "(operator)";
   e->argc = count;
@@ -462,6 +629,117 @@ Function FindFunction(const char * name) {
   return nf->fn;
 }
 
+static int resolver_entries = 0;
+static struct {
+  const char * name;
+  Resolver fn;
+} * resolver_table = NULL;
+
+void RegisterResolver(const char * name, Resolver fn) {
+  resolver_table = realloc(resolver_table,
+                           (resolver_entries + 1) * sizeof(*resolver_table));
+  resolver_table[resolver_entries].name = name;
+  resolver_table[resolver_entries].fn = fn;
+  ++resolver_entries;
+}
+
+// Operators without side effects, safe to evaluate ahead of time.
+static bool IsFoldable(Function fn) {
+  return fn == ConcatFn || fn == EqualityFn || fn == InequalityFn ||
+         fn == LogicalAndFn || fn == LogicalOrFn || fn == LogicalNotFn ||
+         fn == SubstringFn || fn == IfElseFn || fn == SequenceFn;
+}
+
+static void MakeLiteral(Expr * expr, char * str) {
+  expr->fn = Literal;
+  expr->name = str;
+  expr->argc = 0;
+  expr->argv = NULL;
+  expr->op = 0;
+}
+
+// Replace expr by what it evaluates to when that is known now: all
+// operands constant, or a constant condition picking one branch.
+static void FoldExpr(Expr * expr) {
+  Expr ** argv = expr->argv;
+  Expr * taken = NULL;
+  int i;
+  
+  if (!IsFoldable(expr->fn)) {
+    return;
+  }
+  
+  for (i = 0; i < expr->argc; ++i) {
+    if (argv[i]->fn != Literal) {
+      break;
+    }
+  }
+  
+  if (i == expr->argc) {
+    State state = { NULL, NULL, NULL };
+    char * result = Evaluate(&state, expr);
+    
+    if (result != NULL) {
+      MakeLiteral(expr, result);
+    }
+    
+    free(state.errmsg);
+    return;
+  }
+  
+  if (argv[0]->fn != Literal) {
+    return;
+  }
+  
+  bool cond = BooleanString(argv[0]->name);
+  
+  if (expr->fn == SequenceFn) {
+    taken = argv[1];
+  }
+  else if (expr->fn == LogicalAndFn) {
+    taken = cond ? argv[1] : argv[0];
+  }
+  else if (expr->fn == LogicalOrFn) {
+    taken = cond ? argv[0] : argv[1];
+  }
+  else if (expr->fn == IfElseFn && (expr->argc == 2 || expr->argc == 3)) {
+    taken = cond ? argv[1] : (expr->argc == 3 ? argv[2] : argv[0]);
+  }
+  
+  if (taken != NULL) {
+    *expr = *taken;
+  }
+}
+
+void ResolveExpr(Expr * root, int fold) {
+  int i;
+  
+  for (i = 0; i < root->argc; ++i) {
+    ResolveExpr(root->argv[i], fold);
+  }
+  
+  if (fold) {
+    FoldExpr(root);
+  }
+  
+  if (root->fn == Literal) {
+    root->num = atol(root->name);
+    root->flags |= EXPR_NUM;
+    root->value.type = VAL_STRING;
+    root->value.size = strlen(root->name);
+    root->value.data = root->name;
+    root->value.refs = 0;
+    root->value.owned = 0;
+    return;
+  }
+  
+  for (i = 0; i < resolver_entries; ++i) {
+    if (strcmp(root->name, resolver_table[i].name) == 0) {
+      resolver_table[i].fn(root);
+    }
+  }
+}
+
 void RegisterBuiltins() {
   RegisterFunction("ifelse", IfElseFn);
   RegisterFunction("abort", AbortFn);
@@ -569,6 +847,46 @@ char ** ReadVarArgs(State * state, int argc, Expr * argv[]) {
   return args;
 }
 
+// Evaluate the expressions in argv, returning an array of argc char*
+// borrowed from the resulting Values, which are kept after them in
+// the same array.  If any evaluate to NULL, free the rest and return
+// NULL.
+char ** BorrowVarArgs(State * state, int argc, Expr * argv[]) {
+  char ** args = malloc((argc ? argc : 1) * 2 * sizeof(char *));
+  Value ** values = (Value **)(args + argc);
+  int i;
+  
+  for (i = 0; i < argc; ++i) {
+    values[i] = EvaluateString(state, argv[i]);
+    
+    if (values[i] == NULL) {
+      int j;
+      
+      for (j = 0; j < i; ++j) {
+        FreeValue(values[j]);
+      }
+      
+      free(args);
+      return NULL;
+    }
+    
+    args[i] = values[i]->data;
+  }
+  
+  return args;
+}
+
+void FreeBorrowedArgs(int argc, char ** args) {
+  Value ** values = (Value **)(args + argc);
+  int i;
+  
+  for (i = 0; i < argc; ++i) {
+    FreeValue(values[i]);
+  }
+  
+  free(args);
+}
+
 // Evaluate the expressions in argv, returning an array of Value*
 // results.  If any evaluate to NULL, free the rest and return NULL.
 // The caller is responsible for freeing the returned array and the
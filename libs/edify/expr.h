@@ -43,10 +43,16 @@ typedef struct {
 #define VAL_STRING  1  // data will be NULL-terminated; size doesn't count null
 #define VAL_BLOB    2
 
+// Values are immutable once returned, and may be shared: refs counts
+// the owners, FreeValue() drops one.  A Value with refs 0 is static
+// and never freed.  data is released with the Value only when owned,
+// otherwise it outlives the Value (a literal, or a static string).
 typedef struct {
   int type;
   ssize_t size;
   char * data;
+  int refs;
+  int owned;
 } Value;
 
 typedef Value * (*Function)(const char * name, State * state,
@@ -58,8 +64,21 @@ struct Expr {
   int argc;
   Expr ** argv;
   int start, end;
+  
+  // Filled by ResolveExpr(): a literal's value as a number (when
+  // flags has EXPR_NUM), and an operator code a Resolver pre-bound
+  // on this node, 0 if none.
+  long num;
+  int op;
+  int flags;
+  
+  // Filled by ResolveExpr() for a literal: the static Value (refs 0)
+  // every evaluation of this node returns, so none allocates.
+  Value value;
 };
 
+#define EXPR_NUM  1
+
 // Take one of the Expr*s passed to the function as an argument,
 // evaluate it, return the resulting Value.  The caller takes
 // ownership of the returned Value.
@@ -72,6 +91,15 @@ Value * EvaluateValue(State * state, Expr * expr);
 // with strings.
 char * Evaluate(State * state, Expr * expr);
 
+// Evaluate expr as a number, as atol() would.  Literals use the number
+// cached by ResolveExpr().  Returns 0 on success, -1 if the evaluation
+// aborted.
+int EvaluateLong(State * state, Expr * expr, long * out);
+
+// Evaluate expr as a condition, without building the string when the
+// operators allow it.  Returns 1 or 0, or -1 if the evaluation aborted.
+int EvaluateBool(State * state, Expr * expr);
+
 // Glue to make an Expr out of a literal.
 Value * Literal(const char * name, State * state, int argc, Expr * argv[]);
 
@@ -124,6 +152,18 @@ void FinishRegistration();
 // exists.
 Function FindFunction(const char * name);
 
+// Called by ResolveExpr() on every call of a registered name, after its
+// arguments were resolved, to pre-bind constant arguments (Expr.op).
+typedef void (*Resolver)(Expr * expr);
+void RegisterResolver(const char * name, Resolver fn);
+
+// Resolve a parsed tree before evaluating it: cache the number of every
+// literal and run the registered resolvers.  When fold is set, constant
+// operator subexpressions are also replaced by their result, and
+// branches on constant conditions by the branch taken; folded strings
+// are malloc'd and never freed, so only fold trees that live as long.
+void ResolveExpr(Expr * root, int fold);
+
 
 // --- convenience functions for use in functions ---
 
@@ -143,6 +183,12 @@ int ReadValueArgs(State * state, Expr * argv[], int count, ...);
 // strings it contains.
 char ** ReadVarArgs(State * state, int argc, Expr * argv[]);
 
+// Like ReadVarArgs(), but the strings are borrowed from the evaluated
+// Values instead of copied.  They must not be modified, and stay valid
+// until FreeBorrowedArgs().
+char ** BorrowVarArgs(State * state, int argc, Expr * argv[]);
+void FreeBorrowedArgs(int argc, char ** args);
+
 // Evaluate the expressions in argv, returning an array of Value*
 // results.  If any evaluate to NULL, free the rest and return NULL.
 // The caller is responsible for freeing the returned array and the
@@ -156,7 +202,14 @@ Value * ErrorAbort(State * state, char * format, ...);
 // Wrap a string into a Value, taking ownership of the string.
 Value * StringValue(char * str);
 
-// Free a Value object.
+// Wrap a string that outlives the Value, without copying it.  Empty
+// strings share one static Value.
+Value * StaticStringValue(const char * str);
+
+// Add an owner to a Value, returns v.
+Value * RetainValue(Value * v);
+
+// Release one owner of a Value, freeing it with the last one.
 void FreeValue(Value * v);
 
 int yyErrLine();
@@ -165,5 +218,6 @@ int yyErrCol();
 void yyerror(Expr ** root, int * error_count, const char * s);
 int yyparse(Expr ** root, int * error_count);
 struct yy_buffer_state* yy_scan_string(const char* yystr);
+struct yy_buffer_state* yy_scan_bytes(const char* bytes, int len);
 
 #endif  // _EXPRESSION_H
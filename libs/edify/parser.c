@@ -1453,7 +1453,7 @@ yyreduce:
       /* Line 1464 of yacc.c  */
 #line 68 "./parser.y"
       {
-        (yyval.expr) = malloc(sizeof(Expr));
+        (yyval.expr) = calloc(1, sizeof(Expr));
         (yyval.expr)->fn = Literal;
         (yyval.expr)->name = (yyvsp[(1) - (1)].str);
         (yyval.expr)->argc = 0;
@@ -1570,7 +1570,7 @@ yyreduce:
       /* Line 1464 of yacc.c  */
 #line 89 "./parser.y"
       {
-        (yyval.expr) = malloc(sizeof(Expr));
+        (yyval.expr) = calloc(1, sizeof(Expr));
         (yyval.expr)->fn = FindFunction((yyvsp[(1) - (4)].str));
         
         if ((yyval.expr)->fn == NULL) {
@@ -74,3 +74,17 @@ LOCAL_STATIC_LIBRARIES += libpng libz
 LOCAL_MODULE:= libft2_aroma_static
 
 include $(BUILD_STATIC_LIBRARY)
+
+# host variant for the aroma_bench host benchmark
+ifeq ($(AROMA_HOST_BENCH),true)
+aroma_ft_src_files := $(LOCAL_SRC_FILES)
+aroma_ft_c_includes := $(LOCAL_C_INCLUDES)
+aroma_ft_cflags := $(LOCAL_CFLAGS)
+include $(CLEAR_VARS)
+LOCAL_PATH := external/freetype
+LOCAL_SRC_FILES := $(aroma_ft_src_files)
+LOCAL_C_INCLUDES := $(aroma_ft_c_includes)
+LOCAL_CFLAGS := $(aroma_ft_cflags)
+LOCAL_MODULE := libft2_aroma_host
+include $(BUILD_HOST_STATIC_LIBRARY)
+endif
@@ -67,7 +67,12 @@
 typedef uint8_t byte;
 typedef uint32_t dword;
 typedef uint16_t word;
-typedef uint16_t color;
+typedef libaroma_pixel color;       // RGB565, XRGB8888 with _AROMA_CANVAS32
+#ifdef _AROMA_CANVAS32
+typedef uint64_t colorpair;
+#else
+typedef dword colorpair;
+#endif
 
 //
 // AROMA Main Configurations
@@ -83,6 +88,7 @@ typedef uint16_t color;
 //#define AROMA_SYSTMP      "/data"
 #define AROMA_TMP         AROMA_SYSTMP "/aroma"
 #define AROMA_TMP_S       AROMA_SYSTMP "/aroma-data"
+#define AROMA_TRACE_FILE  AROMA_SYSTMP "/aroma-trace.json"
 
 #define AROMA_DIR         "META-INF/com/google/android/aroma"
 #define AROMA_CFG         "META-INF/com/google/android/aroma-config"
@@ -137,6 +143,20 @@ byte      aarray_set(AARRAYP a, char * key, char * val);
 byte      aarray_del(AARRAYP a, char * key);
 byte      aarray_free(AARRAYP a);
 
+//
+// AROMA Prop Index
+//
+typedef struct _APROP APROP, * APROPP;
+
+APROPP    aprop_parse(const char * buffer);                       // Parse key=value String
+char   *  aprop_get(APROPP p, const char * key);                  // Get Value (owned by prop)
+void      aprop_free(APROPP p);
+APROPP    aprop_zip(const char * zpath);                          // Parse Zip Entry
+char   *  aprop_fileget(const char * path, const char * key);     // Cached by path + mtime
+char   *  aprop_zipget(const char * zpath, const char * key);     // Cached by zip entry
+void      aprop_invalidate(const char * path);                    // Call after writing a prop file
+void      aprop_cache_release();
+
 //
 // AROMA PNG Canvas Structure
 //
@@ -172,42 +192,49 @@ typedef struct {
 typedef struct {
   int sz;         // Data Size
   char * data;    // Data
+  byte mapped;    // Data is a read-only view into the package (az_map)
 } AZMEM;
 
 //
 // AROMA FREETYPE GLYPH CACHE
+//   Immutable once published into AFTFACE.cache
 //
 typedef struct {
   FT_Glyph  g;
   byte      w;    // width
-  byte      init; // cached
 } AFTGLYPH, * AFTGLYPHP;
 
 //
 // AROMA FREETYPE FONT FACE
 //
+#define AFT_KCACHE_SZ 256
 typedef struct {
-  FT_Face     face;
-  AFTGLYPHP   cache;
-  long        cache_n;
-  byte        kern;
-  byte    *   mem;
+  FT_Face           face;
+  AFTGLYPHP    *    cache;    // Glyph slots, read without lock
+  long              cache_n;
+  uint64_t     *    kcache;   // Kerning pairs, read without lock
+  byte              kern;
+  AZMEM             mem;      // Font file, az_map view
+  pthread_mutex_t   lock;     // Guard FT_Face (glyph load & kerning)
 } AFTFACE, * AFTFACEP;
 
 //
 // AROMA FREETYPE FAMILY
 //
+#define AFT_CMAP_PAGES 256
 typedef struct {
   //-- Face Holder
   AFTFACEP  faces;
   int       facen;
   
+  //-- Char to face/glyph pages (BMP only), read without lock
+  dword  ** cmap;
+  
   //-- General Info
   byte      s;
   byte      p;
   byte      h;
   byte      y;
-  byte      init;
 } AFTFAMILY, * AFTFAMILYP;
 
 //
@@ -219,6 +246,7 @@ typedef struct {
   int   d;        // Down State
   int   k;        // Key Code
   dword msg;      // Window Message for postmessage
+  long  t;        // Event Time (ms, CLOCK_MONOTONIC)
 } ATEV;
 
 //
@@ -234,10 +262,28 @@ typedef struct {
 // AROMA Graphic Pixel Macro
 //
 
+#ifdef _AROMA_CANVAS32
+#define ag_r(rgb)           ((byte) (((dword)(rgb)) >> 16))
+#define ag_g(rgb)           ((byte) (((dword)(rgb)) >> 8))
+#define ag_b(rgb)           ((byte) (rgb))
+#define ag_rgb(r,g,b)       ((color) ((((r) & 0xff) << 16) | (((g) & 0xff) << 8) | ((b) & 0xff)))
+#else
 #define ag_r(rgb)	          ((byte) (((((word)(rgb))&0xF800))>>8) )
 #define ag_g(rgb)	          ((byte) (((((word)(rgb))&0x07E0))>>3) )
 #define ag_b(rgb)	          ((byte) (((((word)(rgb))&0x001F))<<3) )
 #define ag_rgb(r,g,b)       ((color) ((r >> 3) << 11)| ((g >> 2) << 5)| ((b >> 3) << 0))
+#endif
+
+//-- Two colors in one value, for gradient pairs
+#ifdef _AROMA_CANVAS32
+#define ag_pair(a,b)        ((colorpair) (((colorpair) (b)) << 32) | ((colorpair) (a)))
+#define ag_pairlo(p)        ((color) (p))
+#define ag_pairhi(p)        ((color) ((p) >> 32))
+#else
+#define ag_pair(a,b)        MAKEDWORD(a, b)
+#define ag_pairlo(p)        LOWORD(p)
+#define ag_pairhi(p)        HIWORD(p)
+#endif
 
 /*
 #define ag_rgba32(r,g,b,a)  ((dword)((((a)&0xff)<<24)|(((r)&0xff)<<16)|(((g)&0xff)<<8)|((b)&0xff)))
@@ -254,13 +300,19 @@ byte ag_g32(dword rgb);
 byte ag_b32(dword rgb);
 byte ag_a32(dword rgb);
 
+#ifdef _AROMA_CANVAS32
+#define ag_close_r(r)       ((byte) (r))
+#define ag_close_g(g)       ((byte) (g))
+#else
 #define ag_close_r(r)       (((byte) r)>>3<<3)
 #define ag_close_g(g)       (((byte) g)>>2<<2)
+#endif
 #define ag_close_b(b)       ag_close_r(b)
 #define ag_rgbto32(rgb)     (ag_rgba32(ag_r(rgb),ag_g(rgb),ag_b(rgb),0xff))
 #define ag_rgbto16(rgb)     (ag_rgb(ag_r32(rgb),ag_g32(rgb),ag_b32(rgb)))
 
 void ag_takescreenshoot();
+byte ag_savebmp(const char * filename, color * data, int w, int h);
 byte file_exists(const char * file);
 
 //
@@ -284,14 +336,17 @@ byte file_exists(const char * file);
 //
 // AROMA Kinetic Library Structures
 //
-#define AKINETIC_HISTORY_LENGTH     4
+#define AKINETIC_HISTORY_LENGTH     16
+#define AKINETIC_HORIZON            100               // Velocity Sample Window (ms)
 #define AKINETIC_DAMPERING          0.98              // Gravity
 typedef struct  {
   byte    isdown;                                     // Is Touch Down
   double  velocity;                                   // Fling Velocity
-  int     previousPoints[AKINETIC_HISTORY_LENGTH];    // Touch Y Pos History
-  long    previousTimes[AKINETIC_HISTORY_LENGTH];     // Touch Time History
+  int     previousPoints[AKINETIC_HISTORY_LENGTH];    // Touch Y Pos History (Ring)
+  long    previousTimes[AKINETIC_HISTORY_LENGTH];     // Touch Event Time History (Ring)
   byte    history_n;                                  // Number of Touch History
+  byte    history_pos;                                // Next History Slot
+  byte    evclock;                                    // Gesture Uses Event Times
 } AKINETIC;
 
 //
@@ -390,10 +445,24 @@ typedef byte  (*AC_ONFOCUS)(void *);
 typedef void  (*AC_ONDRAW)(void *);
 typedef void  (*AC_ONDESTROY)(void *);
 
+//
+// AROMA Arena Structure, bump allocator released in one call
+//
+typedef struct _AARENA_CHUNK {
+  struct _AARENA_CHUNK * next;
+  size_t        size;         // Usable bytes
+  size_t        used;
+} AARENA_CHUNK;
+typedef struct {
+  AARENA_CHUNK * head;        // Current chunk first
+  size_t        bytes;        // Total requested
+} AARENA, * AARENAP;
+
 //
 // AROMA Window Structure
 //
 typedef struct {
+  AARENA        arena;        // Page memory, owns the window itself
   byte          isActived;    // Active & Showed
   CANVAS    *   bg;           // Background Canvas
   CANVAS        c;            // Window drawing canvas
@@ -432,6 +501,7 @@ typedef struct {
 // AROMA Root Functions
 //
 FILE   *  apipe();        // Recovery pipe to communicate the command
+byte      aui_prepare();  // Read & Parse aroma-config
 byte      aui_start();    // Start AROMA UI
 char   *  aui_readfromfs(char * name);
 char   *  getArgv(int id);
@@ -452,7 +522,12 @@ char * alang_get(char * key);
 byte      az_init(const char * filename);                               // Init Zip Archive
 void      az_close();                                                   // Release Zip Archive
 byte      az_readmem(AZMEM * out, const char * zpath, byte bytesafe);   // Read Zip Item into Memory
+#define   AZ_MAP_ONCE   0                                               // Read once from start to end
+#define   AZ_MAP_KEEP   1                                               // Kept & read at random
+byte      az_map(AZMEM * out, const char * zpath, byte usage);          // Read-only Zip Item, no copy if stored
+void      az_unmap(AZMEM * mem);                                        // Release az_map / az_readmem data
 byte      az_extract(const char * zpath, const char * dest);            // Extract Zip Item into Filesystem
+byte      az_crc(const char * zpath, dword * crc);                      // CRC32 of Zip Item, from the directory
 
 //-- UI Functions
 char * aui_parsepropstring(char * buffer, char * key);
@@ -481,6 +556,8 @@ PNGCANVAS * aui_menu_icon();
 // AROMA PNG Functions
 //
 byte      apng_load(PNGCANVAS * pngcanvas, char * imgname);       // Load PNG From Zip Item
+byte      apng_load_zip(PNGCANVAS * pngcanvas, const char * zpath);     // Load PNG From Zip Path
+void      apng_prefetch(const char * imgname, const char * themename);  // Decode ahead, for apng_load
 void      apng_close(PNGCANVAS * pngcanvas);                            // Release PNG Memory
 byte      apng_draw(CANVAS * _b, PNGCANVAS * p, int xpos, int ypos);    // Draw PNG Into Canvas
 byte apng_stretch(
@@ -534,6 +611,11 @@ byte      apng_draw_ex(CANVAS * _b, PNGCANVAS * p, int xpos,            // Draw
 
 //
 // AROMA Graphic Function
+//
+// AROMA Transition Frame Callback, p is progress 0-255, scratch may be empty
+//
+typedef void (*AG_TRANSFN)(void * data, CANVAS * scratch, int p);
+
 //
 byte      ag_isfreetype(byte isbig);
 byte      ag_fontready(byte isbig);
@@ -551,6 +633,8 @@ int       agdp();                           // Get Device Pixel Size (WVGA = 3,
 void      set_agdp(int dp);                 // Force Graphic Device Pixel Size
 void      ag_sync_fade(int frame);          // Transition Sync - Async
 void      ag_sync_fade_wait(int frame);     // Transition Sync - Sync
+int       ag_transition_ms(int frame);      // Nominal Transition Duration
+void      ag_transition(int duration, int w, int h, AG_TRANSFN fn, void * data); // Timed Transition
 void      ag_sync_force();                  // Force to Sync
 void      ag_setbusy();                     // Set Display to show Please Wait Progress
 void      ag_setbusy_withtext(char * text); // Display Busy Progress with Custom Text
@@ -560,6 +644,8 @@ void      ag_setbusy_withtext(char * text); // Display Busy Progress with Custom
 //
 void ag_canvas(CANVAS * c, int w, int h); // Create Canvas
 void ag_ccanvas(CANVAS * c);              // Release Canvas
+void ag_canvas_get(CANVAS * c, int w, int h); // Pooled Canvas, content undefined
+void ag_canvas_put(CANVAS * c);           // Return Pooled Canvas
 void ag_blank(CANVAS * c);                // Set Blank into Canvas memset(0)
 
 //
@@ -610,8 +696,13 @@ byte ag_draw_strecth_ex(
   byte withdest
 );
 void ag_dither(byte * qe, int qp, int qx, int dthx, int dthy, int dthw, int dthh, byte r, byte g, byte b);
+#ifdef _AROMA_CANVAS32
+#define ag_dodither(x,y,col)            ((color) ((col) & 0xffffff))
+#define ag_dodither_rgb(x,y,sr,sg,sb)   ag_rgb(sr, sg, sb)
+#else
 color ag_dodither(int x, int y, dword col);
 color ag_dodither_rgb(int x, int y, byte sr, byte sg, byte sb);
+#endif
 
 //
 // AROMA Color Calculator Functions
@@ -620,8 +711,8 @@ color     ag_subpixelget(CANVAS * _b, int x, int y, color cl, byte l); // Calcul
 #define   ag_calculatealpha(d,s,a) libaroma_alpha(d,s,a)              // Calculate 2 Colors with Opacity
 #define   ag_calculatealphaTo32(d,s,a) libaroma_alpha32(d,s,a)
 color     strtocolor(char * c);                                       // Convert String Hex Color #fff,#ffffff to color
-dword     ag_calchighlight(color c1, color c2);
-dword     ag_calcpushlight(color c1, color c2);
+colorpair ag_calchighlight(color c1, color c2);
+colorpair ag_calcpushlight(color c1, color c2);
 color     ag_calpushad(color c_g);
 color     ag_calculatecontrast(color c, float intensity);
 
@@ -647,6 +738,11 @@ byte ag_text_ex(CANVAS * _b, int maxwidth, int x, int y, // Draw String into Can
 int   ag_txtheight(int maxwidth,                      // Calculate String Height to be drawn
                    const char * s, byte isbig);
 int   ag_txtwidth(const char * s, byte isbig);        // Calculate String Width to be drawn
+#define AG_ELLIPSIS_START   0
+#define AG_ELLIPSIS_MIDDLE  1
+#define AG_ELLIPSIS_END     2
+char * ag_txtfit(const char * s, int maxwidth,      // Fit 1 line String with ellipsis,
+                 byte isbig, byte mode, int * width);  // NULL if it fits, free() result
 int  ag_tabwidth(int x, byte isbig);
 byte ag_fontwidth(int c, byte isbig);               // Calculate font width for 1 character
 byte ag_texts(CANVAS * _b, int maxwidth, int x, int y, const char * s, color cl_def, byte isbig);
@@ -676,6 +772,8 @@ int     vibrate(int timeout_ms);
 void    ui_init();
 int     ev_init(void);
 void    ev_exit(void);
+void    ev_inject_touch(int x, int y, int state);
+void    ev_inject_key(int key, int state);
 int     ev_get(struct input_event * ev, unsigned dont_wait);
 int     ui_wait_key();
 int     ui_key_pressed(int key);
@@ -700,18 +798,115 @@ byte alib_disksize(const char * path, unsigned long * ret, int division);
 int   alib_diskusage(const char * path);
 byte alib_diskfree(const char * path, unsigned long * ret, int division);
 void  alib_exec(char * cmd, char * arg);
+void  alib_execv(char ** argv);
+byte  alib_waitpath(const char * path, int timeout);   // Wait until path is created
+
+//
+// AROMA Mount State Functions
+//
+typedef struct {
+  unsigned long long size;      // Total Bytes
+  unsigned long long free;      // Free Bytes
+  unsigned long long used;      // Used Bytes
+  int                percent;   // Used Percentage
+} ADISKINFO;
+
+struct statfs;
+byte  alib_statfs(const char * path, struct statfs * out);         // Memoized statfs
+byte  alib_automount(const char * path);                            // Mount until next page
+void  alib_automount_release();                                     // Unmount auto mounted partitions
+byte  alib_diskinfo(const char * path, ADISKINFO * info);
 void  create_directory(const char * path);
 int   remove_directory(const char * path);
 long  alib_tick();
 long aTick();
 void aSleep(long ms);
 
+//
+// AROMA Arena Functions
+//
+void  aarena_init(AARENAP a);
+void * aarena_alloc(AARENAP a, size_t size);                       // Zeroed, 16 aligned
+void  aarena_free(AARENAP a);                                      // Release everything
+
+//
+// AROMA Task Graph Functions
+//
+#define ATASK_MAX       16
+#define ATASK_DEP(id)   (((dword) 1) << (id))
+typedef byte(*ATASK_FN)(void * arg);
+typedef struct {
+  const char  *   name;
+  ATASK_FN        fn;
+  void        *   arg;
+  dword           deps;         // ATASK_DEP() mask of earlier tasks
+  byte            state;
+  byte            result;
+  long            start;        // aTick() when started, 0 = not run
+  long            end;
+} ATASK, * ATASKP;
+typedef struct {
+  ATASK           t[ATASK_MAX];
+  int             n;
+  int             done;
+  pthread_mutex_t mutex;
+  pthread_cond_t  cond;
+} ATASKGRAPH, * ATASKGRAPHP;
+
+void  atask_init(ATASKGRAPHP g);
+int   atask_add(ATASKGRAPHP g, const char * name, ATASK_FN fn, void * arg, dword deps);
+byte  atask_run(ATASKGRAPHP g, int threads);                       // Run on pool, join
+byte  atask_result(ATASKGRAPHP g, int id);
+
+//
+// AROMA Prefetch Functions
+//
+void  aprefetch_png(const char * zpath, const char * alt);         // Decode in background, alt if zpath fails
+void  aprefetch_mem(const char * zpath);                            // Read zip item in background
+byte  aprefetch_takepng(const char * zpath, PNGCANVAS * out, byte * res);          // 1 = from store
+byte  aprefetch_takemem(const char * zpath, AZMEM * out, byte bytesafe, byte * res); // 1 = from store
+void  aprefetch_release();                                         // Stop thread, drop unclaimed
+
+//
+// AROMA Trace Functions
+//
+void  atrace_enable();                                              // Start recording
+void  atrace_event(char ph, const char * name, long value);
+void  atrace_thread_name(const char * name);
+const char * atrace_scope_begin(const char * name);
+void  atrace_scope_end(const char ** name);
+byte  atrace_dump(const char * path);                               // Chrome trace JSON
+#ifndef _AROMA_NOTRACE
+#define ATRACE_BEGIN(n)       atrace_event('B', n, 0)
+#define ATRACE_END(n)         atrace_event('E', n, 0)
+#define ATRACE_COUNTER(n,v)   atrace_event('C', n, v)
+#define ATRACE_THREAD(n)      atrace_thread_name(n)
+#define ATRACE_SCOPE(n)       const char * _atrace_scope __attribute__((cleanup(atrace_scope_end))) = atrace_scope_begin(n)
+#else
+#define ATRACE_BEGIN(n)
+#define ATRACE_END(n)
+#define ATRACE_COUNTER(n,v)
+#define ATRACE_THREAD(n)
+#define ATRACE_SCOPE(n)
+#endif
+
+//
+// AROMA Replay Functions
+//
+byte  areplay_load(const char * path);                             // Enables replay
+byte  areplay_active();
+void  areplay_run();                                                // Input thread body
+long long areplay_us();
+void  areplay_frame(long long start);                              // After fb flush
+void  areplay_sync(long long start);                               // After ag_sync
+void  areplay_report();
+
 //
 // AROMA Kinetic Calculator Functions
 //
-void  akinetic_downhandler(AKINETIC * p, int mouseY);
-int   akinetic_movehandler(AKINETIC * p, int mouseY);
-byte  akinetic_uphandler(AKINETIC * p, int mouseY);
+void  akinetic_downhandler(AKINETIC * p, int mouseY, long evtime);
+int   akinetic_movehandler(AKINETIC * p, int mouseY, long evtime);
+byte  akinetic_uphandler(AKINETIC * p, int mouseY, long evtime);
 int   akinetic_fling(AKINETIC * p);
 int   akinetic_fling_dampered(AKINETIC * p, float dampersz);
 
@@ -752,7 +947,11 @@ void      aw_destroy(AWINDOWP win);                         // Destroy Window
 void aw_show_ex(AWINDOWP win, byte anitype, int pos, ACONTROLP firstFocus);
 void      aw_show(AWINDOWP win);                            // Show Window
 void      aw_draw(AWINDOWP win);                            // Redraw Window
+void      aw_redraw(AWINDOWP win);                          // Redraw Controls into Window
 void      aw_add(AWINDOWP win, ACONTROLP ctl);              // Add Control into Window
+void   *  aw_alloc(AWINDOWP win, size_t size);              // Zeroed, freed with window
+void      aw_canvas(AWINDOWP win, CANVAS * c, int w, int h); // Fixed canvas, freed with window
+void   *  aw_grow(AWINDOWP win, void * list, int n, size_t elsz); // Room for item n
 void      aw_post(dword msg);                               // Post Message
 dword     aw_dispatch(AWINDOWP win);                        // Dispatch Event, Message & Input
 byte      aw_touchoncontrol(ACONTROLP ctl, int x, int y);   // Calculate Touch Position
@@ -804,6 +1003,8 @@ void ac_regscrollto(
 //
 void actext_rebuild(ACONTROLP ctl, int x, int y, int w, int h, char * text, byte isbig, byte toBottom);
 void actext_appendtxt(ACONTROLP ctl, char * txt);
+void actext_appendlines(ACONTROLP ctl, char ** txt, int n);
+void actext_logrebuild(ACONTROLP ctl, int x, int y, int w, int h, byte toBottom);
 ACONTROLP actext(
   AWINDOWP win,
   int x,
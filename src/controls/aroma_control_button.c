@@ -94,12 +94,7 @@ void acbutton_ondraw(void * x) {
   }
 }
 void acbutton_ondestroy(void * x) {
-  ACONTROLP   ctl = (ACONTROLP) x;
-  ACBUTTONDP  d  = (ACBUTTONDP) ctl->d;
-  ag_ccanvas(&d->control);
-  ag_ccanvas(&d->control_pushed);
-  ag_ccanvas(&d->control_focused);
-  free(ctl->d);
+  //-- Data & canvases are released with the window arena
 }
 byte acbutton_onfocus(void * x) {
   ACONTROLP   ctl = (ACONTROLP) x;
@@ -139,18 +134,17 @@ ACONTROLP acbutton(
   int txtx     = round(w / 2) - round(txtw / 2);
   int txty     = round(h / 2) - round(txth / 2);
   //-- Initializing Button Data
-  ACBUTTONDP d = (ACBUTTONDP) malloc(sizeof(ACBUTTOND));
-  memset(d, 0, sizeof(ACBUTTOND));
+  ACBUTTONDP d = (ACBUTTONDP) aw_alloc(win, sizeof(ACBUTTOND));
   //-- Save Touch Message & Set Stats
   d->touchmsg  = touchmsg;
   d->focused   = 0;
   d->pushed    = 0;
   //-- Initializing Canvas
-  ag_canvas(&d->control, w, h);
-  ag_canvas(&d->control_pushed, w, h);
-  ag_canvas(&d->control_focused, w, h);
+  aw_canvas(win, &d->control, w, h);
+  aw_canvas(win, &d->control_pushed, w, h);
+  aw_canvas(win, &d->control_focused, w, h);
   //-- Draw Rest Control
-  dword hl1 = ag_calchighlight(acfg()->controlbg, acfg()->controlbg_g);
+  colorpair hl1 = ag_calchighlight(acfg()->controlbg, acfg()->controlbg_g);
   ag_draw_ex(&d->control, &win->c, 0, 0, x, y, w, h);
   
   if (!atheme_draw("img.button", &d->control, 0, 0, w, h)) {
@@ -160,7 +154,7 @@ ACONTROLP acbutton(
                  ag_calculatealpha(acfg()->controlbg_g, acfg()->winbg, 160),
                  (agdp()*acfg()->btnroundsz) - 1);
     ag_roundgrad(&d->control, 2, 2, w - 4, h - 4, acfg()->controlbg, acfg()->controlbg_g, (agdp()*acfg()->btnroundsz) - 2);
-    ag_roundgrad_ex(&d->control, 2, 2, w - 4, (h - 4) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->btnroundsz) - 2, 1, 1, 0, 0);
+    ag_roundgrad_ex(&d->control, 2, 2, w - 4, (h - 4) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->btnroundsz) - 2, 1, 1, 0, 0);
   }
   
   ag_textf(&d->control, txtw, txtx + 1, txty + 1, text, acfg()->controlbg, isbig);
@@ -175,7 +169,7 @@ ACONTROLP acbutton(
     ag_roundgrad(&d->control_pushed, 0, 0, w, h, acfg()->border, acfg()->border_g, (agdp()*acfg()->btnroundsz));
     ag_roundgrad(&d->control_pushed, 1, 1, w - 2, h - 2, acfg()->controlbg, acfg()->controlbg_g, (agdp()*acfg()->btnroundsz) - 1);
     ag_roundgrad(&d->control_pushed, 2, 2, w - 4, h - 4, acfg()->selectbg, pshad, (agdp()*acfg()->btnroundsz) - 2);
-    ag_roundgrad_ex(&d->control_pushed, 2, 2, w - 4, (h - 4) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->btnroundsz) - 2, 1, 1, 0, 0);
+    ag_roundgrad_ex(&d->control_pushed, 2, 2, w - 4, (h - 4) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->btnroundsz) - 2, 1, 1, 0, 0);
   }
   
   ag_textf(&d->control_pushed, txtw, txtx + 1, txty + 1, text, acfg()->selectbg_g, isbig);
@@ -188,13 +182,13 @@ ACONTROLP acbutton(
     ag_roundgrad(&d->control_focused, 0, 0, w, h, acfg()->border, acfg()->border_g, (agdp()*acfg()->btnroundsz));
     ag_roundgrad(&d->control_focused, 1, 1, w - 2, h - 2, acfg()->controlbg, acfg()->controlbg_g, (agdp()*acfg()->btnroundsz) - 1);
     ag_roundgrad(&d->control_focused, 2, 2, w - 4, h - 4, acfg()->selectbg, acfg()->selectbg_g, (agdp()*acfg()->btnroundsz) - 2);
-    ag_roundgrad_ex(&d->control_focused, 2, 2, w - 4, (h - 4) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->btnroundsz) - 2, 1, 1, 0, 0);
+    ag_roundgrad_ex(&d->control_focused, 2, 2, w - 4, (h - 4) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->btnroundsz) - 2, 1, 1, 0, 0);
   }
   
   ag_textf(&d->control_focused, txtw, txtx + 1, txty + 1, text, acfg()->selectbg_g, isbig);
   ag_text(&d->control_focused, txtw, txtx, txty, text, acfg()->selectfg, isbig);
   //-- Initializing Control
-  ACONTROLP ctl  = malloc(sizeof(ACONTROL));
+  ACONTROLP ctl  = aw_alloc(win, sizeof(ACONTROL));
   ctl->ondestroy = &acbutton_ondestroy;
   ctl->oninput  = &acbutton_oninput;
   ctl->ondraw   = &acbutton_ondraw;
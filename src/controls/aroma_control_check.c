@@ -135,10 +135,7 @@ byte accb_ischecked(ACONTROLP ctl) {
   return d->checked;
 }
 void accb_ondestroy(void * x) {
-  ACONTROLP   ctl = (ACONTROLP) x;
-  ACCBDP  d  = (ACCBDP) ctl->d;
-  ag_ccanvas(&d->control);
-  free(ctl->d);
+  //-- Data & canvases are released with the window arena
 }
 byte accb_onfocus(void * x) {
   ACONTROLP   ctl = (ACONTROLP) x;
@@ -175,14 +172,13 @@ ACONTROLP accb(
   char title[128];
   snprintf(title, 128, "%s", textv);
   //-- Initializing Button Data
-  ACCBDP d = (ACCBDP) malloc(sizeof(ACCBD));
-  memset(d, 0, sizeof(ACCBD));
+  ACCBDP d = (ACCBDP) aw_alloc(win, sizeof(ACCBD));
   //-- Save Touch Message & Set Stats
   d->checked   = checked;
   d->focused   = 0;
   d->pushed    = 0;
   //-- Initializing Canvas
-  ag_canvas(&d->control, w, h);
+  aw_canvas(win, &d->control, w, h);
   //-- Draw Control Background
   ag_draw_ex(&d->control, &win->c, 0, 0, x, y, w, h);
   //-- Calculate Position & Size
@@ -200,7 +196,7 @@ ACONTROLP accb(
   ag_textf(&d->control, txtW, minpad + txtX, txtY, title, acfg()->textbg, 0);
   ag_text(&d->control, txtW, minpad + txtX - 1, txtY - 1, title, acfg()->textfg, 0);
   //-- Initializing Control
-  ACONTROLP ctl  = malloc(sizeof(ACONTROL));
+  ACONTROLP ctl  = aw_alloc(win, sizeof(ACONTROL));
   ctl->ondestroy = &accb_ondestroy;
   ctl->oninput  = &accb_oninput;
   ctl->ondraw   = &accb_ondraw;
@@ -78,21 +78,8 @@ typedef struct {
 void accheck_ondestroy(void * x) {
   ACONTROLP ctl = (ACONTROLP) x;
   ACCHECKDP d  = (ACCHECKDP) ctl->d;
-  ag_ccanvas(&d->control);
-  ag_ccanvas(&d->control_focused);
-  
-  if (d->itemn > 0) {
-    int i;
-    
-    for (i = 0; i < d->itemn; i++) {
-      free(d->items[i]);
-    }
-    
-    free(d->items);
-    ag_ccanvas(&d->client);
-  }
-  
-  free(ctl->d);
+  //-- Items live in the window arena, the client canvas is resized
+  ag_ccanvas(&d->client);
 }
 int accheck_itemcount(ACONTROLP ctl) {
   ACCHECKDP d = (ACCHECKDP) ctl->d;
@@ -172,9 +159,9 @@ void accheck_redrawitem(ACONTROLP ctl, int index) {
     if (index == d->touchedItem) {
       if (!atheme_draw("img.selection.push", c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2))) {
         color pshad = ag_calpushad(acfg()->selectbg_g);
-        dword hl1 = ag_calcpushlight(acfg()->selectbg, pshad);
+        colorpair hl1 = ag_calcpushlight(acfg()->selectbg, pshad);
         ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2), acfg()->selectbg, pshad, (agdp()*acfg()->roundsz));
-        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->roundsz));
+        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->roundsz));
       }
       
       graycolor = txtcolor = acfg()->selectfg;
@@ -182,9 +169,9 @@ void accheck_redrawitem(ACONTROLP ctl, int index) {
     }
     else if ((index == d->focusedItem) && (d->focused)) {
       if (!atheme_draw("img.selection", c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2))) {
-        dword hl1 = ag_calchighlight(acfg()->selectbg, acfg()->selectbg_g);
+        colorpair hl1 = ag_calchighlight(acfg()->selectbg, acfg()->selectbg_g);
         ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2), acfg()->selectbg, acfg()->selectbg_g, (agdp()*acfg()->roundsz));
-        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->roundsz));
+        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->roundsz));
       }
       
       graycolor = txtcolor = acfg()->selectfg;
@@ -307,7 +294,7 @@ byte accheck_add(ACONTROLP ctl, char * title, char * desc, byte checked) {
   }
   
   //-- Allocating Memory For Item Data
-  ACCHECKIP newip = (ACCHECKIP) malloc(sizeof(ACCHECKI));
+  ACCHECKIP newip = (ACCHECKIP) aw_alloc(ctl->win, sizeof(ACCHECKI));
   snprintf(newip->title, 64, "%s", title);
   snprintf(newip->desc, 128, "%s", desc);
   newip->th       = ag_txtheight(d->clientTextW, newip->title, 0);
@@ -328,22 +315,8 @@ byte accheck_add(ACONTROLP ctl, char * title, char * desc, byte checked) {
   newip->y        = d->nextY;
   d->nextY       += newip->h;
   
-  if (d->itemn > 0) {
-    int i;
-    ACCHECKIP * tmpitms   = d->items;
-    d->items              = malloc( sizeof(ACCHECKIP) * (d->itemn + 1) );
-    
-    for (i = 0; i < d->itemn; i++) {
-      d->items[i] = tmpitms[i];
-    }
-    
-    d->items[d->itemn] = newip;
-    free(tmpitms);
-  }
-  else {
-    d->items    = malloc(sizeof(ACCHECKIP));
-    d->items[0] = newip;
-  }
+  d->items = aw_grow(ctl->win, d->items, d->itemn, sizeof(ACCHECKIP));
+  d->items[d->itemn] = newip;
   
   d->itemn++;
   return 1;
@@ -361,7 +334,7 @@ byte accheck_addgroup(ACONTROLP ctl, char * title, char * desc) {
   }
   
   //-- Allocating Memory For Item Data
-  ACCHECKIP newip = (ACCHECKIP) malloc(sizeof(ACCHECKI));
+  ACCHECKIP newip = (ACCHECKIP) aw_alloc(ctl->win, sizeof(ACCHECKI));
   snprintf(newip->title, 64, "%s", title);
   snprintf(newip->desc, 128, "%s", desc);
   newip->th       = ag_txtheight(d->clientTextW + (agdp() * 14), newip->title, 0);
@@ -377,22 +350,8 @@ byte accheck_addgroup(ACONTROLP ctl, char * title, char * desc) {
   newip->y        = d->nextY;
   d->nextY       += newip->h;
   
-  if (d->itemn > 0) {
-    int i;
-    ACCHECKIP * tmpitms   = d->items;
-    d->items              = malloc( sizeof(ACCHECKIP) * (d->itemn + 1) );
-    
-    for (i = 0; i < d->itemn; i++) {
-      d->items[i] = tmpitms[i];
-    }
-    
-    d->items[d->itemn] = newip;
-    free(tmpitms);
-  }
-  else {
-    d->items    = malloc(sizeof(ACCHECKIP));
-    d->items[0] = newip;
-  }
+  d->items = aw_grow(ctl->win, d->items, d->itemn, sizeof(ACCHECKIP));
+  d->items[d->itemn] = newip;
   
   d->itemn++;
   return 1;
@@ -489,7 +448,7 @@ dword accheck_oninput(void * x, int action, ATEV * atev) {
   switch (action) {
     case ATEV_MOUSEDN: {
         d->prevTouchY  = atev->y;
-        akinetic_downhandler(&d->akin, atev->y);
+        akinetic_downhandler(&d->akin, atev->y, atev->t);
         int touchpos = atev->y - ctl->y + d->scrollY;
         int i;
         
@@ -541,7 +500,7 @@ dword accheck_oninput(void * x, int action, ATEV * atev) {
           }
         }
         else if (d->maxScrollY > 0) {
-          if (akinetic_uphandler(&d->akin, atev->y)) {
+          if (akinetic_uphandler(&d->akin, atev->y, atev->t)) {
             ac_regfling(ctl, &d->akin, &d->scrollY, d->maxScrollY);
           }
           else if ((d->scrollY < 0) || (d->scrollY > d->maxScrollY)) {
@@ -582,7 +541,7 @@ dword accheck_oninput(void * x, int action, ATEV * atev) {
           }
           
           if ((allowscroll) && (d->maxScrollY > 0)) {
-            int mv = akinetic_movehandler(&d->akin, atev->y);
+            int mv = akinetic_movehandler(&d->akin, atev->y, atev->t);
             
             if (mv != 0) {
               if ((d->scrollY < 0) && (mv < 0)) {
@@ -754,13 +713,12 @@ ACONTROLP accheck(
   }
   
   //-- Initializing Text Data
-  ACCHECKDP d        = (ACCHECKDP) malloc(sizeof(ACCHECKD));
-  memset(d, 0, sizeof(ACCHECKD));
+  ACCHECKDP d        = (ACCHECKDP) aw_alloc(win, sizeof(ACCHECKD));
   //-- Set Signature
   d->acheck_signature = 133;
   //-- Initializing Canvas
-  ag_canvas(&d->control, w, h);
-  ag_canvas(&d->control_focused, w, h);
+  aw_canvas(win, &d->control, w, h);
+  aw_canvas(win, &d->control_focused, w, h);
   int minpadding = 4; // max(acfg()->roundsz,4);
   //-- Initializing Client Size
   d->clientWidth  = w - (agdp() * minpadding * 2);
@@ -789,7 +747,7 @@ ACONTROLP accheck(
   d->draweditemn = 0;
   d->groupCounts   = 0;
   d->groupCurrId   = -1;
-  ACONTROLP ctl  = malloc(sizeof(ACONTROL));
+  ACONTROLP ctl  = aw_alloc(win, sizeof(ACONTROL));
   ctl->ondestroy = &accheck_ondestroy;
   ctl->oninput  = &accheck_oninput;
   ctl->ondraw   = &accheck_ondraw;
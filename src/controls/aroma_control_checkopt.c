@@ -81,21 +81,8 @@ typedef struct {
 void acchkopt_ondestroy(void * x) {
   ACONTROLP ctl = (ACONTROLP) x;
   ACCHKOPTDP d  = (ACCHKOPTDP) ctl->d;
-  ag_ccanvas(&d->control);
-  ag_ccanvas(&d->control_focused);
-  
-  if (d->itemn > 0) {
-    int i;
-    
-    for (i = 0; i < d->itemn; i++) {
-      free(d->items[i]);
-    }
-    
-    free(d->items);
-    ag_ccanvas(&d->client);
-  }
-  
-  free(ctl->d);
+  //-- Items live in the window arena, the client canvas is resized
+  ag_ccanvas(&d->client);
 }
 int acchkopt_itemcount(ACONTROLP ctl) {
   ACCHKOPTDP d = (ACCHKOPTDP) ctl->d;
@@ -210,9 +197,9 @@ void acchkopt_redrawitem(ACONTROLP ctl, int index) {
     if (index == d->touchedItem) {
       if (!atheme_draw("img.selection.push", c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2))) {
         color pshad = ag_calpushad(acfg()->selectbg_g);
-        dword hl1 = ag_calcpushlight(acfg()->selectbg, pshad);
+        colorpair hl1 = ag_calcpushlight(acfg()->selectbg, pshad);
         ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2), acfg()->selectbg, pshad, (agdp()*acfg()->roundsz));
-        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->roundsz));
+        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->roundsz));
       }
       
       graycolor = txtcolor = acfg()->selectfg;
@@ -220,9 +207,9 @@ void acchkopt_redrawitem(ACONTROLP ctl, int index) {
     }
     else if ((index == d->focusedItem) && (d->focused)) {
       if (!atheme_draw("img.selection", c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2))) {
-        dword hl1 = ag_calchighlight(acfg()->selectbg, acfg()->selectbg_g);
+        colorpair hl1 = ag_calchighlight(acfg()->selectbg, acfg()->selectbg_g);
         ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2), acfg()->selectbg, acfg()->selectbg_g, (agdp()*acfg()->roundsz));
-        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->roundsz));
+        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->roundsz));
       }
       
       graycolor = txtcolor = acfg()->selectfg;
@@ -403,7 +390,7 @@ byte acchkopt_add(ACONTROLP ctl, char * id, char * title, char * desc, byte chec
   }
   
   //-- Allocating Memory For Item Data
-  ACCHKOPTIP newip = (ACCHKOPTIP) malloc(sizeof(ACCHKOPTI));
+  ACCHKOPTIP newip = (ACCHKOPTIP) aw_alloc(ctl->win, sizeof(ACCHKOPTI));
   snprintf(newip->iid, 32, "%s", id);
   snprintf(newip->title, 64, "%s", title);
   snprintf(newip->desc, 128, "%s", desc);
@@ -430,22 +417,8 @@ byte acchkopt_add(ACONTROLP ctl, char * id, char * title, char * desc, byte chec
     d->selectedIndexs[newip->group] = newip->id;
   }
   
-  if (d->itemn > 0) {
-    int i;
-    ACCHKOPTIP * tmpitms   = d->items;
-    d->items              = malloc( sizeof(ACCHKOPTIP) * (d->itemn + 1) );
-    
-    for (i = 0; i < d->itemn; i++) {
-      d->items[i] = tmpitms[i];
-    }
-    
-    d->items[d->itemn] = newip;
-    free(tmpitms);
-  }
-  else {
-    d->items    = malloc(sizeof(ACCHKOPTIP));
-    d->items[0] = newip;
-  }
+  d->items = aw_grow(ctl->win, d->items, d->itemn, sizeof(ACCHKOPTIP));
+  d->items[d->itemn] = newip;
   
   d->itemn++;
   return 1;
@@ -463,7 +436,7 @@ byte acchkopt_addgroup(ACONTROLP ctl, char * id, char * title, char * desc) {
   }
   
   //-- Allocating Memory For Item Data
-  ACCHKOPTIP newip = (ACCHKOPTIP) malloc(sizeof(ACCHKOPTI));
+  ACCHKOPTIP newip = (ACCHKOPTIP) aw_alloc(ctl->win, sizeof(ACCHKOPTI));
   snprintf(newip->iid, 32, "%s", id);
   snprintf(newip->title, 64, "%s", title);
   snprintf(newip->desc, 128, "%s", desc);
@@ -480,22 +453,8 @@ byte acchkopt_addgroup(ACONTROLP ctl, char * id, char * title, char * desc) {
   newip->y        = d->nextY;
   d->nextY       += newip->h;
   
-  if (d->itemn > 0) {
-    int i;
-    ACCHKOPTIP * tmpitms   = d->items;
-    d->items              = malloc( sizeof(ACCHKOPTIP) * (d->itemn + 1) );
-    
-    for (i = 0; i < d->itemn; i++) {
-      d->items[i] = tmpitms[i];
-    }
-    
-    d->items[d->itemn] = newip;
-    free(tmpitms);
-  }
-  else {
-    d->items    = malloc(sizeof(ACCHKOPTIP));
-    d->items[0] = newip;
-  }
+  d->items = aw_grow(ctl->win, d->items, d->itemn, sizeof(ACCHKOPTIP));
+  d->items[d->itemn] = newip;
   
   d->itemn++;
   return 1;
@@ -592,7 +551,7 @@ dword acchkopt_oninput(void * x, int action, ATEV * atev) {
   switch (action) {
     case ATEV_MOUSEDN: {
         d->prevTouchY  = atev->y;
-        akinetic_downhandler(&d->akin, atev->y);
+        akinetic_downhandler(&d->akin, atev->y, atev->t);
         int touchpos = atev->y - ctl->y + d->scrollY;
         int i;
         
@@ -676,7 +635,7 @@ dword acchkopt_oninput(void * x, int action, ATEV * atev) {
           }
         }
         else if (d->maxScrollY > 0) {
-          if (akinetic_uphandler(&d->akin, atev->y)) {
+          if (akinetic_uphandler(&d->akin, atev->y, atev->t)) {
             ac_regfling(ctl, &d->akin, &d->scrollY, d->maxScrollY);
           }
           else if ((d->scrollY < 0) || (d->scrollY > d->maxScrollY)) {
@@ -717,7 +676,7 @@ dword acchkopt_oninput(void * x, int action, ATEV * atev) {
           }
           
           if ((allowscroll) && (d->maxScrollY > 0)) {
-            int mv = akinetic_movehandler(&d->akin, atev->y);
+            int mv = akinetic_movehandler(&d->akin, atev->y, atev->t);
             
             if (mv != 0) {
               if ((d->scrollY < 0) && (mv < 0)) {
@@ -906,13 +865,12 @@ ACONTROLP acchkopt(
   }
   
   //-- Initializing Text Data
-  ACCHKOPTDP d        = (ACCHKOPTDP) malloc(sizeof(ACCHKOPTD));
-  memset(d, 0, sizeof(ACCHKOPTD));
+  ACCHKOPTDP d        = (ACCHKOPTDP) aw_alloc(win, sizeof(ACCHKOPTD));
   //-- Set Signature
   d->acheck_signature = 215;
   //-- Initializing Canvas
-  ag_canvas(&d->control, w, h);
-  ag_canvas(&d->control_focused, w, h);
+  aw_canvas(win, &d->control, w, h);
+  aw_canvas(win, &d->control_focused, w, h);
   int minpadding = 4; // max(acfg()->roundsz,4);
   //-- Initializing Client Size
   d->clientWidth  = w - (agdp() * minpadding * 2);
@@ -947,7 +905,7 @@ ACONTROLP acchkopt(
   
   d->groupCounts   = 0;
   d->groupCurrId   = -1;
-  ACONTROLP ctl  = malloc(sizeof(ACONTROL));
+  ACONTROLP ctl  = aw_alloc(win, sizeof(ACONTROL));
   ctl->ondestroy = &acchkopt_ondestroy;
   ctl->oninput  = &acchkopt_oninput;
   ctl->ondraw   = &acchkopt_ondraw;
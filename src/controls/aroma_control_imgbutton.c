@@ -94,12 +94,7 @@ void imgbtn_ondraw(void * x) {
   }
 }
 void imgbtn_ondestroy(void * x) {
-  ACONTROLP   ctl = (ACONTROLP) x;
-  IMGBTNDP  d  = (IMGBTNDP) ctl->d;
-  ag_ccanvas(&d->control);
-  ag_ccanvas(&d->control_pushed);
-  ag_ccanvas(&d->control_focused);
-  free(ctl->d);
+  //-- Data & canvases are released with the window arena
 }
 byte imgbtn_onfocus(void * x) {
   ACONTROLP   ctl = (ACONTROLP) x;
@@ -215,20 +210,19 @@ ACONTROLP imgbtn_reinit(
     win = ctl->win;
   }
   else {
-    d = (IMGBTNDP) malloc(sizeof(IMGBTND));
-    memset(d, 0, sizeof(IMGBTND));
+    d = (IMGBTNDP) aw_alloc(win, sizeof(IMGBTND));
     //-- Save Touch Message & Set Stats
     d->focused   = 0;
     d->pushed    = 0;
     //-- Initializing Canvas
-    ag_canvas(&d->control, w, h);
-    ag_canvas(&d->control_pushed, w, h);
-    ag_canvas(&d->control_focused, w, h);
+    aw_canvas(win, &d->control, w, h);
+    aw_canvas(win, &d->control_pushed, w, h);
+    aw_canvas(win, &d->control_focused, w, h);
   }
   
   d->touchmsg  = touchmsg;
   //-- Draw Rest Control
-  dword hl1 = ag_calchighlight(acfg()->controlbg, acfg()->controlbg_g);
+  colorpair hl1 = ag_calchighlight(acfg()->controlbg, acfg()->controlbg_g);
   ag_draw_ex(&d->control, win->bg, 0, 0, x, y, w, h);
   
   if (!isflat) {
@@ -240,7 +234,7 @@ ACONTROLP imgbtn_reinit(
                    (agdp()*acfg()->btnroundsz) - 1
                   );
       ag_roundgrad(&d->control, 2, 2, w - 4, h - 4, acfg()->controlbg, acfg()->controlbg_g, (agdp()*acfg()->btnroundsz) - 2);
-      ag_roundgrad_ex(&d->control, 2, 2, w - 4, (h - 4) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->btnroundsz) - 2, 1, 1, 0, 0);
+      ag_roundgrad_ex(&d->control, 2, 2, w - 4, (h - 4) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->btnroundsz) - 2, 1, 1, 0, 0);
     }
   }
   
@@ -258,7 +252,7 @@ ACONTROLP imgbtn_reinit(
     if (!atheme_draw("img.button.push", &d->control_pushed, 0, 0, w, h)) {
       ag_roundgrad(&d->control_pushed, 0, 0, w, h, acfg()->border, acfg()->border_g, (agdp()*acfg()->btnroundsz));
       ag_roundgrad(&d->control_pushed, 1, 1, w - 2, h - 2, acfg()->selectbg, pshad, (agdp()*acfg()->btnroundsz) - 1);
-      ag_roundgrad_ex(&d->control_pushed, 1, 1, w - 2, (h - 2) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->btnroundsz) - 1, 1, 1, 0, 0);
+      ag_roundgrad_ex(&d->control_pushed, 1, 1, w - 2, (h - 2) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->btnroundsz) - 1, 1, 1, 0, 0);
     }
     
     ag_textf(&d->control_pushed, txtw, txtx + 1, txty + 1, vtext, acfg()->selectbg_g, 0);
@@ -270,7 +264,7 @@ ACONTROLP imgbtn_reinit(
     if (!atheme_draw("img.button", &d->control_pushed, 0, 0, w, h)) {
       ag_roundgrad(&d->control_pushed, wadd, wadd, w - wdel, h - wdel, acfg()->border, acfg()->border_g, (agdp()*acfg()->btnroundsz));
       ag_roundgrad(&d->control_pushed, wadd + 1, wadd + 1, w - (2 + wdel), h - (2 + wdel), acfg()->controlbg, acfg()->controlbg_g, (agdp()*acfg()->btnroundsz) - 1);
-      ag_roundgrad_ex(&d->control_pushed, wadd + 1, wadd + 1, w - (2 + wdel), (h - (1 + wdel)) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->btnroundsz) - 1, 1, 1, 0, 0);
+      ag_roundgrad_ex(&d->control_pushed, wadd + 1, wadd + 1, w - (2 + wdel), (h - (1 + wdel)) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->btnroundsz) - 1, 1, 1, 0, 0);
     }
     
     ag_textf(&d->control_pushed, txtw, txtx + 1, txty + 1, vtext, acfg()->controlbg, 0);
@@ -285,7 +279,7 @@ ACONTROLP imgbtn_reinit(
     if (!atheme_draw("img.button.focus", &d->control_focused, 0, 0, w, h)) {
       ag_roundgrad(&d->control_focused, wadd, wadd, w - wdel, h - wdel, acfg()->border, acfg()->border_g, (agdp()*acfg()->btnroundsz));
       ag_roundgrad(&d->control_focused, wadd + 1, wadd + 1, w - (wdel + 2), h - (wdel + 2), acfg()->selectbg, acfg()->selectbg_g, (agdp()*acfg()->btnroundsz) - 1);
-      ag_roundgrad_ex(&d->control_focused, wadd + 1, wadd + 1, w - (wdel + 2), (h - (wdel + 2)) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->btnroundsz) - 1, 1, 1, 0, 0);
+      ag_roundgrad_ex(&d->control_focused, wadd + 1, wadd + 1, w - (wdel + 2), (h - (wdel + 2)) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->btnroundsz) - 1, 1, 1, 0, 0);
     }
     
     ag_textf(&d->control_focused, txtw, txtx + 1, txty + 1, vtext, acfg()->selectbg_g, 0);
@@ -304,7 +298,7 @@ ACONTROLP imgbtn_reinit(
   
   //-- Initializing Control
   if (ctl == NULL) {
-    ctl  = malloc(sizeof(ACONTROL));
+    ctl  = aw_alloc(win, sizeof(ACONTROL));
     ctl->ondestroy = &imgbtn_ondestroy;
     ctl->oninput  = &imgbtn_oninput;
     ctl->ondraw   = &imgbtn_ondraw;
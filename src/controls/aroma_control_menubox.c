@@ -69,27 +69,16 @@ typedef struct {
 void acmenu_ondestroy(void * x) {
   ACONTROLP ctl = (ACONTROLP) x;
   ACMENUDP d  = (ACMENUDP) ctl->d;
-  ag_ccanvas(&d->control);
-  ag_ccanvas(&d->control_focused);
+  int i;
   
-  if (d->itemn > 0) {
-    int i;
-    
-    for (i = 0; i < d->itemn; i++) {
-      if (d->items[i]->img != NULL) {
-        apng_close(d->items[i]->img);
-        free(d->items[i]->img);
-        d->items[i]->img = NULL;
-      }
-      
-      free(d->items[i]);
+  //-- Items live in the window arena, icons & client canvas do not
+  for (i = 0; i < d->itemn; i++) {
+    if (d->items[i]->img != NULL) {
+      apng_close(d->items[i]->img);
     }
-    
-    free(d->items);
-    ag_ccanvas(&d->client);
   }
   
-  free(ctl->d);
+  ag_ccanvas(&d->client);
 }
 void acmenu_redrawitem(ACONTROLP ctl, int index) {
   ACMENUDP d = (ACMENUDP) ctl->d;
@@ -113,9 +102,9 @@ void acmenu_redrawitem(ACONTROLP ctl, int index) {
   if (index == d->touchedItem) {
     if (!atheme_draw("img.selection.push", c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2))) {
       color pshad = ag_calpushad(acfg()->selectbg_g);
-      dword hl1 = ag_calcpushlight(acfg()->selectbg, pshad);
+      colorpair hl1 = ag_calcpushlight(acfg()->selectbg, pshad);
       ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2), acfg()->selectbg, pshad, (agdp()*acfg()->roundsz));
-      ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->roundsz));
+      ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->roundsz));
     }
     
     graycolor = txtcolor = acfg()->selectfg;
@@ -123,9 +112,9 @@ void acmenu_redrawitem(ACONTROLP ctl, int index) {
   }
   else if ((index == d->focusedItem) && (d->focused)) {
     if (!atheme_draw("img.selection", c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2))) {
-      dword hl1 = ag_calchighlight(acfg()->selectbg, acfg()->selectbg_g);
+      colorpair hl1 = ag_calchighlight(acfg()->selectbg, acfg()->selectbg_g);
       ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2), acfg()->selectbg, acfg()->selectbg_g, (agdp()*acfg()->roundsz));
-      ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->roundsz));
+      ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->roundsz));
     }
     
     graycolor = txtcolor = acfg()->selectfg;
@@ -221,15 +210,20 @@ byte acmenu_add(ACONTROLP ctl, char * title, char * desc, char * img) {
   }
   
   //-- Allocating Memory For Item Data
-  ACMENUIP newip = (ACMENUIP) malloc(sizeof(ACMENUI));
-  snprintf(newip->title, 64, "%s", title);
+  ACMENUIP newip = (ACMENUIP) aw_alloc(ctl->win, sizeof(ACMENUI));
+  //-- Single line title, ellipsis at the end
+  char * titfit = ag_txtfit(title, d->clientTextW, 0, AG_ELLIPSIS_END, NULL);
+  snprintf(newip->title, 64, "%s", (titfit != NULL) ? titfit : title);
+  
+  if (titfit != NULL) {
+    free(titfit);
+  }
+  
   snprintf(newip->desc, 128, "%s", desc);
   //-- Load Image
-  newip->img      = (PNGCANVAS *) malloc(sizeof(PNGCANVAS));
-  memset(newip->img, 0, sizeof(PNGCANVAS));
+  newip->img      = (PNGCANVAS *) aw_alloc(ctl->win, sizeof(PNGCANVAS));
   
   if (!apng_load(newip->img, img)) {
-    free(newip->img);
     newip->img = NULL;
   }
   
@@ -247,22 +241,8 @@ byte acmenu_add(ACONTROLP ctl, char * title, char * desc, char * img) {
   newip->y        = d->nextY;
   d->nextY       += newip->h;
   
-  if (d->itemn > 0) {
-    int i;
-    ACMENUIP * tmpitms   = d->items;
-    d->items              = malloc( sizeof(ACMENUIP) * (d->itemn + 1) );
-    
-    for (i = 0; i < d->itemn; i++) {
-      d->items[i] = tmpitms[i];
-    }
-    
-    d->items[d->itemn] = newip;
-    free(tmpitms);
-  }
-  else {
-    d->items    = malloc(sizeof(ACMENUIP));
-    d->items[0] = newip;
-  }
+  d->items = aw_grow(ctl->win, d->items, d->itemn, sizeof(ACMENUIP));
+  d->items[d->itemn] = newip;
   
   d->itemn++;
   return 1;
@@ -358,7 +338,7 @@ dword acmenu_oninput(void * x, int action, ATEV * atev) {
   switch (action) {
     case ATEV_MOUSEDN: {
         d->prevTouchY  = atev->y;
-        akinetic_downhandler(&d->akin, atev->y);
+        akinetic_downhandler(&d->akin, atev->y, atev->t);
         int touchpos = atev->y - ctl->y + d->scrollY;
         int i;
         
@@ -419,7 +399,7 @@ dword acmenu_oninput(void * x, int action, ATEV * atev) {
           }
         }
         else if (d->maxScrollY > 0) {
-          if (akinetic_uphandler(&d->akin, atev->y)) {
+          if (akinetic_uphandler(&d->akin, atev->y, atev->t)) {
             ac_regfling(ctl, &d->akin, &d->scrollY, d->maxScrollY);
           }
           else if ((d->scrollY < 0) || (d->scrollY > d->maxScrollY)) {
@@ -460,7 +440,7 @@ dword acmenu_oninput(void * x, int action, ATEV * atev) {
           }
           
           if ((allowscroll) && (d->maxScrollY > 0)) {
-            int mv = akinetic_movehandler(&d->akin, atev->y);
+            int mv = akinetic_movehandler(&d->akin, atev->y, atev->t);
             
             if (mv != 0) {
               if ((d->scrollY < 0) && (mv < 0)) {
@@ -620,13 +600,12 @@ ACONTROLP acmenu(
   }
   
   //-- Initializing Text Data
-  ACMENUDP d        = (ACMENUDP) malloc(sizeof(ACMENUD));
-  memset(d, 0, sizeof(ACMENUD));
+  ACMENUDP d        = (ACMENUDP) aw_alloc(win, sizeof(ACMENUD));
   //-- Set Signature
   d->acheck_signature = 144;
   //-- Initializing Canvas
-  ag_canvas(&d->control, w, h);
-  ag_canvas(&d->control_focused, w, h);
+  aw_canvas(win, &d->control, w, h);
+  aw_canvas(win, &d->control_focused, w, h);
   int minpadding = 4; //max(acfg()->roundsz,4);
   //-- Initializing Client Size
   d->clientWidth  = w - (agdp() * minpadding * 2);
@@ -655,7 +634,7 @@ ACONTROLP acmenu(
   d->draweditemn = 0;
   d->selectedIndex = -1;
   d->touchmsg    = touchmsg;
-  ACONTROLP ctl  = malloc(sizeof(ACONTROL));
+  ACONTROLP ctl  = aw_alloc(win, sizeof(ACONTROL));
   ctl->ondestroy = &acmenu_ondestroy;
   ctl->oninput  = &acmenu_oninput;
   ctl->ondraw   = &acmenu_ondraw;
@@ -77,21 +77,8 @@ typedef struct {
 void acopt_ondestroy(void * x) {
   ACONTROLP ctl = (ACONTROLP) x;
   ACOPTDP d  = (ACOPTDP) ctl->d;
-  ag_ccanvas(&d->control);
-  ag_ccanvas(&d->control_focused);
-  
-  if (d->itemn > 0) {
-    int i;
-    
-    for (i = 0; i < d->itemn; i++) {
-      free(d->items[i]);
-    }
-    
-    free(d->items);
-    ag_ccanvas(&d->client);
-  }
-  
-  free(ctl->d);
+  //-- Items live in the window arena, the client canvas is resized
+  ag_ccanvas(&d->client);
 }
 void acopt_redrawitem(ACONTROLP ctl, int index) {
   ACOPTDP d = (ACOPTDP) ctl->d;
@@ -124,9 +111,9 @@ void acopt_redrawitem(ACONTROLP ctl, int index) {
     if (index == d->touchedItem) {
       if (!atheme_draw("img.selection.push", c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2))) {
         color pshad = ag_calpushad(acfg()->selectbg_g);
-        dword hl1 = ag_calcpushlight(acfg()->selectbg, pshad);
+        colorpair hl1 = ag_calcpushlight(acfg()->selectbg, pshad);
         ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2), acfg()->selectbg, pshad, (agdp()*acfg()->roundsz));
-        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->roundsz));
+        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->roundsz));
       }
       
       graycolor = txtcolor = acfg()->selectfg;
@@ -134,9 +121,9 @@ void acopt_redrawitem(ACONTROLP ctl, int index) {
     }
     else if ((index == d->focusedItem) && (d->focused)) {
       if (!atheme_draw("img.selection", c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2))) {
-        dword hl1 = ag_calchighlight(acfg()->selectbg, acfg()->selectbg_g);
+        colorpair hl1 = ag_calchighlight(acfg()->selectbg, acfg()->selectbg_g);
         ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, p->h - (agdp() * 2), acfg()->selectbg, acfg()->selectbg_g, (agdp()*acfg()->roundsz));
-        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, LOWORD(hl1), HIWORD(hl1), (agdp()*acfg()->roundsz));
+        ag_roundgrad(c, 0, p->y + agdp(), d->clientWidth, (p->h - (agdp() * 2)) / 2, ag_pairlo(hl1), ag_pairhi(hl1), (agdp()*acfg()->roundsz));
       }
       
       graycolor = txtcolor = acfg()->selectfg;
@@ -285,7 +272,7 @@ byte acopt_add(ACONTROLP ctl, char * title, char * desc, byte selected) {
   }
   
   //-- Allocating Memory For Item Data
-  ACOPTIP newip = (ACOPTIP) malloc(sizeof(ACOPTI));
+  ACOPTIP newip = (ACOPTIP) aw_alloc(ctl->win, sizeof(ACOPTI));
   snprintf(newip->title, 64, "%s", title);
   snprintf(newip->desc, 128, "%s", desc);
   newip->th       = ag_txtheight(d->clientTextW, newip->title, 0);
@@ -309,22 +296,8 @@ byte acopt_add(ACONTROLP ctl, char * title, char * desc, byte selected) {
     d->selectedIndexs[newip->group] = newip->id;
   }
   
-  if (d->itemn > 0) {
-    int i;
-    ACOPTIP * tmpitms   = d->items;
-    d->items              = malloc( sizeof(ACOPTIP) * (d->itemn + 1) );
-    
-    for (i = 0; i < d->itemn; i++) {
-      d->items[i] = tmpitms[i];
-    }
-    
-    d->items[d->itemn] = newip;
-    free(tmpitms);
-  }
-  else {
-    d->items    = malloc(sizeof(ACOPTIP));
-    d->items[0] = newip;
-  }
+  d->items = aw_grow(ctl->win, d->items, d->itemn, sizeof(ACOPTIP));
+  d->items[d->itemn] = newip;
   
   d->itemn++;
   return 1;
@@ -343,7 +316,7 @@ byte acopt_addgroup(ACONTROLP ctl, char * title, char * desc) {
   }
   
   //-- Allocating Memory For Item Data
-  ACOPTIP newip = (ACOPTIP) malloc(sizeof(ACOPTI));
+  ACOPTIP newip = (ACOPTIP) aw_alloc(ctl->win, sizeof(ACOPTI));
   snprintf(newip->title, 64, "%s", title);
   snprintf(newip->desc, 128, "%s", desc);
   newip->th       = ag_txtheight(d->clientTextW + (agdp() * 14), newip->title, 0);
@@ -359,22 +332,8 @@ byte acopt_addgroup(ACONTROLP ctl, char * title, char * desc) {
   newip->y        = d->nextY;
   d->nextY       += newip->h;
   
-  if (d->itemn > 0) {
-    int i;
-    ACOPTIP * tmpitms   = d->items;
-    d->items              = malloc( sizeof(ACOPTIP) * (d->itemn + 1) );
-    
-    for (i = 0; i < d->itemn; i++) {
-      d->items[i] = tmpitms[i];
-    }
-    
-    d->items[d->itemn] = newip;
-    free(tmpitms);
-  }
-  else {
-    d->items    = malloc(sizeof(ACOPTIP));
-    d->items[0] = newip;
-  }
+  d->items = aw_grow(ctl->win, d->items, d->itemn, sizeof(ACOPTIP));
+  d->items[d->itemn] = newip;
   
   d->itemn++;
   return 1;
@@ -473,7 +432,7 @@ dword acopt_oninput(void * x, int action, ATEV * atev) {
   switch (action) {
     case ATEV_MOUSEDN: {
         d->prevTouchY  = atev->y;
-        akinetic_downhandler(&d->akin, atev->y);
+        akinetic_downhandler(&d->akin, atev->y, atev->t);
         int touchpos = atev->y - ctl->y + d->scrollY;
         int i;
         
@@ -532,7 +491,7 @@ dword acopt_oninput(void * x, int action, ATEV * atev) {
           }
         }
         else if (d->maxScrollY > 0) {
-          if (akinetic_uphandler(&d->akin, atev->y)) {
+          if (akinetic_uphandler(&d->akin, atev->y, atev->t)) {
             ac_regfling(ctl, &d->akin, &d->scrollY, d->maxScrollY);
           }
           else if ((d->scrollY < 0) || (d->scrollY > d->maxScrollY)) {
@@ -573,7 +532,7 @@ dword acopt_oninput(void * x, int action, ATEV * atev) {
           }
           
           if ((allowscroll) && (d->maxScrollY > 0)) {
-            int mv = akinetic_movehandler(&d->akin, atev->y);
+            int mv = akinetic_movehandler(&d->akin, atev->y, atev->t);
             
             if (mv != 0) {
               if ((d->scrollY < 0) && (mv < 0)) {
@@ -753,13 +712,12 @@ ACONTROLP acopt(
   }
   
   //-- Initializing Text Data
-  ACOPTDP d        = (ACOPTDP) malloc(sizeof(ACOPTD));
-  memset(d, 0, sizeof(ACOPTD));
+  ACOPTDP d        = (ACOPTDP) aw_alloc(win, sizeof(ACOPTD));
   //-- Set Signature
   d->acheck_signature = 136;
   //-- Initializing Canvas
-  ag_canvas(&d->control, w, h);
-  ag_canvas(&d->control_focused, w, h);
+  aw_canvas(win, &d->control, w, h);
+  aw_canvas(win, &d->control_focused, w, h);
   /*
   printf("MEM control: %x\n",(long) d->control.data);
   printf("MEM control_focused: %x\n",(long) d->control_focused.data);
@@ -798,7 +756,7 @@ ACONTROLP acopt(
   
   d->groupCounts   = 0;
   d->groupCurrId   = -1;
-  ACONTROLP ctl  = malloc(sizeof(ACONTROL));
+  ACONTROLP ctl  = aw_alloc(win, sizeof(ACONTROL));
   ctl->ondestroy = &acopt_ondestroy;
   ctl->oninput  = &acopt_oninput;
   ctl->ondraw   = &acopt_ondraw;
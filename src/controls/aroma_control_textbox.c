@@ -24,6 +24,29 @@
 #include <aroma.h>
 
 /***************************[ TEXTBOX ]**************************/
+#define ACTEXT_LOG_MINLINES   256     // Initial Log Ring Size
+#define ACTEXT_LOG_MAXLINES   131072  // Oldest Lines Dropped After This
+#define ACTEXT_LOG_TILES      64      // Rendered Line Tiles Cache
+typedef struct {
+  char   *  txt;                      // Line Text
+  int       h;                        // Cached Layout Height
+  long      y;                        // Position Since First Line
+} ACTEXTLINE, * ACTEXTLINEP;
+typedef struct {
+  CANVAS    c;                        // Rendered Line
+  long      seq;                      // Line Sequence, -1 = Empty
+} ACTEXTTILE, * ACTEXTTILEP;
+typedef struct {
+  ACTEXTLINEP lines;                  // Line Ring
+  int       cap;
+  int       start;                    // Ring Index of Oldest Line
+  int       n;
+  long      seq;                      // Sequence of Oldest Line
+  long      end;                      // Position After Newest Line
+  int       w;                        // Layout Width
+  ACTEXTTILE tiles[ACTEXT_LOG_TILES];
+  pthread_mutex_t lock;
+} ACTEXTLOG, * ACTEXTLOGP;
 typedef struct {
   CANVAS    client;
   CANVAS    control_focused;
@@ -37,7 +60,162 @@ typedef struct {
   int       appendPos;
   byte      forceGlowTop;
   byte      isFixedText;
+  ACTEXTLOGP log;
 } ACTEXTD, * ACTEXTDP;
+
+//-- Log Line by Logical Index
+static ACTEXTLINEP actext_logline(ACTEXTLOGP l, int i) {
+  return &l->lines[(l->start + i) % l->cap];
+}
+//-- Log Content Height
+static int actext_logheight(ACTEXTLOGP l) {
+  if (l->n == 0) {
+    return 0;
+  }
+  
+  return (int) (l->end - actext_logline(l, 0)->y);
+}
+//-- Rendered Tile of Logical Line, NULL if Empty
+static CANVAS * actext_logtile(ACTEXTDP d, int i) {
+  ACTEXTLOGP  l   = d->log;
+  ACTEXTLINEP ln  = actext_logline(l, i);
+  long        seq = l->seq + i;
+  ACTEXTTILEP t   = &l->tiles[seq % ACTEXT_LOG_TILES];
+  
+  if (ln->h <= 0) {
+    return NULL;
+  }
+  
+  if (t->seq != seq) {
+    if ((t->c.data == NULL) || (t->c.w != l->w) || (t->c.h != ln->h)) {
+      ag_ccanvas(&t->c);
+      ag_canvas(&t->c, l->w, ln->h);
+    }
+    
+    ag_rect(&t->c, 0, 0, l->w, ln->h, acfg()->textbg);
+    ag_text(&t->c, l->w, 0, 0, ln->txt, acfg()->textfg, d->isbigtxt);
+    t->seq = seq;
+  }
+  
+  return &t->c;
+}
+//-- Draw Visible Log Lines into Viewport
+static void actext_drawlog(ACTEXTDP d, CANVAS * pc, int dx, int dy, int sy, int vw, int vh) {
+  ACTEXTLOGP l   = d->log;
+  int        pad = agdp() * 4;
+  pthread_mutex_lock(&l->lock);
+  
+  if (l->n == 0) {
+    pthread_mutex_unlock(&l->lock);
+    return;
+  }
+  
+  //-- Find first line ending below viewport top
+  long base = actext_logline(l, 0)->y;
+  long top  = base + sy - pad;
+  int  lo   = 0;
+  int  hi   = l->n - 1;
+  
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    ACTEXTLINEP ln = actext_logline(l, mid);
+    
+    if (ln->y + ln->h <= top) {
+      lo = mid + 1;
+    }
+    else {
+      hi = mid;
+    }
+  }
+  
+  int i;
+  
+  for (i = lo; i < l->n; i++) {
+    ACTEXTLINEP ln = actext_logline(l, i);
+    int ly = (int) (ln->y - base) + pad;
+    
+    if (ly >= sy + vh) {
+      break;
+    }
+    
+    CANVAS * t = actext_logtile(d, i);
+    
+    if (t == NULL) {
+      continue;
+    }
+    
+    int srcy = (ly < sy) ? (sy - ly) : 0;
+    int srch = min(ln->h, sy + vh - ly) - srcy;
+    ag_draw_ex(pc, t, dx, dy + ly + srcy - sy, 0, srcy, vw, srch);
+  }
+  
+  pthread_mutex_unlock(&l->lock);
+}
+//-- Update Scroll Range after Log Change
+static void actext_logscroll(ACONTROLP ctl, byte toBottom) {
+  ACTEXTDP d   = (ACTEXTDP) ctl->d;
+  int      pad = agdp() * 4;
+  d->maxScrollY = actext_logheight(d->log) + (pad * 2) - (ctl->h - pad);
+  
+  if (d->maxScrollY < 0) {
+    d->maxScrollY = 0;
+  }
+  
+  if (toBottom) {
+    d->scrollY = d->maxScrollY;
+  }
+}
+//-- Layout All Lines for New Width
+static void actext_logrelayout(ACTEXTDP d, int w) {
+  ACTEXTLOGP l = d->log;
+  int i;
+  long y = (l->n > 0) ? actext_logline(l, 0)->y : 0;
+  
+  for (i = 0; i < l->n; i++) {
+    ACTEXTLINEP ln = actext_logline(l, i);
+    ln->h = ag_txtheight(w, ln->txt, d->isbigtxt);
+    ln->y = y;
+    y    += ln->h;
+  }
+  
+  for (i = 0; i < ACTEXT_LOG_TILES; i++) {
+    ag_ccanvas(&l->tiles[i].c);
+    l->tiles[i].seq = -1;
+  }
+  
+  l->end = y;
+  l->w   = w;
+}
+static ACTEXTLOGP actext_logcreate(int w) {
+  ACTEXTLOGP l = (ACTEXTLOGP) malloc(sizeof(ACTEXTLOG));
+  memset(l, 0, sizeof(ACTEXTLOG));
+  l->cap   = ACTEXT_LOG_MINLINES;
+  l->lines = (ACTEXTLINEP) malloc(sizeof(ACTEXTLINE) * l->cap);
+  l->w     = w;
+  int i;
+  
+  for (i = 0; i < ACTEXT_LOG_TILES; i++) {
+    l->tiles[i].seq = -1;
+  }
+  
+  pthread_mutex_init(&l->lock, NULL);
+  return l;
+}
+static void actext_logfree(ACTEXTLOGP l) {
+  int i;
+  
+  for (i = 0; i < l->n; i++) {
+    free(actext_logline(l, i)->txt);
+  }
+  
+  for (i = 0; i < ACTEXT_LOG_TILES; i++) {
+    ag_ccanvas(&l->tiles[i].c);
+  }
+  
+  pthread_mutex_destroy(&l->lock);
+  free(l->lines);
+  free(l);
+}
 dword actext_oninput(void * x, int action, ATEV * atev) {
   ACONTROLP ctl = (ACONTROLP) x;
   ACTEXTDP  d  = (ACTEXTDP) ctl->d;
@@ -50,13 +228,13 @@ dword actext_oninput(void * x, int action, ATEV * atev) {
   
   switch (action) {
     case ATEV_MOUSEDN: {
-        akinetic_downhandler(&d->akin, atev->y);
+        akinetic_downhandler(&d->akin, atev->y, atev->t);
       }
       break;
       
     case ATEV_MOUSEUP: {
         if (d->maxScrollY > 0) {
-          if (akinetic_uphandler(&d->akin, atev->y)) {
+          if (akinetic_uphandler(&d->akin, atev->y, atev->t)) {
             ac_regfling(ctl, &d->akin, &d->scrollY, d->maxScrollY);
           }
           else if ((d->scrollY < 0) || (d->scrollY > d->maxScrollY)) {
@@ -69,7 +247,7 @@ dword actext_oninput(void * x, int action, ATEV * atev) {
     case ATEV_MOUSEMV: {
         if (atev->y != 0) {
           if (d->maxScrollY > 0) {
-            int mv = akinetic_movehandler(&d->akin, atev->y);
+            int mv = akinetic_movehandler(&d->akin, atev->y, atev->t);
             
             if (mv != 0) {
               if ((d->scrollY < 0) && (mv < 0)) {
@@ -157,13 +335,27 @@ void actext_ondraw(void * x) {
   int agdp6 = (agdp() * (minpadding * 2));
   int agdpX = agdp6;
   
+  int contentH = (d->log != NULL) ? actext_logheight(d->log) + agdp6 : d->client.h;
+  
   if ((d->focused) && (!d->isFixedText)) {
     ag_draw(pc, &d->control_focused, ctl->x, ctl->y);
-    ag_draw_ex(pc, &d->client, ctl->x + agdp3, ctl->y + agdp(), 0, d->scrollY + agdp(), ctl->w - agdp6, ctl->h - (agdp() * 2));
+    
+    if (d->log != NULL) {
+      actext_drawlog(d, pc, ctl->x + agdp3, ctl->y + agdp(), d->scrollY + agdp(), ctl->w - agdp6, ctl->h - (agdp() * 2));
+    }
+    else {
+      ag_draw_ex(pc, &d->client, ctl->x + agdp3, ctl->y + agdp(), 0, d->scrollY + agdp(), ctl->w - agdp6, ctl->h - (agdp() * 2));
+    }
   }
   else {
     ag_draw(pc, &d->control, ctl->x, ctl->y);
-    ag_draw_ex(pc, &d->client, ctl->x + agdp3, ctl->y + 1, 0, d->scrollY + 1, ctl->w - agdp6, ctl->h - 2);
+    
+    if (d->log != NULL) {
+      actext_drawlog(d, pc, ctl->x + agdp3, ctl->y + 1, d->scrollY + 1, ctl->w - agdp6, ctl->h - 2);
+    }
+    else {
+      ag_draw_ex(pc, &d->client, ctl->x + agdp3, ctl->y + 1, 0, d->scrollY + 1, ctl->w - agdp6, ctl->h - 2);
+    }
   }
   
   if ((d->maxScrollY > 0) || (d->forceGlowTop)) {
@@ -197,7 +389,7 @@ void actext_ondraw(void * x) {
     if (d->maxScrollY > 0) {
       //-- Scrollbar
       int newh = ctl->h - agdp() * 3;
-      float scrdif    = ((float) newh) / ((float) d->client.h);
+      float scrdif    = ((float) newh) / ((float) contentH);
       int  scrollbarH = floor(scrdif * newh);
       int  scrollbarY = floor(scrdif * d->scrollY) + agdp();
       
@@ -230,10 +422,12 @@ void actext_ondraw(void * x) {
 void actext_ondestroy(void * x) {
   ACONTROLP ctl = (ACONTROLP) x;
   ACTEXTDP  d  = (ACTEXTDP) ctl->d;
-  ag_ccanvas(&d->control);
-  ag_ccanvas(&d->control_focused);
   ag_ccanvas(&d->client);
-  free(ctl->d);
+  
+  if (d->log != NULL) {
+    actext_logfree(d->log);
+  }
+  
 }
 byte actext_onfocus(void * x) {
   ACONTROLP   ctl = (ACONTROLP) x;
@@ -248,68 +442,125 @@ void actext_onblur(void * x) {
   d->focused = 0;
   ctl->ondraw(ctl);
 }
-void actext_appendtxt(ACONTROLP ctl, char * txt) {
+//-- Append lines to the log, redraws the control once
+void actext_appendlines(ACONTROLP ctl, char ** txt, int n) {
   ACTEXTDP   d  = (ACTEXTDP) ctl->d;
-  int ch          = ag_txtheight(d->client.w, txt, d->isbigtxt);
-  int canvas_h    = d->client.h;
+  ACTEXTLOGP l  = d->log;
+  int i;
   
-  if ((d->appendPos + ch) >= canvas_h) {
-    int step_up = (d->appendPos + ch) - canvas_h;
-    int y;
-    int ynew = 0;
+  if ((l == NULL) || (n < 1)) {
+    return;
+  }
+  
+  for (i = 0; i < n; i++) {
+    //-- Layout once, outside the lock
+    int  ch     = ag_txtheight(l->w, txt[i], d->isbigtxt);
+    char * line = strdup(txt[i]);
+    pthread_mutex_lock(&l->lock);
+    byte follow = (d->scrollY >= d->maxScrollY) ? 1 : 0;
     
-    for (y = step_up; y < canvas_h; y++) {
-      color * rowdest = agxy(&d->client, 0, ynew++);
-      color * rowsrc  = agxy(&d->client, 0, y);
-      memcpy(rowdest, rowsrc, sizeof(color)*d->client.w);
+    if (l->n == l->cap) {
+      if (l->cap < ACTEXT_LOG_MAXLINES) {
+        //-- Ring is never wrapped before reaching maximum size
+        l->cap  *= 2;
+        l->lines = (ACTEXTLINEP) realloc(l->lines, sizeof(ACTEXTLINE) * l->cap);
+      }
+      else {
+        //-- Drop oldest line, keep view on the same content
+        ACTEXTLINEP old = actext_logline(l, 0);
+        d->scrollY -= old->h;
+        
+        if (d->scrollY < 0) {
+          d->scrollY = 0;
+        }
+        
+        free(old->txt);
+        l->start = (l->start + 1) % l->cap;
+        l->seq++;
+        l->n--;
+      }
     }
     
-    d->appendPos -= step_up;
+    ACTEXTLINEP ln = actext_logline(l, l->n);
+    ln->txt = line;
+    ln->h   = ch;
+    ln->y   = l->end;
+    l->end += ch;
+    l->n++;
+    actext_logscroll(ctl, follow);
+    pthread_mutex_unlock(&l->lock);
   }
   
-  ag_rect(&d->client, 0, d->appendPos, d->client.w, ch, acfg()->textbg);
-  ag_text(&d->client,
-          d->client.w,
-          0, d->appendPos,
-          txt,
-          acfg()->textfg,
-          d->isbigtxt);
-  d->appendPos += ch;
-  /*
-  int minpadding = max(acfg()->roundsz,4);
-  int ch        = ag_txtheight(d->client.w,txt,d->isbigtxt);
-  int my        = d->client.h-(agdp()*2); // -(agdp()*(minpadding*2));
-  if ((d->appendPos+ch)>=my){
-    if (d->appendPos<my){
-      ch-=(my-d->appendPos);
-    }
-    int y; int ynew=0;
-    for (y=ch;y<d->client.h;y++){
-      color * rowdest = agxy(&d->client,0,ynew++);
-      color * rowsrc  = agxy(&d->client,0,y);
-      memcpy(rowdest,rowsrc,sizeof(color)*d->client.w);
-    }
-    int ypos = my-ch;
-    ag_rect(&d->client,0,ypos,d->client.w,ch,acfg()->textbg);
-    ag_text(&d->client,
-      d->client.w,
-      0,ypos,
-      txt,
-      acfg()->textfg,
-      d->isbigtxt);
-    d->forceGlowTop=1;
-    d->appendPos=my;
-  }
-  else{
-    ag_text(&d->client,
-      d->client.w,
-      0,d->appendPos,
-      txt,
-      acfg()->textfg,
-      d->isbigtxt);
-    d->appendPos+=ch;
+  ctl->ondraw(ctl);
+}
+void actext_appendtxt(ACONTROLP ctl, char * txt) {
+  ACTEXTDP d = (ACTEXTDP) ctl->d;
+  
+  if (d->log == NULL) {
+    return;
   }
-  */
+  
+  actext_appendlines(ctl, &txt, 1);
+  aw_draw(ctl->win);
+}
+//-- Frame canvases are window arena memory, reused when size is unchanged
+static void actext_frames(ACONTROLP ctl, CANVAS * control, CANVAS * focused, int w, int h) {
+  if ((control->data == NULL) || (control->w != w) || (control->h != h)) {
+    aw_canvas(ctl->win, control, w, h);
+    aw_canvas(ctl->win, focused, w, h);
+  }
+}
+void actext_logrebuild(
+  ACONTROLP ctl,
+  int x,
+  int y,
+  int w,
+  int h,
+  byte toBottom
+) {
+  ACTEXTDP  d  = (ACTEXTDP) ctl->d;
+  int minpadding = 4;
+  
+  if (d->log == NULL) {
+    return;
+  }
+  
+  //-- Validate Minimum Size
+  if (h < agdp() * 16) {
+    h = agdp() * 16;
+  }
+  
+  if (w < agdp() * 16) {
+    w = agdp() * 16;
+  }
+  
+  //-- Rebuild Control Frames on new position
+  actext_frames(ctl, &d->control, &d->control_focused, w, h);
+  ag_draw_ex(&d->control, ctl->win->bg, 0, 0, x, y, w, h);
+  ag_rect(&d->control, 0, 0, w, h, acfg()->border);
+  ag_rect(&d->control, 0, 1, w, h - 2, acfg()->textbg);
+  ag_draw_ex(&d->control_focused, ctl->win->bg, 0, 0, x, y, w, h);
+  ag_rect(&d->control_focused, 0, 0, w, h, acfg()->selectbg);
+  ag_rect(&d->control_focused, 0, 1, w, h - 2, acfg()->textbg);
+  ctl->x        = x;
+  ctl->y        = y;
+  ctl->w        = w;
+  ctl->h        = h;
+  ctl->forceNS  = 0;
+  pthread_mutex_lock(&d->log->lock);
+  int cw        = w - (agdp() * (minpadding * 2));
+  
+  if (cw != d->log->w) {
+    actext_logrelayout(d, cw);
+  }
+  
+  d->targetY      = 0;
+  d->focused      = 0;
+  d->scrollY      = 0;
+  d->forceGlowTop = 0;
+  d->isFixedText  = 0;
+  actext_logscroll(ctl, toBottom);
+  pthread_mutex_unlock(&d->log->lock);
   ctl->ondraw(ctl);
   aw_draw(ctl->win);
 }
@@ -325,10 +576,15 @@ void actext_rebuild(
 ) {
   ACTEXTDP  d  = (ACTEXTDP) ctl->d;
   int minpadding = 4; // max(acfg()->roundsz,4);
-  //-- Cleanup
-  ag_ccanvas(&d->control);
-  ag_ccanvas(&d->control_focused);
+  //-- Cleanup, control canvases stay in the window arena
+  CANVAS control          = d->control;
+  CANVAS control_focused  = d->control_focused;
   ag_ccanvas(&d->client);
+  
+  if (d->log != NULL) {
+    actext_logfree(d->log);
+  }
+  
   memset(d, 0, sizeof(ACTEXTD));
   
   //-- Rebuild
@@ -353,8 +609,9 @@ void actext_rebuild(
   }
   
   //-- Initializing Canvas
-  ag_canvas(&d->control, w, h);
-  ag_canvas(&d->control_focused, w, h);
+  d->control          = control;
+  d->control_focused  = control_focused;
+  actext_frames(ctl, &d->control, &d->control_focused, w, h);
   ag_canvas(&d->client, cw, ch);
   /*
   //-- Draw Control
@@ -446,12 +703,19 @@ ACONTROLP actext(
   }
   
   //-- Initializing Text Data
-  ACTEXTDP d        = (ACTEXTDP) malloc(sizeof(ACTEXTD));
-  memset(d, 0, sizeof(ACTEXTD));
+  ACTEXTDP d        = (ACTEXTDP) aw_alloc(win, sizeof(ACTEXTD));
   //-- Initializing Canvas
-  ag_canvas(&d->control, w, h);
-  ag_canvas(&d->control_focused, w, h);
-  ag_canvas(&d->client, cw, ch);
+  aw_canvas(win, &d->control, w, h);
+  aw_canvas(win, &d->control_focused, w, h);
+  
+  if (text != NULL) {
+    ag_canvas(&d->client, cw, ch);
+  }
+  else {
+    //-- Appendable Log, lines are rendered per visible tile
+    d->log = actext_logcreate(cw);
+  }
+
   //-- Draw Control
   ag_draw_ex(&d->control, &win->c, 0, 0, x, y, w, h);
   ag_rect(&d->control, 0, 0, w, h, acfg()->border);
@@ -460,10 +724,10 @@ ACONTROLP actext(
   ag_draw_ex(&d->control_focused, &win->c, 0, 0, x, y, w, h);
   ag_rect(&d->control_focused, 0, 0, w, h, acfg()->selectbg);
   ag_rect(&d->control_focused, 0, 1, w, h - 2, acfg()->textbg);
-  //-- Draw Client
-  ag_rect(&d->client, 0, 0, cw, ch, acfg()->textbg);
   
   if (text != NULL) {
+    //-- Draw Client
+    ag_rect(&d->client, 0, 0, cw, ch, acfg()->textbg);
     ag_text(&d->client, cw, 0, agdp()*minpadding, text, acfg()->textfg, isbig);
   }
   
@@ -487,7 +751,7 @@ ACONTROLP actext(
     d->maxScrollY = 0;
   }
   
-  ACONTROLP ctl  = malloc(sizeof(ACONTROL));
+  ACONTROLP ctl  = aw_alloc(win, sizeof(ACONTROL));
   ctl->ondestroy = &actext_ondestroy;
   ctl->oninput  = &actext_oninput;
   ctl->ondraw   = &actext_ondraw;
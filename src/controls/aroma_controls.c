@@ -259,15 +259,18 @@ char * atheme_key(int id) {
 AWINDOWP aw(CANVAS * bg) {
   ag_setbusy();
   //sleep(4);
-  //-- Create Window
-  AWINDOWP win = (AWINDOWP) malloc(sizeof(AWINDOW));
+  //-- Create Window, it lives in its own arena
+  AARENA arena;
+  aarena_init(&arena);
+  AWINDOWP win = (AWINDOWP) aarena_alloc(&arena, sizeof(AWINDOW));
   
   if (win == NULL) {
     return NULL;
   }
   
+  win->arena        = arena;
   //-- Create Canvas & Draw BG
-  ag_canvas(&win->c, agw(), agh());
+  aw_canvas(win, &win->c, agw(), agh());
   ag_draw(&win->c, bg, 0, 0);
   //-- Initializing Variables
   win->bg           = bg;
@@ -299,44 +302,53 @@ void aw_destroy(AWINDOWP win) {
     }
   }
   
-  //-- Cleanup Controls
+  //-- Controls release what they keep outside the arena
   if (win->controln > 0) {
     int i;
     ACONTROLP * controls = (ACONTROLP *) win->controls;
     
     for (i = win->controln - 1; i >= 0; i--) {
       controls[i]->ondestroy((void *) controls[i]);
-      free(controls[i]);
     }
-    
-    free(win->controls);
   }
   
-  //-- Cleanup Window
-  ag_ccanvas(&win->c);
-  free(win);
+  //-- Window, controls, items & canvases in one go
+  AARENA arena = win->arena;
+  aarena_free(&arena);
 }
 
-//-- Add Control Into Window
-void aw_add(AWINDOWP win, ACONTROLP ctl) {
-  if (win->controln > 0) {
-    int i;
-    void ** tmpctls   = win->controls;
-    win->controls     = malloc( sizeof(ACONTROLP) * (win->controln + 1) );
-    
-    for (i = 0; i < win->controln; i++) {
-      win->controls[i] = tmpctls[i];
-    }
-    
-    win->controls[win->controln] = (void *) ctl;
-    free(tmpctls);
+//-- Page memory, zeroed & released by aw_destroy
+void * aw_alloc(AWINDOWP win, size_t size) {
+  return aarena_alloc(&win->arena, size);
+}
+
+//-- Canvas released by aw_destroy, never call ag_ccanvas on it
+void aw_canvas(AWINDOWP win, CANVAS * c, int w, int h) {
+  c->w      = w;
+  c->h      = h;
+  c->sz     = (w * h * sizeof(color));
+  c->data   = (color *) aw_alloc(win, c->sz);
+}
+
+//-- Array of n items with room for one more, capacity doubles
+void * aw_grow(AWINDOWP win, void * list, int n, size_t elsz) {
+  if ((n >= 4) ? (n & (n - 1)) : (n > 0)) {
+    return list;
   }
-  else {
-    win->controls    = malloc(sizeof(ACONTROLP));
-    win->controls[0] = (void *) ctl;
+  
+  void * nl = aw_alloc(win, (n ? n * 2 : 4) * elsz);
+  
+  if (n > 0) {
+    memcpy(nl, list, n * elsz);
   }
   
-  win->controln++;
+  return nl;
+}
+
+//-- Add Control Into Window
+void aw_add(AWINDOWP win, ACONTROLP ctl) {
+  win->controls = aw_grow(win, win->controls, win->controln, sizeof(ACONTROLP));
+  win->controls[win->controln++] = (void *) ctl;
 }
 
 //-- Draw Window
@@ -376,8 +388,65 @@ void aw_redraw(AWINDOWP win) {
   aw_redraw_ex(win, 1);
 }
 
+//-- Window Transition Layers, fg is the moving layer, bg the one it covers
+typedef struct {
+  CANVAS * fg;
+  CANVAS * bg;
+  int x, y, w, h;
+  byte reverse;
+} AW_ANI;
+
+static void aw_ani_bottomtop(void * data, CANVAS * frm, int p) {
+  AW_ANI * a = (AW_ANI *) data;
+  ag_draw_ex(NULL, a->fg, 0, agh() - ((a->h * p) / 255), 0, a->y, a->w, a->h);
+}
+
+static void aw_ani_slide(void * data, CANVAS * frm, int p) {
+  AW_ANI * a  = (AW_ANI *) data;
+  int dir     = a->reverse ? -1 : 1;
+  int off     = (agw() * p) / 255;
+  ag_draw_ex(NULL, a->bg, 0 - (dir * off), a->y, 0, a->y, agw(), a->h);
+  ag_draw_ex(NULL, a->fg, dir * (agw() - off), a->y, 0, a->y, agw(), a->h);
+}
+
+static void aw_ani_scale(void * data, CANVAS * frm, int p) {
+  AW_ANI * a  = (AW_ANI *) data;
+  byte scale  = a->reverse ? 0xff - p : p;
+  scale = (scale * (0x200 - scale)) >> 8;
+  byte scale2 = ((scale * 0x80) >> 8) + 0x80;
+  int wtarget = (a->w * scale2) >> 8;
+  int htarget = (a->h * scale2) >> 8;
+  ag_draw_ex(frm, a->bg, 0, 0, a->x, a->y, a->w, a->h);
+  ag_draw_strecth_ex(
+    frm,
+    a->fg,
+    (a->w - wtarget) / 2, (a->h - htarget) / 2, wtarget, htarget,
+    a->x, a->y, a->w, a->h, scale, 1
+  );
+  ag_draw(NULL, frm, a->x, a->y);
+}
+
+static void aw_ani_stack(void * data, CANVAS * frm, int p) {
+  AW_ANI * a  = (AW_ANI *) data;
+  byte scale  = a->reverse ? 0xff - p : p;
+  byte scale2 = ((scale * 0x80) >> 8) + 0x80;
+  int wtarget = (a->w * scale2) >> 8;
+  int htarget = (a->h * scale2) >> 8;
+  int xtarget = (a->w * scale) >> 8;
+  ag_blank(frm);
+  ag_draw_strecth_ex(
+    frm,
+    a->fg,
+    a->w - wtarget, (a->h - htarget) / 2, wtarget, htarget,
+    a->x, a->y, a->w, a->h, scale, 0
+  );
+  ag_draw_ex(frm, a->bg, 0, 0, a->x + xtarget, a->y, a->w - xtarget, a->h);
+  ag_draw(NULL, frm, a->x, a->y);
+}
+
 //-- Show Window
 void aw_show_ex2(AWINDOWP win, byte anitype, int x, int pos, int w, int h, ACONTROLP firstFocus) {
+  ATRACE_SCOPE("aw_show_ex2");
   win->threadnum    = 0;
   win->isActived    = 1;
   
@@ -423,180 +492,40 @@ void aw_show_ex2(AWINDOWP win, byte anitype, int x, int pos, int w, int h, ACONT
     else if (anitype == 1) {
       //-- Bottom Top
       aw_redraw_ex(win, 0);
-      int drawh  = agh() - pos;
-      int anisz = floor(((float) drawh) / acfg()->fadeframes);
-      int i;
-      
-      for (i = 1; i <= acfg()->fadeframes; i++) {
-        ag_draw_ex(NULL, &win->c, 0, agh() - (anisz * i), 0, pos, agw(), drawh);
-        ag_sync();
-      }
-      
-      ag_draw(NULL, &win->c, 0, 0);
-      ag_sync();
-    }
-    else if (anitype == 2) {
-      //-- Right Left
-      aw_redraw_ex(win, 0);
-      int drawh  = agh() - pos;
-      int anisz = floor(((float) agw()) / acfg()->fadeframes);
-      int i;
-      CANVAS cbg;
-      ag_canvas(&cbg, agw(), agh());
-      ag_draw(&cbg, agc(), 0, 0);
-      
-      for (i = 1; i <= acfg()->fadeframes; i++) {
-        ag_draw_ex(NULL, &cbg, 0 - (anisz * i), pos, 0, pos, agw(), drawh);
-        ag_draw_ex(NULL, &win->c, agw() - (anisz * i), pos, 0, pos, agw(), drawh);
-        ag_sync();
-      }
-      
-      ag_ccanvas(&cbg);
-      ag_draw(NULL, &win->c, 0, 0);
-      ag_sync();
-    }
-    else if (anitype == 3) {
-      //-- Left Right
-      aw_redraw_ex(win, 0);
-      int drawh  = agh() - pos;
-      int anisz = floor(((float) agw()) / acfg()->fadeframes);
-      int i;
-      CANVAS cbg;
-      ag_canvas(&cbg, agw(), agh());
-      ag_draw(&cbg, agc(), 0, 0);
-      
-      for (i = 1; i <= acfg()->fadeframes; i++) {
-        ag_draw_ex(NULL, &cbg, (anisz * i), pos, 0, pos, agw(), drawh);
-        ag_draw_ex(NULL, &win->c, 0 - (agw() - (anisz * i)), pos, 0, pos, agw(), drawh);
-        ag_sync();
-      }
-      
-      ag_ccanvas(&cbg);
-      ag_draw(NULL, &win->c, 0, 0);
-      ag_sync();
-    }
-    else if (anitype == 5) {
-      //-- Scale
-      byte fadesz = acfg()->fadeframes;
-      ag_sync();
-      aw_redraw_ex(win, 0);
-      CANVAS cbg;
-      ag_canvas(&cbg, agw(), agh());
-      ag_draw(&cbg, agc(), 0, 0);
-      int xc = w / 2;
-      int yc = h / 2;
-      int i;
-      CANVAS * tmpb = (CANVAS *) malloc(sizeof(CANVAS) * fadesz);
-      memset(tmpb, 0, sizeof(CANVAS)*fadesz);
-      
-      for (i = 1; i <= fadesz; i++) {
-        /* Calculating Scale */
-        byte scale  = (i * 0xff) / fadesz;
-        scale = (scale * (0x200 - scale)) >> 8;
-        byte scale2 = ((scale * 0x80) >> 8) + 0x80;
-        int wtarget = (w * scale2) >> 8;
-        int htarget = (h * scale2) >> 8;
-        ag_canvas(&tmpb[i - 1], w, h);
-        ag_draw_ex(&tmpb[i - 1], &cbg, 0, 0, x, pos, w, h);
-        ag_draw_strecth_ex(
-          &tmpb[i - 1],
-          &win->c,
-          xc - wtarget / 2, yc - htarget / 2, wtarget, htarget,
-          x, pos, w, h, scale, 1
-        );
-      }
-      
-      ag_ccanvas(&cbg);
-      
-      for (i = 0; i < fadesz; i++) {
-        ag_draw(NULL, &tmpb[i], x, pos);
-        ag_ccanvas(&tmpb[i]);
-        ag_sync();
-      }
-      
-      free(tmpb);
+      AW_ANI ani = { &win->c, NULL, 0, pos, agw(), agh() - pos, 0 };
+      ag_transition(ag_transition_ms(acfg()->fadeframes), 0, 0, aw_ani_bottomtop, &ani);
       ag_draw(NULL, &win->c, 0, 0);
       ag_sync();
     }
-    else if (anitype == 6) {
-      //-- Stack Right to Left
-      int fadesz = acfg()->fadeframes;
-      ag_sync();
+    else if ((anitype == 2) || (anitype == 3)) {
+      //-- Right Left / Left Right
       aw_redraw_ex(win, 0);
       CANVAS cbg;
-      ag_canvas(&cbg, agw(), agh());
+      ag_canvas_get(&cbg, agw(), agh());
       ag_draw(&cbg, agc(), 0, 0);
-      int yc = h / 2;
-      int i;
-      CANVAS * tmpb = (CANVAS *) malloc(sizeof(CANVAS) * fadesz);
-      memset(tmpb, 0, sizeof(CANVAS)*fadesz);
-      
-      for (i = 1; i <= fadesz; i++) {
-        byte scale  = (i * 0xff) / fadesz;
-        byte scale2 = ((scale * 0x80) >> 8) + 0x80;
-        int wtarget = (w * scale2) >> 8;
-        int htarget = (h * scale2) >> 8;
-        int xtarget = (w * scale) >> 8;
-        ag_canvas(&tmpb[i - 1], w, h);
-        ag_draw_strecth_ex(
-          &tmpb[i - 1],
-          &win->c,
-          w - wtarget, yc - htarget / 2, wtarget, htarget,
-          x, pos, w, h, scale, 0
-        );
-        ag_draw_ex(&tmpb[i - 1], &cbg, 0, 0, x + xtarget, pos, w - xtarget, h);
-      }
-      
-      ag_ccanvas(&cbg);
-      
-      for (i = 0; i < fadesz; i++) {
-        ag_draw(NULL, &tmpb[i], x, pos);
-        ag_ccanvas(&tmpb[i]);
-        ag_sync();
-      }
-      
-      free(tmpb);
+      AW_ANI ani = { &win->c, &cbg, 0, pos, agw(), agh() - pos, (anitype == 3) };
+      ag_transition(ag_transition_ms(acfg()->fadeframes), 0, 0, aw_ani_slide, &ani);
+      ag_canvas_put(&cbg);
       ag_draw(NULL, &win->c, 0, 0);
       ag_sync();
     }
-    else if (anitype == 7) {
-      //-- Stack Right to Left
-      int fadesz = acfg()->fadeframes;
+    else if ((anitype == 5) || (anitype == 6) || (anitype == 7)) {
+      //-- Scale / Stack Right to Left / Stack Left to Right
       ag_sync();
       aw_redraw_ex(win, 0);
       CANVAS cbg;
-      ag_canvas(&cbg, agw(), agh());
+      ag_canvas_get(&cbg, agw(), agh());
       ag_draw(&cbg, agc(), 0, 0);
-      int yc = h / 2;
-      int i;
-      CANVAS * tmpb = (CANVAS *) malloc(sizeof(CANVAS) * fadesz);
-      memset(tmpb, 0, sizeof(CANVAS)*fadesz);
+      AW_ANI ani = { &win->c, &cbg, x, pos, w, h, (anitype == 7) };
       
-      for (i = 1; i <= fadesz; i++) {
-        byte scale  = (i * 0xff) / fadesz;
-        byte scale2 = ((scale * 0x80) >> 8) + 0x80;
-        int wtarget = (w * scale2) >> 8;
-        int htarget = (h * scale2) >> 8;
-        int xtarget = (w * scale) >> 8;
-        ag_canvas(&tmpb[i - 1], w, h);
-        ag_draw_strecth_ex(
-          &tmpb[i - 1],
-          &cbg,
-          w - wtarget, yc - htarget / 2, wtarget, htarget,
-          x, pos, w, h, scale, 0
-        );
-        ag_draw_ex(&tmpb[i - 1], &win->c, 0, 0, x + xtarget, pos, w - xtarget, h);
+      if (anitype == 7) {
+        ani.fg = &cbg;
+        ani.bg = &win->c;
       }
       
-      ag_ccanvas(&cbg);
-      
-      for (i = fadesz - 1; i >= 0; i--) {
-        ag_draw(NULL, &tmpb[i], x, pos);
-        ag_ccanvas(&tmpb[i]);
-        ag_sync();
-      }
-      
-      free(tmpb);
+      ag_transition(ag_transition_ms(acfg()->fadeframes), w, h,
+                    (anitype == 5) ? aw_ani_scale : aw_ani_stack, &ani);
+      ag_canvas_put(&cbg);
       ag_draw(NULL, &win->c, 0, 0);
       ag_sync();
     }
@@ -886,7 +815,7 @@ CANVAS * aw_muteparent(AWINDOWP win) {
   if (win == NULL) {
     //-- Set Temporary
     CANVAS * tmpbg = (CANVAS *) malloc(sizeof(CANVAS));
-    ag_canvas(tmpbg, agw(), agh());
+    ag_canvas_get(tmpbg, agw(), agh());
     ag_draw(tmpbg, agc(), 0, 0);
     return tmpbg;
   }
@@ -897,7 +826,7 @@ CANVAS * aw_muteparent(AWINDOWP win) {
 }
 CANVAS * aw_maskparent() {
   CANVAS * tmpbg = (CANVAS *) malloc(sizeof(CANVAS));
-  ag_canvas(tmpbg, agw(), agh());
+  ag_canvas_get(tmpbg, agw(), agh());
   ag_draw(tmpbg, agc(), 0, 0);
   ag_rectopa(tmpbg, 0, 0, agw(), agh(), 0x0000, 180);
   ag_draw(agc(), tmpbg, 0, 0);
@@ -909,13 +838,13 @@ void aw_unmuteparent(AWINDOWP win, CANVAS * p) {
       ag_draw(NULL, p, 0, 0);
       //ag_sync_fade(acfg_var.fadeframes);
       ag_sync();
-      ag_ccanvas(p);
+      ag_canvas_put(p);
       free(p);
     }
   }
   else {
     if (p != NULL) {
-      ag_ccanvas(p);
+      ag_canvas_put(p);
       free(p);
     }
     
@@ -935,7 +864,7 @@ void aw_unmaskparent(AWINDOWP win, CANVAS * p, CANVAS * maskc, int x, int y, int
       }
       else {
         if (maskc != NULL) {
-          ag_ccanvas(maskc);
+          ag_canvas_put(maskc);
           free(maskc);
         }
         
@@ -947,48 +876,17 @@ void aw_unmaskparent(AWINDOWP win, CANVAS * p, CANVAS * maskc, int x, int y, int
       wincanvas = &win->c;
     }
     
-    int fadesz = acfg()->fadeframes;
-    
-    if (fadesz > 0) {
-      //-- Current Canvas
+    if (acfg()->fadeframes > 0) {
+      //-- Scale the dialog out over the masked parent
       CANVAS cbg;
-      ag_canvas(&cbg, agw(), agh());
+      ag_canvas_get(&cbg, agw(), agh());
       ag_draw(&cbg, agc(), 0, 0);
-      int xc    = w / 2;
-      int yc    = h / 2;
-      int i;
-      CANVAS * tmpb = (CANVAS *) malloc(sizeof(CANVAS) * fadesz);
-      memset(tmpb, 0, sizeof(CANVAS)*fadesz);
-      
-      for (i = 1; i <= fadesz; i++) {
-        /* Calculating Scale */
-        byte scale  = (i * 0xff) / fadesz;
-        scale = (scale * (0x200 - scale)) >> 8;
-        byte scale2 = ((scale * 0x80) >> 8) + 0x80;
-        int wtarget = (w * scale2) >> 8;
-        int htarget = (h * scale2) >> 8;
-        ag_canvas(&tmpb[i - 1], w, h);
-        ag_draw_ex(&tmpb[i - 1], maskc, 0, 0, x, y, w, h);
-        ag_draw_strecth_ex(
-          &tmpb[i - 1],
-          &cbg,
-          xc - wtarget / 2, yc - htarget / 2, wtarget, htarget,
-          x, y, w, h, scale, 1
-        );
-      }
-      
-      ag_ccanvas(&cbg);
-      
-      for (i = fadesz - 1; i >= 0; i--) {
-        ag_draw(NULL, &tmpb[i], x, y);
-        ag_ccanvas(&tmpb[i]);
-        ag_sync();
-      }
-      
-      free(tmpb);
+      AW_ANI ani = { &cbg, maskc, x, y, w, h, 1 };
+      ag_transition(ag_transition_ms(acfg()->fadeframes), w, h, aw_ani_scale, &ani);
+      ag_canvas_put(&cbg);
     }
     
-    ag_ccanvas(maskc);
+    ag_canvas_put(maskc);
     free(maskc);
     aw_unmuteparent(win, p);
   }
@@ -1011,7 +909,7 @@ void aw_textdialog(AWINDOWP parent, char * titlev, char * text, char * ok_text)
   int txtW  = winW - (pad * 2);
   int txtX  = pad * 2;
   int btnH  = agdp() * 20;
-  int titW  = ag_txtwidth(title, 1);
+  int titW  = 0;
   int titH  = ag_fontheight(1) + (pad * 2);
   PNGCANVASP winp = atheme("img.dialog");
   PNGCANVASP titp = atheme("img.dialog.titlebar");
@@ -1044,6 +942,14 @@ void aw_textdialog(AWINDOWP parent, char * titlev, char * text, char * ok_text)
   int winH    = titH + infH + btnH + (pad * 2) + vpadB;
   int winX    = pad;
   int winY    = (agh() / 2) - (winH / 2);
+  //-- Fit Title, ellipsis at the end
+  char * titfit = ag_txtfit(title, winW - (pad * 2), 1, AG_ELLIPSIS_END, &titW);
+  
+  if (titfit != NULL) {
+    snprintf(title, 64, "%s", titfit);
+    free(titfit);
+  }
+  
   //-- Calculate Title Size & Position
   int titX    = (agw() / 2) - (titW / 2);
   int titY    = winY + pad;
@@ -1061,7 +967,7 @@ void aw_textdialog(AWINDOWP parent, char * titlev, char * text, char * ok_text)
   int btnX    = (agw() / 2) - (btnW / 2);
   //-- Initializing Canvas
   CANVAS alertbg;
-  ag_canvas(&alertbg, agw(), agh());
+  ag_canvas_get(&alertbg, agw(), agh());
   ag_draw(&alertbg, agc(), 0, 0);
   
   //-- Draw Window
@@ -1099,7 +1005,7 @@ void aw_textdialog(AWINDOWP parent, char * titlev, char * text, char * ok_text)
   }
   
   aw_destroy(hWin);
-  ag_ccanvas(&alertbg);
+  ag_canvas_put(&alertbg);
   on_dialog_window = 0;
   aw_unmaskparent(parent, tmpc, maskc, winX - 1, winY - 1, winW + 2, winH + 2);
 }
@@ -1119,7 +1025,7 @@ void aw_alert(AWINDOWP parent, char * titlev, char * textv, char * img, char * o
   int txtW  = winW - (pad * 2);
   int txtX  = pad * 2;
   int btnH  = agdp() * 20;
-  int titW  = ag_txtwidth(title, 1);
+  int titW  = 0;
   int titH  = ag_fontheight(1) + (pad * 2);
   PNGCANVASP winp = atheme("img.dialog");
   PNGCANVASP titp = atheme("img.dialog.titlebar");
@@ -1172,6 +1078,14 @@ void aw_alert(AWINDOWP parent, char * titlev, char * textv, char * img, char * o
   
   int winX    = pad;
   int winY    = (agh() / 2) - (winH / 2);
+  //-- Fit Title, ellipsis at the end
+  char * titfit = ag_txtfit(title, winW - (pad * 2), 1, AG_ELLIPSIS_END, &titW);
+  
+  if (titfit != NULL) {
+    snprintf(title, 32, "%s", titfit);
+    free(titfit);
+  }
+  
   //-- Calculate Title Size & Position
   int titX    = (agw() / 2) - (titW / 2);
   int titY    = winY + pad;
@@ -1190,7 +1104,7 @@ void aw_alert(AWINDOWP parent, char * titlev, char * textv, char * img, char * o
   int btnX    = (agw() / 2) - (btnW / 2);
   //-- Initializing Canvas
   CANVAS alertbg;
-  ag_canvas(&alertbg, agw(), agh());
+  ag_canvas_get(&alertbg, agw(), agh());
   ag_draw(&alertbg, agc(), 0, 0);
   
   //-- Draw Window
@@ -1236,7 +1150,7 @@ void aw_alert(AWINDOWP parent, char * titlev, char * textv, char * img, char * o
   }
   
   aw_destroy(hWin);
-  ag_ccanvas(&alertbg);
+  ag_canvas_put(&alertbg);
   on_dialog_window = 0;
   aw_unmaskparent(parent, tmpc, maskc, winX - 1, winY - 1, winW + 2, winH + 2);
 }
@@ -1256,7 +1170,7 @@ byte aw_confirm(AWINDOWP parent, char * titlev, char * textv, char * img, char *
   int txtW  = winW - (pad * 2);
   int txtX  = pad * 2;
   int btnH  = agdp() * 20;
-  int titW  = ag_txtwidth(title, 1);
+  int titW  = 0;
   int titH  = ag_fontheight(1) + (pad * 2);
   PNGCANVASP winp = atheme("img.dialog");
   PNGCANVASP titp = atheme("img.dialog.titlebar");
@@ -1309,6 +1223,14 @@ byte aw_confirm(AWINDOWP parent, char * titlev, char * textv, char * img, char *
   
   int winX    = pad;
   int winY    = (agh() / 2) - (winH / 2);
+  //-- Fit Title, ellipsis at the end
+  char * titfit = ag_txtfit(title, winW - (pad * 2), 1, AG_ELLIPSIS_END, &titW);
+  
+  if (titfit != NULL) {
+    snprintf(title, 64, "%s", titfit);
+    free(titfit);
+  }
+  
   //-- Calculate Title Size & Position
   int titX    = (agw() / 2) - (titW / 2);
   int titY    = winY + pad;
@@ -1328,7 +1250,7 @@ byte aw_confirm(AWINDOWP parent, char * titlev, char * textv, char * img, char *
   int btnX2   = txtX + (txtW / 2) + (pad / 2);
   //-- Initializing Canvas
   CANVAS alertbg;
-  ag_canvas(&alertbg, agw(), agh());
+  ag_canvas_get(&alertbg, agw(), agh());
   ag_draw(&alertbg, agc(), 0, 0);
   
   //-- Draw Window
@@ -1378,7 +1300,7 @@ byte aw_confirm(AWINDOWP parent, char * titlev, char * textv, char * img, char *
   }
   
   aw_destroy(hWin);
-  ag_ccanvas(&alertbg);
+  ag_canvas_put(&alertbg);
   on_dialog_window = 0;
   aw_unmaskparent(parent, tmpc, maskc, winX - 1, winY - 1, winW + 2, winH + 2);
   return res;
@@ -1414,9 +1336,9 @@ byte aw_calibdraw(CANVAS * c,
     ty2 = (ty + ag_fontheight(0) + agdp());
     ty -= txh - ag_fontheight(0);
     ag_text(agc(), agw(), 1, ty + 1, txt, 0x0000, 0);
-    ag_text(agc(), agw(), 0, ty, txt, 0xffff, 0);
+    ag_text(agc(), agw(), 0, ty, txt, ag_rgb(0xff, 0xff, 0xff), 0);
     ag_text(agc(), tw2, tx2 + 1, ty2 + 1, txt2, 0x0000, 0);
-    ag_text(agc(), tw2, tx2, ty2, txt2, 0xffff, 0);
+    ag_text(agc(), tw2, tx2, ty2, txt2, ag_rgb(0xff, 0xff, 0xff), 0);
   }
   else if (id != -1) {
     char txt[128];
@@ -1429,9 +1351,9 @@ byte aw_calibdraw(CANVAS * c,
     int ty = (agh() / 2) + (sz * 2);
     ty2 = (ty + ag_fontheight(0) + agdp());
     ag_text(agc(), tw, tx + 1, ty + 1, txt, 0x0000, 0);
-    ag_text(agc(), tw, tx, ty, txt, 0xffff, 0);
+    ag_text(agc(), tw, tx, ty, txt, ag_rgb(0xff, 0xff, 0xff), 0);
     ag_text(agc(), tw2, tx2 + 1, ty2 + 1, txt2, 0x0000, 0);
-    ag_text(agc(), tw2, tx2, ty2, txt2, 0xffff, 0);
+    ag_text(agc(), tw2, tx2, ty2, txt2, ag_rgb(0xff, 0xff, 0xff), 0);
   }
   else {
     char * txt  = "Tap The Screen to Test Calibrated Data";
@@ -1443,13 +1365,13 @@ byte aw_calibdraw(CANVAS * c,
     int ty = (agh() / 2) + (sz * 2);
     ty2 = (ty + ag_fontheight(0) + agdp());
     ag_text(agc(), tw, tx + 1, ty + 1, txt, 0x0000, 0);
-    ag_text(agc(), tw, tx, ty, txt, 0xffff, 0);
+    ag_text(agc(), tw, tx, ty, txt, ag_rgb(0xff, 0xff, 0xff), 0);
     ag_text(agc(), tw2, tx2 + 1, ty2 + 1, txt2, 0x0000, 0);
-    ag_text(agc(), tw2, tx2, ty2, txt2, 0xffff, 0);
+    ag_text(agc(), tw2, tx2, ty2, txt2, ag_rgb(0xff, 0xff, 0xff), 0);
   }
   
   CANVAS bg;
-  ag_canvas(&bg, agw(), agh());
+  ag_canvas_get(&bg, agw(), agh());
   ag_draw(&bg, agc(), 0, 0);
   ag_sync();
   int rx = 0;
@@ -1476,7 +1398,7 @@ byte aw_calibdraw(CANVAS * c,
         prx += addx;
         pry += addy;
         ag_roundgrad(agc(), prx, pry, sz, sz,
-                     0xffff,
+                     ag_rgb(0xff, 0xff, 0xff),
                      ag_rgb(200, 200, 200),
                      sz / 2);
         ag_sync();
@@ -1488,7 +1410,7 @@ byte aw_calibdraw(CANVAS * c,
   
     ag_roundgrad(
       agc(), rx, ry, sz, sz,
-      0xffff,
+      ag_rgb(0xff, 0xff, 0xff),
       ag_rgb(200, 200, 200),
       sz / 2);
     ag_sync();
@@ -1500,7 +1422,7 @@ byte aw_calibdraw(CANVAS * c,
     int ty3 = agh() - (ag_fontheight(0) + (agdp() * 6));
     int tw3 = ag_txtwidth(txt3, 0);
     int tx3 = (agw() / 2) - (tw3 / 2);
-    ag_text(agc(), tw3, tx3, ty3, txt3, 0xffff, 0);
+    ag_text(agc(), tw3, tx3, ty3, txt3, ag_rgb(0xff, 0xff, 0xff), 0);
     ag_sync();
   }
   
@@ -1528,17 +1450,17 @@ byte aw_calibdraw(CANVAS * c,
             int ty3 = ty2 + ag_fontheight(0) + (agdp() * 6);
             int tw3 = ag_txtwidth(txt3, 0);
             int tx3 = (agw() / 2) - (tw3 / 2);
-            ag_text(agc(), tw3, tx3, ty3, txt3, 0xffff, 0);
-            ag_rect(agc(), 0, atev.y, agw(), 1, 0xffff);
-            ag_rect(agc(), atev.x, 0, 1, agh(), 0xffff);
-            ag_roundgrad(agc(), vx, vy, vz, vz, 0xffff, ag_rgb(180, 180, 180), (vz / 2));
+            ag_text(agc(), tw3, tx3, ty3, txt3, ag_rgb(0xff, 0xff, 0xff), 0);
+            ag_rect(agc(), 0, atev.y, agw(), 1, ag_rgb(0xff, 0xff, 0xff));
+            ag_rect(agc(), atev.x, 0, 1, agh(), ag_rgb(0xff, 0xff, 0xff));
+            ag_roundgrad(agc(), vx, vy, vz, vz, ag_rgb(0xff, 0xff, 0xff), ag_rgb(180, 180, 180), (vz / 2));
   
             if (id == -2) {
               snprintf(txt3, 256, "<b>Fine Tuning Value : %i</b>", *xpos);
               ty3 = agh() - (ag_fontheight(0) + (agdp() * 6));
               tw3 = ag_txtwidth(txt3, 0);
               tx3 = (agw() / 2) - (tw3 / 2);
-              ag_text(agc(), tw3, tx3, ty3, txt3, 0xffff, 0);
+              ag_text(agc(), tw3, tx3, ty3, txt3, ag_rgb(0xff, 0xff, 0xff), 0);
             }
   
             ag_sync();
@@ -1548,7 +1470,7 @@ byte aw_calibdraw(CANVAS * c,
             int agpl = agdp() * 10;
             ag_roundgrad(
               agc(), rx - agpl, ry - agpl, sz + (agpl * 2), sz + (agpl * 2),
-              0xffff,
+              ag_rgb(0xff, 0xff, 0xff),
               ag_rgb(200, 200, 200),
               (sz / 2) + agpl);
             agpl = agdp() * 7;
@@ -1560,7 +1482,7 @@ byte aw_calibdraw(CANVAS * c,
             agpl = 0;
             ag_roundgrad(
               agc(), rx - agpl, ry - agpl, sz + (agpl * 2), sz + (agpl * 2),
-              0xffff,
+              ag_rgb(0xff, 0xff, 0xff),
               ag_rgb(200, 200, 200),
               (sz / 2) + agpl);
             ag_sync();
@@ -1584,17 +1506,17 @@ byte aw_calibdraw(CANVAS * c,
               int ty3 = ty2 + ag_fontheight(0) + (agdp() * 6);
               int tw3 = ag_txtwidth(txt3, 0);
               int tx3 = (agw() / 2) - (tw3 / 2);
-              ag_text(agc(), tw3, tx3, ty3, txt3, 0xffff, 0);
-              ag_rect(agc(), 0, atev.y, agw(), 1, 0xffff);
-              ag_rect(agc(), atev.x, 0, 1, agh(), 0xffff);
-              ag_roundgrad(agc(), vx, vy, vz, vz, 0xffff, ag_rgb(180, 180, 180), (vz / 2));
+              ag_text(agc(), tw3, tx3, ty3, txt3, ag_rgb(0xff, 0xff, 0xff), 0);
+              ag_rect(agc(), 0, atev.y, agw(), 1, ag_rgb(0xff, 0xff, 0xff));
+              ag_rect(agc(), atev.x, 0, 1, agh(), ag_rgb(0xff, 0xff, 0xff));
+              ag_roundgrad(agc(), vx, vy, vz, vz, ag_rgb(0xff, 0xff, 0xff), ag_rgb(180, 180, 180), (vz / 2));
   
               if (id == -2) {
                 snprintf(txt3, 256, "<b>Fine Tuning Value : %i</b>", *xpos);
                 ty3 = agh() - (ag_fontheight(0) + (agdp() * 6));
                 tw3 = ag_txtwidth(txt3, 0);
                 tx3 = (agw() / 2) - (tw3 / 2);
-                ag_text(agc(), tw3, tx3, ty3, txt3, 0xffff, 0);
+                ag_text(agc(), tw3, tx3, ty3, txt3, ag_rgb(0xff, 0xff, 0xff), 0);
               }
   
               ag_sync();
@@ -1623,17 +1545,17 @@ byte aw_calibdraw(CANVAS * c,
             int ty3 = ty2 + ag_fontheight(0) + (agdp() * 6);
             int tw3 = ag_txtwidth(txt3, 0);
             int tx3 = (agw() / 2) - (tw3 / 2);
-            ag_text(agc(), tw3, tx3, ty3, txt3, 0xffff, 0);
+            ag_text(agc(), tw3, tx3, ty3, txt3, ag_rgb(0xff, 0xff, 0xff), 0);
   
             if (id == -2) {
               snprintf(txt3, 256, "<b>Fine Tuning Value : %i</b>", *xpos);
               ty3 = agh() - (ag_fontheight(0) + (agdp() * 6));
               tw3 = ag_txtwidth(txt3, 0);
               tx3 = (agw() / 2) - (tw3 / 2);
-              ag_text(agc(), tw3, tx3, ty3, txt3, 0xffff, 0);
+              ag_text(agc(), tw3, tx3, ty3, txt3, ag_rgb(0xff, 0xff, 0xff), 0);
             }
   
-            // ag_roundgrad(agc(),vx,vy,vz,vz,0xffff,ag_rgb(180,180,180),(vz/2));
+            // ag_roundgrad(agc(),vx,vy,vz,vz,ag_rgb(0xff, 0xff, 0xff),ag_rgb(180,180,180),(vz/2));
             ag_sync();
           }
         }
@@ -1654,7 +1576,7 @@ byte aw_calibdraw(CANVAS * c,
             int ty3 = agh() - (ag_fontheight(0) + (agdp() * 6));
             int tw3 = ag_txtwidth(txt3, 0);
             int tx3 = (agw() / 2) - (tw3 / 2);
-            ag_text(agc(), tw3, tx3, ty3, txt3, 0xffff, 0);
+            ag_text(agc(), tw3, tx3, ty3, txt3, ag_rgb(0xff, 0xff, 0xff), 0);
             ag_sync();
           }
         }
@@ -1675,7 +1597,7 @@ byte aw_calibdraw(CANVAS * c,
             int ty3 = agh() - (ag_fontheight(0) + (agdp() * 6));
             int tw3 = ag_txtwidth(txt3, 0);
             int tx3 = (agw() / 2) - (tw3 / 2);
-            ag_text(agc(), tw3, tx3, ty3, txt3, 0xffff, 0);
+            ag_text(agc(), tw3, tx3, ty3, txt3, ag_rgb(0xff, 0xff, 0xff), 0);
             ag_sync();
           }
         }
@@ -1693,7 +1615,7 @@ byte aw_calibdraw(CANVAS * c,
     }
   }
   
-  ag_ccanvas(&bg);
+  ag_canvas_put(&bg);
   return res;
 }
 */
@@ -1768,7 +1690,7 @@ byte aw_calibtools_(AWINDOWP parent) {
   byte isvalid = 0;
   //-- Initializing Canvas
   CANVAS ccv;
-  ag_canvas(&ccv, agw(), agh());
+  ag_canvas_get(&ccv, agw(), agh());
   ag_blur(&ccv, agc(), agdp() * 2);
   atouch_plaincalibrate();
   int dp10    = agdp() * 20;
@@ -1818,7 +1740,7 @@ byte aw_calibtools_(AWINDOWP parent) {
   }
   
   doneit:
-  ag_ccanvas(&ccv);
+  ag_canvas_put(&ccv);
   on_dialog_window = 0;
   aw_unmuteparent(parent, tmpc);
   byte dont_restore_caldata = 0;
@@ -1918,7 +1840,7 @@ byte aw_showmenu(AWINDOWP parent) {
   int btnW  = winW - (pad * 2);
   //-- Initializing Canvas
   CANVAS alertbg;
-  ag_canvas(&alertbg, agw(), agh());
+  ag_canvas_get(&alertbg, agw(), agh());
   ag_draw(&alertbg, agc(), 0, 0);
   //-- Draw Window Background
   ag_roundgrad_ex(&alertbg, winX - 1, winY - 1, winW + 2, winH + 2, acfg_var.border, acfg_var.border_g, 0, 1, 1, 0, 0);
@@ -1966,7 +1888,7 @@ byte aw_showmenu(AWINDOWP parent) {
   }
   
   aw_destroy(hWin);
-  ag_ccanvas(&alertbg);
+  ag_canvas_put(&alertbg);
   on_dialog_window = 0;
   aw_unmuteparent(parent, tmpc);
   
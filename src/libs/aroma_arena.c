@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Descriptions:
+ * -------------
+ * AROMA Arena - bump allocator for objects that share one lifetime,
+ * like a window and its controls. Nothing is freed one by one.
+ *
+ */
+
+#include <aroma.h>
+
+#define AARENA_CHUNK_SZ   32768       // Default chunk
+#define AARENA_BIG_SZ     8192        // Bigger requests get own chunk
+#define AARENA_ALIGN(x)   (((x) + 15) & ~((size_t) 15))
+#define AARENA_HDR        AARENA_ALIGN(sizeof(AARENA_CHUNK))
+
+void aarena_init(AARENAP a) {
+  a->head   = NULL;
+  a->bytes  = 0;
+}
+
+static AARENA_CHUNK * aarena_chunk(size_t size) {
+  AARENA_CHUNK * c = (AARENA_CHUNK *) malloc(AARENA_HDR + size);
+  c->next = NULL;
+  c->size = size;
+  c->used = 0;
+  return c;
+}
+
+void * aarena_alloc(AARENAP a, size_t size) {
+  AARENA_CHUNK * c = a->head;
+  size = AARENA_ALIGN(size);
+  a->bytes += size;
+  
+  if ((c == NULL) || (c->used + size > c->size)) {
+    if (size > AARENA_BIG_SZ) {
+      //-- Own chunk, keep the current one open for small objects
+      AARENA_CHUNK * b = aarena_chunk(size);
+      
+      if (c == NULL) {
+        a->head = b;
+      }
+      else {
+        b->next = c->next;
+        c->next = b;
+      }
+      
+      b->used = size;
+      memset((byte *) b + AARENA_HDR, 0, size);
+      return (byte *) b + AARENA_HDR;
+    }
+    
+    c       = aarena_chunk(AARENA_CHUNK_SZ);
+    c->next = a->head;
+    a->head = c;
+  }
+  
+  void * p = (byte *) c + AARENA_HDR + c->used;
+  c->used += size;
+  memset(p, 0, size);
+  return p;
+}
+
+void aarena_free(AARENAP a) {
+  AARENA_CHUNK * c = a->head;
+  
+  while (c != NULL) {
+    AARENA_CHUNK * n = c->next;
+    free(c);
+    c = n;
+  }
+  
+  a->head  = NULL;
+  a->bytes = 0;
+}
@@ -21,6 +21,7 @@
  *
  */
 
+#include <sched.h>
 #include <aroma.h>
 
 #include FT_LCD_FILTER_H
@@ -30,16 +31,52 @@
 /*****************************[ GLOBAL VARIABLES ]*****************************/
 static FT_Library             aft_lib;            // Freetype Library
 static byte                   aft_initialized = 0; // Is Library Initialized
-static AFTFAMILY              aft_big;            // Big Font Family
-static AFTFAMILY              aft_small;          // Small Font Family
+static AFTFAMILYP             aft_families[2] = {NULL, NULL}; // Small & Big Family
 
-/******************************[ LOCK FUNCTIONS ]******************************/
-static pthread_mutex_t  _afont_mutex = PTHREAD_MUTEX_INITIALIZER;
-void aft_waitlock() {
-  pthread_mutex_lock(&_afont_mutex);
+/***************************[ FAMILY SYNCHRONIZING ]***************************/
+//*
+//* Readers never lock. Each reader announces itself on the counter of the
+//* current generation and retries if the generation flipped meanwhile.
+//* aft_load/aft_close swap the family pointer one at a time, flip the
+//* generation and wait only for readers that may still see the old family.
+//*
+static int             aft_gen[2]        = {0, 0};
+static int             aft_readers[2][2] = {{0, 0}, {0, 0}};
+static pthread_mutex_t aft_swap_mutex    = PTHREAD_MUTEX_INITIALIZER;
+
+static AFTFAMILYP aft_family_get(byte isbig, int * gen) {
+  int i = isbig ? 1 : 0;
+  int g = __atomic_load_n(&aft_gen[i], __ATOMIC_SEQ_CST);
+  __atomic_fetch_add(&aft_readers[i][g], 1, __ATOMIC_SEQ_CST);
+  
+  //-- Counted too late, the swapper may already be past this counter
+  while (__atomic_load_n(&aft_gen[i], __ATOMIC_SEQ_CST) != g) {
+    __atomic_fetch_sub(&aft_readers[i][g], 1, __ATOMIC_SEQ_CST);
+    g = __atomic_load_n(&aft_gen[i], __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&aft_readers[i][g], 1, __ATOMIC_SEQ_CST);
+  }
+  
+  *gen = g;
+  return __atomic_load_n(&aft_families[i], __ATOMIC_SEQ_CST);
+}
+
+static void aft_family_put(byte isbig, int gen) {
+  __atomic_fetch_sub(&aft_readers[isbig ? 1 : 0][gen], 1, __ATOMIC_SEQ_CST);
 }
-void aft_unlock() {
-  pthread_mutex_unlock(&_afont_mutex);
+
+static AFTFAMILYP aft_family_swap(byte isbig, AFTFAMILYP m) {
+  int i = isbig ? 1 : 0;
+  pthread_mutex_lock(&aft_swap_mutex);
+  AFTFAMILYP old = __atomic_exchange_n(&aft_families[i], m, __ATOMIC_SEQ_CST);
+  int g = __atomic_load_n(&aft_gen[i], __ATOMIC_SEQ_CST);
+  __atomic_store_n(&aft_gen[i], g ? 0 : 1, __ATOMIC_SEQ_CST);
+  
+  while (__atomic_load_n(&aft_readers[i][g], __ATOMIC_SEQ_CST) > 0) {
+    sched_yield();
+  }
+  
+  pthread_mutex_unlock(&aft_swap_mutex);
+  return old;
 }
 
 /*******************************[ RTL FUNCTION ]*******************************/
@@ -142,9 +179,13 @@ byte aft_createglyph(AFTFACEP f) {
   }
   
   f->cache_n  = f->face->num_glyphs;
-  int sz      = f->cache_n * sizeof(AFTGLYPH);
-  f->cache    = (AFTGLYPHP) malloc(sz);
+  int sz      = f->cache_n * sizeof(AFTGLYPHP);
+  f->cache    = (AFTGLYPHP *) malloc(sz);
   memset(f->cache, 0, sz);
+  sz          = AFT_KCACHE_SZ * sizeof(uint64_t);
+  f->kcache   = (uint64_t *) malloc(sz);
+  memset(f->kcache, 0, sz);
+  pthread_mutex_init(&f->lock, NULL);
   return 1;
 }
 
@@ -164,9 +205,9 @@ byte aft_closeglyph(AFTFACEP f) {
     long i = 0;
     
     for (i = 0; i < f->cache_n; i++) {
-      if (f->cache[i].init) {
-        FT_Done_Glyph(f->cache[i].g);
-        f->cache[i].init = 0;
+      if (f->cache[i] != NULL) {
+        FT_Done_Glyph(f->cache[i]->g);
+        free(f->cache[i]);
       }
     }
     
@@ -175,74 +216,134 @@ byte aft_closeglyph(AFTFACEP f) {
     f->cache_n = 0;
   }
   
+  if (f->kcache != NULL) {
+    free(f->kcache);
+  }
+  
+  pthread_mutex_destroy(&f->lock);
   return 1;
 }
 
 //*
-//* Cache Readed Glyph
+//* Get cached glyph, load & publish it on first use
 //*
-byte aft_cacheglyph(AFTFACEP f, long id) {
-  if (!aft_initialized) {
-    return 0;
+AFTGLYPHP aft_cacheglyph(AFTFACEP f, long id) {
+  if ((id < 0) || (id >= f->cache_n)) {
+    return NULL;
   }
   
-  if (f == NULL) {
-    return 0;
+  AFTGLYPHP g = __atomic_load_n(&f->cache[id], __ATOMIC_ACQUIRE);
+  
+  if (g != NULL) {
+    return g;
   }
   
-  if (f->cache_n < id) {
-    return 0;
+  //-- Only glyph loading need the face, rendering works on a copy
+  pthread_mutex_lock(&f->lock);
+  g = NULL;
+  
+  if (FT_Load_Glyph(f->face, id, FT_LOAD_DEFAULT) == 0) {
+    g = (AFTGLYPHP) malloc(sizeof(AFTGLYPH));
+    
+    if (FT_Get_Glyph(f->face->glyph, &g->g) == 0) {
+      g->w = f->face->glyph->advance.x >> 6;
+    }
+    else {
+      free(g);
+      g = NULL;
+    }
   }
   
-  if (!f->cache[id].init) {
-    FT_Get_Glyph(f->face->glyph, &f->cache[id].g);
-    f->cache[id].w    = f->face->glyph->advance.x >> 6;
-    f->cache[id].init = 1;
+  pthread_mutex_unlock(&f->lock);
+  
+  if (g != NULL) {
+    AFTGLYPHP cur = NULL;
+    
+    if (!__atomic_compare_exchange_n(&f->cache[id], &cur, g, 0,
+                                     __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+      //-- Other thread win the race, use its glyph
+      FT_Done_Glyph(g->g);
+      free(g);
+      g = cur;
+    }
   }
   
-  return 1;
+  return g;
 }
 
 /**************************[ FONT FAMILY MANAGEMENT ]***************************/
+//*
+//* Search glyph index & face for given character
+//*
+static long aft_id_search(AFTFAMILYP m, int c, int * fi) {
+  long id = 0;
+  int  i  = 0;
+  
+  for (i = 0; i < m->facen; i++) {
+    pthread_mutex_lock(&m->faces[i].lock);
+    id = FT_Get_Char_Index(m->faces[i].face, c);
+    pthread_mutex_unlock(&m->faces[i].lock);
+    
+    if (id != 0) {
+      *fi = i;
+      return id;
+    }
+  }
+  
+  *fi = 0;
+  return 0;
+}
+
 //*
 //* Get glyph index & face for given character
 //*
-long aft_id(AFTFACEP * f, int c, byte isbig) {
-  if (!aft_initialized) {
+long aft_id(AFTFAMILYP m, AFTFACEP * f, int c) {
+  if (c == 0xfeff) {
     return 0;
   }
   
-  if (c == 0xfeff) {
+  if (m->facen < 1) {
     return 0;
   }
   
-  AFTFAMILYP m = (isbig != 0) ? &aft_big : &aft_small;
+  int  fi = 0;
+  long id = 0;
   
-  if (!m->init) {
-    return 0;
+  if ((c < 0) || (c >= (AFT_CMAP_PAGES << 8))) {
+    id = aft_id_search(m, c, &fi);
+    *f = &(m->faces[fi]);
+    return id;
   }
   
-  if (m->facen > 0) {
-    aft_waitlock();
-    long id = 0;
-    int  i  = 0;
+  //-- Page entry: bit 31 = resolved, bit 24-30 = face, bit 0-23 = glyph
+  dword * page = __atomic_load_n(&m->cmap[c >> 8], __ATOMIC_ACQUIRE);
+  
+  if (page == NULL) {
+    dword * npage = (dword *) malloc(sizeof(dword) * 256);
+    memset(npage, 0, sizeof(dword) * 256);
     
-    for (i = 0; i < m->facen; i++) {
-      id = FT_Get_Char_Index(m->faces[i].face, c);
-      
-      if (id != 0) {
-        *f = &(m->faces[i]);
-        aft_unlock();
-        return id;
-      }
+    if (__atomic_compare_exchange_n(&m->cmap[c >> 8], &page, npage, 0,
+                                    __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+      page = npage;
+    }
+    else {
+      free(npage);
     }
-    
-    *f = &(m->faces[0]);
-    aft_unlock();
-    return 0;
   }
   
-  return 0;
+  dword e = __atomic_load_n(&page[c & 0xff], __ATOMIC_RELAXED);
+  
+  if (e & 0x80000000) {
+    *f = &(m->faces[(e >> 24) & 0x7f]);
+    return e & 0xffffff;
+  }
+  
+  id = aft_id_search(m, c, &fi);
+  __atomic_store_n(&page[c & 0xff],
+                   0x80000000 | (((dword) fi) << 24) | (((dword) id) & 0xffffff),
+                   __ATOMIC_RELAXED);
+  *f = &(m->faces[fi]);
+  return id;
 }
 
 //*
@@ -257,30 +358,48 @@ int aft_kern(int c, int p, byte isbig) {
     return 0;
   }
   
-  AFTFAMILYP m = (isbig != 0) ? &aft_big : &aft_small;
+  int gen;
+  int ret = 0;
+  AFTFAMILYP m = aft_family_get(isbig, &gen);
   
-  if (!m->init) {
-    return 0;
-  }
-  
-  AFTFACEP cf = NULL;
-  AFTFACEP pf = NULL;
-  long  up = aft_id(&pf, p, isbig);
-  long  uc = aft_id(&cf, c, isbig);
-  
-  if (up && uc && cf && pf) {
-    if (cf == pf) {
-      if (cf->kern == 1) {
-        aft_waitlock();
+  if (m != NULL) {
+    AFTFACEP cf = NULL;
+    AFTFACEP pf = NULL;
+    long  up = aft_id(m, &pf, p);
+    long  uc = aft_id(m, &cf, c);
+    
+    if (up && uc && cf && (cf == pf) && (cf->kern == 1)) {
+      if ((up > 0xffff) || (uc > 0xffff)) {
         FT_Vector delta;
+        pthread_mutex_lock(&cf->lock);
         FT_Get_Kerning(cf->face, up, uc, FT_KERNING_DEFAULT, &delta );
-        aft_unlock();
-        return (delta.x >> 6);
+        pthread_mutex_unlock(&cf->lock);
+        ret = (delta.x >> 6);
+      }
+      else {
+        //-- Pair cache: high dword = pair key, low dword = delta
+        dword    key  = (((dword) up) << 16) | ((dword) uc);
+        int      pos  = ((up * 31) + uc) & (AFT_KCACHE_SZ - 1);
+        uint64_t e    = __atomic_load_n(&cf->kcache[pos], __ATOMIC_RELAXED);
+        
+        if ((dword) (e >> 32) == key) {
+          ret = (int) ((int32_t) (dword) e);
+        }
+        else {
+          FT_Vector delta;
+          pthread_mutex_lock(&cf->lock);
+          FT_Get_Kerning(cf->face, up, uc, FT_KERNING_DEFAULT, &delta );
+          pthread_mutex_unlock(&cf->lock);
+          ret = (delta.x >> 6);
+          e   = (((uint64_t) key) << 32) | ((uint64_t) (dword) ret);
+          __atomic_store_n(&cf->kcache[pos], e, __ATOMIC_RELAXED);
+        }
       }
     }
   }
   
-  return 0;
+  aft_family_put(isbig, gen);
+  return ret;
 }
 
 //*
@@ -295,13 +414,8 @@ byte aft_free(AFTFAMILYP m) {
     return 0;
   }
   
-  if (!m->init) {
-    return 0;
-  }
-  
   int fn = m->facen;
   m->facen = 0;
-  m->init = 0;
   
   if (fn > 0) {
     int i;
@@ -309,12 +423,25 @@ byte aft_free(AFTFAMILYP m) {
     for (i = 0; i < fn; i++) {
       aft_closeglyph(&(m->faces[i]));
       FT_Done_Face(m->faces[i].face);
-      free(m->faces[i].mem);
+      az_unmap(&m->faces[i].mem);
     }
     
     free(m->faces);
   }
   
+  if (m->cmap != NULL) {
+    int i;
+    
+    for (i = 0; i < AFT_CMAP_PAGES; i++) {
+      if (m->cmap[i] != NULL) {
+        free(m->cmap[i]);
+      }
+    }
+    
+    free(m->cmap);
+  }
+  
+  free(m);
   return 1;
 }
 
@@ -322,6 +449,7 @@ byte aft_free(AFTFAMILYP m) {
 //* Load Font Family
 //*
 byte aft_load(const char * source_name, int size, byte isbig, char * relativeto) {
+  ATRACE_SCOPE("aft_load");
   if (!aft_initialized) {
     return 0;
   }
@@ -368,7 +496,7 @@ byte aft_load(const char * source_name, int size, byte isbig, char * relativeto)
   int i = 0;
   int c = 0;
   FT_Face ftfaces[10];
-  unsigned char * ftmem[10];
+  AZMEM   ftmem[10];
   
   for (i = 0; i < count; i++) {
     if (strlen(zpaths[i]) > 0) {
@@ -376,35 +504,37 @@ byte aft_load(const char * source_name, int size, byte isbig, char * relativeto)
       snprintf(zpath, 256, "%s%s", relativeto, zpaths[i]);
       AZMEM mem;
       
-      if (az_readmem(&mem, zpath, 1)) {
+      //-- Stored fonts are used in place, no heap copy
+      if (az_map(&mem, zpath, AZ_MAP_KEEP)) {
         if (FT_New_Memory_Face(aft_lib, (unsigned char*)mem.data, mem.sz, 0, &ftfaces[c]) == 0) {
           if (FT_Set_Pixel_Sizes(ftfaces[c], 0, m_p) == 0) {
-            ftmem[c] = (unsigned char*)mem.data;
+            ftmem[c] = mem;
             c++;
           }
           else {
             FT_Done_Face(ftfaces[c]);
-            free(mem.data);
+            az_unmap(&mem);
           }
         }
         else {
-          free(mem.data);
+          az_unmap(&mem);
         }
       }
     }
   }
   
   if (c > 0) {
-    aft_waitlock();
-    AFTFAMILYP m = (isbig != 0) ? &aft_big : &aft_small;
-    //-- Cleanup Font
-    aft_free(m);
+    //-- Build the new family privately, then publish it
+    AFTFAMILYP m = (AFTFAMILYP) malloc(sizeof(AFTFAMILY));
+    memset(m, 0, sizeof(AFTFAMILY));
     m->s = m_s;
     m->p = m_p;
     m->h = m_h;
     m->y = m_y;
     m->faces = malloc(sizeof(AFTFACE) * c);
     memset(m->faces, 0, sizeof(AFTFACE) * c);
+    m->cmap = (dword **) malloc(sizeof(dword *) * AFT_CMAP_PAGES);
+    memset(m->cmap, 0, sizeof(dword *) * AFT_CMAP_PAGES);
     
     for (i = 0; i < c; i++) {
       m->faces[i].face = ftfaces[i];
@@ -414,9 +544,10 @@ byte aft_load(const char * source_name, int size, byte isbig, char * relativeto)
     }
     
     m->facen = c;
-    m->init  = 1;
+    
+    //-- Cleanup Old Font
+    aft_free(aft_family_swap(isbig, m));
     LOGS("(%i) Freetype fonts loaded as Font Family", c);
-    aft_unlock();
     return 1;
   }
   
@@ -432,8 +563,8 @@ byte aft_open() {
     return 0;
   }
   
-  aft_big.init = 0;
-  aft_small.init = 0;
+  aft_families[0] = NULL;
+  aft_families[1] = NULL;
   
   if (FT_Init_FreeType( &aft_lib ) == 0) {
     FT_Library_SetLcdFilter(aft_lib, FT_LCD_FILTER_DEFAULT);
@@ -452,13 +583,7 @@ byte aft_fontready(byte isbig) {
     return 0;
   }
   
-  AFTFAMILYP m = (isbig) ? &aft_big : &aft_small;
-  
-  if (!m->init) {
-    return 0;
-  }
-  
-  return 1;
+  return (__atomic_load_n(&aft_families[isbig ? 1 : 0], __ATOMIC_ACQUIRE) != NULL) ? 1 : 0;
 }
 
 //*
@@ -470,8 +595,8 @@ byte aft_close() {
   }
   
   //-- Release All Font Family
-  aft_free(&aft_big);
-  aft_free(&aft_small);
+  aft_free(aft_family_swap(1, NULL));
+  aft_free(aft_family_swap(0, NULL));
   
   if (FT_Done_FreeType( aft_lib ) == 0) {
     aft_initialized = 0;
@@ -482,73 +607,44 @@ byte aft_close() {
 }
 
 //*
-//* Font Width - No Auto Unlock
+//* Get Glyph for given character
 //*
-int aft_fontwidth_lock(int c, byte isbig, AFTGLYPHP * ch, byte * onlock) {
-  if (!aft_initialized) {
-    return 0;
-  }
-  
+static AFTGLYPHP aft_glyph(AFTFAMILYP m, int c) {
   if (c == 0xfeff) {
-    return 0;
+    return NULL;
   }
   
   AFTFACEP   f = NULL;
-  long uc      = aft_id(&f, c, isbig);
+  long uc      = aft_id(m, &f, c);
   
-  if (f == NULL) {
-    return 0;
+  if ((f == NULL) || (f->cache == NULL)) {
+    return NULL;
   }
   
-  if (f->cache == NULL) {
-    return 0;
-  }
-  
-  if (uc > f->cache_n) {
-    return 0;
-  }
-  
-  aft_waitlock();
-  *onlock = 1;
-  
-  if (f->cache[uc].init) {
-    if (ch != NULL) {
-      *ch = &f->cache[uc];
-    }
-    
-    return f->cache[uc].w;
-  }
-  
-  if (FT_Load_Glyph(f->face, uc, FT_LOAD_DEFAULT) == 0) {
-    if (aft_cacheglyph(f, uc)) {
-      if (ch != NULL) {
-        *ch = &f->cache[uc];
-      }
-      
-      return f->cache[uc].w;
-    }
-    
-    return 0;
-  }
-  
-  return 0;
+  return aft_cacheglyph(f, uc);
 }
 
 //*
-//* Font Width - Auto Unlock
+//* Font Width
 //*
 int aft_fontwidth(int c, byte isbig) {
   if (!aft_initialized) {
     return 0;
   }
   
-  byte onlock = 0;
-  int w = aft_fontwidth_lock(c, isbig, NULL, &onlock);
+  int gen;
+  int w = 0;
+  AFTFAMILYP m = aft_family_get(isbig, &gen);
   
-  if (onlock) {
-    aft_unlock();
+  if (m != NULL) {
+    AFTGLYPHP ch = aft_glyph(m, c);
+    
+    if (ch != NULL) {
+      w = ch->w;
+    }
   }
   
+  aft_family_put(isbig, gen);
   return w;
 }
 
@@ -571,13 +667,16 @@ byte aft_fontheight(byte isbig) {
     return 0;
   }
   
-  AFTFAMILYP m      = (isbig) ? &aft_big : &aft_small;
+  int gen;
+  byte h = 0;
+  AFTFAMILYP m = aft_family_get(isbig, &gen);
   
-  if (!m->init) {
-    return 0;
+  if (m != NULL) {
+    h = m->h;
   }
   
-  return m->h;
+  aft_family_put(isbig, gen);
+  return h;
 }
 /* Multisampling Alpha */
 color aAlphaMulti(color dcl, color scl, byte lr, byte lg, byte lb) {
@@ -603,6 +702,7 @@ color aAlphaMulti(color dcl, color scl, byte lr, byte lg, byte lb) {
 //* Draw Font
 //*
 byte aft_drawfont(CANVAS * _b, byte isbig, int fpos, int xpos, int ypos, color cl, byte underline, byte bold, byte italic, byte lcd) {
+  ATRACE_SCOPE("aft_drawfont");
   if (!aft_initialized) {
     return 0;
   }
@@ -613,37 +713,30 @@ byte aft_drawfont(CANVAS * _b, byte isbig, int fpos, int xpos, int ypos, color c
   }
   
   //-- Get Font Glyph
-  AFTFAMILYP m      = (isbig) ? &aft_big : &aft_small;
+  int        gen;
+  AFTFAMILYP m      = aft_family_get(isbig, &gen);
   
-  if (!m->init) {
+  if (m == NULL) {
+    aft_family_put(isbig, gen);
     return 0;
   }
   
-  AFTGLYPHP ch      = NULL;
-  byte      onlock  = 0;
-  int       fw      = aft_fontwidth_lock(fpos, isbig, &ch, &onlock);
-  int       fh      = aft_fontheight(isbig);
+  AFTGLYPHP ch      = aft_glyph(m, fpos);
+  int       fw      = (ch != NULL) ? ch->w : 0;
+  int       fh      = m->h;
+  int       fy      = m->y;
+  int       fp      = m->p;
   
   //-- Check Validity
   if ((fw == 0) || (ch == NULL)) {
-    if (onlock) {
-      aft_unlock();
-    }
-    
+    aft_family_put(isbig, gen);
     return 0;
   }
   
-  if (!ch->init) {
-    if (onlock) {
-      aft_unlock();
-    }
-    
-    return 0;
-  }
-  
-  //-- Copy & Render
+  //-- Copy & Render on private glyph, cache & family no longer needed
   FT_Glyph glyph;
   FT_Glyph_Copy(ch->g, &glyph);
+  aft_family_put(isbig, gen);
   /* Outline Embolden - BOLD */
   byte embolded = 0;
   
@@ -693,7 +786,7 @@ byte aft_drawfont(CANVAS * _b, byte isbig, int fpos, int xpos, int ypos, color c
         
         if (ar + ag + ab > 0) {
           int bx = xpos + bit->left + xx;
-          int by = (ypos + yy + fh - m->y) - bit->top;
+          int by = (ypos + yy + fh - fy) - bit->top;
           color * dst = agxy(_b, bx, by);
           
           if (dst) {
@@ -713,7 +806,7 @@ byte aft_drawfont(CANVAS * _b, byte isbig, int fpos, int xpos, int ypos, color c
         
         if (a > 0) {
           int bx = xpos + bit->left + xx;
-          int by = (ypos + yy + fh - m->y) - bit->top;
+          int by = (ypos + yy + fh - fy) - bit->top;
           ag_subpixel(_b, bx, by, cl, a);
         }
       }
@@ -725,20 +818,15 @@ byte aft_drawfont(CANVAS * _b, byte isbig, int fpos, int xpos, int ypos, color c
   
   //-- Draw Underline
   if (underline) {
-    int usz = ceil(((float) m->p) / 12);
+    int usz = ceil(((float) fp) / 12);
     int ux, uy;
     
-    for (uy = m->p - usz; uy < m->p; uy++) {
+    for (uy = fp - usz; uy < fp; uy++) {
       for (ux = 0; ux < fw; ux++) {
         ag_setpixel(_b, xpos + ux, ypos + uy, cl);
       }
     }
   }
   
-  //-- Unlock
-  if (onlock) {
-    aft_unlock();
-  }
-  
   return 1;
 }
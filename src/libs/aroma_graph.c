@@ -31,11 +31,13 @@
 
 static int colorspace_positions[4] = {0, 0, 0, 0};
 
+#define AG_FRAME_MS   17      //-- Transition frame period, 60 fps
+
 /*****************************[ GLOBAL VARIABLES ]*****************************/
 static dword                           ag_fbsz = 0;
-static word              *             ag_fbuf = NULL;    //-- FrameBuffer Direct Memory
-static word              *             ag_b = NULL;       //-- FrameBuffer Cache Memory
-static word              *             ag_bz = NULL;      //-- FrameBuffer Cache Memory
+static color             *             ag_fbuf = NULL;    //-- FrameBuffer Direct Memory
+static color             *             ag_b = NULL;       //-- FrameBuffer Cache Memory
+static color             *             ag_bz = NULL;      //-- FrameBuffer Cache Memory
 static CANVAS                          ag_c;           //-- FrameBuffer Main Canvas
 static CANVAS                          ag_recovery;    //-- Saved Recovery Screen
 static pthread_t                       ag_pthread;     //-- FrameBuffer Thread Variables
@@ -97,9 +99,10 @@ int * ag_getcolorspace() {
 }
 
 void ag_changecolorspace(int r, int g, int b, __unused int a) {
-  libaroma_fb_changecolorspace(libaroma_fb(), r, g, b);
+  libaroma_fb_setrgb(r, g, b);
 }
 
+#ifndef _AROMA_CANVAS32
 color ag_dodither_rgb(int x, int y, byte sr, byte sg, byte sb) {
   byte dither_xy = ((y & 7) << 3) + (x & 7);
   byte r = ag_close_r(min(sr + dither_tresshold_r[dither_xy], 0xff));
@@ -111,22 +114,26 @@ color ag_dodither_rgb(int x, int y, byte sr, byte sg, byte sb) {
 color ag_dodither(int x, int y, dword col) {
   return ag_dodither_rgb(x, y, ag_r32(col), ag_g32(col), ag_b32(col));
 }
+#endif
 
 /****************************[ DECLARED FUNCTIONS ]*****************************/
 static void * ag_thread();
+static void ag_canvas_pool_release();
 void ag_refreshrate();
 
 /*******************[ CALCULATING ALPHA COLOR WITH NEON ]***********************/
-dword ag_calchighlight(color c1, color c2) {
-  color vc1 = ag_calculatealpha(c1, 0xffff, 40);
-  color vc2 = ag_calculatealpha(ag_calculatealpha(c1, c2, 110), 0xffff, 20);
-  return MAKEDWORD(vc1, vc2);
+colorpair ag_calchighlight(color c1, color c2) {
+  color white = ag_rgb(0xff, 0xff, 0xff);
+  color vc1   = ag_calculatealpha(c1, white, 40);
+  color vc2   = ag_calculatealpha(ag_calculatealpha(c1, c2, 110), white, 20);
+  return ag_pair(vc1, vc2);
 }
 
-dword ag_calcpushlight(color c1, color c2) {
-  color vc1 = ag_calculatealpha(c1, 0xffff, 20);
-  color vc2 = ag_calculatealpha(ag_calculatealpha(c1, c2, 100), 0xffff, 10);
-  return MAKEDWORD(vc1, vc2);
+colorpair ag_calcpushlight(color c1, color c2) {
+  color white = ag_rgb(0xff, 0xff, 0xff);
+  color vc1   = ag_calculatealpha(c1, white, 20);
+  color vc2   = ag_calculatealpha(ag_calculatealpha(c1, c2, 100), white, 10);
+  return ag_pair(vc1, vc2);
 }
 
 color ag_calpushad(color c_g) {
@@ -192,13 +199,13 @@ byte ag_init() {
 
   ag_canvas(&ag_c, libaroma_fb()->w, libaroma_fb()->h);
   ag_dp = floor( min(libaroma_fb()->w, libaroma_fb()->h) / 160);
-  agclp = 2;
-  ag_fbsz = libaroma_fb()->sz*2;
+  agclp = sizeof(color);
+  ag_fbsz = libaroma_fb()->sz * sizeof(color);
   ag_fbuf = libaroma_fb()->canvas;
-  ag_b    = (word *) malloc(ag_fbsz);
-  ag_bz   = (word *) malloc(ag_fbsz);
+  ag_b    = (color *) malloc(ag_fbsz);
+  ag_bz   = (color *) malloc(ag_fbsz);
   ag_16w  = libaroma_fb()->w / 2;
-  ag_line_length = libaroma_fb()->w*2;
+  ag_line_length = libaroma_fb()->w * sizeof(color);
   memcpy(ag_b, ag_fbuf, ag_fbsz);
   memcpy(ag_c.data, ag_fbuf, ag_fbsz);
 
@@ -206,8 +213,6 @@ byte ag_init() {
   ag_draw(&ag_recovery, &ag_c, 0, 0);
   ag_isrun = 1;
   pthread_create(&ag_pthread, NULL, ag_thread, NULL);
-  LOGS("Opening Freetype");
-  aft_open();
   return 1;
 }
 
@@ -222,6 +227,9 @@ byte ag_close_thread() {
 }
 
 color aAlphaB(color scl, byte l) {
+#ifdef _AROMA_CANVAS32
+  return libaroma_alphab(scl, l);
+#else
   if (l == 0) {
     return 0;
   }
@@ -237,6 +245,7 @@ color aAlphaB(color scl, byte l) {
       ((ag_g(scl) * na) >> 10 << 5) |
       ((ag_b(scl) * na) >> 11)
     );
+#endif
 }
 
 byte ag_draw_strecth(CANVAS * d,
@@ -279,9 +288,9 @@ byte ag_draw_strecth(CANVAS * d,
   int i, j;
   
   for (i = 0; i < dh; i++) {
-    word * t = d->data + (i + dy) * d->w + dx;
+    color * t = d->data + (i + dy) * d->w + dx;
     y2       = ((i * y_ratio) >> 16);
-    word * p = s->data + (y2 + sy) * s->w + sx;
+    color * p = s->data + (y2 + sy) * s->w + sx;
     int rat = 0;
     
     for (j = 0; j < dw; j++) {
@@ -337,9 +346,9 @@ byte ag_draw_strecth_ex(
   int i, j;
   
   for (i = 0; i < dh; i++) {
-    word * t = d->data + (i + dy) * d->w + dx;
+    color * t = d->data + (i + dy) * d->w + dx;
     y2       = ((i * y_ratio) >> 16);
-    word * p = s->data + (y2 + sy) * s->w + sx;
+    color * p = s->data + (y2 + sy) * s->w + sx;
     int rat = 0;
     
     if (withdest) {
@@ -361,40 +370,29 @@ byte ag_draw_strecth_ex(
   return 1;
 }
 
+static void ag_close_frame(void * data, CANVAS * scratch, int p) {
+  CANVAS * cbg  = (CANVAS *) data;
+  byte scale    = 0xff - p;
+  int wtarget   = (agw() * scale) >> 8;
+  int htarget   = (agh() * scale) >> 8;
+  ag_draw(NULL, &ag_recovery, 0, 0);
+  ag_draw_strecth_ex(
+    NULL,
+    cbg,
+    (agw() - wtarget) / 2, (agh() - htarget) / 2, wtarget, htarget,
+    0, 0, agw(), agh(), scale, 1
+  );
+}
+
 //-- RELEASE AMARULLZ GRAPHIC
 void ag_close() {
-  int fadesz = acfg()->fadeframes;
-  if (fadesz > 0) {
+  if (acfg()->fadeframes > 0) {
+    //-- Zoom out into the saved recovery screen
     CANVAS cbg;
-    ag_canvas(&cbg, agw(), agh());
+    ag_canvas_get(&cbg, agw(), agh());
     ag_draw(&cbg, agc(), 0, 0);
-    int xc    = agw() / 2;
-    int yc    = agh() / 2;
-    int i;
-    CANVAS * tmpb = (CANVAS *) malloc(sizeof(CANVAS) * fadesz);
-    memset(tmpb, 0, sizeof(CANVAS)*fadesz);
-    
-    for (i = 1; i <= fadesz; i++) {
-      byte scale  = 0xff - ((i * 0xff) / fadesz);
-      int wtarget = (agw() * scale) >> 8;
-      int htarget = (agh() * scale) >> 8;
-      ag_canvas(&tmpb[i - 1], agw(), agh());
-      ag_draw(&tmpb[i - 1], &ag_recovery, 0, 0);
-      ag_draw_strecth_ex(
-        &tmpb[i - 1],
-        &cbg,
-        xc - wtarget / 2, yc - htarget / 2, wtarget, htarget,
-        0, 0, agw(), agh(), scale, 1
-      );
-    }
-    ag_ccanvas(&cbg);
-    for (i = 0; i < fadesz; i++) {
-      ag_draw(NULL, &tmpb[i], 0, 0);
-      ag_ccanvas(&tmpb[i]);
-      ag_sync();
-    }
-    
-    free(tmpb);
+    ag_transition(ag_transition_ms(acfg()->fadeframes), 0, 0, ag_close_frame, &cbg);
+    ag_canvas_put(&cbg);
   }
   ag_draw(&ag_c, &ag_recovery, 0, 0);
   ag_ccanvas(&ag_recovery);
@@ -413,6 +411,7 @@ void ag_close() {
   }
   
   //-- Cleanup Canvas & FrameBuffer
+  ag_canvas_pool_release();
   ag_ccanvas(&ag_c);
   //-- Cleanup Freetype
   LOGS("Closing Freetype");
@@ -425,10 +424,14 @@ byte ag_isbusy  = 0;
 byte ag_refreshlock = 0;
 int  ag_busypos = 0;
 int  ag_busywinW = 0;
+static int  ag_busyrc[4] = {0, 0, 0, 0};  //-- Busy indicator area, x,y,w,h
+static byte ag_busyfull  = 0;             //-- Whole busy frame not posted yet
 long ag_lastbusy = 0;
 
 //-- Refresh Thread
 static void * ag_thread() {
+  ATRACE_THREAD("graph");
+  
   while (ag_isrun) {
     if (ag_isbusy != 2) {
       if (!ag_refreshlock) {
@@ -445,27 +448,33 @@ static void * ag_thread() {
   return NULL;
 }
 
-//-- Sync Display
+//-- Render the dimmed busy frame once, only the indicator animates
 void ag_copybusy(char * wait) {
   CANVAS tmpc;
-  ag_canvas(&tmpc, agw(), agh());
-  //ag_draw(&tmpc, &ag_c, 0, 0);
+  ag_canvas_get(&tmpc, agw(), agh());
   memcpy(tmpc.data, ag_b, ag_fbsz);
   ag_rectopa(&tmpc, 0, 0, agw(), agh(), 0x0000, 180);
   while (!(ag_fontready(0))) {
     usleep(50);
   }
   ag_oncopybusy = 1;
-  //char * wait = "Please Wait...";
   int txtW    = ag_txtwidth(wait, 0);
   int txtH    = ag_fontheight(0);
   int txtX    = (agw() / 2) - (txtW / 2);
   int txtY    = (agh() / 2) - (txtH / 2) - (agdp() * 2);
   ag_busywinW = agw() / 3;
-  ag_text(&tmpc, txtW, txtX, txtY, wait, 0xffff, 0);
+  ag_text(&tmpc, txtW, txtX, txtY, wait, ag_rgb(0xff, 0xff, 0xff), 0);
   ag_oncopybusy = 0;
+  
+  //-- Indicator track below the text
+  ag_busyrc[2] = ag_busywinW;
+  ag_busyrc[3] = max(agdp(), 2);
+  ag_busyrc[0] = (agw() - ag_busyrc[2]) / 2;
+  ag_busyrc[1] = min(txtY + txtH + (agdp() * 4), agh() - ag_busyrc[3]);
+  ag_rectopa(&tmpc, ag_busyrc[0], ag_busyrc[1], ag_busyrc[2], ag_busyrc[3], ag_rgb(0xff, 0xff, 0xff), 60);
   memcpy(ag_bz, tmpc.data, ag_fbsz);
-  ag_ccanvas(&tmpc);
+  ag_canvas_put(&tmpc);
+  ag_busyfull = 1;
 }
 
 void ag_setbusy() {
@@ -480,32 +489,51 @@ void ag_setbusy_withtext(char * text) {
   ag_isbusy = 2;
 }
 
+//-- Step the indicator, a segment running along the track.
+//-- Touches only the indicator rows of the display buffer
 void ag_busyprogress() {
   if (!ag_isbusy) {
     return;
   }
-  ag_busypos+=10;
-  if (ag_busypos>180) {
+  ag_busypos += 10;
+  if (ag_busypos > 180) {
     ag_busypos = 0;
   }
-  byte alp=0;
-  if (ag_busypos>90){
-    alp=255-(ag_busypos-90);
-  }
-  else{
-    alp=(255-90)+ag_busypos;
-  }
+  int bx  = ag_busyrc[0];
+  int bw  = ag_busyrc[2];
+  int seg = max(bw / 4, 1);
+  int x1  = ((ag_busypos * (bw + seg)) / 180) - seg;
+  int x2  = min(x1 + seg, bw);
+  x1      = max(x1, 0);
   int y;
-  for (y=0;y<libaroma_fb()->h;y++){
-    int p=y*libaroma_fb()->w;
-    libaroma_alpha_const_line(y, libaroma_fb()->w,ag_fbuf+p,ag_b+p,ag_bz+p,alp);
+  for (y = ag_busyrc[1]; y < ag_busyrc[1] + ag_busyrc[3]; y++) {
+    int p = (y * agw()) + bx;
+    memcpy(ag_fbuf + p, ag_bz + p, bw * sizeof(color));
+    int x;
+    for (x = x1; x < x2; x++) {
+      ag_fbuf[p + x] = ag_rgb(0xff, 0xff, 0xff);
+    }
   }
   if (!ag_isbusy) {
     ag_sync();
   }
 }
 
-void ag16fbufcopy(word * bfbz) {
+//-- Post the busy frame, whole frame once then the indicator area only
+static void ag_busysync() {
+  if (ag_busyfull) {
+    ag_busyfull = 0;
+    memcpy(ag_fbuf, ag_bz, ag_fbsz);
+    ag_busyprogress();
+    libaroma_fb_sync();
+  }
+  else {
+    ag_busyprogress();
+    libaroma_fb_sync_area(ag_busyrc[0], ag_busyrc[1], ag_busyrc[2], ag_busyrc[3]);
+  }
+}
+
+void ag16fbufcopy(color * bfbz) {
   memcpy(ag_fbuf,bfbz,ag_fbsz);
 }
 
@@ -520,9 +548,9 @@ void ag_drawcaret() {
         for (j = 0; j < crw; j++) {
           int xpos = ypos + ((ag_caret[0] + j) * agclp);
           if (xpos >= 0) {
-            if (xpos < ((int)ag_fbsz - 2)) {
-              int  xp     = xpos / 2;
-              word fbc    = ag_fbuf[xp];
+            if (xpos < ((int)ag_fbsz - agclp)) {
+              int   xp    = xpos / agclp;
+              color fbc   = ag_fbuf[xp];
               byte nr     = 255 - ag_r(fbc);
               byte ng     = 255 - ag_g(fbc);
               byte nb     = 255 - ag_b(fbc);
@@ -572,23 +600,57 @@ void ag_setcaret(int x, int y, int h) {
   ag_caret[3] = 1;
 }
 
+//-- Copy changed rows into display buffer, returns damaged row range
+static byte ag_fbuf_diff(color * src, int * y1, int * y2) {
+  int w = agw();
+  int h = agh();
+  int y;
+  *y1 = h;
+  *y2 = -1;
+  
+  for (y = 0; y < h; y++) {
+    color * d = ag_fbuf + (y * w);
+    color * s = src + (y * w);
+    
+    if (memcmp(d, s, w * sizeof(color))) {
+      memcpy(d, s, w * sizeof(color));
+      
+      if (y < *y1) {
+        *y1 = y;
+      }
+      
+      *y2 = y;
+    }
+  }
+  
+  return (*y2 >= *y1) ? 1 : 0;
+}
+
 byte ag_have_sync = 0;
 void ag_refreshrate() {
   if (ag_isbusy == 0) {
-    memcpy(ag_fbuf, ag_b, ag_fbsz);
+    int y1, y2;
+    ag_fbuf_diff(ag_b, &y1, &y2);
+    
+    //-- Caret rows are inverted after the copy
+    if ((ag_caret[2] > 0) && (ag_caret[3] != 0)) {
+      y1 = min(y1, max(ag_caret[1], 0));
+      y2 = max(y2, min(ag_caret[1] + ag_caret[2], agh()) - 1);
+    }
+    
     ag_drawcaret();
-    libaroma_fb_sync();
+    
+    if (y2 >= y1) {
+      libaroma_fb_sync_area(0, y1, agw(), y2 - y1 + 1);
+    }
   }
   else if (ag_isbusy == 2) {
-    memcpy(ag_fbuf, ag_bz, ag_fbsz);
-    ag_busyprogress();
-    libaroma_fb_sync();
+    ag_busysync();
   }
   else if (ag_lastbusy < alib_tick() - 50) {
     ag_copybusy("Please Wait...");
     ag_isbusy = 2;
-    memcpy(ag_fbuf, ag_bz, ag_fbsz);
-    libaroma_fb_sync();
+    ag_busysync();
   }
   else if (ag_have_sync){
     ag_have_sync=0;
@@ -599,15 +661,21 @@ void ag_refreshrate() {
 byte ag_sync_locked = 0;
 //-- Sync Display
 void ag_sync() {
+  ATRACE_SCOPE("ag_sync");
   //-- Always On Footer
   ag_isbusy = 0;
   
   if (!ag_sync_locked) {
+    long long t0 = areplay_active() ? areplay_us() : 0;
     ag_refreshlock = 1;
     ag_have_sync = 1;
     memcpy(ag_b, ag_c.data, ag_fbsz);
     ag_refreshrate();
     ag_refreshlock = 0;
+    
+    if (t0) {
+      areplay_sync(t0);
+    }
   }
 }
 
@@ -623,17 +691,36 @@ static void * ag_sync_fade_thread(void * cookie) {
   ag_isbusy = 0;
   ag_sync_locked = 1;
   ag_refreshlock = 1;
-
-  int i;
   
-  for (i = 0; (i < (frame / 2)) && ag_sync_locked; i++) {
-    byte perc = (255 / frame) * i;
-    libaroma_alpha_const(libaroma_fb()->sz,
-      ag_b, ag_b, ag_c.data, perc);
-    ag_have_sync = 1;
-    ag_refreshrate();
-    usleep(16000);
+  //-- Half way over the nominal time, the final sync does the rest
+  long duration = ag_transition_ms(frame) / 2;
+  long start    = aTick();
+  int  shown    = 0;
+  
+  while ((shown < 128) && ag_sync_locked) {
+    long now  = aTick();
+    int  p    = (duration > 0) ? ((now - start + AG_FRAME_MS) * 128) / duration : 128;
+    
+    if (p > 128) {
+      p = 128;
+    }
+    
+    //-- Blend the displayed frame the rest of the way to p
+    if (p > shown) {
+      libaroma_alpha_const(libaroma_fb()->sz,
+        ag_b, ag_b, ag_c.data, ((p - shown) * 255) / (256 - shown));
+      shown = p;
+      ag_have_sync = 1;
+      ag_refreshrate();
+    }
+    
+    long next = start + (((long) shown * duration) / 128) + AG_FRAME_MS;
+    
+    if ((shown < 128) && (next > aTick())) {
+      usleep((next - aTick()) * 1000);
+    }
   }
+  
   ag_refreshlock = 0;
   ag_sync_locked = 0;
   ag_sync();
@@ -650,6 +737,42 @@ void ag_sync_fade(int frame) {
   pthread_detach(threadsyncfade);
 }
 
+//-- Transition length, frame counts are from the 60 fps theme config
+int ag_transition_ms(int frame) {
+  return frame * AG_FRAME_MS;
+}
+
+//-- Timed transition, each frame renders the progress at its own display
+//-- time, late frames are skipped. Scratch is a pooled w x h canvas
+void ag_transition(int duration, int w, int h, AG_TRANSFN fn, void * data) {
+  CANVAS scratch;
+  memset(&scratch, 0, sizeof(CANVAS));
+  
+  if ((w > 0) && (h > 0)) {
+    ag_canvas_get(&scratch, w, h);
+  }
+  
+  ATRACE_SCOPE("ag_transition");
+  long start  = aTick();
+  int  p      = 0;
+  
+  while (p < 255) {
+    long t = aTick() - start + AG_FRAME_MS;
+    p = ((duration > 0) && (t < duration)) ? (t * 255) / duration : 255;
+    fn(data, &scratch, p);
+    ag_sync();
+    
+    //-- Ahead of time, wait for the next frame slot
+    long next = start + (((long) p * duration) / 255);
+    
+    if ((p < 255) && (next > aTick())) {
+      usleep((next - aTick()) * 1000);
+    }
+  }
+  
+  ag_canvas_put(&scratch);
+}
+
 byte ag_blur_h(CANVAS * d, CANVAS * s, int radius) {
   if (radius < 1) {
     return 0;
@@ -810,10 +933,10 @@ byte ag_blur(CANVAS * d, CANVAS * s, int radius) {
   }
   
   CANVAS tmp;
-  ag_canvas(&tmp, s->w, s->h);
+  ag_canvas_get(&tmp, s->w, s->h);
   ag_blur_h(&tmp, s, radius);
   ag_blur_v(d, &tmp, radius);
-  ag_ccanvas(&tmp);
+  ag_canvas_put(&tmp);
   return 1;
 }
 
@@ -821,7 +944,7 @@ byte ag_blur(CANVAS * d, CANVAS * s, int radius) {
 void ag_canvas(CANVAS * c, int w, int h) {
   c->w      = w;
   c->h      = h;
-  c->sz     = (w * h * 2);
+  c->sz     = (w * h * sizeof(color));
   c->data   = (color *) malloc(c->sz);
   memset(c->data, 0, c->sz);
 }
@@ -835,6 +958,85 @@ void ag_ccanvas(CANVAS * c) {
   c->data = NULL;
 }
 
+//-- CANVAS POOL, recycled buffers for short lived canvases
+#define AG_POOL_SLOTS 8
+static CANVAS           ag_pool[AG_POOL_SLOTS];
+static pthread_mutex_t  ag_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int              ag_pool_out   = 0;   //-- Canvases handed out
+static int              ag_pool_hwm   = 0;   //-- High-water mark of ag_pool_out
+static long             ag_pool_hits  = 0;
+static long             ag_pool_miss  = 0;
+
+//-- Pooled canvas, content is undefined. Release with ag_canvas_put
+void ag_canvas_get(CANVAS * c, int w, int h) {
+  int i;
+  c->w    = w;
+  c->h    = h;
+  c->sz   = (w * h * sizeof(color));
+  c->data = NULL;
+  pthread_mutex_lock(&ag_pool_mutex);
+  
+  for (i = 0; i < AG_POOL_SLOTS; i++) {
+    if ((ag_pool[i].data != NULL) && (ag_pool[i].w == w) && (ag_pool[i].h == h)) {
+      c->data           = ag_pool[i].data;
+      ag_pool[i].data   = NULL;
+      break;
+    }
+  }
+  
+  if (c->data != NULL) {
+    ag_pool_hits++;
+  }
+  else {
+    ag_pool_miss++;
+  }
+  
+  if (++ag_pool_out > ag_pool_hwm) {
+    ag_pool_hwm = ag_pool_out;
+  }
+  
+  pthread_mutex_unlock(&ag_pool_mutex);
+  
+  if (c->data == NULL) {
+    c->data = (color *) malloc(c->sz);
+  }
+}
+
+//-- Return canvas into the pool, freed when no slot is left
+void ag_canvas_put(CANVAS * c) {
+  int i;
+  
+  if (c->data == NULL) {
+    return;
+  }
+  
+  pthread_mutex_lock(&ag_pool_mutex);
+  ag_pool_out--;
+  
+  for (i = 0; i < AG_POOL_SLOTS; i++) {
+    if (ag_pool[i].data == NULL) {
+      ag_pool[i]  = *c;
+      c->data     = NULL;
+      break;
+    }
+  }
+  
+  pthread_mutex_unlock(&ag_pool_mutex);
+  ag_ccanvas(c);
+}
+
+static void ag_canvas_pool_release() {
+  int i;
+  pthread_mutex_lock(&ag_pool_mutex);
+  LOGS("Canvas pool: %ld hits, %ld misses, high-water %d", ag_pool_hits, ag_pool_miss, ag_pool_hwm);
+  
+  for (i = 0; i < AG_POOL_SLOTS; i++) {
+    ag_ccanvas(&ag_pool[i]);
+  }
+  
+  pthread_mutex_unlock(&ag_pool_mutex);
+}
+
 //-- Get Main Canvas
 CANVAS * agc() {
   return &ag_c;
@@ -931,11 +1133,11 @@ byte ag_draw_ex(CANVAS * dc, CANVAS * sc, int dx, int dy, int sx, int sy, int sw
   }
 
   int y;
-  int pos_sr_x = sr_x * 2;
-  int pos_ds_x = ds_x * 2;
-  int pos_sc_w = sc->w * 2;
-  int pos_dc_w = dc->w * 2;
-  int copy_sz  = sr_w * 2;
+  int pos_sr_x = sr_x * sizeof(color);
+  int pos_ds_x = ds_x * sizeof(color);
+  int pos_sc_w = sc->w * sizeof(color);
+  int pos_dc_w = dc->w * sizeof(color);
+  int copy_sz  = sr_w * sizeof(color);
   byte * src   = ((byte *) sc->data);
   byte * dst   = ((byte *) dc->data);
 
@@ -1879,6 +2081,130 @@ int ag_txtwidth(const char * ss, byte isbig) {
   return w;
 }
 
+//-- Longest glyph count k with adv[k] <= lim
+static int ag_txtfit_prefix(int * adv, int n, int lim) {
+  int lo = 0;
+  int hi = n;
+  
+  while (lo < hi) {
+    int mid = (lo + hi + 1) / 2;
+    
+    if (adv[mid] <= lim) {
+      lo = mid;
+    }
+    else {
+      hi = mid - 1;
+    }
+  }
+  
+  return lo;
+}
+
+//-- First glyph k with adv[n] - adv[k] <= lim
+static int ag_txtfit_suffix(int * adv, int n, int lim) {
+  int lo = 0;
+  int hi = n;
+  
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    
+    if (adv[n] - adv[mid] <= lim) {
+      hi = mid;
+    }
+    else {
+      lo = mid + 1;
+    }
+  }
+  
+  return lo;
+}
+
+//-- Fit 1 line text into maxwidth with an ellipsis, NULL when it already fits.
+//   Advances are measured once, the cut points are binary searched.
+char * ag_txtfit(const char * ss, int maxwidth, byte isbig, byte mode, int * width) {
+  if (width != NULL) {
+    *width = 0;
+  }
+  
+  if (!ag_fontready(isbig)) {
+    return NULL;
+  }
+  
+  char * sams = alang_ams(ss);
+  int    len  = strlen(sams);
+  int *  pos  = (int *) malloc(sizeof(int) * (len + 1) * 2);
+  int *  adv  = pos + (len + 1);
+  int    n    = 0;
+  int    w    = 0;
+  int    off;
+  int    move = 0;
+  int    p    = 0;
+  const char * s = sams;
+  pos[0] = 0;
+  adv[0] = 0;
+  
+  //-- Glyph boundaries & cumulative advances, as ag_txtwidth
+  while ((off = utf8c(s, &s, &move))) {
+    if ((move == 1) && (ag_check_escape(&off, &s, NULL, 1, NULL))) {
+      continue;
+    }
+    
+    if (off == '\t') {
+      w += ag_tabwidth(w, isbig);
+    }
+    else {
+      w += ag_fontwidth_kerning(off, p, isbig);
+    }
+    
+    p = off;
+    n++;
+    pos[n] = s - sams;
+    adv[n] = w;
+  }
+  
+  if (w < maxwidth) {
+    if (width != NULL) {
+      *width = w;
+    }
+    
+    free(pos);
+    free(sams);
+    return NULL;
+  }
+  
+  int ew    = ag_fontwidth('.', isbig) * 3;
+  int avail = max(maxwidth - ew, 0);
+  int pre   = 0;                        //-- Glyphs kept at the start
+  int suf   = n;                        //-- First glyph kept at the end
+  
+  if (mode == AG_ELLIPSIS_END) {
+    pre = ag_txtfit_prefix(adv, n, avail);
+  }
+  else if (mode == AG_ELLIPSIS_START) {
+    suf = ag_txtfit_suffix(adv, n, avail);
+  }
+  else {
+    pre = ag_txtfit_prefix(adv, n, avail / 2);
+    suf = ag_txtfit_suffix(adv, n, avail - adv[pre]);
+  }
+  
+  int    plen = pos[pre];
+  int    slen = len - pos[suf];
+  char * res  = (char *) malloc(plen + slen + 4);
+  memcpy(res, sams, plen);
+  memcpy(res + plen, "...", 3);
+  memcpy(res + plen + 3, sams + pos[suf], slen);
+  res[plen + slen + 3] = 0;
+  
+  if (width != NULL) {
+    *width = adv[pre] + ew + (adv[n] - adv[suf]);
+  }
+  
+  free(pos);
+  free(sams);
+  return res;
+}
+
 int ag_fontheight(byte isbig) {
   if (!ag_fontready(isbig)) {
     return 0;
@@ -2227,6 +2553,7 @@ void ag_txtxy(int * x, int * y, int maxwidth, const char * ss, byte isbig, int h
 
 /* DRAW TEXT */
 byte ag_text_exl(CANVAS * _b, int maxwidth, int x, int y, const char * ss, color cl_def, byte isbig, byte forcecolor, byte multiline) {
+  ATRACE_SCOPE("ag_text_exl");
   if (maxwidth == 0) {
     return 0;
   }
@@ -2572,16 +2899,8 @@ byte ag_text_exl(CANVAS * _b, int maxwidth, int x, int y, const char * ss, color
   return 1;
 }
 
-/* SCREENSHOOT */
-static int ag_takescreenshoot_n = 1;
-void ag_takescreenshoot() {
-  char filename[256];
-  
-  do {
-    snprintf(filename, 256, "%s.screenshoot-%i.bmp", getArgv(1), ag_takescreenshoot_n++);
-  }
-  while (file_exists(filename));
-  
+/* SAVE RGB565 PIXELS AS BMP */
+byte ag_savebmp(const char * filename, color * data, int w, int h) {
 #pragma pack(push, 1)
   typedef struct {
     /* Header */
@@ -2605,33 +2924,58 @@ void ag_takescreenshoot() {
     dword color_important;
     dword colorspace[3];
   } BMPI;
+#pragma pack(pop)
   BMPH bmph;
   BMPI bmpi;
+  dword datasz = w * h * sizeof(color);
   memset(&bmph, 0, sizeof(BMPH));
   memset(&bmpi, 0, sizeof(BMPI));
   bmph.sig1   = 'B';
   bmph.sig2   = 'M';
   bmpi.sz     = sizeof(BMPI) - 12;
-  bmpi.w      = ag_c.w;
-  bmpi.h      = 0 - ag_c.h;
+  bmpi.w      = w;
+  bmpi.h      = 0 - h;
   bmpi.planes = 1;
-  bmpi.bit    = 16;
+  bmpi.bit    = sizeof(color) * 8;
   bmpi.compressor = 0x00000003;
-  bmpi.compress_sz = ag_c.sz;
+  bmpi.compress_sz = datasz;
+#ifdef _AROMA_CANVAS32
+  /* XRGB8888 */
+  bmpi.colorspace[0] = 0xFF0000;
+  bmpi.colorspace[1] = 0x00FF00;
+  bmpi.colorspace[2] = 0x0000FF;
+#else
   /* 565 */
   bmpi.colorspace[0] = 0x00F800;
   bmpi.colorspace[1] = 0x0007E0;
   bmpi.colorspace[2] = 0x00001F;
+#endif
   bmph.dataoffset = sizeof(BMPH) + sizeof(BMPI);
-  bmph.filesize   = ag_c.sz + bmph.dataoffset;
+  bmph.filesize   = datasz + bmph.dataoffset;
   FILE * fp = fopen(filename, "wb");
   
-  if (fp != NULL) {
-    fwrite(&bmph, 1, sizeof(BMPH), fp);
-    fwrite(&bmpi, 1, sizeof(BMPI), fp);
-    fwrite(ag_c.data, 1, ag_c.sz, fp);
-    fclose(fp);
-    LOGS("Save on \"%s\" %i Bytes", filename, bmph.filesize);
+  if (fp == NULL) {
+    return 0;
+  }
+  
+  fwrite(&bmph, 1, sizeof(BMPH), fp);
+  fwrite(&bmpi, 1, sizeof(BMPI), fp);
+  fwrite(data, 1, datasz, fp);
+  fclose(fp);
+  return 1;
+}
+
+/* SCREENSHOOT */
+static int ag_takescreenshoot_n = 1;
+void ag_takescreenshoot() {
+  char filename[256];
+  
+  do {
+    snprintf(filename, 256, "%s.screenshoot-%i.bmp", getArgv(1), ag_takescreenshoot_n++);
+  }
+  while (file_exists(filename));
+  
+  if (ag_savebmp(filename, ag_c.data, ag_c.w, ag_c.h)) {
+    LOGS("Save on \"%s\"", filename);
   }
-#pragma pack(pop)
 }
@@ -28,6 +28,7 @@
 #include <sys/poll.h>
 #include <linux/input.h>
 #include <pthread.h>
+#include <sched.h>
 #include <aroma.h>
 
 //-- Input Device
@@ -36,16 +37,43 @@
 //-- GLOBAL EVENT VARIABLE
 static  char      key_pressed[KEY_MAX + 1];
 
-//-- AROMA CUSTOM MESSAGE
-static  dword     atouch_winmsg[64];
-static  byte      atouch_winmsg_n = 0;
+//-- INPUT EVENT QUEUE ITEM
+typedef struct {
+  int   key;      //-- Key Code or evtouch_code
+  int   value;    //-- Key/Touch State at post time
+  int   x;        //-- Touch X
+  int   y;        //-- Touch Y
+  long  t;        //-- Post Tick
+  dword gen;      //-- Touch Gesture Generation
+} AEV_ITEM;
+
+//-- INPUT EVENT RING (Single Producer: input thread, Single Consumer: UI)
+#define AEV_RING_SZ       256
+static  AEV_ITEM  ev_ring[AEV_RING_SZ];
+static  dword     ev_ring_head = 0;   //-- Owned by consumer
+static  dword     ev_ring_tail = 0;   //-- Owned by producer
+static  AEV_ITEM  ev_current;         //-- Last dequeued event
+
+//-- COALESCED TOUCH MOVE (seqlock, written by input thread only)
+static  AEV_ITEM  ev_move;
+static  dword     ev_move_seq     = 0;
+static  byte      ev_move_pending = 0;  //-- A move marker is in the ring
+static  dword     ev_touch_gen    = 0;
+
+//-- AROMA CUSTOM MESSAGE RING (Multi Producer, Single Consumer)
+#define AEV_MSG_SZ        64
+typedef struct {
+  dword seq;
+  dword msg;
+} AEV_MSG_CELL;
+static  AEV_MSG_CELL atouch_winmsg[AEV_MSG_SZ];
+static  dword     atouch_winmsg_enq = 0;
+static  dword     atouch_winmsg_deq = 0;
 static  int       atouch_message_code = 889;
 
-//-- KEY QUEUE
-static  int       key_queue[256];
-static  int       key_queue_len = 0;
-static pthread_mutex_t key_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_cond_t key_queue_cond = PTHREAD_COND_INITIALIZER;
+//-- CONSUMER SLEEP/WAKE
+static pthread_mutex_t ev_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  ev_wait_cond  = PTHREAD_COND_INITIALIZER;
 
 //-- TOUCH SCREEN VAR
 static  byte      evthread_active = 1;
@@ -65,32 +93,133 @@ int ontouch() {
   return ((evtouch_state == 0) ? 0 : 1);
 }
 
-dword atouch_winmsg_get(byte cleanup) {
-  dword out = 0;
+//-- Wake up consumer
+static void ev_wake() {
+  pthread_mutex_lock(&ev_wait_mutex);
+  pthread_cond_signal(&ev_wait_cond);
+  pthread_mutex_unlock(&ev_wait_mutex);
+}
+
+//-- Push into input ring - producer side
+static byte ev_ring_push(AEV_ITEM * e) {
+  dword tail = __atomic_load_n(&ev_ring_tail, __ATOMIC_RELAXED);
+  dword head = __atomic_load_n(&ev_ring_head, __ATOMIC_ACQUIRE);
   
-  if (atouch_winmsg_n > 0) {
-    out = atouch_winmsg[0];
-    
-    if (cleanup) {
-      int i = 0;
-      
-      for (i = 0; i < atouch_winmsg_n; i++) {
-        atouch_winmsg[i] = atouch_winmsg[i + 1];
-      }
-      
-      atouch_winmsg_n--;
+  if (tail - head >= AEV_RING_SZ) {
+    return 0;
+  }
+  
+  ev_ring[tail & (AEV_RING_SZ - 1)] = *e;
+  __atomic_store_n(&ev_ring_tail, tail + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+//-- Pop from input ring - consumer side
+static byte ev_ring_pop(AEV_ITEM * e) {
+  dword head = __atomic_load_n(&ev_ring_head, __ATOMIC_RELAXED);
+  dword tail = __atomic_load_n(&ev_ring_tail, __ATOMIC_ACQUIRE);
+  
+  if (head == tail) {
+    return 0;
+  }
+  
+  *e = ev_ring[head & (AEV_RING_SZ - 1)];
+  __atomic_store_n(&ev_ring_head, head + 1, __ATOMIC_RELEASE);
+  return 1;
+}
+
+//-- Is any message waiting - consumer side
+static byte atouch_winmsg_ready() {
+  dword deq = atouch_winmsg_deq;
+  dword seq = __atomic_load_n(&atouch_winmsg[deq & (AEV_MSG_SZ - 1)].seq, __ATOMIC_ACQUIRE);
+  return (seq == deq + 1) ? 1 : 0;
+}
+
+//-- Is any event waiting - consumer side
+static byte ev_ring_ready() {
+  if (atouch_winmsg_ready()) {
+    return 1;
+  }
+  
+  return (__atomic_load_n(&ev_ring_head, __ATOMIC_RELAXED) !=
+          __atomic_load_n(&ev_ring_tail, __ATOMIC_ACQUIRE)) ? 1 : 0;
+}
+
+//-- Read coalesced move - consumer side
+static void ev_move_read(AEV_ITEM * e) {
+  AEV_ITEM m;
+  dword    seq;
+  
+  do {
+    while ((seq = __atomic_load_n(&ev_move_seq, __ATOMIC_ACQUIRE)) & 1) {
+      sched_yield();
     }
+    
+    m = ev_move;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  }
+  while (seq != __atomic_load_n(&ev_move_seq, __ATOMIC_RELAXED));
+  
+  //-- Only use it if still on the same gesture
+  if (m.gen == e->gen) {
+    *e = m;
+  }
+}
+
+void atouch_winmsg_init() {
+  int i;
+  
+  for (i = 0; i < AEV_MSG_SZ; i++) {
+    atouch_winmsg[i].seq = i;
+  }
+  
+  atouch_winmsg_enq = 0;
+  atouch_winmsg_deq = 0;
+}
+dword atouch_winmsg_get(byte cleanup) {
+  dword deq = atouch_winmsg_deq;
+  AEV_MSG_CELL * c = &atouch_winmsg[deq & (AEV_MSG_SZ - 1)];
+  
+  if (!atouch_winmsg_ready()) {
+    return 0;
+  }
+  
+  dword out = c->msg;
+  
+  if (cleanup) {
+    __atomic_store_n(&c->seq, deq + AEV_MSG_SZ, __ATOMIC_RELEASE);
+    atouch_winmsg_deq = deq + 1;
   }
   
   return out;
 }
 byte atouch_winmsg_push(dword msg) {
-  if (atouch_winmsg_n < 64) {
-    atouch_winmsg[atouch_winmsg_n++] = msg;
-    return 1;
+  dword enq = __atomic_load_n(&atouch_winmsg_enq, __ATOMIC_RELAXED);
+  AEV_MSG_CELL * c;
+  
+  while (1) {
+    c = &atouch_winmsg[enq & (AEV_MSG_SZ - 1)];
+    dword seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+    int   dif = (int) (seq - enq);
+    
+    if (dif == 0) {
+      if (__atomic_compare_exchange_n(&atouch_winmsg_enq, &enq, enq + 1, 1,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    }
+    else if (dif < 0) {
+      //-- Full
+      return 0;
+    }
+    else {
+      enq = __atomic_load_n(&atouch_winmsg_enq, __ATOMIC_RELAXED);
+    }
   }
   
-  return 0;
+  c->msg = msg;
+  __atomic_store_n(&c->seq, enq + 1, __ATOMIC_RELEASE);
+  return 1;
 }
 
 float vibrate_rate = 0.5;
@@ -133,17 +262,49 @@ void set_key_pressed(int key, char val) {
 }
 
 //-- INPUT EVENT POST MESSAGE
-void ev_post_message(int key, int value) {
+void ev_post_message_ex(int key, int value, int x, int y, long t) {
   set_key_pressed(key, value);
-  pthread_mutex_lock(&key_queue_mutex);
-  const int queue_max = sizeof(key_queue) / sizeof(key_queue[0]);
+  AEV_ITEM e;
+  e.key   = key;
+  e.value = value;
+  e.x     = x;
+  e.y     = y;
+  e.t     = t;
+  e.gen   = ev_touch_gen;
   
-  if (key_queue_len < queue_max) {
-    key_queue[key_queue_len++] = key;
-    pthread_cond_signal(&key_queue_cond);
+  if (ev_ring_push(&e)) {
+    ev_wake();
   }
+}
+void ev_post_message(int key, int value) {
+  ev_post_message_ex(key, value, evtouch_x, evtouch_y, aTick());
+}
+
+//-- TOUCH MOVE POST MESSAGE - Coalesced into one pending event
+void ev_post_move(int x, int y, long t) {
+  AEV_ITEM e;
+  e.key   = evtouch_code;
+  e.value = 2;
+  e.x     = x;
+  e.y     = y;
+  e.t     = t;
+  e.gen   = ev_touch_gen;
   
-  pthread_mutex_unlock(&key_queue_mutex);
+  //-- Publish latest position
+  __atomic_store_n(&ev_move_seq, ev_move_seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  ev_move = e;
+  __atomic_store_n(&ev_move_seq, ev_move_seq + 1, __ATOMIC_RELEASE);
+  
+  //-- Only queue a marker if consumer already took the previous one
+  if (__atomic_exchange_n(&ev_move_pending, 1, __ATOMIC_ACQ_REL) == 0) {
+    if (ev_ring_push(&e)) {
+      ev_wake();
+    }
+    else {
+      __atomic_store_n(&ev_move_pending, 0, __ATOMIC_RELEASE);
+    }
+  }
 }
 
 //-- INPUT CALLBACK
@@ -193,9 +354,41 @@ void ev_input_callback_(struct input_event * ev) {
   }
 }
 
-byte touch_move_sent = 0;
+//-- Touch event from the producer thread
+static void ev_post_touch(int x, int y, int state, long t) {
+  evtouch_x = x;
+  evtouch_y = y;
+  evtouch_state = state;
+  
+  if (state == 2) {
+    ev_post_move(x, y, t);
+  }
+  else {
+    //-- New gesture, pending move belong to the old one
+    ev_touch_gen++;
+    __atomic_store_n(&ev_move_pending, 0, __ATOMIC_RELEASE);
+    ev_post_message_ex(evtouch_code, state, x, y, t);
+  }
+}
+
+//-- Synthetic input, only from the replay thread
+void ev_inject_touch(int x, int y, int state) {
+  ev_post_touch(x, y, state, aTick());
+}
+void ev_inject_key(int key, int state) {
+  ev_post_message_ex(key, state, evtouch_x, evtouch_y, aTick());
+}
+
+//-- REPLAY THREAD, takes the place of the input thread
+static void * ev_replay_thread() {
+  ATRACE_THREAD("replay");
+  areplay_run();
+  return NULL;
+}
+
 //-- INPUT THREAD
 static void * ev_input_thread() {
+  ATRACE_THREAD("input");
   //-- Loop for Input
   while (evthread_active) {
     AINPUT_EVENT e;
@@ -207,25 +400,7 @@ static void * ev_input_thread() {
     
     if (ret == AINPUT_EV_RET_TOUCH) {
       if ((e.x > 0) && (e.y > 0)) {
-        if (e.state == 2) {
-          evtouch_x = e.x;
-          evtouch_y = e.y;
-          evtouch_state = e.state;
-          
-          if (touch_move_sent == 0) {
-            touch_move_sent = 1;
-            ev_post_message(evtouch_code, evtouch_state);
-          }
-          else {
-            touch_move_sent = 2;
-          }
-        }
-        else {
-          evtouch_x = e.x;
-          evtouch_y = e.y;
-          evtouch_state = e.state;
-          ev_post_message(evtouch_code, evtouch_state);
-        }
+        ev_post_touch(e.x, e.y, e.state, e.t);
       }
       else {
         //-- False Event
@@ -235,7 +410,7 @@ static void * ev_input_thread() {
       }
     }
     else if (e.type == AINPUT_EV_TYPE_KEY) {
-      ev_post_message(e.key, e.state);
+      ev_post_message_ex(e.key, e.state, evtouch_x, evtouch_y, e.t);
     }
   }
   
@@ -246,11 +421,19 @@ void ui_init() {
   ev_init();
 }
 int ev_init() {
-  aipInit();
+  atouch_winmsg_init();
   //-- Create Watcher Thread
   evthread_active = 1;
   pthread_t input_thread_t;
-  pthread_create(&input_thread_t, NULL, ev_input_thread, NULL);
+  
+  if (areplay_active()) {
+    pthread_create(&input_thread_t, NULL, ev_replay_thread, NULL);
+  }
+  else {
+    aipInit();
+    pthread_create(&input_thread_t, NULL, ev_input_thread, NULL);
+  }
+  
   pthread_detach(input_thread_t);
   return 0;
 }
@@ -258,58 +441,71 @@ int ev_init() {
 //-- RELEASE INPUT DEVICE
 void ev_exit(void) {
   evthread_active = 0;
-  aipRelease();
+  
+  if (!areplay_active()) {
+    aipRelease();
+  }
 }
 
 //-- SEND ATOUCH CUSTOM MESSAGE
 byte atouch_send_message(dword msg) {
   if (atouch_winmsg_push(msg)) {
-    ev_post_message(atouch_message_code, 0);
+    ev_wake();
     return 1;
   }
   
   return 0;
 }
 
-//-- Clear Queue
-void ui_clear_key_queue_ex() {
-  pthread_mutex_lock(&key_queue_mutex);
-  key_queue_len = 0;
-  pthread_mutex_unlock(&key_queue_mutex);
-  atouch_winmsg_n = 0;
+//-- Clear Queue - Consumer side
+static void ev_ring_clear() {
+  __atomic_store_n(&ev_ring_head,
+                   __atomic_load_n(&ev_ring_tail, __ATOMIC_ACQUIRE),
+                   __ATOMIC_RELEASE);
+  __atomic_store_n(&ev_move_pending, 0, __ATOMIC_RELEASE);
 }
-void ui_clear_key_queue() {
-  pthread_mutex_lock(&key_queue_mutex);
-  key_queue_len = 0;
-  pthread_mutex_unlock(&key_queue_mutex);
+void ui_clear_key_queue_ex() {
+  ev_ring_clear();
   
-  if (atouch_winmsg_n > 0) {
-    ev_post_message(atouch_message_code, 0);
+  while (atouch_winmsg_ready()) {
+    atouch_winmsg_get(1);
   }
 }
+void ui_clear_key_queue() {
+  ev_ring_clear();
+}
 
 //-- Wait For Key
 int ui_wait_key() {
-  pthread_mutex_lock(&key_queue_mutex);
-  int key = 0;
-  
-  if (touch_move_sent == 2) {
-    touch_move_sent = 1;
-    key = evtouch_code;
-  }
-  else {
-    touch_move_sent = 0;
+  while (1) {
+    //-- Custom Messages go first
+    if (atouch_winmsg_ready()) {
+      memset(&ev_current, 0, sizeof(AEV_ITEM));
+      ev_current.key = atouch_message_code;
+      ev_current.t   = aTick();
+      return ev_current.key;
+    }
     
-    while (key_queue_len == 0) {
-      pthread_cond_wait(&key_queue_cond, &key_queue_mutex);
+    if (ev_ring_pop(&ev_current)) {
+      if ((ev_current.key == evtouch_code) && (ev_current.value == 2)) {
+        //-- Allow producer to queue next move, then take the latest one
+        __atomic_store_n(&ev_move_pending, 0, __ATOMIC_RELEASE);
+        ev_move_read(&ev_current);
+      }
+      
+      return ev_current.key;
+    }
+    
+    pthread_mutex_lock(&ev_wait_mutex);
+    
+    while (!ev_ring_ready()) {
+      pthread_cond_wait(&ev_wait_cond, &ev_wait_mutex);
     }
     
-    key = key_queue[0];
-    memcpy(&key_queue[0], &key_queue[1], sizeof(int) * --key_queue_len);
+    pthread_mutex_unlock(&ev_wait_mutex);
   }
   
-  pthread_mutex_unlock(&key_queue_mutex);
-  return key;
+  return 0;
 }
 
 //-- AROMA Input Handler
@@ -331,18 +527,20 @@ int atouch_wait_ex(ATEV * atev) {
       atev->x   = 0;
       atev->y   = 0;
       atev->k   = 0;
+      atev->t   = ev_current.t;
       return ATEV_MESSAGE;
     }
     
-    atev->d = ui_key_pressed(key);
+    atev->d = ev_current.value;
     atev->k = key;
+    atev->t = ev_current.t;
     
     if (key == evtouch_code) {
-      if ((evtouch_x > 0) && (evtouch_y > 0)) {
-        atev->x = evtouch_x;
-        atev->y = evtouch_y;
+      if ((ev_current.x > 0) && (ev_current.y > 0)) {
+        atev->x = ev_current.x;
+        atev->y = ev_current.y;
         
-        switch (evtouch_state) {
+        switch (ev_current.value) {
           case 1:
             return ATEV_MOUSEDN;
             break;
@@ -26,6 +26,8 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <sys/poll.h>
+#include <sys/inotify.h>
 #include <aroma.h>
 
 /* Micro Sleep */
@@ -169,73 +171,6 @@ char * ai_trim(char * chr) {
   
   return res;
 }
-byte ismounted(char * path) {
-  byte res = 0;
-  FILE * fp = fopen("/proc/mounts", "rb");
-  
-  if (fp) {
-    int c = EOF;
-    
-    do {
-      c = 0;
-      
-      do {
-        c = fgetc(fp);
-        
-        if (c == EOF) {
-          goto done;
-        }
-        else if (isspace(c)) {
-          break;
-        }
-      }
-      while (c != EOF);
-      
-      char p[256];
-      memset(p, 0, 256);
-      int pl = 0;
-      
-      do {
-        c = fgetc(fp);
-        
-        if (c == EOF) {
-          goto done;
-        }
-        else if (isspace(c)) {
-          break;
-        }
-        
-        p[pl++] = c;
-      }
-      while (c != EOF);
-      
-      p[pl++] = 0;
-      
-      if (strcmp(p, path) == 0) {
-        res = 1;
-        goto done;
-      }
-      
-      do {
-        c = fgetc(fp);
-        
-        if (c == EOF) {
-          goto done;
-        }
-        else if (c == '\n') {
-          break;
-        }
-      }
-      while (c != EOF);
-    }
-    while (c != EOF);
-    
-  done:
-    fclose(fp);
-  }
-  
-  return res;
-}
 void create_directory(const char * path) {
   mkdir(path, 0777);
 }
@@ -292,7 +227,7 @@ int remove_directory(const char * path) {
 int alib_diskusage(const char * path) {
   struct statfs fiData;
   
-  if ((statfs(path, &fiData)) < 0) {
+  if (!alib_statfs(path, &fiData)) {
     return -1;
   }
   else {
@@ -303,7 +238,7 @@ int alib_diskusage(const char * path) {
 byte alib_disksize(const char * path, unsigned long * ret, int division) {
   struct statfs fiData;
   
-  if ((statfs(path, &fiData)) < 0) {
+  if (!alib_statfs(path, &fiData)) {
     return 0;
   }
   else {
@@ -325,7 +260,7 @@ byte alib_disksize(const char * path, unsigned long * ret, int division) {
 byte alib_diskfree(const char * path, unsigned long * ret, int division) {
   struct statfs fiData;
   
-  if ((statfs(path, &fiData)) < 0) {
+  if (!alib_statfs(path, &fiData)) {
     return 0;
   }
   else {
@@ -345,10 +280,13 @@ byte alib_diskfree(const char * path, unsigned long * ret, int division) {
   }
 }
 void alib_exec(char * cmd, char * arg) {
-  char ** args2 = malloc(sizeof(char *) * 3);
+  char * args2[3];
   args2[0]    = cmd;
   args2[1]    = arg;
   args2[2]    = NULL;
+  alib_execv(args2);
+}
+void alib_execv(char ** args2) {
   int pipefd[2];
   pipe(pipefd);
   pid_t pid = fork();
@@ -366,64 +304,154 @@ void alib_exec(char * cmd, char * arg) {
   while (fgets(buffer, sizeof(buffer), from_child) != NULL) {}
   
   fclose(from_child);
-  free(args2);
+  waitpid(pid, NULL, 0);
+}
+//-- Wait until path exists, woken by inotify on its directory
+byte alib_waitpath(const char * path, int timeout) {
+  char dir[256];
+  snprintf(dir, sizeof(dir), "%s", path);
+  char * sl = strrchr(dir, '/');
+  
+  if (sl == NULL) {
+    return (access(path, F_OK) == 0);
+  }
+  
+  *sl = 0;
+  long end = aTick() + timeout;
+  int  fd  = inotify_init();
+  int  wd  = -1;
+  byte res = 0;
+  
+  if (fd >= 0) {
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+  }
+  
+  while (1) {
+    //-- Directory itself may not exist yet
+    if ((fd >= 0) && (wd < 0)) {
+      wd = inotify_add_watch(fd, dir, IN_CREATE | IN_MOVED_TO | IN_ATTRIB);
+    }
+    
+    if (access(path, F_OK) == 0) {
+      res = 1;
+      break;
+    }
+    
+    long left = end - aTick();
+    
+    if (left <= 0) {
+      break;
+    }
+    
+    if (wd >= 0) {
+      struct pollfd pfd;
+      pfd.fd      = fd;
+      pfd.events  = POLLIN;
+      pfd.revents = 0;
+      
+      if (poll(&pfd, 1, left) > 0) {
+        char buf[512];
+        
+        while (read(fd, buf, sizeof(buf)) > 0) {}
+      }
+    }
+    else {
+      usleep(min(left, 20) * 1000);
+    }
+  }
+  
+  if (fd >= 0) {
+    close(fd);
+  }
+  
+  return res;
 }
 //-- KINETIC CALCULATOR
-void akinetic_downhandler(AKINETIC * p, int mouseY) {
+//-- One clock per gesture, picked by the down event
+static long akinetic_time(AKINETIC * p, long evtime) {
+  return p->evclock ? evtime : aTick();
+}
+static void akinetic_addpoint(AKINETIC * p, int mouseY, long t) {
+  p->previousPoints[p->history_pos] = mouseY;
+  p->previousTimes[p->history_pos]  = t;
+  p->history_pos = (p->history_pos + 1) % AKINETIC_HISTORY_LENGTH;
+  
+  if (p->history_n < AKINETIC_HISTORY_LENGTH) {
+    p->history_n++;
+  }
+}
+static int akinetic_lastpoint(AKINETIC * p) {
+  return p->previousPoints[
+           (p->history_pos + AKINETIC_HISTORY_LENGTH - 1) % AKINETIC_HISTORY_LENGTH];
+}
+void akinetic_downhandler(AKINETIC * p, int mouseY, long evtime) {
   p->isdown            = 1;
   p->velocity          = 0;
-  p->history_n         = 1;
-  p->previousPoints[0] = mouseY;
-  p->previousTimes[0]  = alib_tick();
+  p->history_n         = 0;
+  p->history_pos       = 0;
+  p->evclock           = (evtime > 0);
+  akinetic_addpoint(p, mouseY, akinetic_time(p, evtime));
+}
+int akinetic_movehandler(AKINETIC * p, int mouseY, long evtime) {
+  if (!p->isdown) {
+    return 0;
+  }
+  
+  int diff = akinetic_lastpoint(p) - mouseY;
+  akinetic_addpoint(p, mouseY, akinetic_time(p, evtime));
+  return diff;
 }
-int akinetic_movehandler(AKINETIC * p, int mouseY) {
+byte akinetic_uphandler(AKINETIC * p, int mouseY, long evtime) {
   if (!p->isdown) {
     return 0;
   }
   
-  int   currPoint       = mouseY;
-  long  currTime        = alib_tick();
-  int   previousPoint   = p->previousPoints[p->history_n - 1];
-  int   diff            = previousPoint - currPoint;
-  p->history_n++;
+  p->isdown = 0;
   
-  if (p->history_n > AKINETIC_HISTORY_LENGTH) {
-    int i;
+  if (mouseY != 0) {
+    akinetic_addpoint(p, mouseY, akinetic_time(p, evtime));
+  }
+  
+  //-- Least squares fit of y(t) over samples inside the horizon,
+  //-- newest first. Times are relative to the newest sample.
+  int     i;
+  int     n     = 0;
+  long    tlast = 0;
+  double  st    = 0, sy = 0, stt = 0, sty = 0;
+  
+  for (i = 0; i < p->history_n; i++) {
+    int   pos = (p->history_pos + AKINETIC_HISTORY_LENGTH - 1 - i) % AKINETIC_HISTORY_LENGTH;
+    long  t   = p->previousTimes[pos];
     
-    for (i = 1; i < AKINETIC_HISTORY_LENGTH; i++) {
-      p->previousPoints[i - 1] = p->previousPoints[i];
-      p->previousTimes[i - 1] = p->previousTimes[i];
+    if (i == 0) {
+      tlast = t;
+    }
+    else if (tlast - t > AKINETIC_HORIZON) {
+      break;
     }
     
-    p->history_n--;
+    double  x = (double) (t - tlast);
+    double  y = (double) p->previousPoints[pos];
+    st  += x;
+    sy  += y;
+    stt += x * x;
+    sty += x * y;
+    n++;
   }
   
-  p->previousPoints[p->history_n - 1]  = currPoint;
-  p->previousTimes[p->history_n - 1]   = currTime;
-  return diff;
-}
-byte akinetic_uphandler(AKINETIC * p, int mouseY) {
-  if (!p->isdown) {
+  if (n < 2) {
     return 0;
   }
   
-  p->isdown             = 0;
-  int   currPoint       = (mouseY == 0) ? p->previousPoints[p->history_n - 1] : mouseY;
-  long  currTime        = alib_tick();
-  int   firstPoint      = p->previousPoints[0];
-  long  firstTime       = p->previousTimes[0];
-  
-  if (currTime - firstTime < 1) {
-    firstTime--;
-  }
+  double den = (n * stt) - (st * st);
   
-  if (currTime - firstTime > 25) {
+  if (den < 1) {
     return 0;
   }
   
-  int   diff            = firstPoint - currPoint;
-  long  time            = (currTime - firstTime);
-  p->velocity           = ((double) diff / (double) time) * 4;
+  //-- Slope in px/ms. Fling steps were tuned on (px / 10ms tick) * 4.
+  double slope  = ((n * sty) - (st * sy)) / den;
+  p->velocity   = -slope * 40;
   return 1;
 }
 int akinetic_fling(AKINETIC * p) {
@@ -19,116 +19,296 @@
 #include <stdlib.h>
 
 #ifndef _AROMA_NODEBUG
-#include <sys/statfs.h>
-#include <dirent.h>
-#include <sys/stat.h>
 #include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 
-#define AROMA_MEM_TMPDIR "/tmp/aroma-memory"
-long aroma_isexist_mem(void * x) {
-  char pn[256];
-  snprintf(pn, 256, "%s/%i", AROMA_MEM_TMPDIR, (long) x);
-  FILE * fp = fopen(pn, "r");
+//
+// In-memory allocation profiler, lock-free:
+//   live table   : pointer -> size, call site (open addressing)
+//   site table   : file:line -> counters
+//   size classes : log2 histogram of requested sizes
+// Dumped on exit and on SIGUSR1
+//
+#define AROMA_MEM_DUMPFILE  "/tmp/aroma-memory.txt"
+#define AROMA_MEM_LIVE_SZ   (1 << 17)         // Live pointers, power of 2
+#define AROMA_MEM_SITE_SZ   4096              // Call sites, power of 2
+#define AROMA_MEM_PROBE     1024              // Max probes before giving up
+#define AROMA_MEM_HIST      32
+#define AROMA_MEM_TOMB      ((void *) 1)
+
+typedef struct {
+  const char  *   file;
+  long            line;
+  int             state;                    // 0 free, 1 claiming, 2 ready
+  long            allocs;
+  long            frees;
+  long long       total;                    // Bytes ever allocated
+  long long       live;
+  long long       peak;
+} AROMA_MEM_SITE;
+
+typedef struct {
+  void        *   ptr;
+  size_t          size;
+  AROMA_MEM_SITE * site;
+} AROMA_MEM_LIVE;
+
+static AROMA_MEM_LIVE * aroma_mem_live    = NULL;
+static AROMA_MEM_SITE   aroma_mem_site[AROMA_MEM_SITE_SZ];
+static long             aroma_mem_hist[AROMA_MEM_HIST];
+static long long        aroma_mem_bytes   = 0;
+static long long        aroma_mem_peak    = 0;
+static long             aroma_mem_allocs  = 0;
+static long             aroma_mem_frees   = 0;
+static long             aroma_mem_lost    = 0;  // Table full, not tracked
+static long             aroma_mem_unknown = 0;  // Freed, never tracked
+static int              aroma_mem_pipe[2] = { -1, -1 };
+
+static uint32_t aroma_mem_hash(uintptr_t v) {
+  v ^= v >> 17;
+  return (uint32_t)(v * 0x9E3779B1u);
+}
+
+static AROMA_MEM_SITE * aroma_mem_getsite(const char * file, long line) {
+  uint32_t h = aroma_mem_hash((uintptr_t) file ^ (line << 5));
+  int i;
   
-  if (fp) {
-    long sz = 0;
-    fread(&sz, 1, sizeof(long), fp);
-    fclose(fp);
-    return sz;
+  for (i = 0; i < AROMA_MEM_SITE_SZ; i++) {
+    AROMA_MEM_SITE * s = &aroma_mem_site[(h + i) & (AROMA_MEM_SITE_SZ - 1)];
+    int st = __atomic_load_n(&s->state, __ATOMIC_ACQUIRE);
+    
+    if (st == 0) {
+      if (__atomic_compare_exchange_n(&s->state, &st, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        s->file = file;
+        s->line = line;
+        __atomic_store_n(&s->state, 2, __ATOMIC_RELEASE);
+        return s;
+      }
+    }
+    
+    //-- Another thread is claiming it, wait for the key
+    while (st == 1) {
+      st = __atomic_load_n(&s->state, __ATOMIC_ACQUIRE);
+    }
+    
+    if ((s->file == file) && (s->line == line)) {
+      return s;
+    }
   }
   
-  return 0;
+  return NULL;
+}
+
+static void aroma_mem_maxpeak(long long * peak, long long v) {
+  long long p = __atomic_load_n(peak, __ATOMIC_RELAXED);
+  
+  while ((v > p) && !__atomic_compare_exchange_n(peak, &p, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
 }
-void aroma_touch_memaddr(void * x, long sz, long line, char * filename) {
-  long fz = aroma_isexist_mem(x);
+
+static void aroma_mem_track(void * x, size_t size, long line, char * filename) {
+  if ((x == NULL) || (aroma_mem_live == NULL)) {
+    return;
+  }
+  
+  int b = 0;
+  
+  while ((b < AROMA_MEM_HIST - 1) && (((size_t) 1) << (b + 1)) <= size) {
+    b++;
+  }
+  
+  __atomic_add_fetch(&aroma_mem_hist[b], 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&aroma_mem_allocs, 1, __ATOMIC_RELAXED);
+  aroma_mem_maxpeak(&aroma_mem_peak, __atomic_add_fetch(&aroma_mem_bytes, size, __ATOMIC_RELAXED));
+  AROMA_MEM_SITE * s = aroma_mem_getsite(filename, line);
   
-  if (fz == 0) {
-    char pn[256];
-    snprintf(pn, 256, "%s/%i", AROMA_MEM_TMPDIR, (long) x);
-    FILE * fp = fopen(pn, "wb");
-    fwrite(&sz, 1, sizeof(long), fp);
-    fwrite(&line, 1, sizeof(long), fp);
-    fwrite(filename, 1, strlen(filename), fp);
+  if (s != NULL) {
+    __atomic_add_fetch(&s->allocs, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&s->total, size, __ATOMIC_RELAXED);
+    aroma_mem_maxpeak(&s->peak, __atomic_add_fetch(&s->live, size, __ATOMIC_RELAXED));
+  }
+  
+  uint32_t h = aroma_mem_hash((uintptr_t) x);
+  int i;
+  
+  for (i = 0; i < AROMA_MEM_PROBE; i++) {
+    AROMA_MEM_LIVE * e = &aroma_mem_live[(h + i) & (AROMA_MEM_LIVE_SZ - 1)];
+    void * cur = __atomic_load_n(&e->ptr, __ATOMIC_RELAXED);
     
-    if (fp) {
-      fclose(fp);
+    if (((cur == NULL) || (cur == AROMA_MEM_TOMB)) &&
+        __atomic_compare_exchange_n(&e->ptr, &cur, x, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+      e->size = size;
+      e->site = s;
+      return;
     }
   }
-}
-void aroma_unlink_memaddr(void * x) {
-  long fz = aroma_isexist_mem(x);
   
-  if (fz) {
-    char pn[256];
-    snprintf(pn, 256, "%s/%i", AROMA_MEM_TMPDIR, (long) x);
-    unlink(pn);
-  }
+  __atomic_add_fetch(&aroma_mem_lost, 1, __ATOMIC_RELAXED);
 }
-void aroma_dump_malloc() {
-  const char * path = AROMA_MEM_TMPDIR;
-  DIR * d = opendir(path);
-  size_t path_len = strlen(path);
-  printf("\n\n===================================================\n");
-  printf(    "|                   LEAK INFO:                    |\n");
-  printf(    "===================================================\n\n");
-  
-  if (d) {
-    struct dirent * p;
+
+//-- 1 = x was tracked, its entry copied into old when not NULL
+static int aroma_mem_untrack(void * x, AROMA_MEM_LIVE * old) {
+  if ((x == NULL) || (aroma_mem_live == NULL)) {
+    return 0;
+  }
+  
+  uint32_t h = aroma_mem_hash((uintptr_t) x);
+  int i;
+  
+  for (i = 0; i < AROMA_MEM_PROBE; i++) {
+    AROMA_MEM_LIVE * e = &aroma_mem_live[(h + i) & (AROMA_MEM_LIVE_SZ - 1)];
+    void * cur = __atomic_load_n(&e->ptr, __ATOMIC_ACQUIRE);
+    
+    if (cur == NULL) {
+      break;
+    }
     
-    while ((p = readdir(d))) {
-      char * buf;
-      size_t len;
+    if (cur == x) {
+      size_t size = e->size;
+      AROMA_MEM_SITE * s = e->site;
       
-      if (!strcmp(p->d_name, ".") || !strcmp(p->d_name, "..")) {
-        continue;
+      if (old != NULL) {
+        old->ptr  = x;
+        old->size = size;
+        old->site = s;
       }
       
-      len = path_len + strlen(p->d_name) + 2;
-      buf = malloc(len);
+      __atomic_store_n(&e->ptr, AROMA_MEM_TOMB, __ATOMIC_RELEASE);
+      __atomic_sub_fetch(&aroma_mem_bytes, size, __ATOMIC_RELAXED);
+      __atomic_add_fetch(&aroma_mem_frees, 1, __ATOMIC_RELAXED);
       
-      if (buf) {
-        struct stat statbuf;
-        snprintf(buf, len, "%s/%s", path, p->d_name);
-        
-        if (!stat(buf, &statbuf)) {
-          if (S_ISDIR(statbuf.st_mode)) {
-          }
-          else {
-            long memaddr = atoi(p->d_name);
-            char pn[256];
-            long fz = 0;
-            long fl = 0;
-            char fn[256];
-            memset(fn, 0, 256);
-            snprintf(pn, 256, "%s/%i", AROMA_MEM_TMPDIR, (long) memaddr);
-            FILE * fp = fopen(pn, "r");
-            
-            if (fp) {
-              fread(&fz, 1, sizeof(long), fp);
-              fread(&fl, 1, sizeof(long), fp);
-              fread(fn, 1, 255, fp);
-              fclose(fp);
-            }
-            
-            char str[10];
-            memset(str, 0, 10);
-            
-            if (fz > 0) {
-              snprintf(str, 10, (char *) memaddr);
-            }
-            
-            printf("[0x%x %ib] = \"%s\" LINE %i <%s>\n", memaddr, fz, fn, fl, str);
-          }
-        }
-        
-        free(buf);
+      if (s != NULL) {
+        __atomic_add_fetch(&s->frees, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&s->live, size, __ATOMIC_RELAXED);
       }
+      
+      return 1;
     }
+  }
+  
+  __atomic_add_fetch(&aroma_mem_unknown, 1, __ATOMIC_RELAXED);
+  return 0;
+}
+
+//-- VmRSS / VmHWM in kB
+static void aroma_mem_rss(long * rss, long * hwm) {
+  char line[128];
+  FILE * fp = fopen("/proc/self/status", "r");
+  *rss = 0;
+  *hwm = 0;
+  
+  if (fp == NULL) {
+    return;
+  }
+  
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    sscanf(line, "VmRSS: %ld", rss);
+    sscanf(line, "VmHWM: %ld", hwm);
+  }
+  
+  fclose(fp);
+}
+
+static int aroma_mem_cmpsite(const void * a, const void * b) {
+  const AROMA_MEM_SITE * x = *(const AROMA_MEM_SITE **) a;
+  const AROMA_MEM_SITE * y = *(const AROMA_MEM_SITE **) b;
+  
+  if (x->peak != y->peak) {
+    return (x->peak < y->peak) ? 1 : -1;
+  }
+  
+  return (x->live < y->live) ? 1 : (x->live > y->live) ? -1 : 0;
+}
+
+static void aroma_mem_report(FILE * fp, int leaks) {
+  AROMA_MEM_SITE * sites[AROMA_MEM_SITE_SZ];
+  long rss, hwm;
+  int i, n = 0;
+  aroma_mem_rss(&rss, &hwm);
+  fprintf(fp, "===================================================\n");
+  fprintf(fp, "|                 MEMORY PROFILE                  |\n");
+  fprintf(fp, "===================================================\n");
+  fprintf(fp, "rss %ld kB, peak rss %ld kB\n", rss, hwm);
+  fprintf(fp, "tracked live %lld bytes, peak %lld bytes\n", aroma_mem_bytes, aroma_mem_peak);
+  fprintf(fp, "allocs %ld, frees %ld, untracked %ld, unknown frees %ld\n\n",
+          aroma_mem_allocs, aroma_mem_frees, aroma_mem_lost, aroma_mem_unknown);
+  fprintf(fp, "size histogram:\n");
+  
+  for (i = 0; i < AROMA_MEM_HIST; i++) {
+    if (aroma_mem_hist[i]) {
+      fprintf(fp, "  %10lu - %-10lu %8ld\n", i ? (1ul << i) : 0ul, (2ul << i) - 1, aroma_mem_hist[i]);
+    }
+  }
+  
+  for (i = 0; i < AROMA_MEM_SITE_SZ; i++) {
+    if (__atomic_load_n(&aroma_mem_site[i].state, __ATOMIC_ACQUIRE) == 2) {
+      sites[n++] = &aroma_mem_site[i];
+    }
+  }
+  
+  qsort(sites, n, sizeof(AROMA_MEM_SITE *), aroma_mem_cmpsite);
+  fprintf(fp, "\ncall sites by peak bytes:\n");
+  fprintf(fp, "  %12s %12s %12s %8s %8s  site\n", "peak", "live", "total", "allocs", "frees");
+  
+  for (i = 0; i < n; i++) {
+    AROMA_MEM_SITE * s = sites[i];
+    fprintf(fp, "  %12lld %12lld %12lld %8ld %8ld  %s:%ld\n",
+            s->peak, s->live, s->total, s->allocs, s->frees, s->file, s->line);
+  }
+  
+  if (leaks) {
+    fprintf(fp, "\nleaks:\n");
+    
+    for (i = 0; i < AROMA_MEM_LIVE_SZ; i++) {
+      AROMA_MEM_LIVE * e = &aroma_mem_live[i];
+      void * p = __atomic_load_n(&e->ptr, __ATOMIC_ACQUIRE);
+      
+      if ((p != NULL) && (p != AROMA_MEM_TOMB) && (e->site != NULL)) {
+        fprintf(fp, "  [%p %zub] %s:%ld\n", p, e->size, e->site->file, e->site->line);
+      }
+    }
+  }
+  
+  fprintf(fp, "===================================================\n");
+}
+
+void aroma_dump_malloc() {
+  if (aroma_mem_live == NULL) {
+    return;
+  }
+  
+  FILE * fp = fopen(AROMA_MEM_DUMPFILE, "wb");
+  
+  if (fp != NULL) {
+    aroma_mem_report(fp, 1);
+    fclose(fp);
+    printf("\naroma memory profile written to %s\n", AROMA_MEM_DUMPFILE);
+  }
+  else {
+    aroma_mem_report(stdout, 1);
+  }
+}
+
+//-- SIGUSR1 only wakes the dumper thread, reporting is not signal safe
+static void aroma_mem_signal(int sig) {
+  char c = 0;
+  write(aroma_mem_pipe[1], &c, 1);
+}
+static void * aroma_mem_dumper(void * cookie) {
+  char c;
+  
+  while (read(aroma_mem_pipe[0], &c, 1) == 1) {
+    FILE * fp = fopen(AROMA_MEM_DUMPFILE, "wb");
     
-    closedir(d);
+    if (fp != NULL) {
+      aroma_mem_report(fp, 0);
+      fclose(fp);
+    }
   }
   
-  printf("\n\n===================================================\n\n");
+  return NULL;
 }
 #endif
 
@@ -152,11 +332,26 @@ void * aroma_realloc ( void * x, size_t size
 #endif
                      ) {
 #ifndef _AROMA_NODEBUG
-  aroma_unlink_memaddr(x);
+  //-- Untrack first, once realloc returns x another thread may get it
+  AROMA_MEM_LIVE old;
+  int tracked = aroma_mem_untrack(x, &old);
 #endif
   void * ret = realloc(x, size);
 #ifndef _AROMA_NODEBUG
-  aroma_touch_memaddr(ret, size, line, filename);
+  
+  if (ret != NULL) {
+    aroma_mem_track(ret, size, line, filename);
+  }
+  else if ((size != 0) && tracked) {
+    //-- Failed, x is still allocated as before
+    if (old.site != NULL) {
+      aroma_mem_track(x, old.size, old.site->line, (char *) old.site->file);
+    }
+    else {
+      aroma_mem_track(x, old.size, line, filename);
+    }
+  }
+  
 #endif
   return ret;
 }
@@ -183,17 +378,16 @@ void * aroma_malloc(size_t size
   }
   
 #ifndef _AROMA_NODEBUG
-  aroma_touch_memaddr(ret, size, line, filename);
+  aroma_mem_track(ret, size, line, filename);
 #endif
   return ret;
 }
 
 void aroma_free(void ** x) {
+  if (*x != NULL) {
 #ifndef _AROMA_NODEBUG
-  aroma_unlink_memaddr(*x);
+    aroma_mem_untrack(*x, NULL);
 #endif
-  
-  if (*x != NULL) {
     free(*x);
     *x = NULL;
   }
@@ -201,6 +395,14 @@ void aroma_free(void ** x) {
 
 #ifndef _AROMA_NODEBUG
 void aroma_memory_debug_init() {
-  create_directory(AROMA_MEM_TMPDIR, 0777);
+  aroma_mem_live = (AROMA_MEM_LIVE *) calloc(AROMA_MEM_LIVE_SZ, sizeof(AROMA_MEM_LIVE));
+  
+  if ((aroma_mem_live != NULL) && (pipe(aroma_mem_pipe) == 0)) {
+    pthread_t dumper;
+    fcntl(aroma_mem_pipe[1], F_SETFL, O_NONBLOCK);
+    pthread_create(&dumper, NULL, aroma_mem_dumper, NULL);
+    pthread_detach(dumper);
+    signal(SIGUSR1, aroma_mem_signal);
+  }
 }
 #endif
@@ -0,0 +1,298 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Descriptions:
+ * -------------
+ * AROMA Mount State - cached mount table (refreshed on mountinfo
+ * POLLPRI), memoized statfs and batched auto mount/unmount
+ *
+ */
+
+#include <sys/vfs.h>
+#include <sys/poll.h>
+#include <aroma.h>
+
+#define AMOUNT_INFO         "/proc/self/mountinfo"
+#define AMOUNT_STATFS_TTL   2000      // ms
+#define AMOUNT_STATFS_MAX   16
+#define AMOUNT_AUTO_MAX     16
+
+typedef struct {
+  char        *   path;
+  struct statfs   st;
+  long            tick;
+} AMOUNT_STATFS;
+
+static pthread_mutex_t  amount_mutex      = PTHREAD_MUTEX_INITIALIZER;
+static int              amount_fd         = -1;
+static char       **    amount_dirs       = NULL;
+static int              amount_n          = 0;
+static AMOUNT_STATFS    amount_stfs[AMOUNT_STATFS_MAX];
+static int              amount_stfs_n     = 0;
+static char       *     amount_auto[AMOUNT_AUTO_MAX];
+static int              amount_auto_n     = 0;
+
+//-- Decode mountinfo octal escapes (\040 = space) in place
+static void amount_unescape(char * s) {
+  char * d = s;
+  
+  while (*s) {
+    if ((s[0] == '\\') && (s[1] >= '0') && (s[1] <= '3') &&
+        (s[2] >= '0') && (s[2] <= '7') && (s[3] >= '0') && (s[3] <= '7')) {
+      *d++ = ((s[1] - '0') << 6) | ((s[2] - '0') << 3) | (s[3] - '0');
+      s += 4;
+    }
+    else {
+      *d++ = *s++;
+    }
+  }
+  
+  *d = 0;
+}
+
+static void amount_statfs_clear() {
+  int i;
+  
+  for (i = 0; i < amount_stfs_n; i++) {
+    free(amount_stfs[i].path);
+  }
+  
+  amount_stfs_n = 0;
+}
+
+static void amount_parse() {
+  int i;
+  
+  for (i = 0; i < amount_n; i++) {
+    free(amount_dirs[i]);
+  }
+  
+  free(amount_dirs);
+  amount_dirs = NULL;
+  amount_n    = 0;
+  //-- Read whole table, it may be larger than one read
+  int    sz  = 0;
+  int    cap = 4096;
+  char * buf = malloc(cap);
+  lseek(amount_fd, 0, SEEK_SET);
+  
+  while (1) {
+    if (sz + 1 >= cap) {
+      cap *= 2;
+      buf  = realloc(buf, cap);
+    }
+    
+    ssize_t r = read(amount_fd, buf + sz, cap - sz - 1);
+    
+    if (r <= 0) {
+      break;
+    }
+    
+    sz += r;
+  }
+  
+  buf[sz] = 0;
+  int    dcap = 32;
+  amount_dirs = malloc(sizeof(char *) * dcap);
+  char * save = NULL;
+  char * line = strtok_r(buf, "\n", &save);
+  
+  while (line != NULL) {
+    //-- id parent major:minor root mountpoint ...
+    char * f = line;
+    
+    for (i = 0; (i < 4) && f; i++) {
+      f = strchr(f, ' ');
+      
+      if (f) {
+        f++;
+      }
+    }
+    
+    if (f != NULL) {
+      char * e = strchr(f, ' ');
+      
+      if (e) {
+        *e = 0;
+      }
+      
+      amount_unescape(f);
+      
+      if (amount_n == dcap) {
+        dcap *= 2;
+        amount_dirs = realloc(amount_dirs, sizeof(char *) * dcap);
+      }
+      
+      amount_dirs[amount_n++] = strdup(f);
+    }
+    
+    line = strtok_r(NULL, "\n", &save);
+  }
+  
+  free(buf);
+  amount_statfs_clear();
+}
+
+//-- Reparse only when kernel flagged a mount table change
+static void amount_refresh() {
+  if (amount_fd < 0) {
+    amount_fd = open(AMOUNT_INFO, O_RDONLY);
+    
+    if (amount_fd < 0) {
+      return;
+    }
+    
+    amount_parse();
+    return;
+  }
+  
+  struct pollfd pfd;
+  pfd.fd      = amount_fd;
+  pfd.events  = POLLPRI;
+  pfd.revents = 0;
+  
+  if ((poll(&pfd, 1, 0) > 0) && (pfd.revents & (POLLPRI | POLLERR))) {
+    amount_parse();
+  }
+}
+
+static byte amount_find(const char * path) {
+  int i;
+  
+  for (i = 0; i < amount_n; i++) {
+    if (strcmp(amount_dirs[i], path) == 0) {
+      return 1;
+    }
+  }
+  
+  return 0;
+}
+
+byte ismounted(char * path) {
+  pthread_mutex_lock(&amount_mutex);
+  amount_refresh();
+  byte res = amount_find(path);
+  pthread_mutex_unlock(&amount_mutex);
+  return res;
+}
+
+//-- statfs, memoized for AMOUNT_STATFS_TTL
+byte alib_statfs(const char * path, struct statfs * out) {
+  long now = aTick();
+  int  i;
+  pthread_mutex_lock(&amount_mutex);
+  amount_refresh();
+  
+  for (i = 0; i < amount_stfs_n; i++) {
+    if (strcmp(amount_stfs[i].path, path) == 0) {
+      if (now - amount_stfs[i].tick < AMOUNT_STATFS_TTL) {
+        memcpy(out, &amount_stfs[i].st, sizeof(struct statfs));
+        pthread_mutex_unlock(&amount_mutex);
+        return 1;
+      }
+      
+      break;
+    }
+  }
+  
+  if (statfs(path, out) < 0) {
+    pthread_mutex_unlock(&amount_mutex);
+    return 0;
+  }
+  
+  if (i == amount_stfs_n) {
+    if (amount_stfs_n == AMOUNT_STATFS_MAX) {
+      i = 0;
+      free(amount_stfs[0].path);
+    }
+    else {
+      amount_stfs_n++;
+    }
+    
+    amount_stfs[i].path = strdup(path);
+  }
+  
+  memcpy(&amount_stfs[i].st, out, sizeof(struct statfs));
+  amount_stfs[i].tick = now;
+  pthread_mutex_unlock(&amount_mutex);
+  return 1;
+}
+
+//-- Mount if needed, stays mounted until alib_automount_release
+byte alib_automount(const char * path) {
+  if (ismounted((char *) path)) {
+    return 1;
+  }
+  
+  alib_exec("/sbin/mount", (char *) path);
+  
+  if (!ismounted((char *) path)) {
+    return 0;
+  }
+  
+  pthread_mutex_lock(&amount_mutex);
+  
+  if (amount_auto_n < AMOUNT_AUTO_MAX) {
+    amount_auto[amount_auto_n++] = strdup(path);
+  }
+  
+  pthread_mutex_unlock(&amount_mutex);
+  return 1;
+}
+
+//-- Unmount everything alib_automount mounted, in one exec
+void alib_automount_release() {
+  pthread_mutex_lock(&amount_mutex);
+  
+  if (amount_auto_n == 0) {
+    pthread_mutex_unlock(&amount_mutex);
+    return;
+  }
+  
+  char * argv[AMOUNT_AUTO_MAX + 2];
+  int    i;
+  argv[0] = "/sbin/umount";
+  
+  for (i = 0; i < amount_auto_n; i++) {
+    argv[i + 1] = amount_auto[i];
+  }
+  
+  argv[i + 1]   = NULL;
+  amount_auto_n = 0;
+  pthread_mutex_unlock(&amount_mutex);
+  alib_execv(argv);
+  
+  for (i = 1; argv[i] != NULL; i++) {
+    free(argv[i]);
+  }
+}
+
+//-- All disk metrics of a mountpoint at once
+byte alib_diskinfo(const char * path, ADISKINFO * info) {
+  struct statfs st;
+  
+  if (!alib_automount(path) || !alib_statfs(path, &st)) {
+    return 0;
+  }
+  
+  info->size    = ((unsigned long long) st.f_blocks) * st.f_bsize;
+  info->free    = ((unsigned long long) st.f_bfree) * st.f_bsize;
+  info->used    = info->size - info->free;
+  info->percent = (st.f_blocks > 0) ?
+                  100 - (int) round((((double) st.f_bfree) / ((double) st.f_blocks)) * 100) : 0;
+  return 1;
+}
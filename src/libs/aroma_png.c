@@ -87,6 +87,7 @@ void apng_close(PNGCANVAS * pngcanvas) {
 
 //-- LOAD PNG FROM ZIP
 byte apng_load(PNGCANVAS * pngcanvas, char * imgname) {
+  ATRACE_SCOPE("apng_load");
   char zpath[256];
   
   if (imgname[0] == '@') {
@@ -110,6 +111,42 @@ byte apng_load(PNGCANVAS * pngcanvas, char * imgname) {
     snprintf(zpath, 255, "%s/%s.png", AROMA_DIR, imgname);
   }
   
+  return apng_load_zip(pngcanvas, zpath);
+}
+
+//-- Queue imgname for the prefetch thread, resolved as apng_load would
+//   once themename is the current theme
+void apng_prefetch(const char * imgname, const char * themename) {
+  char zpath[256];
+  char alt[256];
+  
+  if (imgname[0] == '@') {
+    snprintf(alt, 255, "%s/icons/%s.png", AROMA_DIR, imgname + 1);
+    
+    if (strcmp(themename, "") == 0) {
+      aprefetch_png(alt, NULL);
+    }
+    else {
+      snprintf(zpath, 255, "%s/themes/%s/icon.%s.png", AROMA_DIR, themename, imgname + 1);
+      aprefetch_png(zpath, alt);
+    }
+  }
+  else {
+    snprintf(zpath, 255, "%s/%s.png", AROMA_DIR, imgname);
+    aprefetch_png(zpath, NULL);
+  }
+}
+
+//-- LOAD PNG FROM ZIP PATH
+byte apng_load_zip(PNGCANVAS * pngcanvas, const char * zpath) {
+  byte prefetched;
+  
+  //-- Decoded ahead by apng_prefetch
+  if (aprefetch_takepng(zpath, pngcanvas, &prefetched)) {
+    return prefetched;
+  }
+  
+  ATRACE_SCOPE("apng_decode");
   memset(pngcanvas, 0, sizeof(PNGCANVAS));
   png_structp png_ptr = NULL;
   png_infop info_ptr = NULL;
@@ -122,7 +159,7 @@ byte apng_load(PNGCANVAS * pngcanvas, char * imgname) {
   //-- LOAD DATA FROM ZIP
   AZMEM data_png;
   
-  if (!az_readmem(&data_png, zpath, 1)) {
+  if (!az_map(&data_png, zpath, AZ_MAP_ONCE)) {
     return 0;
   }
   
@@ -232,7 +269,7 @@ byte apng_load(PNGCANVAS * pngcanvas, char * imgname) {
   result = 1;
 exit:
   png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-  free(data_png.data);
+  az_unmap(&data_png);
   return result;
 }
 
@@ -353,7 +390,7 @@ byte apng_loadfont(PNGFONTS * pngfont, const char * imgname) {
   AZMEM data_png;
   printf("Loading PNG : %s\n", zpath);
   
-  if (!az_readmem(&data_png, zpath, 1)) {
+  if (!az_map(&data_png, zpath, AZ_MAP_ONCE)) {
     return 0;
   }
   
@@ -455,7 +492,7 @@ byte apng_loadfont(PNGFONTS * pngfont, const char * imgname) {
   pngfont->loaded = 1;
 exit:
   png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
-  free(data_png.data);
+  az_unmap(&data_png);
   return result;
 }
 //-- CLOSE
@@ -0,0 +1,387 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Descriptions:
+ * -------------
+ * AROMA Prefetch - decodes png images and reads zip items on a
+ * background thread before they are asked for. apng_load & az_readmem
+ * take the result out of the store, everything else is a miss
+ *
+ */
+
+#include <aroma.h>
+
+#define APF_MAX       48                  //-- Store slots
+#define APF_BYTES     (16 * 1024 * 1024)  //-- Decoded bytes kept unclaimed
+
+#define APF_FREE      0
+#define APF_WAIT      1   //-- Fallback, queued when its primary fails
+#define APF_QUEUED    2
+#define APF_BUSY      3
+#define APF_READY     4
+#define APF_FAILED    5
+
+#define APF_PNG       0
+#define APF_MEM       1
+
+typedef struct {
+  char      path[256];
+  byte      kind;
+  byte      state;
+  int       alt;      //-- Fallback slot, -1 = none
+  dword     seq;      //-- Queue order, oldest evicted first
+  long      sz;       //-- Bytes held while ready
+  PNGCANVAS png;
+  AZMEM     mem;
+} APFENTRY;
+
+static APFENTRY         apf[APF_MAX];
+static pthread_mutex_t  apf_mutex   = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   apf_cond    = PTHREAD_COND_INITIALIZER;
+static pthread_t        apf_thread;
+static byte             apf_running = 0;
+static byte             apf_quit    = 0;
+static dword            apf_seq     = 0;
+static long             apf_bytes   = 0;
+static int              apf_used    = 0;
+static int              apf_waited  = 0;
+static int              apf_unused  = 0;
+
+//-- Slot holding path, -1 = none. Caller holds the mutex
+static int apf_find(const char * path, byte kind) {
+  int i;
+  
+  for (i = 0; i < APF_MAX; i++) {
+    if ((apf[i].state != APF_FREE) && (apf[i].kind == kind) &&
+        (strcmp(apf[i].path, path) == 0)) {
+      return i;
+    }
+  }
+  
+  return -1;
+}
+
+//-- Release a slot and the data it holds. Caller holds the mutex
+static void apf_clear(int i) {
+  APFENTRY * e = &apf[i];
+  
+  if (e->state == APF_FREE) {
+    return;
+  }
+  
+  if (e->state == APF_READY) {
+    if (e->kind == APF_PNG) {
+      apng_close(&e->png);
+    }
+    else {
+      az_unmap(&e->mem);
+    }
+    
+    apf_bytes -= e->sz;
+    apf_unused++;
+  }
+  
+  if ((e->alt >= 0) && (apf[e->alt].state == APF_WAIT)) {
+    apf[e->alt].state = APF_FREE;
+  }
+  
+  //-- A fallback going away unlinks from its primary
+  if (e->state == APF_WAIT) {
+    int k;
+    
+    for (k = 0; k < APF_MAX; k++) {
+      if (apf[k].alt == i) {
+        apf[k].alt = -1;
+      }
+    }
+  }
+  
+  e->state = APF_FREE;
+  e->alt   = -1;
+  e->sz    = 0;
+}
+
+//-- Free slot, evicting the oldest unclaimed result. -1 = store busy
+static int apf_slot(int keep) {
+  int i;
+  int old = -1;
+  
+  for (i = 0; i < APF_MAX; i++) {
+    if (apf[i].state == APF_FREE) {
+      return i;
+    }
+    
+    if ((i != keep) && ((apf[i].state == APF_READY) || (apf[i].state == APF_FAILED))) {
+      if ((old < 0) || (apf[i].seq < apf[old].seq)) {
+        old = i;
+      }
+    }
+  }
+  
+  if (old >= 0) {
+    apf_clear(old);
+  }
+  
+  return old;
+}
+
+//-- Oldest queued slot, -1 = none
+static int apf_next() {
+  int i;
+  int next = -1;
+  
+  for (i = 0; i < APF_MAX; i++) {
+    if ((apf[i].state == APF_QUEUED) && ((next < 0) || (apf[i].seq < apf[next].seq))) {
+      next = i;
+    }
+  }
+  
+  return next;
+}
+
+static void * apf_worker(void * cookie) {
+  ATRACE_THREAD("prefetch");
+  pthread_mutex_lock(&apf_mutex);
+  
+  while (!apf_quit) {
+    int i = apf_next();
+    
+    if (i < 0) {
+      pthread_cond_wait(&apf_cond, &apf_mutex);
+      continue;
+    }
+    
+    APFENTRY * e = &apf[i];
+    char path[256];
+    snprintf(path, 256, "%s", e->path);
+    e->state = APF_BUSY;
+    pthread_mutex_unlock(&apf_mutex);
+    //-- Same decoders as the UI thread, which skip the store on this thread
+    PNGCANVAS png;
+    AZMEM     mem;
+    byte      ok;
+    long      sz = 0;
+    memset(&png, 0, sizeof(PNGCANVAS));
+    memset(&mem, 0, sizeof(AZMEM));
+    
+    if (e->kind == APF_PNG) {
+      ok = apng_load_zip(&png, path);
+      
+      if (ok) {
+        sz = png.s * ((png.c == 4) ? 4 : 3);
+      }
+      else {
+        apng_close(&png);
+      }
+    }
+    else {
+      ok = az_readmem(&mem, path, 0);
+      
+      if (ok) {
+        sz = mem.sz;
+      }
+      else {
+        mem.data = NULL;
+      }
+    }
+    
+    pthread_mutex_lock(&apf_mutex);
+    e->state = ok ? APF_READY : APF_FAILED;
+    e->png   = png;
+    e->mem   = mem;
+    e->sz    = sz;
+    apf_bytes += sz;
+    
+    if (e->alt >= 0) {
+      apf[e->alt].state = ok ? APF_FREE : APF_QUEUED;
+      e->alt = -1;
+    }
+    
+    //-- Stay in budget, nothing claimed the oldest yet
+    while (apf_bytes > APF_BYTES) {
+      int old = -1;
+      int k;
+      
+      for (k = 0; k < APF_MAX; k++) {
+        if ((k != i) && (apf[k].state == APF_READY) &&
+            ((old < 0) || (apf[k].seq < apf[old].seq))) {
+          old = k;
+        }
+      }
+      
+      if (old < 0) {
+        break;
+      }
+      
+      apf_clear(old);
+    }
+    
+    ATRACE_COUNTER("prefetch.bytes", apf_bytes);
+    pthread_cond_broadcast(&apf_cond);
+  }
+  
+  pthread_mutex_unlock(&apf_mutex);
+  return NULL;
+}
+
+//-- Queue a slot for path. Caller holds the mutex
+static int apf_queue(const char * path, byte kind, byte state, int keep) {
+  int i = apf_slot(keep);
+  
+  if (i < 0) {
+    return -1;
+  }
+  
+  APFENTRY * e = &apf[i];
+  memset(e, 0, sizeof(APFENTRY));
+  snprintf(e->path, 256, "%s", path);
+  e->kind  = kind;
+  e->state = state;
+  e->alt   = -1;
+  e->seq   = ++apf_seq;
+  
+  if (!apf_running) {
+    apf_quit = 0;
+    apf_running = (pthread_create(&apf_thread, NULL, apf_worker, NULL) == 0);
+  }
+  
+  pthread_cond_broadcast(&apf_cond);
+  return i;
+}
+
+//-- Decode zpath in background, alt when zpath can't be decoded
+void aprefetch_png(const char * zpath, const char * alt) {
+  pthread_mutex_lock(&apf_mutex);
+  
+  if (apf_find(zpath, APF_PNG) < 0) {
+    int i = apf_queue(zpath, APF_PNG, APF_QUEUED, -1);
+    
+    if ((i >= 0) && (alt != NULL) && (apf_find(alt, APF_PNG) < 0)) {
+      apf[i].alt = apf_queue(alt, APF_PNG, APF_WAIT, i);
+    }
+  }
+  
+  pthread_mutex_unlock(&apf_mutex);
+}
+
+//-- Read zip item zpath in background
+void aprefetch_mem(const char * zpath) {
+  pthread_mutex_lock(&apf_mutex);
+  
+  if (apf_find(zpath, APF_MEM) < 0) {
+    apf_queue(zpath, APF_MEM, APF_QUEUED, -1);
+  }
+  
+  pthread_mutex_unlock(&apf_mutex);
+}
+
+//-- Claim a result, waits if it is being decoded. Queued ones are
+//   dropped, the caller is about to do the same work. NULL = miss
+static APFENTRY * apf_take(const char * path, byte kind) {
+  if (!apf_running || pthread_equal(pthread_self(), apf_thread)) {
+    return NULL;
+  }
+  
+  int i = apf_find(path, kind);
+  
+  if ((i >= 0) && (apf[i].state == APF_BUSY)) {
+    apf_waited++;
+    
+    while ((i >= 0) && (apf[i].state == APF_BUSY)) {
+      pthread_cond_wait(&apf_cond, &apf_mutex);
+      i = apf_find(path, kind);
+    }
+  }
+  
+  if (i < 0) {
+    return NULL;
+  }
+  
+  if ((apf[i].state != APF_READY) && (apf[i].state != APF_FAILED)) {
+    apf_clear(i);
+    return NULL;
+  }
+  
+  apf_bytes -= apf[i].sz;
+  apf[i].state = APF_FREE;
+  apf[i].sz    = 0;
+  apf_used++;
+  return &apf[i];
+}
+
+//-- 1 = answered from the store, res is the apng_load result
+byte aprefetch_takepng(const char * zpath, PNGCANVAS * out, byte * res) {
+  pthread_mutex_lock(&apf_mutex);
+  APFENTRY * e = apf_take(zpath, APF_PNG);
+  
+  if (e != NULL) {
+    *res = (e->png.r != NULL);
+    *out = e->png;
+  }
+  
+  pthread_mutex_unlock(&apf_mutex);
+  return (e != NULL);
+}
+
+//-- 1 = answered from the store, res is the az_readmem result
+byte aprefetch_takemem(const char * zpath, AZMEM * out, byte bytesafe, byte * res) {
+  pthread_mutex_lock(&apf_mutex);
+  APFENTRY * e = apf_take(zpath, APF_MEM);
+  
+  if (e != NULL) {
+    *res = (e->mem.data != NULL);
+    *out = e->mem;
+    
+    //-- Stored with the terminating NULL, as bytesafe=0 reads
+    if (*res && bytesafe) {
+      out->sz--;
+    }
+  }
+  
+  pthread_mutex_unlock(&apf_mutex);
+  return (e != NULL);
+}
+
+//-- Stop the worker and drop everything unclaimed
+void aprefetch_release() {
+  pthread_mutex_lock(&apf_mutex);
+  
+  if (apf_running) {
+    apf_quit = 1;
+    pthread_cond_broadcast(&apf_cond);
+    pthread_mutex_unlock(&apf_mutex);
+    pthread_join(apf_thread, NULL);
+    pthread_mutex_lock(&apf_mutex);
+    apf_running = 0;
+    apf_quit    = 0;
+  }
+  
+  int i;
+  
+  for (i = 0; i < APF_MAX; i++) {
+    apf_clear(i);
+  }
+  
+  if (apf_used || apf_unused) {
+    LOGS("prefetch: %d used (%d waited), %d unused", apf_used, apf_waited, apf_unused);
+  }
+  
+  apf_used   = 0;
+  apf_waited = 0;
+  apf_unused = 0;
+  pthread_mutex_unlock(&apf_mutex);
+}
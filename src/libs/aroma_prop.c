@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Descriptions:
+ * -------------
+ * AROMA Prop Index - key=value files parsed once into a hash,
+ * and cached by path (filesystem) or zip entry
+ *
+ */
+
+#include <aroma.h>
+
+#define APROP_CACHE_MAX   32
+
+typedef struct {
+  char  * key;
+  char  * val;
+  dword   hash;
+  int     next;                 // Next Item in Bucket, -1 = End
+} APROP_ITEM, * APROP_ITEMP;
+
+struct _APROP {
+  char      *   buf;            // Parsed Copy, Keys & Values Point Here
+  APROP_ITEMP   items;
+  int           n;
+  int       *   buckets;
+  int           bucket_n;       // Power of 2
+};
+
+typedef struct _APROP_CACHE {
+  char        *   path;
+  byte            iszip;
+  time_t          mtime;
+  long            mtime_ns;
+  off_t           size;
+  ino_t           ino;
+  APROPP          prop;
+  struct _APROP_CACHE * next;
+} APROP_CACHE, * APROP_CACHEP;
+
+static APROP_CACHEP     aprop_cache       = NULL;
+static int              aprop_cache_n     = 0;
+static pthread_mutex_t  aprop_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static dword aprop_hash(const char * s) {
+  dword h = 2166136261u;
+  
+  while (*s) {
+    h ^= (byte) * s++;
+    h *= 16777619u;
+  }
+  
+  return h;
+}
+
+static char * aprop_trim(char * s, char * e) {
+  while (*s && isspace(*s)) {
+    s++;
+  }
+  
+  while ((e > s) && isspace(e[-1])) {
+    e--;
+  }
+  
+  *e = 0;
+  return s;
+}
+
+//-- Parse Prop String, first occurrence of a key wins
+APROPP aprop_parse(const char * buffer) {
+  if (buffer == NULL) {
+    return NULL;
+  }
+  
+  APROPP p = (APROPP) malloc(sizeof(struct _APROP));
+  memset(p, 0, sizeof(struct _APROP));
+  p->buf = strdup(buffer);
+  //-- Size table by line count
+  int    lines = 1;
+  char * c;
+  
+  for (c = p->buf; *c; c++) {
+    if (*c == '\n') {
+      lines++;
+    }
+  }
+  
+  p->bucket_n = 16;
+  
+  while (p->bucket_n < lines) {
+    p->bucket_n <<= 1;
+  }
+  
+  p->items   = (APROP_ITEMP) malloc(sizeof(APROP_ITEM) * lines);
+  p->buckets = (int *) malloc(sizeof(int) * p->bucket_n);
+  memset(p->buckets, 0xff, sizeof(int) * p->bucket_n);
+  char * line = p->buf;
+  
+  while (line != NULL) {
+    char * eol = strchr(line, '\n');
+    char * next = NULL;
+    
+    if (eol != NULL) {
+      *eol = 0;
+      next = eol + 1;
+    }
+    else {
+      eol = line + strlen(line);
+    }
+    
+    while (*line && isspace(*line)) {
+      ++line;
+    }
+    
+    char * equal = strchr(line, '=');
+    
+    if ((*line != 0) && (*line != '#') && (equal != NULL)) {
+      char * key = aprop_trim(line, equal);
+      char * val = aprop_trim(equal + 1, eol);
+      dword  h   = aprop_hash(key);
+      int    b   = h & (p->bucket_n - 1);
+      int    i;
+      
+      for (i = p->buckets[b]; i != -1; i = p->items[i].next) {
+        if ((p->items[i].hash == h) && (strcmp(p->items[i].key, key) == 0)) {
+          break;
+        }
+      }
+      
+      if (i == -1) {
+        APROP_ITEMP it = &p->items[p->n];
+        it->key      = key;
+        it->val      = val;
+        it->hash     = h;
+        it->next     = p->buckets[b];
+        p->buckets[b] = p->n++;
+      }
+    }
+    
+    line = next;
+  }
+  
+  return p;
+}
+
+//-- Get Value, owned by prop
+char * aprop_get(APROPP p, const char * key) {
+  if ((p == NULL) || (key == NULL)) {
+    return NULL;
+  }
+  
+  dword h = aprop_hash(key);
+  int   i;
+  
+  for (i = p->buckets[h & (p->bucket_n - 1)]; i != -1; i = p->items[i].next) {
+    if ((p->items[i].hash == h) && (strcmp(p->items[i].key, key) == 0)) {
+      return p->items[i].val;
+    }
+  }
+  
+  return NULL;
+}
+
+void aprop_free(APROPP p) {
+  if (p == NULL) {
+    return;
+  }
+  
+  free(p->items);
+  free(p->buckets);
+  free(p->buf);
+  free(p);
+}
+
+static void aprop_cache_drop(APROP_CACHEP * prev) {
+  APROP_CACHEP c = *prev;
+  *prev = c->next;
+  aprop_free(c->prop);
+  free(c->path);
+  free(c);
+  aprop_cache_n--;
+}
+
+//-- Cached Lookup, returns strdup'ed value or NULL
+static char * aprop_cached_get(const char * path, byte iszip, const char * key) {
+  struct stat st;
+  memset(&st, 0, sizeof(st));
+  
+  if (!iszip && (stat(path, &st) < 0)) {
+    return NULL;
+  }
+  
+  pthread_mutex_lock(&aprop_cache_mutex);
+  APROP_CACHEP * prev = &aprop_cache;
+  APROP_CACHEP   c;
+  
+  while ((c = *prev) != NULL) {
+    if ((c->iszip == iszip) && (strcmp(c->path, path) == 0)) {
+      if (iszip || ((c->mtime == st.st_mtime) &&
+                    (c->mtime_ns == st.st_mtim.tv_nsec) &&
+                    (c->size == st.st_size) && (c->ino == st.st_ino))) {
+        break;
+      }
+      
+      //-- Changed on disk
+      aprop_cache_drop(prev);
+      continue;
+    }
+    
+    prev = &c->next;
+  }
+  
+  if (c == NULL) {
+    char * buf = iszip ? aui_readfromzip((char *) path) : aui_readfromfs((char *) path);
+    
+    if (buf == NULL) {
+      pthread_mutex_unlock(&aprop_cache_mutex);
+      return NULL;
+    }
+    
+    c = (APROP_CACHEP) malloc(sizeof(APROP_CACHE));
+    c->path     = strdup(path);
+    c->iszip    = iszip;
+    c->mtime    = st.st_mtime;
+    c->mtime_ns = st.st_mtim.tv_nsec;
+    c->size     = st.st_size;
+    c->ino      = st.st_ino;
+    c->prop     = aprop_parse(buf);
+    free(buf);
+    
+    //-- Keep cache bounded, oldest entry sits at the tail
+    if (aprop_cache_n >= APROP_CACHE_MAX) {
+      APROP_CACHEP * tail = &aprop_cache;
+      
+      while ((*tail)->next != NULL) {
+        tail = &(*tail)->next;
+      }
+      
+      aprop_cache_drop(tail);
+    }
+    
+    c->next     = aprop_cache;
+    aprop_cache = c;
+    aprop_cache_n++;
+  }
+  
+  char * val = aprop_get(c->prop, key);
+  val = (val != NULL) ? strdup(val) : NULL;
+  pthread_mutex_unlock(&aprop_cache_mutex);
+  return val;
+}
+
+char * aprop_fileget(const char * path, const char * key) {
+  return aprop_cached_get(path, 0, key);
+}
+
+char * aprop_zipget(const char * zpath, const char * key) {
+  return aprop_cached_get(zpath, 1, key);
+}
+
+//-- Parsed Zip Prop, NULL if not exists. Caller must aprop_free
+APROPP aprop_zip(const char * zpath) {
+  char * buf = aui_readfromzip((char *) zpath);
+  APROPP p   = aprop_parse(buf);
+  free(buf);
+  return p;
+}
+
+//-- Drop cached file after it was written
+void aprop_invalidate(const char * path) {
+  pthread_mutex_lock(&aprop_cache_mutex);
+  APROP_CACHEP * prev = &aprop_cache;
+  
+  while (*prev != NULL) {
+    if (!(*prev)->iszip && (strcmp((*prev)->path, path) == 0)) {
+      aprop_cache_drop(prev);
+      break;
+    }
+    
+    prev = &(*prev)->next;
+  }
+  
+  pthread_mutex_unlock(&aprop_cache_mutex);
+}
+
+void aprop_cache_release() {
+  pthread_mutex_lock(&aprop_cache_mutex);
+  
+  while (aprop_cache != NULL) {
+    aprop_cache_drop(&aprop_cache);
+  }
+  
+  pthread_mutex_unlock(&aprop_cache_mutex);
+}
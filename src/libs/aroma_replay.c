@@ -0,0 +1,332 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Descriptions:
+ * -------------
+ * AROMA Replay - feeds a scripted input sequence in place of the input
+ * devices, and records frame timing per interaction
+ *
+ * Script, one event per line, time is ms since replay start:
+ *   <ms> tap x y
+ *   <ms> down|move|up x y
+ *   <ms> swipe x1 y1 x2 y2 duration      (fling when duration is short)
+ *   <ms> key code                         (press + release)
+ *   <ms> mark label                       (start a named interaction)
+ *   <ms> end                              (write report)
+ *   <ms> quit                             (write report & exit)
+ *
+ */
+
+#include <aroma.h>
+
+#define AREPLAY_BUDGET_US   16667         // 60 Hz
+#define AREPLAY_IDLE_US     100000        // Longer gap = idle, not a drop
+#define AREPLAY_MOVE_MS     8             // Swipe sample interval
+#define AREPLAY_MAX_IA      256
+
+typedef struct {
+  long    t;                  // ms since start
+  char    cmd[8];
+  int     v[5];
+  char    label[48];
+} AREPLAY_EVENT;
+
+typedef struct {
+  char      label[48];
+  dword     frames;
+  dword     syncs;
+  dword     dropped;
+  long long sync_us;          // Total ag_sync time
+  long long sync_max;
+  long long interval_max;
+} AREPLAY_IA;
+
+typedef struct {
+  int       ia;
+  long long at;               // Present time (us since start)
+  long long interval;         // Since previous present, 0 = first/idle
+  long long flush;            // Flush duration
+} AREPLAY_FRAME;
+
+static byte             areplay_on      = 0;
+static AREPLAY_EVENT *  areplay_ev      = NULL;
+static int              areplay_evn     = 0;
+static long long        areplay_t0      = 0;
+static pthread_mutex_t  areplay_mutex   = PTHREAD_MUTEX_INITIALIZER;
+static AREPLAY_IA       areplay_ia[AREPLAY_MAX_IA];
+static int              areplay_ian     = 0;
+static AREPLAY_FRAME *  areplay_frames  = NULL;
+static int              areplay_fn      = 0;
+static int              areplay_fcap    = 0;
+static long long        areplay_last    = 0;
+static byte             areplay_done    = 0;
+
+long long areplay_us() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((long long) now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+byte areplay_active() {
+  return areplay_on;
+}
+
+//-- Load script, enables replay mode
+byte areplay_load(const char * path) {
+  FILE * fp = fopen(path, "rb");
+  
+  if (fp == NULL) {
+    LOGE("replay: cannot open %s", path);
+    return 0;
+  }
+  
+  char line[256];
+  int  cap = 64;
+  areplay_ev  = malloc(sizeof(AREPLAY_EVENT) * cap);
+  areplay_evn = 0;
+  
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    AREPLAY_EVENT e;
+    memset(&e, 0, sizeof(e));
+    
+    if ((line[0] == '#') || (sscanf(line, "%ld %7s", &e.t, e.cmd) != 2)) {
+      continue;
+    }
+    
+    if (strcmp(e.cmd, "mark") == 0) {
+      sscanf(line, "%*d %*s %47[^\n]", e.label);
+    }
+    else {
+      sscanf(line, "%*d %*s %d %d %d %d %d", &e.v[0], &e.v[1], &e.v[2], &e.v[3], &e.v[4]);
+      snprintf(e.label, sizeof(e.label), "%s", ai_trim(line));
+    }
+    
+    if (areplay_evn == cap) {
+      cap *= 2;
+      areplay_ev = realloc(areplay_ev, sizeof(AREPLAY_EVENT) * cap);
+    }
+    
+    areplay_ev[areplay_evn++] = e;
+  }
+  
+  fclose(fp);
+  LOGS("replay: %d events from %s", areplay_evn, path);
+  areplay_on = 1;
+  return 1;
+}
+
+//-- Start a new interaction, frames after this point are counted to it
+static void areplay_mark(const char * label) {
+  pthread_mutex_lock(&areplay_mutex);
+  
+  if (areplay_ian < AREPLAY_MAX_IA) {
+    AREPLAY_IA * ia = &areplay_ia[areplay_ian++];
+    memset(ia, 0, sizeof(AREPLAY_IA));
+    snprintf(ia->label, sizeof(ia->label), "%s", label);
+  }
+  
+  areplay_last = 0;
+  pthread_mutex_unlock(&areplay_mutex);
+}
+
+//-- Called after every framebuffer flush
+void areplay_frame(long long start) {
+  if (!areplay_on || (areplay_ian == 0)) {
+    return;
+  }
+  
+  long long now = areplay_us();
+  pthread_mutex_lock(&areplay_mutex);
+  AREPLAY_IA * ia = &areplay_ia[areplay_ian - 1];
+  long long interval = 0;
+  
+  if ((areplay_last > 0) && (now - areplay_last < AREPLAY_IDLE_US)) {
+    interval = now - areplay_last;
+    
+    //-- Missed vsyncs since previous frame
+    int missed = (int)((interval + AREPLAY_BUDGET_US / 2) / AREPLAY_BUDGET_US) - 1;
+    
+    if (missed > 0) {
+      ia->dropped += missed;
+    }
+    
+    if (interval > ia->interval_max) {
+      ia->interval_max = interval;
+    }
+  }
+  
+  ia->frames++;
+  areplay_last = now;
+  
+  if (areplay_fn == areplay_fcap) {
+    areplay_fcap    = areplay_fcap ? areplay_fcap * 2 : 1024;
+    areplay_frames  = realloc(areplay_frames, sizeof(AREPLAY_FRAME) * areplay_fcap);
+  }
+  
+  AREPLAY_FRAME * f = &areplay_frames[areplay_fn++];
+  f->ia       = areplay_ian - 1;
+  f->at       = now - areplay_t0;
+  f->interval = interval;
+  f->flush    = now - start;
+  pthread_mutex_unlock(&areplay_mutex);
+}
+
+//-- Called after every ag_sync
+void areplay_sync(long long start) {
+  if (!areplay_on || (areplay_ian == 0)) {
+    return;
+  }
+  
+  long long d = areplay_us() - start;
+  pthread_mutex_lock(&areplay_mutex);
+  AREPLAY_IA * ia = &areplay_ia[areplay_ian - 1];
+  ia->syncs++;
+  ia->sync_us += d;
+  
+  if (d > ia->sync_max) {
+    ia->sync_max = d;
+  }
+  
+  pthread_mutex_unlock(&areplay_mutex);
+}
+
+//-- Per-frame CSV & per-interaction summary
+void areplay_report() {
+  if (!areplay_on || areplay_done) {
+    return;
+  }
+  
+  areplay_done = 1;
+  pthread_mutex_lock(&areplay_mutex);
+  int i;
+  FILE * fp = fopen(AROMA_SYSTMP "/aroma-replay.csv", "wb");
+  
+  if (fp != NULL) {
+    fprintf(fp, "frame,interaction,at_us,interval_us,flush_us\n");
+    
+    for (i = 0; i < areplay_fn; i++) {
+      AREPLAY_FRAME * f = &areplay_frames[i];
+      fprintf(fp, "%d,%d,%lld,%lld,%lld\n", i, f->ia, f->at, f->interval, f->flush);
+    }
+    
+    fclose(fp);
+  }
+  
+  fp = fopen(AROMA_SYSTMP "/aroma-replay.txt", "wb");
+  dword frames = 0, dropped = 0, syncs = 0;
+  
+  for (i = 0; i < areplay_ian; i++) {
+    AREPLAY_IA * ia = &areplay_ia[i];
+    char line[256];
+    snprintf(line, sizeof(line),
+             "%-32s frames %4u dropped %4u syncs %4u sync avg %6lld us max %6lld us, max interval %6lld us",
+             ia->label, ia->frames, ia->dropped, ia->syncs,
+             ia->syncs ? ia->sync_us / ia->syncs : 0, ia->sync_max, ia->interval_max);
+    LOGS("replay: %s", line);
+    
+    if (fp != NULL) {
+      fprintf(fp, "%s\n", line);
+    }
+    
+    frames  += ia->frames;
+    dropped += ia->dropped;
+    syncs   += ia->syncs;
+  }
+  
+  LOGS("replay: total frames %u dropped %u syncs %u", frames, dropped, syncs);
+  
+  if (fp != NULL) {
+    fprintf(fp, "total frames %u dropped %u syncs %u\n", frames, dropped, syncs);
+    fclose(fp);
+  }
+  
+  pthread_mutex_unlock(&areplay_mutex);
+}
+
+static void areplay_wait(long t) {
+  long long at = areplay_t0 + ((long long) t) * 1000;
+  long long now;
+  
+  while ((now = areplay_us()) < at) {
+    usleep(at - now);
+  }
+}
+
+//-- Run script, on the input thread so it stays the single event producer
+void areplay_run() {
+  int i, j;
+  areplay_t0 = areplay_us();
+  
+  for (i = 0; i < areplay_evn; i++) {
+    AREPLAY_EVENT * e = &areplay_ev[i];
+    int * v = e->v;
+    areplay_wait(e->t);
+    
+    if (strcmp(e->cmd, "mark") == 0) {
+      areplay_mark(e->label);
+      continue;
+    }
+    
+    if ((strcmp(e->cmd, "end") == 0) || (strcmp(e->cmd, "quit") == 0)) {
+      areplay_report();
+      
+      if (e->cmd[0] == 'q') {
+        exit(0);
+      }
+      
+      continue;
+    }
+    
+    areplay_mark(e->label);
+    
+    if (strcmp(e->cmd, "tap") == 0) {
+      ev_inject_touch(v[0], v[1], 1);
+      usleep(AREPLAY_MOVE_MS * 1000 * 6);
+      ev_inject_touch(v[0], v[1], 0);
+    }
+    else if (strcmp(e->cmd, "down") == 0) {
+      ev_inject_touch(v[0], v[1], 1);
+    }
+    else if (strcmp(e->cmd, "move") == 0) {
+      ev_inject_touch(v[0], v[1], 2);
+    }
+    else if (strcmp(e->cmd, "up") == 0) {
+      ev_inject_touch(v[0], v[1], 0);
+    }
+    else if (strcmp(e->cmd, "swipe") == 0) {
+      int steps = max(1, v[4] / AREPLAY_MOVE_MS);
+      ev_inject_touch(v[0], v[1], 1);
+      
+      for (j = 1; j <= steps; j++) {
+        usleep(AREPLAY_MOVE_MS * 1000);
+        ev_inject_touch(v[0] + (v[2] - v[0]) * j / steps, v[1] + (v[3] - v[1]) * j / steps, 2);
+      }
+      
+      ev_inject_touch(v[2], v[3], 0);
+    }
+    else if (strcmp(e->cmd, "key") == 0) {
+      ev_inject_key(v[0], 1);
+      usleep(AREPLAY_MOVE_MS * 1000);
+      ev_inject_key(v[0], 0);
+    }
+    else {
+      LOGW("replay: unknown command %s", e->cmd);
+    }
+  }
+  
+  LOGS("replay: script finished");
+}
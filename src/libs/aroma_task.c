@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Descriptions:
+ * -------------
+ * AROMA Task Graph - runs a small set of dependent jobs on a
+ * thread pool, each job starts as soon as its dependencies are done
+ *
+ */
+
+#include <aroma.h>
+
+#define ATASK_PENDING   0
+#define ATASK_RUNNING   1
+#define ATASK_DONE      2
+
+//-- Next runnable task, -1 = none yet. Caller holds the mutex
+static int atask_next(ATASKGRAPHP g) {
+  int i, j;
+  
+  for (i = 0; i < g->n; i++) {
+    ATASKP t = &g->t[i];
+    
+    if (t->state != ATASK_PENDING) {
+      continue;
+    }
+    
+    byte ready = 1;
+    
+    for (j = 0; j < g->n; j++) {
+      if (!(t->deps & ATASK_DEP(j))) {
+        continue;
+      }
+      
+      if (g->t[j].state != ATASK_DONE) {
+        ready = 0;
+        break;
+      }
+      
+      if (!g->t[j].result) {
+        //-- Dependency failed, skip without running
+        t->state  = ATASK_DONE;
+        t->result = 0;
+        g->done++;
+        ready = 0;
+        pthread_cond_broadcast(&g->cond);
+        break;
+      }
+    }
+    
+    if (ready) {
+      return i;
+    }
+  }
+  
+  return -1;
+}
+
+static void * atask_worker(void * cookie) {
+  ATASKGRAPHP g = (ATASKGRAPHP) cookie;
+  pthread_mutex_lock(&g->mutex);
+  
+  while (g->done < g->n) {
+    int i = atask_next(g);
+    
+    if (i < 0) {
+      if (g->done < g->n) {
+        pthread_cond_wait(&g->cond, &g->mutex);
+      }
+      
+      continue;
+    }
+    
+    ATASKP t = &g->t[i];
+    t->state = ATASK_RUNNING;
+    pthread_mutex_unlock(&g->mutex);
+    t->start  = aTick();
+    byte res  = t->fn(t->arg);
+    t->end    = aTick();
+    pthread_mutex_lock(&g->mutex);
+    t->result = res;
+    t->state  = ATASK_DONE;
+    g->done++;
+    pthread_cond_broadcast(&g->cond);
+  }
+  
+  pthread_mutex_unlock(&g->mutex);
+  return NULL;
+}
+
+void atask_init(ATASKGRAPHP g) {
+  memset(g, 0, sizeof(ATASKGRAPH));
+  pthread_mutex_init(&g->mutex, NULL);
+  pthread_cond_init(&g->cond, NULL);
+}
+
+//-- Add task, deps is ATASK_DEP(id) of earlier tasks. Returns id
+int atask_add(ATASKGRAPHP g, const char * name, ATASK_FN fn, void * arg, dword deps) {
+  if (g->n >= ATASK_MAX) {
+    LOGE("atask_add: too many tasks (%s)", name);
+    return -1;
+  }
+  
+  ATASKP t = &g->t[g->n];
+  t->name  = name;
+  t->fn    = fn;
+  t->arg   = arg;
+  t->deps  = deps & (ATASK_DEP(g->n) - 1);
+  return g->n++;
+}
+
+//-- Run all tasks, calling thread joins the pool. 1 if all succeeded
+byte atask_run(ATASKGRAPHP g, int threads) {
+  pthread_t th[ATASK_MAX];
+  int       i;
+  int       nth = 0;
+  long      start = aTick();
+  
+  if (threads > g->n) {
+    threads = g->n;
+  }
+  
+  for (i = 1; i < threads; i++) {
+    if (pthread_create(&th[nth], NULL, atask_worker, g) == 0) {
+      nth++;
+    }
+  }
+  
+  atask_worker(g);
+  
+  for (i = 0; i < nth; i++) {
+    pthread_join(th[i], NULL);
+  }
+  
+  byte res = 1;
+  
+  for (i = 0; i < g->n; i++) {
+    ATASKP t = &g->t[i];
+    
+    if (t->start) {
+      LOGS("task %-8s %s at +%ld ms, took %ld ms",
+           t->name, t->result ? "done" : "FAILED", t->start - start, t->end - t->start);
+    }
+    else {
+      LOGS("task %-8s skipped", t->name);
+    }
+    
+    res &= t->result;
+  }
+  
+  LOGS("tasks finished in %ld ms on %d threads", aTick() - start, nth + 1);
+  pthread_mutex_destroy(&g->mutex);
+  pthread_cond_destroy(&g->cond);
+  return res;
+}
+
+byte atask_result(ATASKGRAPHP g, int id) {
+  return ((id >= 0) && (id < g->n)) ? g->t[id].result : 0;
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Descriptions:
+ * -------------
+ * AROMA Trace - begin/end spans and counters recorded into a per
+ * thread ring (single writer, no locks), dumped as Chrome trace JSON.
+ * Records nothing until atrace_enable. Rings of finished threads are
+ * reused, keeping their events until overwritten
+ *
+ */
+
+#include <sys/syscall.h>
+#include <aroma.h>
+
+#define ATRACE_RING_SZ    16384       // Events per named thread, power of 2
+#define ATRACE_RING_WORK  1024        // Events per worker thread, power of 2
+
+typedef struct {
+  const char  *   name;
+  long long       ts;                 // Microseconds, CLOCK_MONOTONIC
+  long            value;
+  int             tid;                // Rings are reused across threads
+  char            ph;                 // B, E or C
+} ATRACE_EVENT;
+
+typedef struct _ATRACE_RING {
+  int             tid;
+  const char  *   tname;
+  dword           size;
+  dword           head;               // Total written, release-stored
+  ATRACE_EVENT  * ev;
+  struct _ATRACE_RING * next;         // All rings, for the dump
+  struct _ATRACE_RING * free_next;    // Rings of finished threads
+} ATRACE_RING;
+
+static pthread_key_t    atrace_key;
+static pthread_once_t   atrace_once    = PTHREAD_ONCE_INIT;
+static pthread_mutex_t  atrace_mutex   = PTHREAD_MUTEX_INITIALIZER;
+static ATRACE_RING   *  atrace_rings   = NULL;
+static ATRACE_RING   *  atrace_free    = NULL;
+static byte             atrace_enabled = 0;
+
+//-- Thread exit, ring goes back for the next thread
+static void atrace_ring_put(void * cookie) {
+  ATRACE_RING * r = (ATRACE_RING *) cookie;
+  pthread_mutex_lock(&atrace_mutex);
+  r->free_next = atrace_free;
+  atrace_free  = r;
+  pthread_mutex_unlock(&atrace_mutex);
+}
+
+static void atrace_keyinit() {
+  pthread_key_create(&atrace_key, atrace_ring_put);
+}
+
+//-- Start recording, call before any thread is created
+void atrace_enable() {
+  atrace_enabled = 1;
+}
+
+//-- Calling thread ring, reused or created & published on first use.
+//   Named threads get a full ring, short lived workers a small one
+static ATRACE_RING * atrace_ring(dword size) {
+  pthread_once(&atrace_once, atrace_keyinit);
+  ATRACE_RING * r = (ATRACE_RING *) pthread_getspecific(atrace_key);
+  
+  if (r != NULL) {
+    return r;
+  }
+  
+  ATRACE_RING ** p;
+  pthread_mutex_lock(&atrace_mutex);
+  
+  for (p = &atrace_free; *p != NULL; p = &(*p)->free_next) {
+    if ((*p)->size == size) {
+      r  = *p;
+      *p = r->free_next;
+      break;
+    }
+  }
+  
+  pthread_mutex_unlock(&atrace_mutex);
+  
+  if (r == NULL) {
+    r = (ATRACE_RING *) calloc(1, sizeof(ATRACE_RING));
+    
+    if (r == NULL) {
+      return NULL;
+    }
+    
+    r->ev = (ATRACE_EVENT *) calloc(size, sizeof(ATRACE_EVENT));
+    
+    if (r->ev == NULL) {
+      free(r);
+      return NULL;
+    }
+    
+    r->size = size;
+    r->next = __atomic_load_n(&atrace_rings, __ATOMIC_RELAXED);
+    
+    while (!__atomic_compare_exchange_n(&atrace_rings, &r->next, r, 1,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {}
+  }
+  
+  r->tid   = (int) syscall(__NR_gettid);
+  r->tname = NULL;
+  pthread_setspecific(atrace_key, r);
+  return r;
+}
+
+void atrace_event(char ph, const char * name, long value) {
+  if (!atrace_enabled) {
+    return;
+  }
+  
+  ATRACE_RING * r = atrace_ring(ATRACE_RING_WORK);
+  
+  if (r == NULL) {
+    return;
+  }
+  
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  dword h = r->head;
+  ATRACE_EVENT * e = &r->ev[h & (r->size - 1)];
+  e->name  = name;
+  e->ts    = ((long long) now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+  e->value = value;
+  e->tid   = r->tid;
+  e->ph    = ph;
+  __atomic_store_n(&r->head, h + 1, __ATOMIC_RELEASE);
+}
+
+//-- Name shown for calling thread, must be a literal. Call first
+//   thing in the thread, it decides the ring size
+void atrace_thread_name(const char * name) {
+  if (!atrace_enabled) {
+    return;
+  }
+  
+  ATRACE_RING * r = atrace_ring(ATRACE_RING_SZ);
+  
+  if (r != NULL) {
+    r->tname = name;
+  }
+}
+
+const char * atrace_scope_begin(const char * name) {
+  atrace_event('B', name, 0);
+  return name;
+}
+void atrace_scope_end(const char ** name) {
+  atrace_event('E', *name, 0);
+}
+
+static void atrace_putname(FILE * fp, const char * s) {
+  fputc('"', fp);
+  
+  for (; *s; s++) {
+    if ((*s == '"') || (*s == '\\')) {
+      fputc('\\', fp);
+    }
+    
+    if ((byte) * s >= 0x20) {
+      fputc(*s, fp);
+    }
+  }
+  
+  fputc('"', fp);
+}
+
+//-- Write all rings as Chrome trace-event JSON
+byte atrace_dump(const char * path) {
+  FILE * fp = fopen(path, "wb");
+  
+  if (fp == NULL) {
+    LOGE("atrace_dump: cannot write %s", path);
+    return 0;
+  }
+  
+  int pid   = getpid();
+  int count = 0;
+  ATRACE_RING * r;
+  fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  
+  for (r = __atomic_load_n(&atrace_rings, __ATOMIC_ACQUIRE); r != NULL; r = r->next) {
+    dword head  = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    dword start = (head > r->size) ? head - r->size : 0;
+    dword i;
+    
+    if (r->tname != NULL) {
+      fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":",
+              count++ ? ",\n" : "", pid, r->tid);
+      atrace_putname(fp, r->tname);
+      fprintf(fp, "}}");
+    }
+    
+    for (i = start; i != head; i++) {
+      ATRACE_EVENT * e = &r->ev[i & (r->size - 1)];
+      fprintf(fp, "%s{\"name\":", count++ ? ",\n" : "");
+      atrace_putname(fp, e->name);
+      fprintf(fp, ",\"ph\":\"%c\",\"ts\":%lld,\"pid\":%d,\"tid\":%d",
+              e->ph, e->ts, pid, e->tid);
+      
+      if (e->ph == 'C') {
+        fprintf(fp, ",\"args\":{\"value\":%ld}", e->value);
+      }
+      
+      fputc('}', fp);
+    }
+  }
+  
+  fprintf(fp, "\n]}\n");
+  fclose(fp);
+  LOGS("Trace written to %s (%d events)", path, count);
+  return 1;
+}
@@ -21,6 +21,7 @@
  *
  */
 
+#include <sys/mman.h>
 #include "minzip/Zip.h"
 #include "minzip/SysUtil.h"
 #include <aroma.h>
@@ -52,6 +53,14 @@ void az_close() {
 
 //-- Extract To Memory
 byte az_readmem(AZMEM * out, const char * zpath, byte bytesafe) {
+  ATRACE_SCOPE("az_readmem");
+  byte prefetched;
+  
+  //-- Read ahead by aprefetch_mem
+  if (aprefetch_takemem(zpath, out, bytesafe, &prefetched)) {
+    return prefetched;
+  }
+  
   char z_path[256];
   snprintf(z_path, sizeof(z_path) - 1, "%s", zpath);
   const ZipEntry * se = mzFindZipEntry(&zip, z_path);
@@ -60,8 +69,9 @@ byte az_readmem(AZMEM * out, const char * zpath, byte bytesafe) {
     return 0;
   }
   
-  out->sz   = se->uncompLen + (bytesafe ? 0 : 1);
-  out->data = malloc(out->sz);
+  out->sz     = se->uncompLen + (bytesafe ? 0 : 1);
+  out->data   = malloc(out->sz);
+  out->mapped = 0;
   
   //memset(out->data,0,out->sz);
   if (!mzReadZipEntry(&zip, se, (char *)out->data, se->uncompLen)) {
@@ -73,6 +83,81 @@ byte az_readmem(AZMEM * out, const char * zpath, byte bytesafe) {
     out->data[se->uncompLen] = '\0';
   }
   
+  ATRACE_COUNTER("zip.bytes", se->uncompLen);
+  return 1;
+}
+
+//-- madvise the pages of [p, p+len), inner = only pages fully inside
+static void az_advise(char * p, long len, int advice, byte inner) {
+  uintptr_t pg = (uintptr_t) sysconf(_SC_PAGESIZE);
+  uintptr_t s  = (uintptr_t) p;
+  uintptr_t e  = s + len;
+  
+  if (inner) {
+    s = (s + pg - 1) & ~(pg - 1);
+    e = e & ~(pg - 1);
+  }
+  else {
+    s = s & ~(pg - 1);
+  }
+  
+  if (e > s) {
+    madvise((void *) s, e - s, advice);
+  }
+}
+
+//-- Read-only view of a zip item. Stored items point straight into the
+//   package mapping, deflated ones are inflated as az_readmem (bytesafe).
+//   The mapping is kept over az_close, so views stay valid until az_unmap
+byte az_map(AZMEM * out, const char * zpath, byte usage) {
+  ATRACE_SCOPE("az_map");
+  char z_path[256];
+  snprintf(z_path, sizeof(z_path) - 1, "%s", zpath);
+  const ZipEntry * se = mzFindZipEntry(&zip, z_path);
+  
+  if (se == NULL) {
+    return 0;
+  }
+  
+  if (se->compression != STORED) {
+    return az_readmem(out, zpath, 1);
+  }
+  
+  out->sz     = se->uncompLen;
+  out->data   = (char *) zip.addr + se->offset;
+  out->mapped = 1;
+  az_advise(out->data, out->sz, (usage == AZ_MAP_KEEP) ? MADV_WILLNEED : MADV_SEQUENTIAL, 0);
+  ATRACE_COUNTER("zip.mapped", se->uncompLen);
+  return 1;
+}
+
+//-- Release az_map / az_readmem data. Mapped pages are only dropped
+//   from memory, the package stays mapped
+void az_unmap(AZMEM * mem) {
+  if (mem->data == NULL) {
+    return;
+  }
+  
+  if (mem->mapped) {
+    az_advise(mem->data, mem->sz, MADV_DONTNEED, 1);
+    mem->data = NULL;
+  }
+  else {
+    free(mem->data);
+  }
+}
+
+//-- CRC32 of an item, as recorded in the zip directory
+byte az_crc(const char * zpath, dword * crc) {
+  char z_path[256];
+  snprintf(z_path, sizeof(z_path) - 1, "%s", zpath);
+  const ZipEntry * se = mzFindZipEntry(&zip, z_path);
+  
+  if (se == NULL) {
+    return 0;
+  }
+  
+  *crc = (dword) se->crc32;
   return 1;
 }
 
@@ -136,12 +136,13 @@ static drm_surface *drm_create_surface(int width, int height) {
         return NULL;
     }
 
-    if (1) {
+    /* match the canvas, a 32bit canvas posts as a plain copy */
+    if (sizeof(libaroma_pixel) == 2) {
         format = DRM_FORMAT_RGB565;
         LOGI("setting DRM_FORMAT_RGB565");
     } else {
-        format = DRM_FORMAT_XBGR8888;
-        LOGI("setting DRM_FORMAT_XBGR8888");
+        format = DRM_FORMAT_XRGB8888;
+        LOGI("setting DRM_FORMAT_XRGB8888");
     }
 
     memset(&create_dumb, 0, sizeof(create_dumb));
@@ -377,7 +378,7 @@ int drm_start_post(LIBAROMA_FBP me) {
 }
 
 int drm_post(
-    LIBAROMA_FBP me, uint16_t *__restrict src,
+    LIBAROMA_FBP me, libaroma_pixel *__restrict src,
     __unused int dx, __unused int dy, __unused int dw, __unused int dh,
     __unused int sx, __unused int sy, __unused int sw, __unused int sh
     ) {
@@ -387,9 +388,9 @@ int drm_post(
     LINUXFBDR_INTERNALP mi = (LINUXFBDR_INTERNALP) me->internal;
     /* DRM doesn't allow to update regions, so we must blit the entire buffer */
     if (mi->pixsz == 2) {
-        libaroma_blt_align16((uint16_t *) mi->buffer, src, me->w, me->h, mi->stride, 0);
+        libaroma_blt_to16((uint16_t *) mi->buffer, src, me->w, me->h, mi->stride, 0);
     } else {
-        libaroma_blt_align16_to32((uint32_t *) mi->buffer, src, me->w, me->h, mi->stride, 0);
+        libaroma_blt_to32((uint32_t *) mi->buffer, src, me->w, me->h, mi->stride, 0, NULL);
     }
     return 1;
 }
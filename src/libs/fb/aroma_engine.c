@@ -28,6 +28,8 @@
 
 #include <aroma.h>
 
+/* ordered dithering, only a 565 canvas quantizes */
+#ifndef _AROMA_CANVAS32
 static uint8_t libaroma_dither_tresshold_r[64] = {
     1, 7, 3, 5, 0, 8, 2, 6,
     7, 1, 5, 3, 8, 0, 6, 2,
@@ -113,8 +115,9 @@ uint16_t libaroma_dither_mono(int x, int y, uint32_t col) {
 uint16_t libaroma_dither(int x, int y, uint32_t col) {
     return libaroma_dither_rgb(x, y, libaroma_color_r32(col), libaroma_color_g32(col), libaroma_color_b32(col));
 }
+#endif
 
-uint16_t libaroma_rgb_from_string(const char * c) {
+libaroma_pixel libaroma_rgb_from_string(const char * c) {
     if (c[0] != '#') {
         return 0;
     }
@@ -133,22 +136,23 @@ uint16_t libaroma_rgb_from_string(const char * c) {
         return 0;
     }
     out[8] = 0;
-    return libaroma_rgb_to16(strtoul(out, NULL, 0));
+    uint32_t rgb = strtoul(out, NULL, 0);
+    return libaroma_rgb(libaroma_color_r32(rgb), libaroma_color_g32(rgb), libaroma_color_b32(rgb));
 }
 
-/* Convert 16bit color to 32bit color */
-uint32_t libaroma_rgb_to32(uint16_t rgb) {
+/* Convert canvas color to 32bit color */
+uint32_t libaroma_rgb_to32(libaroma_pixel rgb) {
 return libaroma_rgb32(libaroma_color_r(rgb), libaroma_color_g(rgb), libaroma_color_b(rgb));
 }
 
-void libaroma_color_set(uint16_t *dst, uint16_t color, int n) {
+void libaroma_color_set(libaroma_pixel *dst, libaroma_pixel color, int n) {
     int i,left=n%32;
     if (n>=32) {
         for (i=0;i<32;i++) {
             dst[i]=color;
         }
         for (i=32;i<n-left;i+=32) {
-            memcpy(dst+i,dst,64);
+            memcpy(dst+i,dst,32*sizeof(libaroma_pixel));
         }
     }
     if (left>0) {
@@ -162,7 +166,7 @@ void libaroma_color_copy32(uint32_t *dst, uint16_t *src, int n, uint8_t *rgb_pos
     int i;
     for (i = 0; i < n; i++) {
         uint16_t cl = src[i];
-        dst[i] = (((libaroma_color_r(cl) & 0xff) << rgb_pos[0]) | ((libaroma_color_g(cl) & 0xff) << rgb_pos[1]) | ((libaroma_color_b(cl) & 0xff) << rgb_pos[2]));
+        dst[i] = ((((cl & 0xF800) >> 8) << rgb_pos[0]) | (((cl & 0x07E0) >> 3) << rgb_pos[1]) | (((cl & 0x001F) << 3) << rgb_pos[2]));
     }
 }
 
@@ -170,11 +174,41 @@ void libaroma_color_copy16(uint16_t *dst, uint32_t *src, int n, uint8_t *rgb_pos
     int i;
     for (i = 0; i < n; i++) {
         uint32_t cl = src[i];
-        dst[i] = libaroma_rgb((uint8_t) ((cl >> rgb_pos[0]) & 0xff), (uint8_t) ((cl >> rgb_pos[1]) & 0xff), (uint8_t) ((cl >> rgb_pos[2]) & 0xff));
+        dst[i] = libaroma_rgb_to16(libaroma_rgb32((uint8_t) ((cl >> rgb_pos[0]) & 0xff), (uint8_t) ((cl >> rgb_pos[1]) & 0xff), (uint8_t) ((cl >> rgb_pos[2]) & 0xff)));
     }
 }
 
-uint16_t libaroma_alpha(uint16_t dcl, uint16_t scl, uint8_t l) {
+#ifdef _AROMA_CANVAS32
+/* XRGB8888: red & blue blended together, green alone */
+libaroma_pixel libaroma_alpha(libaroma_pixel dcl, libaroma_pixel scl, uint8_t l) {
+    if (scl == dcl) {
+        return scl;
+    } else if (l == 0) {
+        return dcl;
+    } else if (l == 0xff) {
+        return scl;
+    }
+    uint32_t na = l;
+    uint32_t fa = 256 - na;
+    uint32_t rb = (((dcl & 0xff00ff) * fa) + ((scl & 0xff00ff) * na)) >> 8;
+    uint32_t g = (((dcl & 0x00ff00) * fa) + ((scl & 0x00ff00) * na)) >> 8;
+    return (rb & 0xff00ff) | (g & 0x00ff00);
+}
+uint32_t libaroma_alpha32(libaroma_pixel dcl, libaroma_pixel scl, uint8_t l) {
+    return libaroma_alpha(dcl, scl, l) | 0xff000000;
+}
+
+libaroma_pixel libaroma_alphab(libaroma_pixel scl, uint8_t l) {
+    if (l == 0) {
+        return 0;
+    } else if (l == 255) {
+        return scl;
+    }
+    uint32_t na = l;
+    return ((((scl & 0xff00ff) * na) >> 8) & 0xff00ff) | ((((scl & 0x00ff00) * na) >> 8) & 0x00ff00);
+}
+#else
+libaroma_pixel libaroma_alpha(libaroma_pixel dcl, libaroma_pixel scl, uint8_t l) {
     if (scl == dcl) {
         return scl;
     } else if (l == 0) {
@@ -193,7 +227,7 @@ uint16_t libaroma_alpha(uint16_t dcl, uint16_t scl, uint8_t l) {
         (libaroma_color_b(scl) * na)) >> 11)
     );
 }
-uint32_t libaroma_alpha32(uint16_t dcl, uint16_t scl, uint8_t l) {
+uint32_t libaroma_alpha32(libaroma_pixel dcl, libaroma_pixel scl, uint8_t l) {
     if (scl == dcl) {
         return libaroma_rgb_to32(scl);
     } else if (l == 0) {
@@ -214,7 +248,7 @@ uint32_t libaroma_alpha32(uint16_t dcl, uint16_t scl, uint8_t l) {
     );
 }
 
-uint16_t libaroma_alphab(uint16_t scl, uint8_t l) {
+libaroma_pixel libaroma_alphab(libaroma_pixel scl, uint8_t l) {
     if (l == 0) {
         return 0;
     } else if (l == 255) {
@@ -223,8 +257,9 @@ uint16_t libaroma_alphab(uint16_t scl, uint8_t l) {
     uint16_t na = l;
     return (uint16_t) (((libaroma_color_r(scl) * na) >> 11 << 11) | ((libaroma_color_g(scl) * na) >> 10 << 5) | ((libaroma_color_b(scl) * na) >> 11));
 }
+#endif
 
-void libaroma_alpha_const(int n, uint16_t *dst, uint16_t *bottom, uint16_t *top, uint8_t alpha) {
+void libaroma_alpha_const(int n, libaroma_pixel *dst, libaroma_pixel *bottom, libaroma_pixel *top, uint8_t alpha) {
     int i;
 
     for (i = 0; i < n; i++) {
@@ -232,14 +267,19 @@ void libaroma_alpha_const(int n, uint16_t *dst, uint16_t *bottom, uint16_t *top,
     }
 }
 
-void libaroma_alpha_const_line(int _Y, int n, uint16_t *dst, uint16_t *bottom, uint16_t *top, uint8_t alpha) {
+void libaroma_alpha_const_line(int _Y, int n, libaroma_pixel *dst, libaroma_pixel *bottom, libaroma_pixel *top, uint8_t alpha) {
+#ifdef _AROMA_CANVAS32
+    /* no quantization, nothing to dither */
+    libaroma_alpha_const(n, dst, bottom, top, alpha);
+#else
     int i;
     for (i = 0; i < n; i++) {
         dst[i] = libaroma_dither(i, _Y, libaroma_alpha32(bottom[i], top[i], alpha));
     }
+#endif
 }
 
-void libaroma_alpha_rgba_fill(int n, uint16_t *dst, uint16_t *bottom, uint16_t top, uint8_t alpha) {
+void libaroma_alpha_rgba_fill(int n, libaroma_pixel *dst, libaroma_pixel *bottom, libaroma_pixel top, uint8_t alpha) {
     int i;
     for (i = 0; i < n; i++) {
         dst[i] = libaroma_alpha(bottom[i], top, alpha);
@@ -249,7 +289,7 @@ void libaroma_alpha_rgba_fill(int n, uint16_t *dst, uint16_t *bottom, uint16_t t
 void libaroma_btl32(int n, uint32_t *dst, const uint16_t *src) {
     int i;
     for (i = 0; i < n; i++) {
-        dst[i] = libaroma_rgb_to32(src[i]);
+        dst[i] = libaroma_rgb32(((src[i] & 0xF800) >> 8), ((src[i] & 0x07E0) >> 3), ((src[i] & 0x001F) << 3));
     }
 }
 
@@ -291,3 +331,78 @@ void libaroma_blt_align_to16_pos(uint16_t *__restrict dst, uint32_t *__restrict
         libaroma_color_copy16(dst+dline*i, src+sline*i, w, rgb_pos);
     }
 }
+
+#ifdef _AROMA_CANVAS32
+/* canvas is XRGB already, only a different channel order needs a swap */
+static inline int libaroma_blt_native(uint8_t *rgb_pos) {
+    return (rgb_pos == NULL) || ((rgb_pos[0] == 16) && (rgb_pos[1] == 8) && (rgb_pos[2] == 0));
+}
+
+static void libaroma_blt_swap32(uint32_t *__restrict dst, uint32_t *__restrict src, int w, int h, int dst_stride, int src_stride, uint8_t *rgb_pos, uint8_t *src_pos) {
+    int i, j;
+    int dline = w+(dst_stride>>2);
+    int sline = w+(src_stride>>2);
+    for (i = 0; i < h; i++) {
+        uint32_t *d = dst+dline*i;
+        uint32_t *s = src+sline*i;
+        for (j = 0; j < w; j++) {
+            uint32_t cl = s[j];
+            d[j] = ((((cl >> src_pos[0]) & 0xff) << rgb_pos[0]) | (((cl >> src_pos[1]) & 0xff) << rgb_pos[1]) | (((cl >> src_pos[2]) & 0xff) << rgb_pos[2]));
+        }
+    }
+}
+
+static uint8_t libaroma_xrgb_pos[3] = {16, 8, 0};
+
+void libaroma_blt_to16(uint16_t *__restrict dst, libaroma_pixel *__restrict src, int w, int h, int dst_stride, int src_stride) {
+    libaroma_blt_align_to16_pos(dst, src, w, h, dst_stride, src_stride, libaroma_xrgb_pos);
+}
+
+void libaroma_blt_to32(uint32_t *__restrict dst, libaroma_pixel *__restrict src, int w, int h, int dst_stride, int src_stride, uint8_t *rgb_pos) {
+    if (!libaroma_blt_native(rgb_pos)) {
+        libaroma_blt_swap32(dst, src, w, h, dst_stride, src_stride, rgb_pos, libaroma_xrgb_pos);
+        return;
+    }
+    int i;
+    int w4 = w<<2;
+    int ds = w4 + dst_stride;
+    int ss = w4 + src_stride;
+    uint8_t *d = (uint8_t *) dst;
+    uint8_t *s = (uint8_t *) src;
+    for (i = 0; i < h; i++) {
+        memcpy(d+ds*i, s+ss*i, w4);
+    }
+}
+
+void libaroma_blt_from16(libaroma_pixel *__restrict dst, uint16_t *__restrict src, int w, int h, int dst_stride, int src_stride) {
+    libaroma_blt_align_to32_pos(dst, src, w, h, dst_stride, src_stride, libaroma_xrgb_pos);
+}
+
+void libaroma_blt_from32(libaroma_pixel *__restrict dst, uint32_t *__restrict src, int w, int h, int dst_stride, int src_stride, uint8_t *rgb_pos) {
+    if (!libaroma_blt_native(rgb_pos)) {
+        libaroma_blt_swap32(dst, src, w, h, dst_stride, src_stride, libaroma_xrgb_pos, rgb_pos);
+        return;
+    }
+    libaroma_blt_to32(dst, src, w, h, dst_stride, src_stride, NULL);
+}
+#else
+void libaroma_blt_to16(uint16_t *__restrict dst, libaroma_pixel *__restrict src, int w, int h, int dst_stride, int src_stride) {
+    libaroma_blt_align16(dst, src, w, h, dst_stride, src_stride);
+}
+
+void libaroma_blt_to32(uint32_t *__restrict dst, libaroma_pixel *__restrict src, int w, int h, int dst_stride, int src_stride, uint8_t *rgb_pos) {
+    if (rgb_pos == NULL) {
+        libaroma_blt_align16_to32(dst, src, w, h, dst_stride, src_stride);
+    } else {
+        libaroma_blt_align_to32_pos(dst, src, w, h, dst_stride, src_stride, rgb_pos);
+    }
+}
+
+void libaroma_blt_from16(libaroma_pixel *__restrict dst, uint16_t *__restrict src, int w, int h, int dst_stride, int src_stride) {
+    libaroma_blt_align16(dst, src, w, h, dst_stride, src_stride);
+}
+
+void libaroma_blt_from32(libaroma_pixel *__restrict dst, uint32_t *__restrict src, int w, int h, int dst_stride, int src_stride, uint8_t *rgb_pos) {
+    libaroma_blt_align_to16_pos(dst, src, w, h, dst_stride, src_stride, rgb_pos);
+}
+#endif
@@ -29,6 +29,13 @@
 #ifndef __aroma_engine_h__
 #define __aroma_engine_h__
 
+/* canvas pixel, RGB565 or XRGB8888 when built with _AROMA_CANVAS32 */
+#ifdef _AROMA_CANVAS32
+typedef uint32_t libaroma_pixel;
+#else
+typedef uint16_t libaroma_pixel;
+#endif
+
 /* color macros */
 #ifdef RGB
 #pragma message "RGB already defined, overriding"
@@ -37,15 +44,27 @@
 #define libaroma_color_close_b libaroma_color_close_r
 
 /* inline color functions */
-static inline uint8_t libaroma_color_r(uint16_t rgb) {
+#ifdef _AROMA_CANVAS32
+static inline uint8_t libaroma_color_r(libaroma_pixel rgb) {
+    return (uint8_t) ((rgb >> 16) & 0xff);
+}
+static inline uint8_t libaroma_color_g(libaroma_pixel rgb) {
+    return (uint8_t) ((rgb >> 8) & 0xff);
+}
+static inline uint8_t libaroma_color_b(libaroma_pixel rgb) {
+    return (uint8_t) (rgb & 0xff);
+}
+#else
+static inline uint8_t libaroma_color_r(libaroma_pixel rgb) {
     return ((uint8_t) (((((uint16_t)(rgb)) & 0xF800)) >> 8));
 }
-static inline uint8_t libaroma_color_g(uint16_t rgb) {
+static inline uint8_t libaroma_color_g(libaroma_pixel rgb) {
     return ((uint8_t) (((((uint16_t)(rgb)) & 0x07E0)) >> 3));
 }
-static inline uint8_t libaroma_color_b(uint16_t rgb) {
+static inline uint8_t libaroma_color_b(libaroma_pixel rgb) {
     return ((uint8_t) (((((uint16_t)(rgb)) & 0x001F)) << 3));
 }
+#endif
 static inline uint8_t libaroma_color_hi_g(uint8_t v){
     return (v | (v >> 6));
 }
@@ -70,9 +89,15 @@ static inline uint8_t libaroma_color_close_g(uint8_t c) {
 static inline uint8_t libaroma_color_left(uint8_t r, uint8_t g, uint8_t b) {
     return ((((r - libaroma_color_close_r(r)) & 7) << 5) | (((g - libaroma_color_close_g(g)) & 3) << 3) | ((b - libaroma_color_close_b(b)) & 7));
 }
-static inline uint16_t libaroma_rgb(uint8_t r, uint8_t g, uint8_t b) {
+#ifdef _AROMA_CANVAS32
+static inline libaroma_pixel libaroma_rgb(uint8_t r, uint8_t g, uint8_t b) {
+    return (libaroma_pixel) ((r << 16) | (g << 8) | b);
+}
+#else
+static inline libaroma_pixel libaroma_rgb(uint8_t r, uint8_t g, uint8_t b) {
     return ((uint16_t)((r >> 3) << 11)|((g >> 2) << 5) | (b >> 3));
 }
+#endif
 static inline uint32_t libaroma_rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a) {
     return (uint32_t) (((r & 0xff)<<16)|((g & 0xff)<<8)|(b & 0xff)|((a & 0xff) << 24));
 }
@@ -80,18 +105,18 @@ static inline uint32_t libaroma_rgb32(uint8_t r, uint8_t g, uint8_t b) {
     return libaroma_rgba(r, g, b, 0xff);
 }
 static inline uint16_t libaroma_rgb_to16(uint32_t rgb) {
-    return libaroma_rgb(libaroma_color_r32(rgb), libaroma_color_g32(rgb), libaroma_color_b32(rgb));
+    return ((uint16_t)((libaroma_color_r32(rgb) >> 3) << 11)|((libaroma_color_g32(rgb) >> 2) << 5) | (libaroma_color_b32(rgb) >> 3));
 }
 
 /* vector color functions */
-void libaroma_color_set(uint16_t *__restrict dst, uint16_t color, int n);
+void libaroma_color_set(libaroma_pixel *__restrict dst, libaroma_pixel color, int n);
 void libaroma_color_copy32(uint32_t *__restrict dst, uint16_t *__restrict src, int n, uint8_t *__restrict rgb_pos);
 void libaroma_color_copy16(uint16_t *dst, uint32_t *src, int n, uint8_t *rgb_pos);
 
 /* vector alpha blend */
-void libaroma_alpha_const(int n, uint16_t *__restrict dst, uint16_t *__restrict bottom, uint16_t *__restrict top, uint8_t alpha);
-void libaroma_alpha_const_line(int _Y, int n, uint16_t *__restrict dst, uint16_t *__restrict bottom, uint16_t *__restrict top, uint8_t alpha);
-void libaroma_alpha_rgba_fill(int n, uint16_t *__restrict dst, uint16_t *__restrict bottom, uint16_t top, uint8_t alpha);
+void libaroma_alpha_const(int n, libaroma_pixel *__restrict dst, libaroma_pixel *__restrict bottom, libaroma_pixel *__restrict top, uint8_t alpha);
+void libaroma_alpha_const_line(int _Y, int n, libaroma_pixel *__restrict dst, libaroma_pixel *__restrict bottom, libaroma_pixel *__restrict top, uint8_t alpha);
+void libaroma_alpha_rgba_fill(int n, libaroma_pixel *__restrict dst, libaroma_pixel *__restrict bottom, libaroma_pixel top, uint8_t alpha);
 
 /* vector blitting */
 void libaroma_blt_align16(uint16_t *__restrict dst, uint16_t *__restrict src, int w, int h, int dst_stride, int src_stride);
@@ -99,13 +124,19 @@ void libaroma_blt_align16_to32(uint32_t *__restrict dst, uint16_t *__restrict sr
 void libaroma_blt_align_to32_pos(uint32_t *__restrict dst, uint16_t *__restrict src, int w, int h, int dst_stride, int src_stride, uint8_t *rgb_pos);
 void libaroma_blt_align_to16_pos(uint16_t *__restrict dst, uint32_t *__restrict src, int w, int h, int dst_stride, int src_stride, uint8_t *__restrict rgb_pos);
 
+/* canvas <-> framebuffer blitting, rgb_pos NULL = XRGB */
+void libaroma_blt_to16(uint16_t *__restrict dst, libaroma_pixel *__restrict src, int w, int h, int dst_stride, int src_stride);
+void libaroma_blt_to32(uint32_t *__restrict dst, libaroma_pixel *__restrict src, int w, int h, int dst_stride, int src_stride, uint8_t *rgb_pos);
+void libaroma_blt_from16(libaroma_pixel *__restrict dst, uint16_t *__restrict src, int w, int h, int dst_stride, int src_stride);
+void libaroma_blt_from32(libaroma_pixel *__restrict dst, uint32_t *__restrict src, int w, int h, int dst_stride, int src_stride, uint8_t *rgb_pos);
+
 /* scalar color functions */
-uint16_t libaroma_rgb_from_string(const char * c);
-uint32_t libaroma_rgb_to32(uint16_t rgb);
+libaroma_pixel libaroma_rgb_from_string(const char * c);
+uint32_t libaroma_rgb_to32(libaroma_pixel rgb);
 
 /* scalar alpha blend */
-uint16_t libaroma_alpha(uint16_t dcl, uint16_t scl, uint8_t l);
-uint32_t libaroma_alpha32(uint16_t dcl, uint16_t scl, uint8_t l);
-uint16_t libaroma_alphab(uint16_t scl, uint8_t l);
+libaroma_pixel libaroma_alpha(libaroma_pixel dcl, libaroma_pixel scl, uint8_t l);
+uint32_t libaroma_alpha32(libaroma_pixel dcl, libaroma_pixel scl, uint8_t l);
+libaroma_pixel libaroma_alphab(libaroma_pixel scl, uint8_t l);
 
 #endif /* __aroma_engine_h__ */
@@ -102,6 +102,21 @@ int libaroma_fb_snapshoot() {
 }
 
 int libaroma_fb_driver_init(LIBAROMA_FBP me) {
+    /* headless memory driver, for benchmark & replay */
+#ifndef _AROMA_HOST
+    if (getenv("AROMA_HEADLESS") != NULL)
+#endif
+    {
+        if (memfb_init(me)) {
+            LOGS("using headless memory framebuffer driver");
+            return 1;
+        }
+#ifdef _AROMA_HOST
+        return 0;
+#endif
+    }
+
+#ifndef _AROMA_HOST
     /* try drm driver */
     if (drm_init(me)) {
         LOGS("using drm framebuffer driver");
@@ -118,6 +133,7 @@ int libaroma_fb_driver_init(LIBAROMA_FBP me) {
     if (fbdev_init(me)) {
         LOGS("using fbdev framebuffer driver");
     }
+#endif
 
     return 1;
 }
@@ -172,8 +188,8 @@ LIBAROMA_FBP libaroma_fb_init() {
 
     /* create framebuffer canvas */
     if (!_libaroma_fb->canvas) {
-        _libaroma_fb->canvas = (uint16_t *) malloc(_libaroma_fb->sz*2);
-        memset(_libaroma_fb->canvas,0,_libaroma_fb->sz*2);
+        _libaroma_fb->canvas = (libaroma_pixel *) malloc(_libaroma_fb->sz*sizeof(libaroma_pixel));
+        memset(_libaroma_fb->canvas,0,_libaroma_fb->sz*sizeof(libaroma_pixel));
     }
 
     /* Show Information */
@@ -221,7 +237,7 @@ int libaroma_fb_end_post() {
 }
 
 int libaroma_fb_post(
-    uint16_t *canvas,
+    libaroma_pixel *canvas,
     int dx, int dy,
     int sx, int sy,
     int w, int h
@@ -293,11 +309,13 @@ int libaroma_fb_release() {
 }
 
 int libaroma_fb_sync() {
+    ATRACE_SCOPE("libaroma_fb_sync");
     if (_libaroma_fb == NULL) {
         LOGW("libaroma_fb_sync framebuffer uninitialized");
         return 0;
     }
 
+    long long t0 = areplay_active() ? areplay_us() : 0;
     int ret=0;
     if (libaroma_fb_start_post()) {
         if (_libaroma_fb->post(_libaroma_fb, _libaroma_fb->canvas, 0, 0, _libaroma_fb->w, _libaroma_fb->h, 0, 0, _libaroma_fb->w, _libaroma_fb->h)) {
@@ -305,6 +323,29 @@ int libaroma_fb_sync() {
         }
         libaroma_fb_end_post();
     }
+    if (t0) {
+        areplay_frame(t0);
+    }
+    return ret;
+}
+
+int libaroma_fb_sync_area(int x, int y, int w, int h) {
+    if (_libaroma_fb == NULL) {
+        LOGW("libaroma_fb_sync_area framebuffer uninitialized");
+        return 0;
+    }
+
+    long long t0 = areplay_active() ? areplay_us() : 0;
+    int ret=0;
+    if (libaroma_fb_start_post()) {
+        if (libaroma_fb_post(_libaroma_fb->canvas, x, y, x, y, w, h)) {
+            ret = 1;
+        }
+        libaroma_fb_end_post();
+    }
+    if (t0) {
+        areplay_frame(t0);
+    }
     return ret;
 }
 
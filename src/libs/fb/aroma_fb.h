@@ -79,11 +79,11 @@ struct _LIBAROMA_FB{
 
     /* callbacks */
     void (*release)(LIBAROMA_FBP);
-    int (*snapshoot)(LIBAROMA_FBP, uint16_t *);
+    int (*snapshoot)(LIBAROMA_FBP, libaroma_pixel *);
 
     /* post callbacks */
     int (*start_post)(LIBAROMA_FBP);
-    int (*post)(LIBAROMA_FBP, uint16_t *__restrict, int, int, int, int, int, int, int, int);
+    int (*post)(LIBAROMA_FBP, libaroma_pixel *__restrict, int, int, int, int, int, int, int, int);
     int (*end_post)(LIBAROMA_FBP);
 
     /* rgb setting callback */
@@ -97,7 +97,7 @@ struct _LIBAROMA_FB{
     uint8_t		onpost;
 
     /* AROMA CORE Runtime Data */
-    uint16_t		*canvas;
+    libaroma_pixel	*canvas;
 };
 
 typedef struct GRSurface {
@@ -157,6 +157,10 @@ int libaroma_fb_release();
 
 int libaroma_fb_sync();
 
+int libaroma_fb_sync_area(int x, int y, int w, int h);
+
+void libaroma_fb_setrgb(uint8_t r, uint8_t g, uint8_t b);
+
 void libaroma_fb_changecolorspace(LIBAROMA_FBP me, uint8_t r, uint8_t g, uint8_t b);
 
 void fbdev_set_dpi(LIBAROMA_FBP me);
@@ -167,4 +171,12 @@ int overlay_init(LIBAROMA_FBP me);
 
 int fbdev_init(LIBAROMA_FBP me);
 
+int memfb_init(LIBAROMA_FBP me);
+
+dword memfb_frames();
+
+dword memfb_posts();
+
+libaroma_pixel *memfb_buffer();
+
 #endif /* __aroma_fb_h__ */
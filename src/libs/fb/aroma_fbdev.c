@@ -27,6 +27,7 @@
  */
 
 #include <stdbool.h>
+#include <limits.h>
 #include <sys/mman.h>
 #include "aroma_fb.h"
 
@@ -40,6 +41,49 @@ static struct fb_fix_screeninfo fi;
 static int fb_fd = -1;
 static __u32 smem_len;
 
+/* damage rects as x1,y1,x2,y2 (exclusive) */
+static int damage[4];
+static int prev_damage[4];
+static libaroma_pixel *damage_src = NULL;
+static int full_flips = 0;
+
+static void fbdev_damage_reset(int *d)
+{
+    d[0] = d[1] = INT_MAX;
+    d[2] = d[3] = 0;
+}
+
+static void fbdev_damage_add(int *d, int x, int y, int w, int h)
+{
+    if (x < d[0]) d[0] = x;
+    if (y < d[1]) d[1] = y;
+    if (x + w > d[2]) d[2] = x + w;
+    if (y + h > d[3]) d[3] = y + h;
+}
+
+static void fbdev_convert(
+    LIBAROMA_FBP me, libaroma_pixel *__restrict src,
+    int dx, int dy, int dw, int dh,
+    int sx, int sy, int sw
+    ) {
+    LINUXFBDR_INTERNALP mi = (LINUXFBDR_INTERNALP) me->internal;
+    int sstride = (sw - dw) * sizeof(libaroma_pixel);
+    int dstride = (mi->line - (dw * mi->pixsz));
+    uint8_t *copy_dst = ((uint8_t *) mi->buffer)+(mi->line * dy)+(dx * mi->pixsz);
+    libaroma_pixel *copy_src = src + (sw * sy) + sx;
+    if (mi->pixsz == 2) {
+        libaroma_blt_to16((uint16_t *) copy_dst, copy_src, dw, dh, dstride, sstride);
+    } else {
+        libaroma_blt_to32((uint32_t *) copy_dst, copy_src, dw, dh, dstride, sstride, mi->rgb_pos);
+    }
+}
+
+static uint8_t *fbdev_front(void)
+{
+    return double_buffered ?
+        gr_framebuffer[displayed_buffer].data : gr_draw->data;
+}
+
 static void set_displayed_framebuffer(unsigned n)
 {
     if (n > 1 || !double_buffered) return;
@@ -63,29 +107,34 @@ int fbdev_flush(LIBAROMA_FBP me) {
     }
     LINUXFBDR_INTERNALP mi = (LINUXFBDR_INTERNALP) me->internal;
 
-    if (vi.red.offset == 8 || vi.red.offset == 16) {
-        // In case of BGRA, do some byte swapping
-        unsigned char* ucfb_vaddr = (unsigned char*)gr_draw->data;
-        int idx;
-        for (idx = 0 ; idx < (gr_draw->height * gr_draw->row_bytes);
-                idx += 4) {
-            unsigned char tmp = ucfb_vaddr[idx];
-            ucfb_vaddr[idx    ] = ucfb_vaddr[idx + 2];
-            ucfb_vaddr[idx + 2] = tmp;
-        }
+    /* nothing posted, keep current buffer */
+    if (damage[2] <= damage[0] || damage[3] <= damage[1]) {
+        return 1;
     }
+
     if (double_buffered) {
-        // Copy from the in-memory surface to the framebuffer.
-        memcpy(gr_framebuffer[1-displayed_buffer].data, gr_draw->data,
-               gr_draw->height * gr_draw->row_bytes);
+        // The back buffer still holds the frame before last, so the
+        // previous frame's damage has to be brought up to date as well.
+        int full[4] = { 0, 0, me->w, me->h };
+        int *p = (full_flips > 0) ? full : prev_damage;
+        if (full_flips > 0) full_flips--;
+        if ((p[2] > p[0]) && (p[3] > p[1]) && (damage_src != NULL) &&
+            ((p[0] < damage[0]) || (p[1] < damage[1]) ||
+             (p[2] > damage[2]) || (p[3] > damage[3]))) {
+            fbdev_convert(me, damage_src, p[0], p[1], p[2] - p[0], p[3] - p[1],
+                p[0], p[1], me->w);
+        }
         set_displayed_framebuffer(1-displayed_buffer);
+        mi->buffer = gr_framebuffer[1-displayed_buffer].data;
+        memcpy(prev_damage, damage, sizeof(damage));
     } else {
-        // Copy from the in-memory surface to the framebuffer.
-        memcpy(gr_framebuffer[0].data, gr_draw->data,
-               gr_draw->height * gr_draw->row_bytes);
+        // Copy damaged rows from the in-memory surface to the framebuffer.
+        memcpy(gr_framebuffer[0].data + damage[1] * gr_draw->row_bytes,
+               gr_draw->data + damage[1] * gr_draw->row_bytes,
+               (damage[3] - damage[1]) * gr_draw->row_bytes);
     }
 
-    mi->buffer = gr_draw->data;
+    fbdev_damage_reset(damage);
 
     return 1;
 }
@@ -127,32 +176,49 @@ int fbdev_end_post(LIBAROMA_FBP me) {
     return 1;
 }
 
-int fbdev_post_32bit(
-    LIBAROMA_FBP me, uint16_t *__restrict src,
+int fbdev_post(
+    LIBAROMA_FBP me, libaroma_pixel *__restrict src,
     int dx, int dy, int dw, int dh,
     int sx, int sy, int sw, __unused int sh
     ) {
     if (me == NULL) {
         return 0;
     }
-    LINUXFBDR_INTERNALP mi = (LINUXFBDR_INTERNALP) me->internal;
-    int sstride = (sw - dw) * 2;
-    int dstride = (mi->line - (dw * mi->pixsz));
-    uint32_t *copy_dst = (uint32_t *) (((uint8_t *) mi->buffer)+(mi->line * dy)+(dx * mi->pixsz));
-    uint16_t *copy_src = (uint16_t *) (src + (sw * sy) + sx);
-    libaroma_blt_align_to32_pos(copy_dst, copy_src, dw, dh, dstride, sstride, mi->rgb_pos);
+    fbdev_convert(me, src, dx, dy, dw, dh, sx, sy, sw);
+    fbdev_damage_add(damage, dx, dy, dw, dh);
+    damage_src = src;
     return 1;
 }
 
-int fbdev_snapshoot_32bit(LIBAROMA_FBP me, uint16_t *dst) {
+int fbdev_snapshoot_32bit(LIBAROMA_FBP me, libaroma_pixel *dst) {
     if (me == NULL) {
         return 0;
     }
     LINUXFBDR_INTERNALP mi = (LINUXFBDR_INTERNALP) me->internal;
-    libaroma_blt_align_to16_pos(dst, (uint32_t *) mi->buffer, me->w, me->h, 0, mi->stride, mi->rgb_pos);
+    libaroma_blt_from32(dst, (uint32_t *) fbdev_front(), me->w, me->h, 0, mi->stride, mi->rgb_pos);
     return 1;
 }
 
+static uint8_t fbdev_bgra_pos(uint8_t pos) {
+    if (pos == 0) {
+        return 16;
+    } else if (pos == 16) {
+        return 0;
+    }
+    return pos;
+}
+
+void fbdev_setrgb(LIBAROMA_FBP me, uint8_t r, uint8_t g, uint8_t b) {
+    if (vi.red.offset == 8 || vi.red.offset == 16) {
+        /* In case of BGRA, swap bytes 0 and 2 in the positions, so the
+           conversion writes final byte order */
+        r = fbdev_bgra_pos(r);
+        g = fbdev_bgra_pos(g);
+        b = fbdev_bgra_pos(b);
+    }
+    libaroma_fb_changecolorspace(me, r, g, b);
+}
+
 void fbdev_init_32bit(LIBAROMA_FBP me) {
     if (me == NULL) {
         return;
@@ -165,41 +231,24 @@ void fbdev_init_32bit(LIBAROMA_FBP me) {
 
     /* gralloc framebuffer subpixel position style */
     if (vi.red.offset==8) {
-        libaroma_fb_changecolorspace(me,16,8,0);
+        fbdev_setrgb(me,16,8,0);
     } else {
-        libaroma_fb_changecolorspace(me,0,8,16);
+        fbdev_setrgb(me,0,8,16);
     }
 
     /* set fbdev sync callbacks */
     me->start_post = &fbdev_start_post;
     me->end_post = &fbdev_end_post;
-    me->post = &fbdev_post_32bit;
+    me->post = &fbdev_post;
     me->snapshoot = &fbdev_snapshoot_32bit;
 }
 
-int fbdev_post_16bit(
-    LIBAROMA_FBP me, uint16_t *__restrict src,
-    int dx, int dy, int dw, int dh,
-    int sx, int sy, int sw, __unused int sh
-    ) {
+int fbdev_snapshoot_16bit(LIBAROMA_FBP me, libaroma_pixel *dst) {
     if (me == NULL) {
         return 0;
     }
     LINUXFBDR_INTERNALP mi = (LINUXFBDR_INTERNALP) me->internal;
-    int sstride = (sw - dw) * 2;
-    int dstride = (mi->line - (dw * mi->pixsz));
-    uint16_t *copy_dst = (uint16_t *) (((uint8_t *) mi->buffer)+(mi->line * dy)+(dx * mi->pixsz));
-    uint16_t *copy_src = (uint16_t *) (src + (sw * sy) + sx);
-    libaroma_blt_align16(copy_dst, copy_src, dw, dh, dstride, sstride);
-    return 1;
-}
-
-int fbdev_snapshoot_16bit(LIBAROMA_FBP me, uint16_t *dst) {
-    if (me == NULL) {
-        return 0;
-    }
-    LINUXFBDR_INTERNALP mi = (LINUXFBDR_INTERNALP) me->internal;
-    libaroma_blt_align16(dst, (uint16_t *) mi->buffer, me->w, me->h, 0, mi->stride);
+    libaroma_blt_from16(dst, (uint16_t *) fbdev_front(), me->w, me->h, 0, mi->stride);
     return 1;
 }
 
@@ -221,7 +270,7 @@ void fbdev_init_16bit(LIBAROMA_FBP me) {
     /* set fbdev sync callbacks */
     me->start_post = &fbdev_start_post;
     me->end_post = &fbdev_end_post;
-    me->post = &fbdev_post_16bit;
+    me->post = &fbdev_post;
     me->snapshoot = &fbdev_snapshoot_16bit;
 }
 
@@ -279,12 +328,8 @@ void fbdev_release(LIBAROMA_FBP me) {
         return;
     }
 
-    /* unmap */
-    if (mi->buffer != NULL) {
-        LOGI("fbdev munmap buffer");
-        munmap(mi->buffer, fi.smem_len);
-        mi->buffer = NULL;
-    }
+    /* buffer points into gr_draw or the mapping, both released below */
+    mi->buffer = NULL;
 
     /* close fb */
     if (fb_fd >= 0) {
@@ -331,20 +376,16 @@ int fbdev_init(LIBAROMA_FBP me) {
     /* init mutex & cond */
     libaroma_mutex_init(mi->mutex);
 
-    int retry = 20;
-    int fd = -1;
-    while (fd == -1) {
-        fd = open("/dev/graphics/fb0", O_RDWR);
-        if (fd == -1) {
-            if (--retry) {
-                // wait for init to create the device node
-                LOGW("cannot open fb0 (retrying)");
-                usleep(100000);
-            } else {
-                LOGE("cannot open fb0 (giving up)");
-                goto error;
-            }
-        }
+    /* wait for init to create the device node, returns as soon as it exists */
+    if (!alib_waitpath("/dev/graphics/fb0", 2000)) {
+        LOGE("fb0 device node not created (giving up)");
+        goto error;
+    }
+
+    int fd = open("/dev/graphics/fb0", O_RDWR);
+    if (fd == -1) {
+        LOGE("cannot open fb0");
+        goto error;
     }
 
     if (ioctl(fd, FBIOGET_VSCREENINFO, &vi) < 0) {
@@ -435,26 +476,6 @@ int fbdev_init(LIBAROMA_FBP me) {
         }
     }
 
-    // Drawing directly to the framebuffer takes about 5 times longer.
-    // Instead, we will allocate some memory and draw to that, then
-    // memcpy the data into the framebuffer later.
-    gr_draw = (GRSurface*) malloc(sizeof(GRSurface));
-    if (!gr_draw) {
-        LOGE("failed to allocate gr_draw");
-        close(fd);
-        munmap(bits, fi.smem_len);
-        goto error;
-    }
-    memcpy(gr_draw, gr_framebuffer, sizeof(GRSurface));
-    gr_draw->data = (unsigned char*) calloc(gr_draw->height * gr_draw->row_bytes, 1);
-    if (!gr_draw->data) {
-        LOGE("failed to allocate in-memory surface");
-        close(fd);
-        free(gr_draw);
-        munmap(bits, fi.smem_len);
-        goto error;
-    }
-
     /* check if we can use double buffering */
     if (vi.yres * fi.line_length * 2 <= fi.smem_len) {
         double_buffered = true;
@@ -465,20 +486,48 @@ int fbdev_init(LIBAROMA_FBP me) {
         gr_framebuffer[1].data = gr_framebuffer[0].data +
             gr_framebuffer[0].height * gr_framebuffer[0].row_bytes;
 
+        // Posts are converted straight into the off-screen half,
+        // then it get panned in.
+        mi->buffer = gr_framebuffer[1].data;
     } else {
         double_buffered = false;
         me->double_buffer = 0;
         LOGI("single buffered");
+
+        // Drawing directly to the framebuffer takes about 5 times longer.
+        // Instead, we will allocate some memory and draw to that, then
+        // memcpy the damaged rows into the framebuffer later.
+        gr_draw = (GRSurface*) malloc(sizeof(GRSurface));
+        if (!gr_draw) {
+            LOGE("failed to allocate gr_draw");
+            close(fd);
+            munmap(bits, fi.smem_len);
+            goto error;
+        }
+        memcpy(gr_draw, gr_framebuffer, sizeof(GRSurface));
+        gr_draw->data = (unsigned char*) calloc(gr_draw->height * gr_draw->row_bytes, 1);
+        if (!gr_draw->data) {
+            LOGE("failed to allocate in-memory surface");
+            close(fd);
+            free(gr_draw);
+            gr_draw = NULL;
+            munmap(bits, fi.smem_len);
+            goto error;
+        }
+        mi->buffer = gr_draw->data;
     }
     fb_fd = fd;
     set_displayed_framebuffer(0);
 
-    LOGI("framebuffer: %d (%d x %d)", fb_fd, gr_draw->width, gr_draw->height);
+    LOGI("framebuffer: %d (%d x %d)", fb_fd, gr_framebuffer[0].width, gr_framebuffer[0].height);
 
     smem_len = fi.smem_len;
 
-    /* swap buffer now */
-    fbdev_flush(me);
+    /* both halves start blank, first flips must fill them entirely */
+    fbdev_damage_reset(damage);
+    fbdev_damage_reset(prev_damage);
+    damage_src = NULL;
+    full_flips = 2;
 
     if (mi->pixsz == 2) {
         /* init colorspace */
@@ -489,7 +538,7 @@ int fbdev_init(LIBAROMA_FBP me) {
     }
 
     /* set config */
-    me->setrgb = &libaroma_fb_changecolorspace;
+    me->setrgb = &fbdev_setrgb;
 
     /* set dpi */
     fbdev_set_dpi(me);
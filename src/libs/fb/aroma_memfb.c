@@ -0,0 +1,155 @@
+/********************************************************************[libaroma]*
+ * Copyright (C) 2011-2015 Ahmad Amarullah (http://amarullz.com/)
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *______________________________________________________________________________
+ *
+ * File: aroma_memfb.c
+ * Description: headless framebuffer driver.
+ *
+ * Plain memory display for benchmarks and replay, no device needed.
+ * Enabled by AROMA_HEADLESS="WxH" (or "WxH@dpi"), every flushed frame
+ * is also written as BMP when AROMA_HEADLESS_DUMP names a directory.
+ *
+ */
+
+#include "aroma_fb.h"
+
+#define MEMFB_DEFAULT_W     480
+#define MEMFB_DEFAULT_H     800
+
+typedef struct {
+    libaroma_pixel *buffer;         /* displayed pixels */
+    dword       frames;             /* flushed frames */
+    dword       posts;              /* post calls */
+    char        *dumpdir;           /* BMP dump directory or NULL */
+} MEMFB_INTERNAL, *MEMFB_INTERNALP;
+
+static MEMFB_INTERNALP memfb_active = NULL;
+
+void memfb_release(LIBAROMA_FBP me) {
+    if (me == NULL) {
+        return;
+    }
+    MEMFB_INTERNALP mi = (MEMFB_INTERNALP) me->internal;
+    if (mi == NULL) {
+        return;
+    }
+    memfb_active = NULL;
+    free(mi->buffer);
+    if (mi->dumpdir != NULL) {
+        free(mi->dumpdir);
+    }
+    free(mi);
+    me->internal = NULL;
+}
+
+int memfb_start_post(LIBAROMA_FBP me) {
+    return (me != NULL);
+}
+
+int memfb_post(
+    LIBAROMA_FBP me, libaroma_pixel *__restrict src,
+    int dx, int dy, int dw, int dh,
+    int sx, int sy, int sw, __unused int sh
+    ) {
+    if (me == NULL) {
+        return 0;
+    }
+    MEMFB_INTERNALP mi = (MEMFB_INTERNALP) me->internal;
+    int y;
+    for (y = 0; y < dh; y++) {
+        memcpy(mi->buffer + (dy + y) * me->w + dx, src + (sy + y) * sw + sx, dw * sizeof(libaroma_pixel));
+    }
+    mi->posts++;
+    return 1;
+}
+
+int memfb_end_post(LIBAROMA_FBP me) {
+    if (me == NULL) {
+        return 0;
+    }
+    MEMFB_INTERNALP mi = (MEMFB_INTERNALP) me->internal;
+    mi->frames++;
+    if (mi->dumpdir != NULL) {
+        char path[256];
+        snprintf(path, 256, "%s/frame-%05u.bmp", mi->dumpdir, mi->frames);
+        ag_savebmp(path, mi->buffer, me->w, me->h);
+    }
+    return 1;
+}
+
+int memfb_snapshoot(LIBAROMA_FBP me, libaroma_pixel *dst) {
+    if (me == NULL) {
+        return 0;
+    }
+    MEMFB_INTERNALP mi = (MEMFB_INTERNALP) me->internal;
+    memcpy(dst, mi->buffer, me->sz * sizeof(libaroma_pixel));
+    return 1;
+}
+
+int memfb_init(LIBAROMA_FBP me) {
+    int w = MEMFB_DEFAULT_W;
+    int h = MEMFB_DEFAULT_H;
+    int dpi = 0;
+    char *cfg = getenv("AROMA_HEADLESS");
+    if (cfg != NULL) {
+        sscanf(cfg, "%dx%d@%d", &w, &h, &dpi);
+    }
+    if ((w < 1) || (h < 1)) {
+        LOGE("memfb invalid size %s", cfg);
+        return 0;
+    }
+
+    MEMFB_INTERNALP mi = (MEMFB_INTERNALP) calloc(sizeof(MEMFB_INTERNAL), 1);
+    if (!mi) {
+        LOGE("allocating memfb internal data - memory error");
+        return 0;
+    }
+    mi->buffer = (libaroma_pixel *) calloc(w * h, sizeof(libaroma_pixel));
+    if (!mi->buffer) {
+        LOGE("allocating memfb buffer - memory error");
+        free(mi);
+        return 0;
+    }
+    char *dump = getenv("AROMA_HEADLESS_DUMP");
+    if ((dump != NULL) && (dump[0] != 0)) {
+        mi->dumpdir = strdup(dump);
+    }
+
+    me->internal      = (void *) mi;
+    me->w             = w;
+    me->h             = h;
+    me->sz            = w * h;
+    me->dpi           = dpi;
+    me->double_buffer = 0;
+    me->release       = &memfb_release;
+    me->snapshoot     = &memfb_snapshoot;
+    me->start_post    = &memfb_start_post;
+    me->post          = &memfb_post;
+    me->end_post      = &memfb_end_post;
+    memfb_active      = mi;
+    LOGS("memfb headless display %ix%i", w, h);
+    return 1;
+}
+
+/* counters for benchmarks */
+dword memfb_frames() {
+    return (memfb_active != NULL) ? memfb_active->frames : 0;
+}
+dword memfb_posts() {
+    return (memfb_active != NULL) ? memfb_active->posts : 0;
+}
+libaroma_pixel *memfb_buffer() {
+    return (memfb_active != NULL) ? memfb_active->buffer : NULL;
+}
@@ -510,7 +510,7 @@ int overlay_end_post(LIBAROMA_FBP me) {
 }
 
 int overlay_post_32bit(
-    LIBAROMA_FBP me, uint16_t *__restrict src,
+    LIBAROMA_FBP me, libaroma_pixel *__restrict src,
     int dx, int dy, int dw, int dh,
     int sx, int sy, int sw, __unused int sh
     ) {
@@ -518,11 +518,11 @@ int overlay_post_32bit(
         return 0;
     }
     LINUXFBDR_INTERNALP mi = (LINUXFBDR_INTERNALP) me->internal;
-    int sstride = (sw - dw) * 2;
+    int sstride = (sw - dw) * sizeof(libaroma_pixel);
     int dstride = (mi->line - (dw * mi->pixsz));
     uint32_t *copy_dst = (uint32_t *) (((uint8_t *) mi->buffer)+(mi->line * dy)+(dx * mi->pixsz));
-    uint16_t *copy_src = (uint16_t *) (src + (sw * sy) + sx);
-    libaroma_blt_align_to32_pos(copy_dst, copy_src, dw, dh, dstride, sstride, mi->rgb_pos);
+    libaroma_pixel *copy_src = src + (sw * sy) + sx;
+    libaroma_blt_to32(copy_dst, copy_src, dw, dh, dstride, sstride, mi->rgb_pos);
     return 1;
 }
 
@@ -551,7 +551,7 @@ void overlay_init_32bit(LIBAROMA_FBP me) {
 }
 
 int overlay_post_16bit(
-    LIBAROMA_FBP me, uint16_t *__restrict src,
+    LIBAROMA_FBP me, libaroma_pixel *__restrict src,
     int dx, int dy, int dw, int dh,
     int sx, int sy, int sw, __unused int sh
     ) {
@@ -559,11 +559,11 @@ int overlay_post_16bit(
         return 0;
     }
     LINUXFBDR_INTERNALP mi = (LINUXFBDR_INTERNALP) me->internal;
-    int sstride = (sw - dw) * 2;
+    int sstride = (sw - dw) * sizeof(libaroma_pixel);
     int dstride = (mi->line - (dw * mi->pixsz));
     uint16_t *copy_dst = (uint16_t *) (((uint8_t *) mi->buffer)+(mi->line * dy)+(dx * mi->pixsz));
-    uint16_t *copy_src = (uint16_t *) (src + (sw * sy) + sx);
-    libaroma_blt_align16(copy_dst, copy_src, dw, dh, dstride, sstride);
+    libaroma_pixel *copy_src = src + (sw * sy) + sx;
+    libaroma_blt_to16(copy_dst, copy_src, dw, dh, dstride, sstride);
     return 1;
 }
 
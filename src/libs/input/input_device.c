@@ -69,6 +69,7 @@ struct _AINPUT_EVENT_STRUCT {
   byte  state;                          /* Look at AINPUT_EV_STATE_ */
   int   x;                              /* Touch x coordinate */
   int   y;                              /* Touch y coordinate */
+  long  t;                              /* Kernel event time in ms (CLOCK_MONOTONIC) */
 };
 
 /* Input Event Type */
@@ -28,6 +28,9 @@
  *
  */
 #include <linux/input.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
 
 /*
  * Defines & Macros
@@ -35,6 +38,8 @@
  */
 #define INDR_DEVPATH                  "/dev/input"
 #define INDR_MAXDEV                   0xf
+#define INDR_EVBUF                    64      /* input_event per read() */
+#define INDR_EPOLL_HOTPLUG            0xffff  /* epoll data for inotify fd */
 #define INDR_SIZEOF_BIT_ARRAY(bits)   ((bits + 7) / 8)
 #define INDR_TEST_BIT(bit, array)     (array[bit/8] & (1<<(bit%8)))
 
@@ -102,6 +107,9 @@ typedef struct {
   int       vkn;             /* Virtual Key Count */
   INDR_VKP  vks;             /* Virtual Keys */
   INDR_POS  p;               /* ABS Position */
+  byte      monoclock;       /* Event time is CLOCK_MONOTONIC */
+  byte      tbase_set;       /* tbase taken from first event */
+  long long tbase;           /* Realtime event ms to aTick() ms */
 } INDR_DEVICE, *INDR_DEVICEP;
 
 /*
@@ -110,8 +118,21 @@ typedef struct {
  */
 typedef struct {
   int           n;                /* Devices Count */
-  struct pollfd fds[INDR_MAXDEV]; /* Devices Pool FD */
+  int           fds[INDR_MAXDEV]; /* Devices FD, -1 = free slot */
   INDR_DEVICE   dev[INDR_MAXDEV]; /* Devices Data */
+  int           epfd;             /* epoll FD */
+  int           inofd;            /* inotify FD for hotplug */
+  
+  /* Pending epoll Events */
+  struct epoll_event epev[INDR_MAXDEV + 1];
+  int           epev_n;
+  int           epev_pos;
+  
+  /* Batched Events of Current Device */
+  struct input_event evbuf[INDR_EVBUF];
+  int           evbuf_n;
+  int           evbuf_pos;
+  int           evbuf_dev;
   
   /* Configurations */
   byte          touch_swap_xy;    /* Swap X with Y */
@@ -156,6 +177,162 @@ void INDR_dumpdev(INDR_DEVICEP dev) {
       );
 }
 
+/*
+ * Function : Find Device Slot by Filename
+ *
+ */
+int INDR_findslot(INDR_INTERNALP mi, const char * name) {
+  int i;
+  
+  for (i = 0; i < INDR_MAXDEV; i++) {
+    if ((mi->fds[i] >= 0) && (strcmp(mi->dev[i].file, name) == 0)) {
+      return i;
+    }
+  }
+  
+  return -1;
+}
+
+/*
+ * Function : Open & Monitor Input Device
+ *
+ */
+byte INDR_add_device(INDR_INTERNALP mi, int dfd, const char * name) {
+  /* Continue if filename not contain "event" */
+  if (strncmp(name, "event", 5)) {
+    return 0;
+  }
+  
+  /* Already Monitored */
+  if (INDR_findslot(mi, name) >= 0) {
+    return 0;
+  }
+  
+  /* Find Free Slot */
+  int n;
+  
+  for (n = 0; n < INDR_MAXDEV; n++) {
+    if (mi->fds[n] < 0) {
+      break;
+    }
+  }
+  
+  if (n == INDR_MAXDEV) {
+    LOGW("INDR: Maximum device reached, ignoring %s", name);
+    return 0;
+  }
+  
+  /* Open File Handler */
+  int fd = openat(dfd, name, O_RDONLY | O_NONBLOCK);
+  
+  if (fd < 0) {
+    return 0;
+  }
+  
+  /* Cleanup Device Data */
+  memset(&mi->dev[n], 0, sizeof(INDR_DEVICE));
+  /* Set Device ID */
+  mi->dev[n].id = n;
+  /* Set Device Filename */
+  snprintf(mi->dev[n].file, 10, "%s", name);
+  
+  /* Load virtualkeys if there are any */
+  if (INDR_init_device(fd, &mi->dev[n])) {
+    /* Dump Device Information */
+    INDR_dumpdev(&mi->dev[n]);
+    /* Monitor it */
+    struct epoll_event epev;
+    memset(&epev, 0, sizeof(epev));
+    epev.events   = EPOLLIN;
+    epev.data.u32 = n;
+    
+    if (epoll_ctl(mi->epfd, EPOLL_CTL_ADD, fd, &epev) == 0) {
+      mi->fds[n] = fd;
+      mi->n++;
+      return 1;
+    }
+    
+    LOGW("INDR: epoll_ctl failed for %s", name);
+    
+    if (mi->dev[n].vkn) {
+      free(mi->dev[n].vks);
+    }
+  }
+  else {
+    /* Dump Device Information */
+    INDR_dumpdev(&mi->dev[n]);
+  }
+  
+  /* Don't Monitor This Device */
+  memset(&mi->dev[n], 0, sizeof(INDR_DEVICE));
+  close(fd);
+  return 0;
+}
+
+/*
+ * Function : Stop Monitoring Input Device
+ *
+ */
+void INDR_remove_device(INDR_INTERNALP mi, int n) {
+  if ((n < 0) || (n >= INDR_MAXDEV) || (mi->fds[n] < 0)) {
+    return;
+  }
+  
+  LOGI("INDR Input Device Removed: %s", mi->dev[n].file);
+  epoll_ctl(mi->epfd, EPOLL_CTL_DEL, mi->fds[n], NULL);
+  close(mi->fds[n]);
+  mi->fds[n] = -1;
+  
+  /* Release Virtual Keys */
+  if (mi->dev[n].vkn) {
+    free(mi->dev[n].vks);
+  }
+  
+  memset(&mi->dev[n], 0, sizeof(INDR_DEVICE));
+  mi->n--;
+  
+  /* Drop Batched Events */
+  if (mi->evbuf_dev == n) {
+    mi->evbuf_n   = 0;
+    mi->evbuf_pos = 0;
+  }
+}
+
+/*
+ * Function : Handle Hotplug Notifications
+ *
+ */
+void INDR_hotplug(INDR_INTERNALP mi) {
+  char buf[sizeof(struct inotify_event) + NAME_MAX + 1]
+  __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t len;
+  
+  while ((len = read(mi->inofd, buf, sizeof(buf))) > 0) {
+    char * p = buf;
+    
+    while (p < buf + len) {
+      struct inotify_event * ie = (struct inotify_event *) p;
+      
+      if (ie->len) {
+        if (ie->mask & (IN_CREATE | IN_ATTRIB)) {
+          /* Node may be created before its permission was set */
+          int dfd = open(INDR_DEVPATH, O_RDONLY | O_DIRECTORY);
+          
+          if (dfd >= 0) {
+            INDR_add_device(mi, dfd, ie->name);
+            close(dfd);
+          }
+        }
+        else if (ie->mask & IN_DELETE) {
+          INDR_remove_device(mi, INDR_findslot(mi, ie->name));
+        }
+      }
+      
+      p += sizeof(struct inotify_event) + ie->len;
+    }
+  }
+}
+
 /*
  * Function : Init Input Device
  *
@@ -165,58 +342,58 @@ byte INDR_init(AINPUTP me) {
   INDR_INTERNALP mi = (INDR_INTERNALP) malloc(sizeof(INDR_INTERNAL));
   /* Cleanup */
   memset(mi, 0, sizeof(INDR_INTERNAL));
-  /* Set Internal Address */
-  me->internal = (voidp) mi;
   /* Set Initial Value */
-  mi->n = 0;
+  mi->n         = 0;
+  mi->inofd     = -1;
+  mi->evbuf_dev = -1;
+  int i;
+  
+  for (i = 0; i < INDR_MAXDEV; i++) {
+    mi->fds[i] = -1;
+  }
+  
+  /* Create epoll Instance */
+  mi->epfd = epoll_create(INDR_MAXDEV + 1);
+  
+  if (mi->epfd < 0) {
+    free(mi);
+    LOGE("INDR ERROR: Can't create epoll instance...");
+    return 0;
+  }
+  
+  /* Watch /dev/input for late devices */
+  mi->inofd = inotify_init();
+  
+  if (mi->inofd >= 0) {
+    fcntl(mi->inofd, F_SETFL, O_NONBLOCK);
+    
+    if (inotify_add_watch(mi->inofd, INDR_DEVPATH,
+                          IN_CREATE | IN_DELETE | IN_ATTRIB) >= 0) {
+      struct epoll_event epev;
+      memset(&epev, 0, sizeof(epev));
+      epev.events   = EPOLLIN;
+      epev.data.u32 = INDR_EPOLL_HOTPLUG;
+      epoll_ctl(mi->epfd, EPOLL_CTL_ADD, mi->inofd, &epev);
+    }
+    else {
+      close(mi->inofd);
+      mi->inofd = -1;
+    }
+  }
+  
+  if (mi->inofd < 0) {
+    LOGW("INDR: inotify not available, input hotplug disabled");
+  }
+  
   /* Open Input Device Directory */
   DIR * dir = opendir(INDR_DEVPATH);
   
   if (dir != 0) {
     struct dirent * de; /* DIRENT */
-    int             fd; /* Temporary Device FD */
     
     /* Read Input Device Directory */
     while ((de = readdir(dir))) {
-      /* Continue if filename not contain "event" */
-      if (strncmp(de->d_name, "event", 5)) {
-        continue;
-      }
-      
-      /* Open File Handler */
-      fd = openat(dirfd(dir), de->d_name, O_RDONLY);
-      
-      /* Continue if openat failed */
-      if (fd < 0) {
-        continue;
-      }
-      
-      /* Cleanup Device Data */
-      memset(&mi->dev[mi->n], 0, sizeof(INDR_DEVICE));
-      /* Set Device ID */
-      mi->dev[mi->n].id     = mi->n;
-      /* Set Device Filename */
-      snprintf(mi->dev[mi->n].file, 10, "%s", de->d_name);
-      
-      /* Load virtualkeys if there are any */
-      if (INDR_init_device(fd, &mi->dev[mi->n])) {
-        /* Dump Device Information */
-        INDR_dumpdev(&mi->dev[mi->n]);
-        /* Set Pooling Data and Monitor it */
-        mi->fds[mi->n].fd     = fd;
-        mi->fds[mi->n].events = POLLIN;
-        /* Increment the polling count */
-        mi->n++;
-      }
-      else {
-        /* Dump Device Information */
-        INDR_dumpdev(&mi->dev[mi->n]);
-        /* Cleanup Device Data */
-        memset(&mi->dev[mi->n], 0, sizeof(INDR_DEVICE));
-        /* Don't Monitor This Device */
-        close(fd);
-        /* Ignore It */
-      }
+      INDR_add_device(mi, dirfd(dir), de->d_name);
       
       /* Break when maximum device */
       if (mi->n == INDR_MAXDEV) {
@@ -227,8 +404,9 @@ byte INDR_init(AINPUTP me) {
     /* Close Dir */
     closedir(dir);
     
-    /* Input Device Not Found */
-    if (mi->n == 0) {
+    /* Input Device Not Found, and none can come later */
+    if ((mi->n == 0) && (mi->inofd < 0)) {
+      close(mi->epfd);
       /* Free Internal Data */
       free(mi);
       LOGE("INDR ERROR: Input Device Not Found...");
@@ -236,6 +414,12 @@ byte INDR_init(AINPUTP me) {
       return 0;
     }
     
+    if (mi->n == 0) {
+      LOGW("INDR: No input device yet, waiting for hotplug");
+    }
+    
+    /* Set Internal Address */
+    me->internal = (voidp) mi;
     /* Set Driver Callbacks */
     me->cb_release    = &INDR_release;
     me->cb_getinput   = &INDR_getinput;
@@ -243,6 +427,11 @@ byte INDR_init(AINPUTP me) {
     return 1;
   }
   
+  if (mi->inofd >= 0) {
+    close(mi->inofd);
+  }
+  
+  close(mi->epfd);
   /* Free Internal Data */
   free(mi);
   LOGE("INDR ERROR: Can't access /dev/input...");
@@ -263,19 +452,18 @@ void INDR_release(AINPUTP me) {
   /* Get Internal Data */
   INDR_INTERNALP mi = (INDR_INTERNALP)
                       me->internal;
-                      
+  int n;
+  
   /* Release Devices Data */
-  while (mi->n-- > 0) {
-    /* Release Virtual Keys */
-    if (mi->dev[mi->n].vkn) {
-      free(mi->dev[mi->n].vks);
-      mi->dev[mi->n].vkn = 0;
-    }
-    
-    /* Close FD */
-    close(mi->fds[mi->n].fd);
+  for (n = 0; n < INDR_MAXDEV; n++) {
+    INDR_remove_device(mi, n);
   }
   
+  if (mi->inofd >= 0) {
+    close(mi->inofd);
+  }
+  
+  close(mi->epfd);
   /* Free Internal Data */
   free(me->internal);
   me->internal = NULL;
@@ -400,6 +588,18 @@ byte INDR_init_device(int fd, INDR_DEVICEP dev) {
   /* Get device class */
   dev->devclass = INDR_getdevclass(fd);
   
+  /* Event Time on Same Clock as aTick() */
+  dev->monoclock = 0;
+  dev->tbase_set = 0;
+#ifdef EVIOCSCLOCKID
+  int clk = CLOCK_MONOTONIC;
+  dev->monoclock = (ioctl(fd, EVIOCSCLOCKID, &clk) == 0);
+#endif
+  
+  if (!dev->monoclock) {
+    LOGW("INDR: %s event time is not monotonic", dev->name);
+  }
+  
   /* If Class is none, Ignore it */
   if (!dev->devclass) {
     return 0;
@@ -518,6 +718,26 @@ byte INDR_translate(AINPUTP me, INDR_DEVICEP dev,
   return AINPUT_EV_RET_NONE;
 }
 
+/*
+ * Function : Event Time in ms, on the aTick() clock
+ *
+ */
+long INDR_evtime(INDR_DEVICEP dev, struct input_event * ev) {
+  long long t = (long long) ev->time.tv_sec * 1000 + ev->time.tv_usec / 1000;
+  
+  /* Realtime stamps keep their spacing, anchored to aTick() at first event */
+  if (!dev->monoclock) {
+    if (!dev->tbase_set) {
+      dev->tbase     = (long long) aTick() - t;
+      dev->tbase_set = 1;
+    }
+    
+    t += dev->tbase;
+  }
+  
+  return (long) t;
+}
+
 /*
  * Function : Get Input
  *
@@ -529,35 +749,68 @@ byte INDR_getinput(AINPUTP me, AINPUT_EVENTP dest_ev) {
                       
   /* Polling Loop */
   do {
-    int r = poll(mi->fds, mi->n, -1);
-    
-    if (me->internal == NULL) {
-      /* If Released */
-      break;
+    /* Translate batched events until a frame is complete */
+    while (mi->evbuf_pos < mi->evbuf_n) {
+      struct input_event * ev = &mi->evbuf[mi->evbuf_pos++];
+      byte translate_ret = INDR_translate(me, &mi->dev[mi->evbuf_dev], dest_ev, ev);
+      
+      /* Check */
+      if (translate_ret != AINPUT_EV_RET_NONE) {
+        /* Keep Kernel Event Time */
+        dest_ev->t = INDR_evtime(&mi->dev[mi->evbuf_dev], ev);
+        return translate_ret;
+      }
     }
-    else if (r > 0) {
-      /* Events Loop */
-      int n;
+    
+    /* Next ready fd from last epoll_wait */
+    if (mi->epev_pos < mi->epev_n) {
+      struct epoll_event * epev = &mi->epev[mi->epev_pos++];
       
-      for (n = 0; n < mi->n; n++) {
-        if (mi->fds[n].revents & POLLIN) {
-          /* Read Data */
-          struct input_event ev;
-          r = read(mi->fds[n].fd, &ev, sizeof(ev));
-          
-          if (r == sizeof(ev)) {
-            /* Translate It */
-            byte translate_ret = INDR_translate(me, &mi->dev[n], dest_ev, &ev);
-            
-            /* Check */
-            if (translate_ret != AINPUT_EV_RET_NONE) {
-              /* Don't Process It */
-              return translate_ret;
-            }
-          }
+      if (epev->data.u32 == INDR_EPOLL_HOTPLUG) {
+        INDR_hotplug(mi);
+        continue;
+      }
+      
+      int n = epev->data.u32;
+      
+      if (mi->fds[n] < 0) {
+        continue;
+      }
+      
+      if (epev->events & (EPOLLERR | EPOLLHUP)) {
+        INDR_remove_device(mi, n);
+        continue;
+      }
+      
+      /* Read whole batch of events at once */
+      ssize_t r = read(mi->fds[n], mi->evbuf, sizeof(mi->evbuf));
+      
+      if (r > 0) {
+        mi->evbuf_n   = r / sizeof(struct input_event);
+        mi->evbuf_pos = 0;
+        mi->evbuf_dev = n;
+        
+        /* More frames may still wait in the kernel buffer */
+        if (mi->evbuf_n == INDR_EVBUF) {
+          mi->epev_pos--;
         }
       }
+      else if ((r == 0) || (errno == ENODEV)) {
+        INDR_remove_device(mi, n);
+      }
+      
+      continue;
     }
+    
+    int r = epoll_wait(mi->epfd, mi->epev, INDR_MAXDEV + 1, -1);
+    
+    if (me->internal == NULL) {
+      /* If Released */
+      break;
+    }
+    
+    mi->epev_n   = (r > 0) ? r : 0;
+    mi->epev_pos = 0;
   }
   while (me->internal != NULL);
   
@@ -22,6 +22,7 @@
  */
 #include <sys/reboot.h>
 #include <sys/syscall.h>
+#include <sys/ioctl.h>
 #include <aroma.h>
 
 //*
@@ -98,16 +99,100 @@ void a_splash(char * spipe) {
           "ui_print\n"
           "ui_print\n"
          );
-  usleep(600000);
+}
+
+//*
+//* Startup Tasks
+//*
+#define AROMA_STARTUP_THREADS   4
+#define AROMA_SPLASH_TIMEOUT    600
+
+//-- Wait until recovery consumed the splash, then mute it
+static byte a_task_splash(void * arg) {
+  long end = aTick() + AROMA_SPLASH_TIMEOUT;
+  int  n   = 0;
+  
+  while ((ioctl(fileno(acmd_pipe), FIONREAD, &n) == 0) && (n > 0) && (aTick() < end)) {
+    usleep(5000);
+  }
+  
+  if (parent_pid) {
+    LOGS("Mute Parent");
+    aroma_memory_parentpid(parent_pid);
+    kill(parent_pid, 19);
+  }
+  
+  return 1;
+}
+static byte a_task_zip(void * arg) {
+  return (az_init((char *) arg) == 1);
+}
+static byte a_task_graph(void * arg) {
+  return ag_init();
+}
+static byte a_task_input(void * arg) {
+  ui_init();
+  return 1;
+}
+static byte a_task_config(void * arg) {
+  if (!aui_prepare()) {
+    LOGE("Cannot Read " AROMA_CFG);
+  }
+  
+  return 1;
+}
+static byte a_task_freetype(void * arg) {
+  if (!aft_open()) {
+    LOGW("Cannot Open Freetype, png fonts only");
+  }
+  
+  return 1;
+}
+//-- Fallback fonts, decoded before the script picks its own
+static byte a_task_fonts(void * arg) {
+  ag_loadsmallfont("fonts/small", 0, NULL);
+  ag_loadbigfont("fonts/big", 0, NULL);
+  return 1;
 }
 
 //*
 //* Init All Resources
 //*
-void a_init_all() {
-  //-- Init
-  ag_init();                        //-- Init Graphic Framebuffer
-  ui_init();                        //-- Init Event Handler
+byte a_init_all(char * zipfile) {
+  ATASKGRAPH g;
+  atask_init(&g);
+  int t_splash  = atask_add(&g, "splash", a_task_splash, NULL, 0);
+  int t_zip     = atask_add(&g, "zip", a_task_zip, zipfile, 0);
+  int t_graph   = atask_add(&g, "graph", a_task_graph, NULL, ATASK_DEP(t_splash));
+  atask_add(&g, "input", a_task_input, NULL, ATASK_DEP(t_graph));
+  atask_add(&g, "config", a_task_config, NULL, ATASK_DEP(t_zip));
+  atask_add(&g, "freetype", a_task_freetype, NULL, 0);
+  atask_add(&g, "fonts", a_task_fonts, NULL, ATASK_DEP(t_zip));
+  
+  if (atask_run(&g, AROMA_STARTUP_THREADS)) {
+    return 1;
+  }
+  
+  //-- Release what did start
+  if (!atask_result(&g, t_zip)) {
+    LOGE("Cannot Open Archive");
+  }
+  else {
+    ag_closefonts();
+    az_close();
+  }
+  
+  if (!atask_result(&g, t_graph)) {
+    LOGE("Cannot Init Framebuffer");
+    aft_close();
+  }
+  else {
+    ev_exit();
+    ag_close_thread();
+    ag_close();
+  }
+  
+  return 0;
 }
 
 //*
@@ -131,10 +216,16 @@ void a_release_all() {
 //*
 int main(int argc, char ** argv) {
 #ifndef _AROMA_NODEBUG
-  remove_directory("/tmp/aroma-memory");
   aroma_memory_debug_init();
 #endif
   int retval = 1;
+  
+  //-- Tracing is opt-in, AROMA_TRACE also names the dump
+  if (getenv("AROMA_TRACE") != NULL) {
+    atrace_enable();
+  }
+  
+  ATRACE_THREAD("main");
   parent_pid = getppid();
   LOGS("Initializing");
   //-- Normal Updater Sequences
@@ -158,29 +249,26 @@ int main(int argc, char ** argv) {
     return 2;
   }
   
-  //-- Init Pipe & Show Splash Info
-  a_splash(argv[2]);
+  //-- Scripted input replay, parent is not recovery then
+  char * replay = getenv("AROMA_REPLAY");
   
-  //-- Mute Parent Thread
-  if (parent_pid) {
-    LOGS("Mute Parent");
-    aroma_memory_parentpid(parent_pid);
-    kill(parent_pid, 19);
+  if ((replay != NULL) && areplay_load(replay)) {
+    parent_pid = 0;
   }
   
+  //-- Init Pipe & Show Splash Info
+  a_splash(argv[2]);
   //-- Save to Argument
   LOGS("Saving Arguments");
   snprintf(currArgv[0], 255, "%s", argv[1]);
   snprintf(currArgv[1], 255, "%s", argv[3]);
-  //-- Init Zip
-  LOGS("Open Archive");
+  //-- Open Archive & Init All Resources, overlapped
+  LOGS("Initializing Resource");
+  long start_tick = aTick();
   
-  if (az_init(argv[3])) {
-    //-- Initializing All Resources
-    LOGS("Initializing Resource");
-    a_init_all();
+  if (a_init_all(argv[3])) {
     //-- Starting AROMA Installer UI
-    LOGS("Starting Interface");
+    LOGS("Starting Interface (startup %ld ms)", aTick() - start_tick);
     
     if (aui_start()) {
       fprintf(apipe(), "ui_print " AROMA_NAME " Finished...\nui_print\nui_print\n");
@@ -196,9 +284,6 @@ int main(int argc, char ** argv) {
     LOGS("Starting Release");
     a_release_all();
   }
-  else {
-    LOGE("Cannot Open Archive");
-  }
   
   //-- Unmute Parent
   if (parent_pid) {
@@ -206,6 +291,15 @@ int main(int argc, char ** argv) {
     kill(parent_pid, 18);
   }
   
+  //-- Replay report, when the script had no end
+  areplay_report();
+  //-- Trace dump is opt-in, kept outside AROMA_TMP
+  char * trace = getenv("AROMA_TRACE");
+  
+  if (trace != NULL) {
+    atrace_dump(trace[0] ? trace : AROMA_TRACE_FILE);
+  }
+  
   //-- REMOVE AROMA TEMPORARY
   LOGS("Cleanup Temporary");
   unlink(AROMA_TMP_S);
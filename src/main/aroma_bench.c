@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Descriptions:
+ * -------------
+ * AROMA Benchmark - times the graphic, png, text and control engines on
+ * the headless framebuffer, reports ns/pixel and ns/glyph
+ *
+ * Usage: aroma_bench [aroma.zip] [WxH]
+ *   Fonts for the text & control cases are loaded from the zip,
+ *   without it those cases are skipped.
+ *
+ */
+
+#include <aroma.h>
+#include "aroma_engine.h"
+
+#define BENCH_MIN_NS    200000000LL     // Minimum time per case
+#define BENCH_TEXT      "The quick brown fox jumps over the lazy dog 0123456789"
+
+static char bench_argv[2][256];
+
+//-- Host shims for symbols normally provided by aroma.c / aroma_ui.c
+char * getArgv(int id) {
+  return bench_argv[id];
+}
+char * aui_readfromzip(char * name) {
+  AZMEM filedata;
+  
+  if (!az_readmem(&filedata, name, 0)) {
+    return NULL;
+  }
+  
+  return filedata.data;
+}
+char * aui_readfromfs(char * name) {
+  return NULL;
+}
+char * aui_getvar(char * name) {
+  return NULL;
+}
+
+static long long bench_ns() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((long long) now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+
+static void bench_report(const char * name, const char * size, long long ns, long it, double units, const char * unit) {
+  double per_it = ((double) ns) / it;
+  printf("%-22s %-10s %8ld it %12.1f us/it", name, size, it, per_it / 1000.0);
+  
+  if (units > 0) {
+    printf(" %10.3f ns/%s", per_it / units, unit);
+  }
+  
+  printf("\n");
+}
+
+//-- Repeat code for at least BENCH_MIN_NS, units = pixels/glyphs per run
+#define BENCH(name, size, units, unit, code) do { \
+    long      _it = 0; \
+    long long _s  = bench_ns(), _e; \
+    do { \
+      code; \
+      _it++; \
+      _e = bench_ns(); \
+    } while (_e - _s < BENCH_MIN_NS); \
+    bench_report(name, size, _e - _s, _it, units, unit); \
+  } while (0)
+
+//-- Synthetic RGBA image, with .9 patch markers when ninepatch
+static void bench_png(PNGCANVAS * p, int w, int h, byte ninepatch) {
+  int x, y;
+  p->w = w;
+  p->h = h;
+  p->s = w * h;
+  p->c = 4;
+  p->r = malloc(p->s);
+  p->g = malloc(p->s);
+  p->b = malloc(p->s);
+  p->a = malloc(p->s);
+  
+  for (y = 0; y < h; y++) {
+    for (x = 0; x < w; x++) {
+      int i = y * w + x;
+      p->r[i] = x * 255 / w;
+      p->g[i] = y * 255 / h;
+      p->b[i] = (x ^ y) & 0xff;
+      p->a[i] = (x + y) & 0xff;
+      
+      if (ninepatch && ((x == 0) || (y == 0) || (x == w - 1) || (y == h - 1))) {
+        int pos = (x == 0 || x == w - 1) ? y : x;
+        int len = (x == 0 || x == w - 1) ? h : w;
+        p->a[i] = ((pos > len / 3) && (pos < len * 2 / 3)) ? 255 : 0;
+      }
+    }
+  }
+}
+
+static void bench_graph() {
+  int sizes[3][2] = {{64, 64}, {256, 256}, {agw(), agh()}};
+  char sz[32];
+  int i;
+  CANVAS c, d, e;
+  
+  for (i = 0; i < 3; i++) {
+    int w = sizes[i][0];
+    int h = sizes[i][1];
+    snprintf(sz, 32, "%dx%d", w, h);
+    ag_canvas(&c, w, h);
+    ag_canvas(&d, w, h);
+    ag_canvas(&e, w, h);
+    BENCH("ag_roundgrad_ex", sz, w * h, "px",
+          ag_roundgrad_ex(&c, 0, 0, w, h, ag_rgb(0x22, 0x66, 0xaa), ag_rgb(0x11, 0x33, 0x55),
+                          agdp() * 4, 1, 1, 1, 1));
+    BENCH("ag_blur r2", sz, w * h, "px", ag_blur(&d, &c, 2));
+    BENCH("ag_blur r8", sz, w * h, "px", ag_blur(&d, &c, 8));
+    BENCH("libaroma_alpha_const", sz, w * h, "px",
+          libaroma_alpha_const(w * h, e.data, d.data, c.data, 0x80));
+    ag_ccanvas(&c);
+    ag_ccanvas(&d);
+    ag_ccanvas(&e);
+  }
+}
+
+static void bench_png_draw() {
+  int sizes[3] = {32, 128, 512};
+  char sz[32];
+  int i;
+  CANVAS c;
+  ag_canvas(&c, agw(), agh());
+  
+  for (i = 0; i < 3; i++) {
+    PNGCANVAS p;
+    APNG9 v;
+    int n = sizes[i];
+    snprintf(sz, 32, "%dx%d", n, n);
+    bench_png(&p, n, n, 0);
+    BENCH("apng_draw_ex", sz, n * n, "px", apng_draw_ex(&c, &p, 0, 0, 0, 0, n, n));
+    apng_close(&p);
+    bench_png(&p, n, n, 1);
+    int w = agw();
+    int h = min(agh(), n * 2);
+    snprintf(sz, 32, "%dx%d", w, h);
+    BENCH("apng9_draw", sz, w * h, "px", apng9_draw(&c, &p, 0, 0, w, h, &v, 1));
+    apng_close(&p);
+  }
+  
+  ag_ccanvas(&c);
+}
+
+static void bench_text_size(const char * font, int size) {
+  char sz[32];
+  CANVAS c;
+  ag_canvas(&c, agw(), agh());
+  
+  if (size > 0) {
+    if (!ag_loadsmallfont((char *) font, size, AROMA_DIR "/")) {
+      ag_ccanvas(&c);
+      return;
+    }
+    
+    snprintf(sz, 32, "ttf %dpx", size);
+  }
+  else if (ag_loadsmallfont("fonts/small", 0, NULL)) {
+    snprintf(sz, 32, "png small");
+  }
+  else {
+    ag_ccanvas(&c);
+    return;
+  }
+  
+  int glyphs = strlen(BENCH_TEXT);
+  BENCH("ag_text_exl", sz, glyphs, "glyph",
+        ag_text_exl(&c, agw(), 0, 0, BENCH_TEXT, 0, 0, 0, 0));
+  ag_ccanvas(&c);
+}
+
+static void bench_text() {
+  int sizes[4] = {10, 12, 16, 24};
+  int i;
+  bench_text_size(NULL, 0);
+  
+  for (i = 0; i < 4; i++) {
+    bench_text_size("ttf/Roboto-Regular.ttf", sizes[i]);
+  }
+  
+  //-- Controls below use the default png fonts
+  ag_loadsmallfont("fonts/small", 0, NULL);
+  ag_loadbigfont("fonts/big", 0, NULL);
+}
+
+static void bench_window(const char * name, CANVAS * bg, ACONTROLP(*create)(AWINDOWP)) {
+  AWINDOWP win = aw(bg);
+  create(win);
+  win->isActived = 1;
+  BENCH(name, "window", agw() * agh(), "px", aw_redraw(win); aw_draw(win));
+  aw_destroy(win);
+}
+
+static ACONTROLP bench_ctl_text(AWINDOWP w) {
+  int i;
+  char buf[4096];
+  buf[0] = 0;
+  
+  for (i = 0; i < 40; i++) {
+    strcat(buf, BENCH_TEXT "\n");
+  }
+  
+  return actext(w, 0, 0, agw(), agh(), buf, 0);
+}
+static ACONTROLP bench_ctl_button(AWINDOWP w) {
+  return acbutton(w, agdp() * 4, agdp() * 4, agw() / 2, agdp() * 20, "Button", 0, 1);
+}
+static ACONTROLP bench_ctl_check(AWINDOWP w) {
+  int i;
+  ACONTROLP c = accheck(w, 0, 0, agw(), agh());
+  
+  for (i = 0; i < 32; i++) {
+    if ((i % 8) == 0) {
+      accheck_addgroup(c, "Group", "Group description");
+    }
+    
+    accheck_add(c, "Check item", "Item description", i & 1);
+  }
+  
+  return c;
+}
+static ACONTROLP bench_ctl_opt(AWINDOWP w) {
+  int i;
+  ACONTROLP c = acopt(w, 0, 0, agw(), agh());
+  
+  for (i = 0; i < 32; i++) {
+    if ((i % 8) == 0) {
+      acopt_addgroup(c, "Group", "Group description");
+    }
+    
+    acopt_add(c, "Option item", "Item description", (i % 8) == 1);
+  }
+  
+  return c;
+}
+static ACONTROLP bench_ctl_menu(AWINDOWP w) {
+  int i;
+  ACONTROLP c = acmenu(w, 0, 0, agw(), agh(), 6);
+  
+  for (i = 0; i < 32; i++) {
+    acmenu_add(c, "Menu item", "Item description", "");
+  }
+  
+  return c;
+}
+static ACONTROLP bench_ctl_chkopt(AWINDOWP w) {
+  int i;
+  ACONTROLP c = acchkopt(w, 0, 0, agw(), agh());
+  
+  for (i = 0; i < 32; i++) {
+    if ((i % 8) == 0) {
+      acchkopt_addgroup(c, "g", "Group", "Group description");
+    }
+    
+    acchkopt_add(c, "i", "Form item", "Item description", i & 1, (i & 2) ? 1 : 0);
+  }
+  
+  return c;
+}
+static ACONTROLP bench_ctl_cb(AWINDOWP w) {
+  return accb(w, 0, 0, agw(), agdp() * 20, "Checkbox", 1);
+}
+
+static void bench_controls() {
+  CANVAS bg;
+  ag_canvas(&bg, agw(), agh());
+  ag_rect(&bg, 0, 0, agw(), agh(), acfg()->winbg);
+  bench_window("actext", &bg, bench_ctl_text);
+  bench_window("acbutton", &bg, bench_ctl_button);
+  bench_window("accheck", &bg, bench_ctl_check);
+  bench_window("acopt", &bg, bench_ctl_opt);
+  bench_window("acmenu", &bg, bench_ctl_menu);
+  bench_window("acchkopt", &bg, bench_ctl_chkopt);
+  bench_window("accb", &bg, bench_ctl_cb);
+  ag_ccanvas(&bg);
+}
+
+int main(int argc, char ** argv) {
+  setbuf(stdout, NULL);
+  
+  if (argc > 2) {
+    setenv("AROMA_HEADLESS", argv[2], 1);
+  }
+  else if (getenv("AROMA_HEADLESS") == NULL) {
+    setenv("AROMA_HEADLESS", "480x800", 1);
+  }
+  
+  snprintf(bench_argv[1], 256, "%s", (argc > 1) ? argv[1] : "aroma_bench");
+  
+  if (!ag_init()) {
+    LOGE("Cannot init headless framebuffer");
+    return 1;
+  }
+  
+  aft_open();
+  acfg_init();
+  printf("aroma_bench %dx%d\n", agw(), agh());
+  bench_graph();
+  bench_png_draw();
+  
+  if ((argc > 1) && (az_init(argv[1]) == 1)) {
+    bench_text();
+    bench_controls();
+    az_close();
+  }
+  else {
+    printf("no archive, text & control cases skipped\n");
+  }
+  
+  ag_close_thread();
+  ag_close();
+  return 0;
+}
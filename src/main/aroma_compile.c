@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Descriptions:
+ * -------------
+ * AROMA Compile - host tool, parses an aroma-config / include script and
+ * writes the precompiled tree (edify/bytecode.h) the installer loads
+ * instead of running the parser on the device
+ *
+ * Usage: aroma_compile script [output]
+ *   output defaults to script.bin. Calls to functions the installer does
+ *   not register fail here, at build time.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include "edify/expr.h"
+#include "edify/bytecode.h"
+
+//-- Stands in for every installer function, only the names are needed
+static Value * acomp_call(const char * name, State * state, int argc, Expr * argv[]) {
+  return ErrorAbort(state, "%s() is not available at build time", name);
+}
+
+static char * acomp_read(const char * path, long * size) {
+  FILE * fp = fopen(path, "rb");
+  
+  if (fp == NULL) {
+    return NULL;
+  }
+  
+  fseek(fp, 0, SEEK_END);
+  *size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  char * data = malloc(*size + 1);
+  
+  if ((data != NULL) && (fread(data, 1, *size, fp) != (size_t) * size)) {
+    free(data);
+    data = NULL;
+  }
+  
+  fclose(fp);
+  return data;
+}
+
+int main(int argc, char ** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s script [output]\n", argv[0]);
+    return 1;
+  }
+  
+  char out_path[1024];
+  snprintf(out_path, sizeof(out_path), (argc > 2) ? "%s" : "%s.bin", argv[(argc > 2) ? 2 : 1]);
+  long size = 0;
+  char * data = acomp_read(argv[1], &size);
+  
+  if (data == NULL) {
+    fprintf(stderr, "%s: cannot read\n", argv[1]);
+    return 1;
+  }
+  
+  //-- Stale check on the device compares this with the zip entry crc
+  unsigned int crc = crc32(0, (const Bytef *) data, size);
+  char * script = data;
+  
+  //-- Check UTF-8 File Header
+  if ((size > 3) &&
+      (script[0] == (char) 0xEF) &&
+      (script[1] == (char) 0xBB) &&
+      (script[2] == (char) 0xBF)) {
+    script += 3;
+  }
+  
+  //-- EDIFY REGISTRATION:
+  RegisterBuiltins();
+#define AROMA_FUNCTION(name, fn) RegisterFunction(name, acomp_call);
+#include "aroma_functions.h"
+#undef AROMA_FUNCTION
+  FinishRegistration();
+  //-- PARSE SCRIPT
+  Expr * root = NULL;
+  int error_count = 0;
+  yy_scan_bytes(script, size - (script - data));
+  int error = yyparse(&root, &error_count);
+  
+  if (error != 0 || error_count > 0) {
+    fprintf(stderr, "%s: SYNTAX ERROR on line %d col %d\n", argv[1], yyErrLine(), yyErrCol());
+    return 1;
+  }
+  
+  //-- Constant subexpressions are folded once, here
+  ResolveExpr(root, 1);
+  size_t blob_size = 0;
+  char * blob = SaveExprBlob(root, crc, &blob_size);
+  
+  if (blob == NULL) {
+    fprintf(stderr, "%s: out of memory\n", argv[1]);
+    return 1;
+  }
+  
+  //-- Load it back the way the installer will
+  Expr * check = LoadExprBlob(blob, blob_size, &crc);
+  
+  if (check == NULL) {
+    fprintf(stderr, "%s: %s\n", argv[1], ExprBlobError());
+    return 1;
+  }
+  
+  FreeExprBlob(check);
+  FILE * fp = fopen(out_path, "wb");
+  
+  if ((fp == NULL) || (fwrite(blob, 1, blob_size, fp) != blob_size)) {
+    fprintf(stderr, "%s: cannot write\n", out_path);
+    return 1;
+  }
+  
+  fclose(fp);
+  printf("%s: %ld bytes -> %s: %ld bytes\n", argv[1], size, out_path, (long) blob_size);
+  free(blob);
+  free(data);
+  return 0;
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2011 Ahmad Amarullah ( http://amarullz.com/ )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Descriptions:
+ * -------------
+ * AROMA edify function table, shared by the installer and aroma_compile.
+ * Define AROMA_FUNCTION(name, fn) before including, no include guard.
+ *
+ */
+
+//-- CONFIG FUNCTIONS
+AROMA_FUNCTION("setcolor",      AROMA_SETCOLOR)      //-- SET AROMA COLORSET
+AROMA_FUNCTION("ini_set",       AROMA_INI_SET)       //-- SET INI CONFIGURATION
+AROMA_FUNCTION("ini_get",       AROMA_INI_GET)       //-- GET INI CONFIGURATION
+AROMA_FUNCTION("calibrate",     AROMA_CALIBRATE)     //-- SET CALIBRATION DATA
+AROMA_FUNCTION("calibrate_matrix",     AROMA_CALIBRATE_MATRIX) //-- SET CALIBRATION MATRIX
+AROMA_FUNCTION("calibtool",     AROMA_CALIBTOOL)     //-- SHOW CALIBRATING TOOL
+//-- SET THEME
+AROMA_FUNCTION("theme",         AROMA_THEME)         //-- SET THEME
+AROMA_FUNCTION("fontload",      AROMA_FONT)          //-- LOAD FONTS
+AROMA_FUNCTION("fontresload",   AROMA_FONT)          //-- LOAD FONTS
+//-- LANGUAGE FUNCTIONS
+AROMA_FUNCTION("loadlang",      AROMA_LOADLANG)       //-- Load Language File
+AROMA_FUNCTION("lang",          AROMA_LANG)           //-- Get Language Words
+//-- VARIABLE FUNCTIONS
+AROMA_FUNCTION("getvar",        AROMA_GETVAR)        //-- GET VARIABLE
+AROMA_FUNCTION("setvar",        AROMA_SAVEVAR)       //-- SET VARIABLE
+AROMA_FUNCTION("appendvar",     AROMA_SAVEVAR)       //-- APPEND STRING INTO VARIABLE
+AROMA_FUNCTION("prependvar",    AROMA_SAVEVAR)       //-- PREPEND STRING INTO VARIABLE
+//-- PROP FUNCTIONS
+AROMA_FUNCTION("file_getprop",  AROMA_FILEGETPROP)   //-- GET PROP
+AROMA_FUNCTION("prop",          AROMA_FILEGETPROP)   //-- GET PROP FROM AROMA TMP
+AROMA_FUNCTION("zipprop",       AROMA_FILEGETPROP)   //-- GET PROP FROM ZIP
+AROMA_FUNCTION("resprop",       AROMA_FILEGETPROP)   //-- GET PROP FROM AROMA RESOURCE ZIP
+AROMA_FUNCTION("sysprop",       AROMA_RECOVERYPROP)  //-- GET RECOVERY PROP
+AROMA_FUNCTION("property_get",  AROMA_RECOVERYPROP)  //-- GET RECOVERY PROP
+//-- FILE FUNCTIONS
+AROMA_FUNCTION("writetmpfile",  AROMA_WRITEFILE)     //-- WRITE STRING INTO TEMPORARY FILE
+AROMA_FUNCTION("write",         AROMA_WRITEFILE)     //-- WRITE STRING INTO FILESYSTEM
+AROMA_FUNCTION("readtmpfile",   AROMA_GETFILE)       //-- READ TEMPORARY FILE AS STRING
+AROMA_FUNCTION("read",          AROMA_GETFILE)       //-- READ FILESYSTEM AS STRING
+//-- ZIP HANDLING
+AROMA_FUNCTION("ziptotmp",      AROMA_EXTRACT)       //-- EXTRACT ZIP CONTENT INTO TMP
+AROMA_FUNCTION("restotmp",      AROMA_EXTRACT)       //-- EXTRACT RES CONTENT INTO TMP
+//-- ZIP CONTENT FUNCTIONS
+AROMA_FUNCTION("readfile",      AROMA_ZIPREAD)       //-- [Deprecated] - Renamed to zipread
+AROMA_FUNCTION("readfile_aroma", AROMA_RESREAD)      //-- [Deprecated] - Renamed to resread
+AROMA_FUNCTION("zipread",       AROMA_ZIPREAD)       //-- Read String From Zip
+AROMA_FUNCTION("resread",       AROMA_RESREAD)       //-- Read Strinf From Resource
+//-- EXEC
+AROMA_FUNCTION("zipexec",       AROMA_EXEC)          //-- Exec Program From Zip
+AROMA_FUNCTION("resexec",       AROMA_EXEC)          //-- Exec Program From Resource
+AROMA_FUNCTION("run_program",   AROMA_EXEC)          //-- Run Program/Exec
+AROMA_FUNCTION("exec",          AROMA_EXEC)          //-- Run Prohram/Exec
+//-- MAIN UI FUNCTIONS (With Next & Back Buttons)
+AROMA_FUNCTION("anisplash",     AROMA_ANISPLASH)     //-- SPLASH SCREEN
+AROMA_FUNCTION("splash",        AROMA_SPLASH)        //-- SPLASH SCREEN
+AROMA_FUNCTION("checkbox",      AROMA_CHECKBOX)      //-- CHECKBOX
+AROMA_FUNCTION("form",          AROMA_CHECKOPT)      //-- CHECKBOX
+AROMA_FUNCTION("selectbox",     AROMA_SELECTBOX)     //-- SELECTBOX
+AROMA_FUNCTION("textbox",       AROMA_TEXTBOX)       //-- TEXTBOX
+AROMA_FUNCTION("viewbox",       AROMA_VIEWBOX)       //-- VIEWBOX
+AROMA_FUNCTION("checkviewbox",  AROMA_VIEWBOX)       //-- VIEWBOX
+AROMA_FUNCTION("agreebox",      AROMA_TEXTBOX)       //-- AGREEBOX
+AROMA_FUNCTION("menubox",       AROMA_MENUBOX)       //-- MENUBOX
+//-- INSTALL UI
+AROMA_FUNCTION("install",       AROMA_INSTALL)       //-- START INSTALLATION PROCCESS
+//-- DIALOG UI FUNCTIONS
+AROMA_FUNCTION("alert",         AROMA_ALERT)         //-- ALERT DIALOG
+AROMA_FUNCTION("textdialog",    AROMA_TEXTDIALOG)    //-- TEXT DIALOG
+AROMA_FUNCTION("confirm",       AROMA_CONFIRM)       //-- CONFIRM DIALOG
+//-- DISK INFO FUNCTIONS
+AROMA_FUNCTION("getdisksize",         AROMA_GETPART) //-- GET DISK SIZE
+AROMA_FUNCTION("getdiskfree",         AROMA_GETPART) //-- GET DISK FREE
+AROMA_FUNCTION("getdiskusedpercent",  AROMA_GETPART) //-- GET DISKUSAGE AS PERCENTAGE
+AROMA_FUNCTION("getdiskinfo",         AROMA_GETDISKINFO) //-- ALL DISK METRICS INTO PROP FILE
+//-- COMPARISON & MATH
+AROMA_FUNCTION("cmp", AROMA_CMP)                     //-- COMPARE INTEGER
+AROMA_FUNCTION("cal", AROMA_CAL)                     //-- CALCULATE INTEGER
+AROMA_FUNCTION("iif", AROMA_IIF)                     //-- INLINE IF
+//-- ETC
+AROMA_FUNCTION("exit",          AROMA_EXIT)          //-- TERMINATE PROCCESS
+AROMA_FUNCTION("pleasewait",    AROMA_PLEASEWAIT)    //-- SHOW WAIT SCREEN
+AROMA_FUNCTION("reboot",        AROMA_REBOOT)        //-- REBOOT DEVICE
+//-- SEQUENCES
+AROMA_FUNCTION("back",          AROMA_BACK)          //-- BACK TO PREVIOUS WIZARD
+AROMA_FUNCTION("goto",          AROMA_GOTO)          //-- Go To Section
+AROMA_FUNCTION("gotolabel",     AROMA_GOLABEL)        //-- Get Current Position
+//-- INCLUDE
+AROMA_FUNCTION("include",        AROMA_INCLUDE)        //-- INCLUDE SCRIPT
+AROMA_FUNCTION("eval",            AROMA_EVAL)        //-- EVAL SCRIPT
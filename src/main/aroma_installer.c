@@ -52,90 +52,102 @@ static AWINDOWP  ai_win;
 static ACONTROLP ai_buftxt;
 static int       ai_return_status  = 0;
 
+//-- Installer feedback, queued by the pipe reader for the progress thread
+#define AI_Q_LOG    0                 // ui_print line
+#define AI_Q_TEXT   1                 // Progress title
+#define AI_Q_INFO   2                 // Progress info
+#define AI_Q_FILE   3                 // Extracted file, shortened when applied
+typedef struct _AI_QITEM {
+  struct _AI_QITEM * next;
+  byte      type;
+  char      txt[];
+} AI_QITEM, * AI_QITEMP;
+static AI_QITEMP ai_queue          = NULL;    //-- Newest first
+
 void ai_rebuildtxt(int cx, int cy, int cw, int ch) {
-  char * buffer = NULL;
-  struct stat st;
+  //-- Log lines are already kept by the textbox, just move it
+  actext_logrebuild(ai_buftxt, cx, cy, cw, ch, 1);
+}
+char * ai_fixlen(char * str, char * addstr) {
+  int maxw = ai_prog_w - (ai_prog_or * 2) - ag_txtwidth(addstr, 0);
+  return ag_txtfit(str, maxw, 0, AG_ELLIPSIS_MIDDLE, NULL);
+}
+//-- Lock-free push, never waits for the UI
+static void ai_qpush(byte type, const char * txt) {
+  int len = strlen(txt);
+  AI_QITEMP it = (AI_QITEMP) malloc(sizeof(AI_QITEM) + len + 1);
+  it->type = type;
+  memcpy(it->txt, txt, len + 1);
+  it->next = __atomic_load_n(&ai_queue, __ATOMIC_RELAXED);
   
-  if (stat(AROMA_INSTALL_TXT, &st) < 0) {
-    return;
+  while (!__atomic_compare_exchange_n(&ai_queue, &it->next, it, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
   }
+}
+//-- Apply queued feedback: all log lines at once, latest title & info only
+static void ai_qapply() {
+  AI_QITEMP it = __atomic_exchange_n(&ai_queue, NULL, __ATOMIC_ACQUIRE);
+  AI_QITEMP head = NULL;
+  AI_QITEMP text = NULL;
+  AI_QITEMP info = NULL;
+  int n = 0;
   
-  buffer = malloc(st.st_size + 1);
+  if (it == NULL) {
+    return;
+  }
   
-  if (buffer == NULL) {
-    goto done;
+  //-- Back to arrival order
+  while (it != NULL) {
+    AI_QITEMP next = it->next;
+    it->next = head;
+    head     = it;
+    it       = next;
+    n++;
   }
   
-  FILE * f = fopen(AROMA_INSTALL_TXT, "rb");
+  char ** lines = (char **) malloc(sizeof(char *) * n);
+  int     nline = 0;
   
-  if (f == NULL) {
-    goto done;
+  for (it = head; it != NULL; it = it->next) {
+    if (it->type == AI_Q_LOG) {
+      lines[nline++] = it->txt;
+    }
+    else if (it->type == AI_Q_TEXT) {
+      text = it;
+    }
+    else {
+      info = it;
+    }
   }
   
-  if (fread(buffer, 1, (size_t)st.st_size, f) != (size_t)st.st_size) {
-    fclose(f);
-    goto done;
+  if (nline > 0) {
+    actext_appendlines(ai_buftxt, lines, nline);
   }
   
-  buffer[st.st_size] = '\0';
-  fclose(f);
-done:
-  actext_rebuild(
-    ai_buftxt,
-    cx, cy, cw, ch,
-    ((buffer != NULL) ? buffer : ""),
-    0, 1);
-  free(buffer);
-}
-char * ai_fixlen(char * str, char * addstr) {
-  int maxw = ai_prog_w - (ai_prog_or * 2) - ag_txtwidth(addstr, 0);
-  int clen = ag_txtwidth(str, 0);
-  
-  if (clen < maxw) {
-    return NULL;
+  if (text != NULL) {
+    snprintf(ai_progress_text, 63, "%s", text->txt);
   }
   
-  int basepos = 0;
-  int i = 0;
-  char basestr[64];
-  char allstr[128];
-  memset(basestr, 0, 64);
-  
-  for (i = strlen(str) - 1; i >= 0; i--) {
-    if (str[i] == '/') {
-      basepos = i - 2;
-      snprintf(basestr, 63, "%s", &(str[i]));
+  if (info != NULL) {
+    if (info->type == AI_Q_FILE) {
+      char * fstr = ai_fixlen(info->txt, "Extract:");
+      snprintf(ai_progress_info, 100, "<#selectbg_g>Extract:</#>%s", (fstr != NULL) ? fstr : info->txt);
       
-      if (i > 0) {
-        snprintf(allstr, 127, "/%c%c..%s", str[1], str[2], basestr);
+      if (fstr != NULL) {
+        free(fstr);
       }
-      else {
-        snprintf(allstr, 127, "%s", basestr);
-      }
-      
-      break;
+    }
+    else {
+      snprintf(ai_progress_info, 100, "%s", info->txt);
     }
   }
   
-  if (basepos > 50) {
-    basepos = 50;
-  }
+  free(lines);
   
-  do {
-    if (basepos <= 0) {
-      break;
-    }
-    
-    char dirstr[64];
-    memset(dirstr, 0, 64);
-    memcpy(dirstr, str, basepos);
-    snprintf(allstr, 127, "%s..%s", dirstr, basestr);
-    clen = ag_txtwidth(allstr, 0);
-    basepos--;
+  while (head != NULL) {
+    it   = head;
+    head = head->next;
+    free(it);
   }
-  while (clen >= maxw);
-  
-  return strdup(allstr);
 }
 void ai_actionsavelog() {
 }
@@ -183,7 +195,105 @@ void ai_dump_logs() {
     }
   }
 }
+//-- Parse one updater line, runs on the pipe reader
+static void ai_parseline(char * line, FILE * fp, FILE * fpi) {
+  char   buffer[4096];
+  snprintf(buffer, sizeof(buffer), "%s", line);
+  char * command = strtok(buffer, " \n");
+  
+  if (command == NULL) {
+    return;
+  }
+  else if (strcmp(command, "progress") == 0) {
+    char * fraction_s    = strtok(NULL, " \n");
+    char * numfiles_s    = strtok(NULL, " \n");
+    
+    if ((fraction_s == NULL) || (numfiles_s == NULL)) {
+      return;
+    }
+    
+    float progsize      = strtof(fraction_s, NULL);
+    ai_progress_fract_n = strtol(numfiles_s, NULL, 10);
+    ai_progress_fract_c = 0;
+    ai_progress_fract_l = alib_tick();
+    
+    if (ai_progress_fract_n > 0) {
+      ai_progress_fract = progsize / ai_progress_fract_n;
+    }
+    else if (ai_progress_fract_n < 0) {
+      ai_progress_fract = progsize / abs(ai_progress_fract_n);
+    }
+    else {
+      ai_progress_fract = 0;
+      ai_progress_pos   = progsize;
+    }
+  }
+  else if (strcmp(command, "set_progress") == 0) {
+    char * fraction_s = strtok(NULL, " \n");
+    
+    if (fraction_s == NULL) {
+      return;
+    }
+    
+    ai_progress_fract   = 0;
+    ai_progress_fract_n = 0;
+    ai_progress_fract_c = 0;
+    ai_progress_pos     = strtof(fraction_s, NULL);
+  }
+  else if (strcmp(command, "firmware") == 0) {
+    //-- Firmware Command
+    fprintf(apipe(), "%s\n", ai_trim(line));
+  }
+  else if (strcmp(command, "ui_print") == 0) {
+    char * str = strtok(NULL, "\n");
+    
+    if (str) {
+      if (str[0] == '@') {
+        char tmpbuf[256];
+        snprintf(tmpbuf, 255, "<#selectbg_g><b>%s</b></#>", str + 1);
+        ai_qpush(AI_Q_LOG, tmpbuf);
+        fprintf(fpi, "%s\n", tmpbuf);
+        char * t_trimmed = ai_trim(str + 1);
+        ai_qpush(AI_Q_TEXT, t_trimmed);
+        fprintf(fp, "%s\n", t_trimmed);
+      }
+      else {
+        ai_qpush(AI_Q_LOG, str);
+        fprintf(fpi, "%s\n", str);
+        char * t_trimmed = ai_trim(str);
+        ai_qpush(AI_Q_INFO, t_trimmed);
+        fprintf(fp, "  %s\n", t_trimmed);
+      }
+    }
+  }
+  else if (strcmp(command, "minzip:") == 0) {
+    char * minzipcmd = strtok(NULL, "\"");
+    
+    if ((minzipcmd != NULL) && (strcmp(ai_trim(minzipcmd), "Extracted file") == 0)) {
+      char * filename = strtok(NULL, "\" \n");
+      
+      if (filename == NULL) {
+        return;
+      }
+      
+      ai_qpush(AI_Q_FILE, filename);
+      fprintf(fp, "    Extract: %s\n", filename);
+      
+      if (ai_progress_fract_n > 0) {
+        if (ai_progress_fract_c < ai_progress_fract_n) {
+          ai_progress_fract_c++;
+          ai_progress_pos += ai_progress_fract;
+        }
+      }
+    }
+  }
+  else {
+    fprintf(fp, "    %s\n", ai_trim(line));
+  }
+}
 static void * aroma_install_package() {
+  //-- Leave partitions as the updater expects them
+  alib_automount_release();
   //-- Extract update-binary
   int res = az_extract(AROMA_ORIB, AROMA_TMP "/update-binary");
   
@@ -230,7 +340,7 @@ static void * aroma_install_package() {
   // LOGS("Installer: Initializing PIPE");
   close(pipefd[1]);
   //-- Set New Progress Text
-  snprintf(ai_progress_text, 63, "Installing...");
+  ai_qpush(AI_Q_TEXT, "Installing...");
   //-- Dump LOG
   FILE * fp = fopen(AROMA_INSTALL_LOG, "wb");
   FILE * fpi = fopen(AROMA_INSTALL_TXT, "wb");
@@ -246,106 +356,58 @@ static void * aroma_install_package() {
   fprintf(fp, "Device      : %s\n", acfg()->rom_device);
   fprintf(fp, "Start at    : %s\n\n", asctime (timeinfo));
   //-- Start Reading Feedback
-  char  buffer[1024];
-  FILE * from_child = fdopen(pipefd[0], "r");
+  char  buffer[4096];
+  int   buflen = 0;
   // LOGS("Installer: Get Events");
   
-  while (fgets(buffer, sizeof(buffer), from_child) != NULL) {
-    char * bufall  = strdup(buffer);
-    char * command = strtok(buffer, " \n");
+  for (;;) {
+    ssize_t rd = read(pipefd[0], buffer + buflen, sizeof(buffer) - 1 - buflen);
     
-    if (command == NULL) {
-      free(bufall);
-      continue;
-    }
-    else if (strcmp(command, "progress") == 0) {
-      char * fraction_s    = strtok(NULL, " \n");
-      char * numfiles_s    = strtok(NULL, " \n");
-      float progsize      = strtof(fraction_s, NULL);
-      ai_progress_fract_n = strtol(numfiles_s, NULL, 10);
-      ai_progress_fract_c = 0;
-      ai_progress_fract_l = alib_tick();
-      
-      if (ai_progress_fract_n > 0) {
-        ai_progress_fract = progsize / ai_progress_fract_n;
+    if (rd < 0) {
+      if (errno == EINTR) {
+        continue;
       }
-      else if (ai_progress_fract_n < 0) {
-        ai_progress_fract = progsize / abs(ai_progress_fract_n);
-      }
-      else {
-        ai_progress_fract = 0;
-        ai_progress_pos   = progsize;
-      }
-    }
-    else if (strcmp(command, "set_progress") == 0) {
-      char * fraction_s = strtok(NULL, " \n");
-      ai_progress_fract   = 0;
-      ai_progress_fract_n = 0;
-      ai_progress_fract_c = 0;
-      ai_progress_pos     = strtof(fraction_s, NULL);
-    }
-    else if (strcmp(command, "firmware") == 0) {
-      //-- Firmware Command
-      fprintf(apipe(), "%s\n", ai_trim(bufall));
-    }
-    else if (strcmp(command, "ui_print") == 0) {
-      char * str = strtok(NULL, "\n");
       
-      if (str) {
-        if (str[0] == '@') {
-          char tmpbuf[256];
-          snprintf(tmpbuf, 255, "<#selectbg_g><b>%s</b></#>", str + 1);
-          actext_appendtxt(ai_buftxt, tmpbuf);
-          fprintf(fpi, "%s\n", tmpbuf);
-          char * t_trimmed = ai_trim(str + 1);
-          snprintf(ai_progress_text, 63, "%s", t_trimmed);
-          fprintf(fp, "%s\n", t_trimmed);
-        }
-        else {
-          actext_appendtxt(ai_buftxt, str);
-          fprintf(fpi, "%s\n", str);
-          char * t_trimmed = ai_trim(str);
-          snprintf(ai_progress_info, 100, "%s", t_trimmed);
-          fprintf(fp, "  %s\n", t_trimmed);
-        }
-      }
+      break;
     }
-    else if (strcmp(command, "minzip:") == 0) {
-      char * minzipcmd = ai_trim(strtok(NULL, "\""));
-      
-      if (strcmp(minzipcmd, "Extracted file") == 0) {
-        char * filename = strtok(NULL, "\" \n");
-        char * fstr = ai_fixlen(filename, "Extract:");
-        
-        if (fstr != NULL) {
-          snprintf(ai_progress_info, 100, "<#selectbg_g>Extract:</#>%s", fstr);
-          free(fstr);
-        }
-        else {
-          snprintf(ai_progress_info, 100, "<#selectbg_g>Extract:</#>%s", filename);
-        }
-        
-        fprintf(fp, "    Extract: %s\n", filename);
-        
-        if (ai_progress_fract_n > 0) {
-          if (ai_progress_fract_c < ai_progress_fract_n) {
-            ai_progress_fract_c++;
-            ai_progress_pos += ai_progress_fract;
-          }
-        }
+    
+    buflen += rd;
+    
+    if (rd == 0) {
+      //-- Unterminated last line
+      if (buflen == 0) {
+        break;
       }
+      
+      buffer[buflen++] = '\n';
     }
-    else {
-      char * str = ai_trim(bufall);
-      fprintf(fp, "    %s\n", str);
+    
+    int pos = 0;
+    char * nl;
+    buffer[buflen] = 0;
+    
+    while ((nl = memchr(buffer + pos, '\n', buflen - pos)) != NULL) {
+      nl[0] = 0;
+      ai_parseline(buffer + pos, fp, fpi);
+      pos = (nl - buffer) + 1;
     }
     
-    // LOGS("Installer: Command(%s)", command);
-    free(bufall);
+    if ((pos == 0) && (buflen == (int) sizeof(buffer) - 1)) {
+      //-- Overlong line, split it
+      ai_parseline(buffer, fp, fpi);
+      pos = buflen;
+    }
+    
+    buflen -= pos;
+    memmove(buffer, buffer + pos, buflen);
+    
+    if (rd == 0) {
+      break;
+    }
   }
   
   // LOGS("Installer: Exited - Close Process Handler");
-  fclose(from_child);
+  close(pipefd[0]);
   //-- Get Return Status
   ai_return_status = 0;
   // LOGS("Installer: Wait For PID");
@@ -374,7 +436,7 @@ static void * aroma_install_package() {
 }
 static void * ac_progressthread() {
   //-- COLORS
-  dword hl1 = ag_calchighlight(acfg()->selectbg, acfg()->selectbg_g);
+  colorpair hl1 = ag_calchighlight(acfg()->selectbg, acfg()->selectbg_g);
   byte sg_r = ag_r(acfg()->progressglow);
   byte sg_g = ag_g(acfg()->progressglow);
   byte sg_b = ag_b(acfg()->progressglow);
@@ -383,6 +445,9 @@ static void * ac_progressthread() {
   sg_b = min(sg_b * 1.4, 255);
   
   while (ai_run) {
+    //-- Installer feedback since previous frame
+    ai_qapply();
+    
     //-- CALCULATE PROGRESS BY TIME
     if (ai_progress_fract_n < 0) {
       long curtick  = alib_tick();
@@ -454,7 +519,7 @@ static void * ac_progressthread() {
     
     if (!atheme_draw("img.prograss.fill", ai_cv, ai_prog_ox, ai_prog_oy, curr_prog_w, ai_prog_oh)) {
       ag_roundgrad(ai_cv, ai_prog_x, ai_prog_y, ai_progress_w, ai_prog_h, acfg()->selectbg, acfg()->selectbg_g, ai_prog_r);
-      ag_roundgrad_ex(ai_cv, ai_prog_x, ai_prog_y, ai_progress_w, ceil((ai_prog_h) / 2.0), LOWORD(hl1), HIWORD(hl1), ai_prog_r, 2, 2, 0, 0);
+      ag_roundgrad_ex(ai_cv, ai_prog_x, ai_prog_y, ai_progress_w, ceil((ai_prog_h) / 2.0), ag_pairlo(hl1), ag_pairhi(hl1), ai_prog_r, 2, 2, 0, 0);
       
       if (issmall >= 0) {
         ag_draw_ex(ai_cv, ai_bg, ai_prog_x + issmall, ai_prog_oy, ai_prog_x + issmall, ai_prog_oy, (ai_prog_r * 2), ai_prog_oh);
@@ -536,6 +601,8 @@ static void * ac_progressthread() {
     usleep(160);
   }
   
+  //-- Feedback queued after the last frame
+  ai_qapply();
   return NULL;
 }
 void aroma_init_install(
@@ -558,15 +625,15 @@ void aroma_init_install(
   ai_prog_oy += py;
   ai_prog_or = ai_prog_oh / 2;
   //-- Draw Progress Holder Into BG
-  dword hl1 = ag_calchighlight(acfg()->controlbg, acfg()->controlbg_g);
+  colorpair hl1 = ag_calchighlight(acfg()->controlbg, acfg()->controlbg_g);
   
   if (!atheme_draw("img.progress", bg, px, ai_prog_oy, pw, ai_prog_oh)) {
     ag_roundgrad(bg, px, ai_prog_oy, pw, ai_prog_oh, acfg()->border, acfg()->border_g, ai_prog_or);
     ag_roundgrad(bg, px + 1, ai_prog_oy + 1, pw - 2, ai_prog_oh - 2,
-                 ag_calculatealpha(acfg()->controlbg, 0xffff, 180),
-                 ag_calculatealpha(acfg()->controlbg_g, 0xffff, 160), ai_prog_or - 1);
+                 ag_calculatealpha(acfg()->controlbg, ag_rgb(0xff, 0xff, 0xff), 180),
+                 ag_calculatealpha(acfg()->controlbg_g, ag_rgb(0xff, 0xff, 0xff), 160), ai_prog_or - 1);
     ag_roundgrad(bg, px + 2, ai_prog_oy + 2, pw - 4, ai_prog_oh - 4, acfg()->controlbg, acfg()->controlbg_g, ai_prog_or - 2);
-    ag_roundgrad_ex(bg, px + 2, ai_prog_oy + 2, pw - 4, ceil((ai_prog_oh - 4) / 2.0), LOWORD(hl1), HIWORD(hl1), ai_prog_or - 2, 2, 2, 0, 0);
+    ag_roundgrad_ex(bg, px + 2, ai_prog_oy + 2, pw - 4, ceil((ai_prog_oh - 4) / 2.0), ag_pairlo(hl1), ag_pairhi(hl1), ai_prog_or - 2, 2, 2, 0, 0);
   }
   
   //-- Calculate Progress Value Locations
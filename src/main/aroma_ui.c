@@ -23,6 +23,7 @@
 
 #include <sys/stat.h>       //-- Filesystem Stats
 #include "../edify/expr.h"  //-- Edify Parser
+#include "../edify/bytecode.h" //-- Precompiled Edify
 #include <aroma.h>
 
 #define APARSE_MAXHISTORY 256
@@ -130,19 +131,21 @@ static  int     aparse_last_back_view = 0;
 
 // MACROS
 #define _INITBACK() \
+  alib_automount_release(); \
   int func_pos = ++aparse_current_position; \
   if (aparse_history_pos<APARSE_MAXHISTORY) { \
     aparse_history[aparse_history_pos++]=func_pos; \
   } \
   if ((func_pos<aparse_installpos)||(func_pos<aparse_startpos)){ \
     aparse_backpos = func_pos; \
-    return StringValue(strdup("")); \
+    return StaticStringValue(""); \
   } \
   byte is_back_request  = (aparse_last_back_view==func_pos)?4:aparse_is_back_request+2; \
   if (aparse_last_back_view==0) { if (!aparse_is_back_request) { is_back_request = 5; }} \
   aparse_last_back_view = func_pos; \
   aparse_is_back_request = 0; \
-  if (is_back_request!=5) is_back_request+=transition_style;
+  if (is_back_request!=5) is_back_request+=transition_style; \
+  aui_prefetch(argv);
 
 #define _FINISHBACK() \
   if (func_pos==-4){ \
@@ -150,14 +153,13 @@ static  int     aparse_last_back_view = 0;
   } \
   aparse_backpos = func_pos;
 
+//-- Arguments are borrowed from the evaluated values, read-only
 #define _INITARGS() \
-  char** args = ReadVarArgs(state, argc, argv); \
+  char** args = BorrowVarArgs(state, argc, argv); \
   if (args==NULL) return NULL;
 
 #define _FREEARGS() \
-  int freearg_i; \
-  for (freearg_i=0;freearg_i<argc;++freearg_i) free(args[freearg_i]); \
-  free(args);
+  FreeBorrowedArgs(argc, args);
 
 #define MAX_FILE_GETPROP_SIZE    65536
 
@@ -215,8 +217,8 @@ void apply_font_change_request(byte big) {
   }
 }
 
-void aui_setthemeconfig(char * prop, char * key, byte * b);
-void aui_setthemecolor(char * prop, char * key, color * cl);
+void aui_setthemeconfig(APROPP prop, char * key, byte * b);
+void aui_setthemecolor(APROPP prop, char * key, color * cl);
 char aroma_theme_request[64] = {0};
 byte aroma_theme_new_request = 1;
 
@@ -241,23 +243,19 @@ byte aroma_theme_update() {
     return 1;
   }
   
-  /* Read Theme Prop */
-  char * propstr = aui_readfromzip(themename);
+  /* Read Theme Prop, parsed once */
+  APROPP propstr = aprop_zip(themename);
   
   if (propstr) {
     int i = 0;
     
     for (i = 0; i < AROMA_THEME_CNT; i++) {
       char * key = atheme_key(i);
-      char * val = aui_parsepropstring(propstr, key);
+      char * val = aprop_get(propstr, key);
       
-      if (val != NULL) {
-        if (strcmp(val, "") != 0) {
-          snprintf(themename, 256, "themes/%s/%s", aroma_theme_request, val);
-          atheme_create(key, themename);
-        }
-        
-        free(val);
+      if ((val != NULL) && (strcmp(val, "") != 0)) {
+        snprintf(themename, 256, "themes/%s/%s", aroma_theme_request, val);
+        atheme_create(key, themename);
       }
     }
     
@@ -293,7 +291,7 @@ byte aroma_theme_update() {
     aui_setthemeconfig(propstr, "config.button_roundsize",  &acfg()->btnroundsz);
     aui_setthemeconfig(propstr, "config.window_roundsize",  &acfg()->winroundsz);
     aui_setthemeconfig(propstr, "config.transition_frame",  &acfg()->fadeframes);
-    free(propstr);
+    aprop_free(propstr);
     snprintf(acfg()->themename, 64, "%s", aroma_theme_request);
   }
   else {
@@ -409,6 +407,8 @@ void aui_writetofs(char * name, char * value) {
     fwrite(value, 1, strlen(value), fp);
     fclose(fp);
   }
+  
+  aprop_invalidate(name);
 }
 
 // Read Strings From Temporary File
@@ -438,79 +438,25 @@ char * aui_readfromzip(char * name) {
 
 // Parse PROP String
 char * aui_parsepropstring(char * bf, char * key) {
-  char * result = NULL;
-  
-  if (bf == NULL) {
-    return result;
-  }
-  
-  char * buffer = strdup(bf);
-  char * line = strtok(buffer, "\n");
+  APROPP prop   = aprop_parse(bf);
+  char * result = aprop_get(prop, key);
   
-  do {
-    while (*line && isspace(*line)) {
-      ++line;
-    }
-    
-    if (*line == '\0' || *line == '#') {
-      continue;
-    }
-    
-    char * equal = strchr(line, '=');
-    
-    if (equal == NULL) {
-      goto done;
-    }
-    
-    char * key_end = equal - 1;
-    
-    while (key_end > line && isspace(*key_end)) {
-      --key_end;
-    }
-    
-    key_end[1] = '\0';
-    
-    if (strcmp(key, line) != 0) {
-      continue;
-    }
-    
-    char * val_start = equal + 1;
-    
-    while (*val_start && isspace(*val_start)) {
-      ++val_start;
-    }
-    
-    char * val_end = val_start + strlen(val_start) - 1;
-    
-    while (val_end > val_start && isspace(*val_end)) {
-      --val_end;
-    }
-    
-    val_end[1] = '\0';
-    result = strdup(val_start);
-    break;
+  if (result != NULL) {
+    result = strdup(result);
   }
-  while ((line = strtok(NULL, "\n")));
   
-  free(buffer);
-done:
+  aprop_free(prop);
   return result;
 }
 
 // Parse PROP Files
 char * aui_parseprop(char * filename, char * key) {
-  char * buffer = aui_readfromfs(filename);
-  char * result = aui_parsepropstring(buffer, key);
-  free(buffer);
-  return result;
+  return aprop_fileget(filename, key);
 }
 
 // Parse PROP from ZIP
 char * aui_parsepropzip(char * filename, char * key) {
-  char * buffer = aui_readfromzip(filename);
-  char * result = aui_parsepropstring(buffer, key);
-  free(buffer);
-  return result;
+  return aprop_zipget(filename, key);
 }
 
 // Read Variable
@@ -569,22 +515,221 @@ void aui_prependvar(char * name, char * value) {
 }
 
 // Set Colorset From Prop String
-void aui_setthemecolor(char * prop, char * key, color * cl) {
-  char * val = aui_parsepropstring(prop, key);
+void aui_setthemecolor(APROPP prop, char * key, color * cl) {
+  char * val = aprop_get(prop, key);
   
   if (val != NULL) {
     cl[0] = strtocolor(val);
-    free(val);
   }
 }
 
 // Set Drawing Config From Prop String
-void aui_setthemeconfig(char * prop, char * key, byte * b) {
-  char * val = aui_parsepropstring(prop, key);
+void aui_setthemeconfig(APROPP prop, char * key, byte * b) {
+  char * val = aprop_get(prop, key);
   
   if (val != NULL) {
     b[0] = (byte) min(atoi(val), 255);
-    free(val);
+  }
+}
+
+/************************************[ PAGE LOOK-AHEAD ]************************************/
+//-- Pages ahead of the one shown whose images & texts are decoded on the
+//   prefetch thread
+#define AUI_PREFETCH_PAGES  2
+
+//-- Page & theme() calls of a script tree, in evaluation order
+typedef struct {
+  Expr ** e;
+  byte  * cond;   //-- Inside an if / && / || branch
+  int     n;
+  int     last;   //-- Page shown last, next search starts there
+} AUIPAGES;
+static AUIPAGES * aui_pages = NULL;
+
+//-- Page functions and their image arguments: icon, first item image & item size
+static const struct {
+  const char * name;
+  int ico;
+  int item;
+  int step;
+} aui_pagefn[] = {
+  { "anisplash",    -1, 1, 2 },
+  { "splash",        1, -1, 0 },
+  { "checkbox",      2, -1, 0 },
+  { "form",          2, -1, 0 },
+  { "selectbox",     2, -1, 0 },
+  { "textbox",       2, -1, 0 },
+  { "agreebox",      2, -1, 0 },
+  { "viewbox",       2, -1, 0 },
+  { "checkviewbox",  2, -1, 0 },
+  { "menubox",       2, 6, 3 },
+  { "install",       2, -1, 0 },
+  { NULL,           -1, -1, 0 }
+};
+
+static int aui_pagefn_id(const char * name) {
+  int i;
+  
+  for (i = 0; aui_pagefn[i].name != NULL; i++) {
+    if (strcmp(name, aui_pagefn[i].name) == 0) {
+      return i;
+    }
+  }
+  
+  return -1;
+}
+
+//-- Collect the pages of a resolved tree
+static void aui_pages_scan(AUIPAGES * p, Expr * e, byte cond) {
+  byte branch = (e->fn == IfElseFn) || (e->fn == LogicalAndFn) || (e->fn == LogicalOrFn);
+  int  i;
+  
+  for (i = 0; i < e->argc; i++) {
+    aui_pages_scan(p, e->argv[i], cond || (branch && (i > 0)));
+  }
+  
+  if ((e->fn == Literal) ||
+      ((aui_pagefn_id(e->name) < 0) && (strcmp(e->name, "theme") != 0))) {
+    return;
+  }
+  
+  if ((p->n % 32) == 0) {
+    Expr ** ne = realloc(p->e, sizeof(Expr *) * (p->n + 32));
+    byte  * nc = realloc(p->cond, p->n + 32);
+    
+    if (ne != NULL) {
+      p->e = ne;
+    }
+    
+    if (nc != NULL) {
+      p->cond = nc;
+    }
+    
+    if ((ne == NULL) || (nc == NULL)) {
+      return;
+    }
+  }
+  
+  p->cond[p->n] = cond;
+  p->e[p->n++]  = e;
+}
+
+static void aui_pages_free(AUIPAGES * p) {
+  free(p->e);
+  free(p->cond);
+}
+
+//-- Theme the following pages are drawn with, as aroma_theme_update sees it
+static const char * aui_pages_theme(const char * name) {
+  return (strcmp(name, "generic") == 0) ? "" : name;
+}
+
+static void aui_prefetch_img(Expr * e, int i, const char * themename) {
+  if ((i >= 0) && (i < e->argc) && (e->argv[i]->fn == Literal) && (e->argv[i]->name[0] != 0)) {
+    apng_prefetch(e->argv[i]->name, themename);
+  }
+}
+
+//-- resread() of a literal file anywhere in e
+static void aui_prefetch_text(Expr * e) {
+  int i;
+  
+  if ((e->argc == 1) && (e->argv[0]->fn == Literal) &&
+      ((strcmp(e->name, "resread") == 0) || (strcmp(e->name, "readfile_aroma") == 0))) {
+    char path[256];
+    snprintf(path, 256, "%s/%s", AROMA_DIR, e->argv[0]->name);
+    aprefetch_mem(path);
+    return;
+  }
+  
+  for (i = 0; i < e->argc; i++) {
+    aui_prefetch_text(e->argv[i]);
+  }
+}
+
+//-- Images of a requested theme, as aroma_theme_update will load them
+static void aui_prefetch_theme(const char * themename) {
+  if ((strcmp(themename, "") == 0) || (strcmp(themename, acfg()->themename) == 0)) {
+    return;
+  }
+  
+  char path[256];
+  snprintf(path, 256, "%s/themes/%s/theme.prop", AROMA_DIR, themename);
+  APROPP prop = aprop_zip(path);
+  
+  if (prop == NULL) {
+    return;
+  }
+  
+  int i;
+  
+  for (i = 0; i < AROMA_THEME_CNT; i++) {
+    char * val = aprop_get(prop, atheme_key(i));
+    
+    if ((val != NULL) && (strcmp(val, "") != 0)) {
+      snprintf(path, 256, "themes/%s/%s", themename, val);
+      apng_prefetch(path, "");
+    }
+  }
+  
+  aprop_free(prop);
+}
+
+//-- Queue what the AUI_PREFETCH_PAGES pages from p->e[i] will load
+static void aui_prefetch_from(AUIPAGES * p, int i) {
+  char themename[64];
+  int  pages = 0;
+  snprintf(themename, 64, "%s",
+           aui_pages_theme(aroma_theme_new_request ? aroma_theme_request : acfg()->themename));
+  
+  for (; (i < p->n) && (pages < AUI_PREFETCH_PAGES); i++) {
+    Expr * e  = p->e[i];
+    int    id = aui_pagefn_id(e->name);
+    
+    if (id < 0) {
+      //-- theme(), icons after it are the new one's. In a branch its
+      //   images wait for the call, only one of the themes will be used
+      if ((e->argc == 1) && (e->argv[0]->fn == Literal)) {
+        snprintf(themename, 64, "%s", aui_pages_theme(e->argv[0]->name));
+        
+        if (!p->cond[i]) {
+          aui_prefetch_theme(themename);
+        }
+      }
+      
+      continue;
+    }
+    
+    int k;
+    aui_prefetch_img(e, aui_pagefn[id].ico, themename);
+    
+    for (k = aui_pagefn[id].item; (k >= 0) && (k < e->argc); k += aui_pagefn[id].step) {
+      aui_prefetch_img(e, k, themename);
+    }
+    
+    aui_prefetch_text(e);
+    pages++;
+  }
+}
+
+//-- Called by a page being shown, argv identifies its node
+static void aui_prefetch(Expr * argv[]) {
+  AUIPAGES * p = aui_pages;
+  
+  if (p == NULL) {
+    return;
+  }
+  
+  int k;
+  
+  for (k = 0; k < p->n; k++) {
+    int i = (p->last + k) % p->n;
+    
+    if (p->e[i]->argv == argv) {
+      p->last = i;
+      aui_prefetch_from(p, i + 1);
+      return;
+    }
   }
 }
 
@@ -623,7 +768,7 @@ Value * AROMA_FONT(const char * name, State * state, int argc, Expr * argv[]) {
   _FREEARGS();
   aui_isbgredraw = 1;
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // set_theme
@@ -640,9 +785,11 @@ Value * AROMA_THEME(const char * name, State * state, int argc, Expr * argv[]) {
   snprintf(aroma_theme_request, 64, "%s", args[0]);
   aroma_theme_new_request = 1;
   aui_isbgredraw = 1;
+  //-- Decoded while the script runs up to the next page
+  aui_prefetch_theme(aui_pages_theme(aroma_theme_request));
   _FREEARGS();
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // package_extract
@@ -673,9 +820,9 @@ Value * AROMA_EXTRACT(const char * name, State * state, int argc, Expr * argv[])
   
   //-- Return
   if (res) {
-    return StringValue(strdup("1"));
+    return StaticStringValue("1");
   }
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // file_getprop, prop
@@ -761,7 +908,7 @@ Value * AROMA_ZIPREAD(const char * name, State * state, int argc, Expr * argv[])
     return StringValue(buf);
   }
   
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // resread, readfile_aroma
@@ -786,7 +933,7 @@ Value * AROMA_RESREAD(const char * name, State * state, int argc, Expr * argv[])
   if (buf != NULL) {
     return StringValue(buf);
   }
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // pleasewait
@@ -794,7 +941,7 @@ Value * AROMA_PLEASEWAIT(const char * name, State * state, int argc, Expr * argv
   int func_pos = ++aparse_current_position;
   
   if (func_pos < aparse_startpos) {
-    return StringValue(strdup(""));
+    return StaticStringValue("");
   }
   
   if (argc != 1) {
@@ -810,7 +957,7 @@ Value * AROMA_PLEASEWAIT(const char * name, State * state, int argc, Expr * argv
   //-- Release Arguments
   _FREEARGS();
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // writetmpfile, write
@@ -836,7 +983,7 @@ Value * AROMA_WRITEFILE(const char * name, State * state, int argc, Expr * argv[
   //-- Release Arguments
   _FREEARGS();
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // readtmpfile, read
@@ -867,7 +1014,7 @@ Value * AROMA_GETFILE(const char * name, State * state, int argc, Expr * argv[])
   if (result != NULL) {
     return StringValue(result);
   }
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // getvar
@@ -889,7 +1036,7 @@ Value * AROMA_GETVAR(const char * name, State * state, int argc, Expr * argv[])
   if (result != NULL) {
     return StringValue(result);
   }
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // setvar, appendvar, prependvar
@@ -920,7 +1067,50 @@ Value * AROMA_SAVEVAR(const char * name, State * state, int argc, Expr * argv[])
   //-- Release Arguments
   _FREEARGS();
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
+}
+
+//-- cmp & cal operators, codes are 1 based
+static const char * aroma_cmp_ops[] = { "==", ">", "<", ">=", "<=", "!=", NULL };
+static const char * aroma_cal_ops[] = { "+", "-", "*", "/", "%", NULL };
+
+//-- Operator code, -1 when unknown
+static int aroma_opcode(const char * s, const char ** ops) {
+  int i;
+  
+  for (i = 0; ops[i] != NULL; i++) {
+    if (strcmp(s, ops[i]) == 0) {
+      return i + 1;
+    }
+  }
+  
+  return -1;
+}
+
+//-- Operator argument, pre-bound by aroma_resolve_op or evaluated now.
+//   0 when the evaluation aborted
+static int aroma_argop(State * state, Expr * e, const char ** ops) {
+  if (e->op != 0) {
+    return e->op;
+  }
+  
+  char * s = Evaluate(state, e);
+  
+  if (s == NULL) {
+    return 0;
+  }
+  
+  int op = aroma_opcode(s, ops);
+  free(s);
+  return op;
+}
+
+//-- Resolver for cmp & cal, binds a literal operator once
+static void aroma_resolve_op(Expr * e) {
+  if ((e->argc == 3) && (e->argv[1]->fn == Literal)) {
+    e->argv[1]->op = aroma_opcode(e->argv[1]->name,
+                                  (strcmp(e->name, "cmp") == 0) ? aroma_cmp_ops : aroma_cal_ops);
+  }
 }
 
 // cmp
@@ -931,41 +1121,47 @@ Value * AROMA_CMP(const char * name, State * state, int argc, Expr * argv[]) {
 
   //-- This is Busy Function
   ag_setbusy();
-  //-- Get Arguments
-  _INITARGS();
-  //-- Convert Arguments
-  byte ret = 0;
-  long val1 = atol(args[0]);
-  long val2 = atol(args[2]);
-
-  //-- Compare
-  if (strcmp(args[1], "==") == 0) {
-    ret = (val1 == val2) ? 1 : 0;
-  }
-  else if (strcmp(args[1], ">") == 0) {
-    ret = (val1 > val2) ? 1 : 0;
-  }
-  else if (strcmp(args[1], "<") == 0) {
-    ret = (val1 < val2) ? 1 : 0;
-  }
-  else if (strcmp(args[1], ">=") == 0) {
-    ret = (val1 >= val2) ? 1 : 0;
-  }
-  else if (strcmp(args[1], "<=") == 0) {
-    ret = (val1 <= val2) ? 1 : 0;
+  //-- Get Arguments, literal numbers are cached by ResolveExpr
+  long val1, val2;
+  int  op;
+  
+  if ((EvaluateLong(state, argv[0], &val1) < 0) ||
+      ((op = aroma_argop(state, argv[1], aroma_cmp_ops)) == 0) ||
+      (EvaluateLong(state, argv[2], &val2) < 0)) {
+    return NULL;
   }
-  else if (strcmp(args[1], "!=") == 0) {
-    ret = (val1 != val2) ? 1 : 0;
+  
+  //-- Compare
+  byte ret = 0;
+  
+  switch (op) {
+    case 1:
+      ret = (val1 == val2);
+      break;
+      
+    case 2:
+      ret = (val1 > val2);
+      break;
+      
+    case 3:
+      ret = (val1 < val2);
+      break;
+      
+    case 4:
+      ret = (val1 >= val2);
+      break;
+      
+    case 5:
+      ret = (val1 <= val2);
+      break;
+      
+    case 6:
+      ret = (val1 != val2);
+      break;
   }
 
-  //-- Release Arguments
-  _FREEARGS();
-
   //-- Return
-  if (ret) {
-    return StringValue(strdup("1"));
-  }
-  return StringValue(strdup(""));
+  return StaticStringValue(ret ? "1" : "");
 }
 
 // cal
@@ -976,32 +1172,41 @@ Value * AROMA_CAL(const char * name, State * state, int argc, Expr * argv[]) {
   
   //-- This is Busy Function
   ag_setbusy();
-  //-- Get Arguments
-  _INITARGS();
-  //-- Convert Arguments
-  long ret = 0;
-  long val1 = atol(args[0]);
-  long val2 = atol(args[2]);
+  //-- Get Arguments, literal numbers are cached by ResolveExpr
+  long val1, val2;
+  int  op;
   
-  //-- Calculating
-  if (strcmp(args[1], "+") == 0) {
-    ret = val1 + val2;
-  }
-  else if (strcmp(args[1], "-") == 0) {
-    ret = val1 - val2;
-  }
-  else if (strcmp(args[1], "*") == 0) {
-    ret = val1 * val2;
-  }
-  else if (strcmp(args[1], "/") == 0) {
-    ret = val1 / val2;
+  if ((EvaluateLong(state, argv[0], &val1) < 0) ||
+      ((op = aroma_argop(state, argv[1], aroma_cal_ops)) == 0) ||
+      (EvaluateLong(state, argv[2], &val2) < 0)) {
+    return NULL;
   }
-  else if (strcmp(args[1], "\%") == 0) {
-    ret = val1 % val2;
+  
+  //-- Calculating
+  long ret = 0;
+  
+  switch (op) {
+    case 1:
+      ret = val1 + val2;
+      break;
+      
+    case 2:
+      ret = val1 - val2;
+      break;
+      
+    case 3:
+      ret = val1 * val2;
+      break;
+      
+    case 4:
+      ret = val1 / val2;
+      break;
+      
+    case 5:
+      ret = val1 % val2;
+      break;
   }
   
-  //-- Release Arguments
-  _FREEARGS();
   //-- Return
   char retstr[64];
   snprintf(retstr, 64, "%ld", ret);
@@ -1016,32 +1221,35 @@ Value * AROMA_IIF(const char * name, State * state, int argc, Expr * argv[]) {
   
   //-- This is Busy Function
   ag_setbusy();
-  //-- Get Arguments
-  _INITARGS();
-  //-- Compare
-  char * ret = NULL;
+  //-- Get Arguments, as values so the chosen one is shared, not copied
+  Value ** args = ReadValueVarArgs(state, argc, argv);
   
-  if (args[0][0] == '\0') {
-    ret = strdup(args[2]);
-  }
-  else {
-    ret = strdup(args[1]);
+  if (args == NULL) {
+    return NULL;
   }
   
+  //-- Compare
+  Value * ret = RetainValue(args[(args[0]->data[0] == '\0') ? 2 : 1]);
   //-- Release Arguments
-  _FREEARGS();
+  int i;
+  
+  for (i = 0; i < argc; i++) {
+    FreeValue(args[i]);
+  }
+  
+  free(args);
   //-- Return
-  return StringValue(ret);
+  return ret;
 }
 
 // calibrate
 Value * AROMA_CALIBRATE() {
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // calibrate_matrix
 Value * AROMA_CALIBRATE_MATRIX() {
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // setcolor
@@ -1148,7 +1356,7 @@ Value * AROMA_SETCOLOR(const char * name, State * state, int argc, Expr * argv[]
   //-- Release Arguments
   _FREEARGS();
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // ini_get
@@ -1395,7 +1603,7 @@ Value * AROMA_INI_SET(const char * name, State * state, int argc, Expr * argv[])
   //-- Release Arguments
   _FREEARGS();
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // anisplash
@@ -1403,9 +1611,11 @@ Value * AROMA_ANISPLASH(const char * name, State * state, int argc, Expr * argv[
   int func_pos = ++aparse_current_position;
 
   if (func_pos < aparse_startpos) {
-    return StringValue(strdup(""));
+    return StaticStringValue("");
   }
 
+  aui_prefetch(argv);
+
   if (argc < 3) {
     return ErrorAbort(state, "%s() expects at least 2 args (loop count, [image name, duration]), got %d", name, argc);
   }
@@ -1490,7 +1700,7 @@ Value * AROMA_ANISPLASH(const char * name, State * state, int argc, Expr * argv[
   ag_ccanvas(&splashbg);
   ag_ccanvas(&tmpbg);
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // splash
@@ -1498,9 +1708,11 @@ Value * AROMA_SPLASH(const char * name, State * state, int argc, Expr * argv[])
   int func_pos = ++aparse_current_position;
 
   if (func_pos < aparse_startpos) {
-    return StringValue(strdup(""));
+    return StaticStringValue("");
   }
 
+  aui_prefetch(argv);
+
   if (argc != 2) {
     return ErrorAbort(state, "%s() expects 2 args (delay in milisecond, image name), got %d", name, argc);
   }
@@ -1541,7 +1753,7 @@ Value * AROMA_SPLASH(const char * name, State * state, int argc, Expr * argv[])
   ag_ccanvas(&splashbg);
   ag_ccanvas(&tmpbg);
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // viewbox
@@ -1616,7 +1828,7 @@ Value * AROMA_VIEWBOX(const char * name, State * state, int argc, Expr * argv[])
   //-- Draw Separator
   if (!isplain) {
     color sepcl = ag_calculatealpha(acfg()->winbg, 0x0000, 80);
-    color sepcb = ag_calculatealpha(acfg()->winbg, 0xffff, 127);
+    color sepcb = ag_calculatealpha(acfg()->winbg, ag_rgb(0xff, 0xff, 0xff), 127);
     ag_rect(&aui_win_bg, tifX, tifY + pad + txtH, chkW - ((pad * 2) + imgA), 1, sepcl);
     ag_rect(&aui_win_bg, tifX, tifY + pad + txtH + 1, chkW - ((pad * 2) + imgA), 1, sepcb);
   }
@@ -1751,10 +1963,10 @@ Value * AROMA_VIEWBOX(const char * name, State * state, int argc, Expr * argv[])
   
   //-- Return Value
   if (is_checked) {
-    return StringValue(strdup("1"));
+    return StaticStringValue("1");
   }
   
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // textbox, agreebox
@@ -1939,7 +2151,7 @@ Value * AROMA_TEXTBOX(const char * name, State * state, int argc, Expr * argv[])
   }
   
   _FINISHBACK();
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // checkbox & optionbox hybrid
@@ -2157,6 +2369,8 @@ Value * AROMA_CHECKOPT(const char * name, State * state, int argc, Expr * argv[]
     fclose(fp);
   }
   
+  aprop_invalidate(path);
+  
   //-- Destroy Window
   aw_destroy(hWin);
   
@@ -2166,7 +2380,7 @@ Value * AROMA_CHECKOPT(const char * name, State * state, int argc, Expr * argv[]
   }
   
   _FINISHBACK();
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // checkbox
@@ -2356,6 +2570,8 @@ Value * AROMA_CHECKBOX(const char * name, State * state, int argc, Expr * argv[]
     fclose(fp);
   }
   
+  aprop_invalidate(path);
+  
   //-- Destroy Window
   aw_destroy(hWin);
   
@@ -2365,7 +2581,7 @@ Value * AROMA_CHECKBOX(const char * name, State * state, int argc, Expr * argv[]
   }
   
   _FINISHBACK();
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // selectbox
@@ -2557,6 +2773,8 @@ Value * AROMA_SELECTBOX(const char * name, State * state, int argc, Expr * argv[
     fclose(fp);
   }
   
+  aprop_invalidate(path);
+  
   //-- Destroy Window
   aw_destroy(hWin);
   
@@ -2566,7 +2784,7 @@ Value * AROMA_SELECTBOX(const char * name, State * state, int argc, Expr * argv[
   }
   
   _FINISHBACK();
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // menubox
@@ -2716,6 +2934,8 @@ Value * AROMA_MENUBOX(const char * name, State * state, int argc, Expr * argv[])
     fclose(fp);
   }
   
+  aprop_invalidate(path);
+  
   //-- Destroy Window
   aw_destroy(hWin);
   
@@ -2725,7 +2945,7 @@ Value * AROMA_MENUBOX(const char * name, State * state, int argc, Expr * argv[])
   }
   
   _FINISHBACK();
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // install
@@ -2835,7 +3055,7 @@ Value * AROMA_INSTALL(const char * name, State * state, int argc, Expr * argv[])
 
 // calibtool
 Value * AROMA_CALIBTOOL() {
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // alert
@@ -2843,7 +3063,7 @@ Value * AROMA_ALERT(const char * name, State * state, int argc, Expr * argv[]) {
   int func_pos = ++aparse_current_position;
   
   if (func_pos < aparse_startpos) {
-    return StringValue(strdup(""));
+    return StaticStringValue("");
   }
   
   if ((argc < 2) || (argc > 4)) {
@@ -2865,7 +3085,7 @@ Value * AROMA_ALERT(const char * name, State * state, int argc, Expr * argv[]) {
   //-- Release Arguments
   _FREEARGS();
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // confirm
@@ -2873,7 +3093,7 @@ Value * AROMA_CONFIRM(const char * name, State * state, int argc, Expr * argv[])
   int func_pos = ++aparse_current_position;
   
   if (func_pos < aparse_startpos) {
-    return StringValue(strdup(""));
+    return StaticStringValue("");
   }
   
   if ((argc < 2) || (argc > 5)) {
@@ -2898,10 +3118,10 @@ Value * AROMA_CONFIRM(const char * name, State * state, int argc, Expr * argv[])
   
   //-- Return
   if (res) {
-    return StringValue(strdup("yes"));
+    return StaticStringValue("yes");
   }
   
-  return StringValue(strdup("no"));
+  return StaticStringValue("no");
 }
 
 // textdialog
@@ -2909,7 +3129,7 @@ Value * AROMA_TEXTDIALOG(const char * name, State * state, int argc, Expr * argv
   int func_pos = ++aparse_current_position;
   
   if (func_pos < aparse_startpos) {
-    return StringValue(strdup(""));
+    return StaticStringValue("");
   }
   
   if ((argc < 2) || (argc > 3)) {
@@ -2930,7 +3150,7 @@ Value * AROMA_TEXTDIALOG(const char * name, State * state, int argc, Expr * argv
   //-- Release Arguments
   _FREEARGS();
   //-- Return
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // exit
@@ -2972,7 +3192,7 @@ Value * AROMA_REBOOT(const char * name, State * state, int argc, Expr * argv[])
   
   //-- Release Arguments
   _FREEARGS();
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // back
@@ -2999,7 +3219,7 @@ Value * AROMA_BACK(const char * name, State * state, int argc, Expr * argv[]) {
     //-- Not Allow Back before Installation Pos
     if (topos <= aparse_installpos) {
       _FREEARGS();
-      return StringValue(strdup(""));
+      return StaticStringValue("");
     }
     
     //-- Set Back Position
@@ -3012,7 +3232,7 @@ Value * AROMA_BACK(const char * name, State * state, int argc, Expr * argv[]) {
   else {
     //-- Release Arguments
     _FREEARGS();
-    return StringValue(strdup(""));
+    return StaticStringValue("");
   }
   
   return NULL;
@@ -3078,7 +3298,7 @@ Value * AROMA_GOTO(const char * name, State * state, int argc, Expr * argv[]) {
     return NULL;
   }
   
-  return StringValue(strdup(""));
+  return StaticStringValue("");
 }
 
 // getdisksize, getdiskfree, getdiskusedpercent
@@ -3101,20 +3321,10 @@ Value * AROMA_GETPART(const char * name, State * state, int argc, Expr * argv[])
   ag_setbusy();
   //-- Get Arguments
   _INITARGS();
-  //-- Get & Set mounted
+  //-- Mounted until next page, statfs is memoized
   unsigned long ret = 0;
   byte valid = 0;
-  byte mtd = ismounted(args[0]);
-  
-  if (!mtd) {
-    alib_exec("/sbin/mount", args[0]);
-    
-    if (!ismounted(args[0])) {
-      _FREEARGS();
-      goto done;
-    }
-  }
-  
+  ADISKINFO di;
   int division = 1024 * 1024;
   
   //-- Set UNIT
@@ -3131,34 +3341,23 @@ Value * AROMA_GETPART(const char * name, State * state, int argc, Expr * argv[])
   }
   
   //-- Calculating
-  if (ispercent) {
-    int pret = alib_diskusage(args[0]);
+  if (alib_diskinfo(args[0], &di)) {
+    valid = 1;
     
-    if (pret >= 0) {
-      valid   = 1;
-      ret     = pret;
+    if (ispercent) {
+      ret = di.percent;
     }
-  }
-  else if (strcmp(name, "getdisksize") == 0) {
-    if (alib_disksize(args[0], &ret, division)) {
-      valid = 1;
+    else if (strcmp(name, "getdisksize") == 0) {
+      ret = (unsigned long) ((di.size + (division / 2)) / division);
     }
-  }
-  else {
-    if (alib_diskfree(args[0], &ret, division)) {
-      valid = 1;
+    else {
+      ret = (unsigned long) ((di.free + (division / 2)) / division);
     }
   }
   
-  //-- Unmount if previous was unmounted
-  if (!mtd) {
-    alib_exec("/sbin/umount", args[0]);
-  }
-  
   //-- Release Arguments
   _FREEARGS();
-done:
-
+  
   //-- Finish
   if (valid) {
     snprintf(retstr, 64, "%lu", ret);
@@ -3170,6 +3369,46 @@ done:
   return StringValue(strdup(retstr));
 }
 
+// getdiskinfo
+Value * AROMA_GETDISKINFO(const char * name, State * state, int argc, Expr * argv[]) {
+  if (argc != 3) {
+    return ErrorAbort(state, "%s() expects 3 args (mountpoint, unit(b,k,m), prop file), got %d", name, argc);
+  }
+  
+  //-- Set Busy before everythings ready
+  ag_setbusy();
+  //-- Get Arguments
+  _INITARGS();
+  ADISKINFO di;
+  byte valid = alib_diskinfo(args[0], &di);
+  
+  if (valid) {
+    int division = 1024 * 1024;
+    
+    if (args[1][0] == 'k') {
+      division = 1024;
+    }
+    else if (args[1][0] == 'b') {
+      division = 1;
+    }
+    
+    //-- All metrics in one prop file, read back with prop()
+    char path[256];
+    char buf[256];
+    snprintf(path, 256, "%s/%s", AROMA_TMP, args[2]);
+    snprintf(buf, 256, "size=%llu\nfree=%llu\nused=%llu\npercent=%i\n",
+             (di.size + (division / 2)) / division,
+             (di.free + (division / 2)) / division,
+             (di.used + (division / 2)) / division,
+             di.percent);
+    aui_writetofs(path, buf);
+  }
+  
+  //-- Release Arguments
+  _FREEARGS();
+  return StaticStringValue(valid ? "1" : "");
+}
+
 // exec
 Value * AROMA_EXEC(const char * name, State * state, int argc, Expr * argv[]) {
   if (argc < 1) {
@@ -3308,7 +3547,7 @@ Value * AROMA_LOADLANG(const char * name, State * state, int argc, Expr * argv[]
   }
   
   _FREEARGS();
-  return StringValue(strdup(res ? "1" : ""));
+  return StaticStringValue(res ? "1" : "");
 }
 
 // lang
@@ -3326,6 +3565,62 @@ Value * AROMA_LANG(const char * name, State * state, int argc, Expr * argv[]) {
   return StringValue(strdup((out == NULL) ? "" : out));
 }
 
+//-- Load precompiled <path>.bin, unless it is stale against <path>.
+//   Names in the tree point into mem, release both after use
+static Expr * aui_loadbin(AZMEM * mem, const char * path) {
+  char bin[256];
+  snprintf(bin, 256, "%s.bin", path);
+  
+  if (!az_map(mem, bin, AZ_MAP_KEEP)) {
+    return NULL;
+  }
+  
+  dword crc;
+  byte has_src = az_crc(path, &crc);
+  unsigned int src_crc = crc;
+  Expr * root = LoadExprBlob(mem->data, mem->sz, has_src ? &src_crc : NULL);
+  
+  if (root == NULL) {
+    LOGW("%s: %s, parsing source", bin, ExprBlobError());
+    az_unmap(mem);
+  }
+  else {
+    //-- Folded by aroma_compile already
+    ResolveExpr(root, 0);
+  }
+  
+  return root;
+}
+
+//-- Evaluate a script tree in its own state, errors go to the caller.
+//   Its pages are the look-ahead meanwhile
+static char * aui_evaluate(State * state, Expr * root, char * script) {
+  AUIPAGES   pages;
+  AUIPAGES * parent = aui_pages;
+  memset(&pages, 0, sizeof(AUIPAGES));
+  aui_pages_scan(&pages, root, 0);
+  aui_pages = &pages;
+  
+  if (aparse_current_position >= aparse_startpos) {
+    aui_prefetch_from(&pages, 0);
+  }
+  
+  State state_new;
+  state_new.cookie = NULL;
+  state_new.script = script;
+  state_new.errmsg = NULL;
+  char * result = Evaluate(&state_new, root);
+  aui_pages = parent;
+  aui_pages_free(&pages);
+  
+  if ((result == NULL) && (state_new.errmsg != NULL)) {
+    ErrorAbort(state, "%s", state_new.errmsg);
+    free(state_new.errmsg);
+  }
+  
+  return result;
+}
+
 // include file path
 Value * AROMA_INCLUDE(const char * name, State * state, int argc, Expr * argv[]) {
   if (argc != 1) {
@@ -3349,10 +3644,19 @@ Value * AROMA_INCLUDE(const char * name, State * state, int argc, Expr * argv[])
     LOGS("# INCLUDE SCRIPT (%s)", fname);
   }
   
-  //-- Read From Zip
+  //-- Precompiled by aroma_compile
   AZMEM script_installer;
+  Expr * root = aui_loadbin(&script_installer, path);
   
-  if (!az_readmem(&script_installer, path, 0)) {
+  if (root != NULL) {
+    char * result = aui_evaluate(state, root, NULL);
+    FreeExprBlob(root);
+    az_unmap(&script_installer);
+    return (result == NULL) ? NULL : StringValue(result);
+  }
+  
+  //-- Read From Zip
+  if (!az_map(&script_installer, path, AZ_MAP_ONCE)) {
     return ErrorAbort(state, "%s() File to include %s not found", name, fname);
   }
   
@@ -3372,36 +3676,21 @@ Value * AROMA_INCLUDE(const char * name, State * state, int argc, Expr * argv[])
   }
   
   //-- PARSE CONFIG SCRIPT
-  Expr * root;
   int error_count = 0;
-  yy_scan_string(script_data);
+  yy_scan_bytes(script_data, script_installer.sz - (script_data - script_installer.data));
   int error = yyparse(&root, &error_count);
   
   if (error != 0 || error_count > 0) {
-    free(script_installer.data);
+    az_unmap(&script_installer);
     return ErrorAbort(state, "SYNTAX ERROR in %s on line %d col %d", fname, yyErrLine(), yyErrCol());
   }
   
+  //-- Parsed again on every call, folded strings would pile up
+  ResolveExpr(root, 0);
   //-- EVALUATE CONFIG SCRIPT
-  State state_new;
-  state_new.cookie = NULL;
-  state_new.script = script_data;
-  state_new.errmsg = NULL;
-  char * result = Evaluate(&state_new, root);
-  //-- CLEANUP & ERROR HANDLER
-  free(script_installer.data);
-  
-  if (result == NULL) {
-    if (state_new.errmsg == NULL) {
-      return NULL;
-    }
-    
-    ErrorAbort(state, "%s", state_new.errmsg);
-    free(state_new.errmsg);
-    return NULL;
-  }
-  
-  return StringValue(result);
+  char * result = aui_evaluate(state, root, script_data);
+  az_unmap(&script_installer);
+  return (result == NULL) ? NULL : StringValue(result);
 }
 
 // EVAL SCRIPT
@@ -3447,6 +3736,8 @@ Value * AROMA_EVAL(const char * name, State * state, int argc, Expr * argv[]) {
     return ErrorAbort(state, "SYNTAX ERROR in EVAL on line %d col %d", yyErrLine(), yyErrCol());
   }
   
+  //-- Parsed again on every call, folded strings would pile up
+  ResolveExpr(root, 0);
   //-- EVALUATE CONFIG SCRIPT
   State state_new;
   state_new.cookie = NULL;
@@ -3471,104 +3762,106 @@ Value * AROMA_EVAL(const char * name, State * state, int argc, Expr * argv[]) {
 
 /************************************[ AROMA EDIFY REGISTER ]************************************/
 
+#ifndef _AROMA_NOTRACE
+//-- Traced dispatch: edify passes the called name, so one trampoline
+//-- looks up the real function and wraps it in a trace scope
+#define AROMA_FUNC_HASH 256
+typedef struct {
+  const char * name;
+  Function     fn;
+} AROMA_FUNC;
+static AROMA_FUNC aroma_funcs[AROMA_FUNC_HASH];
+
+static dword aroma_func_hash(const char * s) {
+  dword h = 2166136261u;
+  
+  while (*s) {
+    h ^= (byte) * s++;
+    h *= 16777619u;
+  }
+  
+  return h;
+}
+static AROMA_FUNC * aroma_func_slot(const char * name) {
+  dword h = aroma_func_hash(name);
+  int   i;
+  
+  for (i = 0; i < AROMA_FUNC_HASH; i++) {
+    AROMA_FUNC * f = &aroma_funcs[(h + i) & (AROMA_FUNC_HASH - 1)];
+    
+    if ((f->name == NULL) || (strcmp(f->name, name) == 0)) {
+      return f;
+    }
+  }
+  
+  return NULL;
+}
+static Value * AROMA_TRACED(const char * name, State * state, int argc, Expr * argv[]) {
+  AROMA_FUNC * f = aroma_func_slot(name);
+  
+  if ((f == NULL) || (f->fn == NULL)) {
+    return ErrorAbort(state, "unknown function \"%s\"", name);
+  }
+  
+  ATRACE_SCOPE(f->name);
+  return f->fn(name, state, argc, argv);
+}
+static void aroma_register(const char * name, Function fn) {
+  AROMA_FUNC * f = aroma_func_slot(name);
+  
+  if (f == NULL) {
+    RegisterFunction(name, fn);
+    return;
+  }
+  
+  f->name = name;
+  f->fn   = fn;
+  RegisterFunction(name, AROMA_TRACED);
+}
+#else
+static void aroma_register(const char * name, Function fn) {
+  RegisterFunction(name, fn);
+}
+#endif
+
 // Register AROMA edify functions
 void RegisterAroma() {
-  //-- CONFIG FUNCTIONS
-  RegisterFunction("setcolor",      AROMA_SETCOLOR);      //-- SET AROMA COLORSET
-  RegisterFunction("ini_set",       AROMA_INI_SET);       //-- SET INI CONFIGURATION
-  RegisterFunction("ini_get",       AROMA_INI_GET);       //-- GET INI CONFIGURATION
-  RegisterFunction("calibrate",     AROMA_CALIBRATE);     //-- SET CALIBRATION DATA
-  RegisterFunction("calibrate_matrix",     AROMA_CALIBRATE_MATRIX); //-- SET CALIBRATION MATRIX
-  RegisterFunction("calibtool",     AROMA_CALIBTOOL);     //-- SHOW CALIBRATING TOOL
-  //-- SET THEME
-  RegisterFunction("theme",         AROMA_THEME);         //-- SET THEME
-  RegisterFunction("fontload",      AROMA_FONT);          //-- LOAD FONTS
-  RegisterFunction("fontresload",   AROMA_FONT);          //-- LOAD FONTS
-  //-- LANGUAGE FUNCTIONS
-  RegisterFunction("loadlang",      AROMA_LOADLANG);       //-- Load Language File
-  RegisterFunction("lang",          AROMA_LANG);           //-- Get Language Words
-  //-- VARIABLE FUNCTIONS
-  RegisterFunction("getvar",        AROMA_GETVAR);        //-- GET VARIABLE
-  RegisterFunction("setvar",        AROMA_SAVEVAR);       //-- SET VARIABLE
-  RegisterFunction("appendvar",     AROMA_SAVEVAR);       //-- APPEND STRING INTO VARIABLE
-  RegisterFunction("prependvar",    AROMA_SAVEVAR);       //-- PREPEND STRING INTO VARIABLE
-  //-- PROP FUNCTIONS
-  RegisterFunction("file_getprop",  AROMA_FILEGETPROP);   //-- GET PROP
-  RegisterFunction("prop",          AROMA_FILEGETPROP);   //-- GET PROP FROM AROMA TMP
-  RegisterFunction("zipprop",       AROMA_FILEGETPROP);   //-- GET PROP FROM ZIP
-  RegisterFunction("resprop",       AROMA_FILEGETPROP);   //-- GET PROP FROM AROMA RESOURCE ZIP
-  RegisterFunction("sysprop",       AROMA_RECOVERYPROP);  //-- GET RECOVERY PROP
-  RegisterFunction("property_get",  AROMA_RECOVERYPROP);  //-- GET RECOVERY PROP
-  //-- FILE FUNCTIONS
-  RegisterFunction("writetmpfile",  AROMA_WRITEFILE);     //-- WRITE STRING INTO TEMPORARY FILE
-  RegisterFunction("write",         AROMA_WRITEFILE);     //-- WRITE STRING INTO FILESYSTEM
-  RegisterFunction("readtmpfile",   AROMA_GETFILE);       //-- READ TEMPORARY FILE AS STRING
-  RegisterFunction("read",          AROMA_GETFILE);       //-- READ FILESYSTEM AS STRING
-  //-- ZIP HANDLING
-  RegisterFunction("ziptotmp",      AROMA_EXTRACT);       //-- EXTRACT ZIP CONTENT INTO TMP
-  RegisterFunction("restotmp",      AROMA_EXTRACT);       //-- EXTRACT RES CONTENT INTO TMP
-  //-- ZIP CONTENT FUNCTIONS
-  RegisterFunction("readfile",      AROMA_ZIPREAD);       //-- [Deprecated] - Renamed to zipread
-  RegisterFunction("readfile_aroma", AROMA_RESREAD);      //-- [Deprecated] - Renamed to resread
-  RegisterFunction("zipread",       AROMA_ZIPREAD);       //-- Read String From Zip
-  RegisterFunction("resread",       AROMA_RESREAD);       //-- Read Strinf From Resource
-  //-- EXEC
-  RegisterFunction("zipexec",       AROMA_EXEC);          //-- Exec Program From Zip
-  RegisterFunction("resexec",       AROMA_EXEC);          //-- Exec Program From Resource
-  RegisterFunction("run_program",   AROMA_EXEC);          //-- Run Program/Exec
-  RegisterFunction("exec",          AROMA_EXEC);          //-- Run Prohram/Exec
-  //-- MAIN UI FUNCTIONS (With Next & Back Buttons)
-  RegisterFunction("anisplash",     AROMA_ANISPLASH);     //-- SPLASH SCREEN
-  RegisterFunction("splash",        AROMA_SPLASH);        //-- SPLASH SCREEN
-  RegisterFunction("checkbox",      AROMA_CHECKBOX);      //-- CHECKBOX
-  RegisterFunction("form",          AROMA_CHECKOPT);      //-- CHECKBOX
-  RegisterFunction("selectbox",     AROMA_SELECTBOX);     //-- SELECTBOX
-  RegisterFunction("textbox",       AROMA_TEXTBOX);       //-- TEXTBOX
-  RegisterFunction("viewbox",       AROMA_VIEWBOX);       //-- VIEWBOX
-  RegisterFunction("checkviewbox",  AROMA_VIEWBOX);       //-- VIEWBOX
-  RegisterFunction("agreebox",      AROMA_TEXTBOX);       //-- AGREEBOX
-  RegisterFunction("menubox",       AROMA_MENUBOX);       //-- MENUBOX
-  //-- INSTALL UI
-  RegisterFunction("install",       AROMA_INSTALL);       //-- START INSTALLATION PROCCESS
-  //-- DIALOG UI FUNCTIONS
-  RegisterFunction("alert",         AROMA_ALERT);         //-- ALERT DIALOG
-  RegisterFunction("textdialog",    AROMA_TEXTDIALOG);    //-- TEXT DIALOG
-  RegisterFunction("confirm",       AROMA_CONFIRM);       //-- CONFIRM DIALOG
-  //-- DISK INFO FUNCTIONS
-  RegisterFunction("getdisksize",         AROMA_GETPART); //-- GET DISK SIZE
-  RegisterFunction("getdiskfree",         AROMA_GETPART); //-- GET DISK FREE
-  RegisterFunction("getdiskusedpercent",  AROMA_GETPART); //-- GET DISKUSAGE AS PERCENTAGE
-  //-- COMPARISON & MATH
-  RegisterFunction("cmp", AROMA_CMP);                     //-- COMPARE INTEGER
-  RegisterFunction("cal", AROMA_CAL);                     //-- CALCULATE INTEGER
-  RegisterFunction("iif", AROMA_IIF);                     //-- INLINE IF
-  //-- ETC
-  RegisterFunction("exit",          AROMA_EXIT);          //-- TERMINATE PROCCESS
-  RegisterFunction("pleasewait",    AROMA_PLEASEWAIT);    //-- SHOW WAIT SCREEN
-  RegisterFunction("reboot",        AROMA_REBOOT);        //-- REBOOT DEVICE
-  //-- SEQUENCES
-  RegisterFunction("back",          AROMA_BACK);          //-- BACK TO PREVIOUS WIZARD
-  RegisterFunction("goto",          AROMA_GOTO);          //-- Go To Section
-  RegisterFunction("gotolabel",     AROMA_GOLABEL);        //-- Get Current Position
-  //-- INCLUDE
-  RegisterFunction("include",        AROMA_INCLUDE);        //-- INCLUDE SCRIPT
-  RegisterFunction("eval",            AROMA_EVAL);        //-- EVAL SCRIPT
+#define AROMA_FUNCTION(name, fn) aroma_register(name, fn);
+#include "aroma_functions.h"
+#undef AROMA_FUNCTION
+  RegisterResolver("cmp", aroma_resolve_op);
+  RegisterResolver("cal", aroma_resolve_op);
 }
 
 /************************************[ START AND PARSE SCRIPT ]************************************/
 
 // AROMA PARSING & PROCCESSING SCRIPT
-byte aui_start() {
-  //-- LOAD CONFIG SCRIPT
-  AZMEM script_installer;
+static AZMEM  aui_script;
+static char * aui_script_data = NULL;
+static Expr * aui_script_root = NULL;
+static byte   aui_script_err  = 0;
+
+//-- Read & parse aroma-config, needs only the zip
+byte aui_prepare() {
+  //-- EDIFY REGISTRATION:
+  RegisterBuiltins();
+  RegisterAroma();
+  FinishRegistration();
+  //-- Precompiled by aroma_compile, no source text
+  aui_script_root = aui_loadbin(&aui_script, AROMA_CFG);
+  
+  if (aui_script_root != NULL) {
+    LOGS("aroma-config was precompiled");
+    return 1;
+  }
   
-  if (!az_readmem(&script_installer, AROMA_CFG, 0)) {
+  if (!az_map(&aui_script, AROMA_CFG, AZ_MAP_ONCE)) {
     return 0;
   }
   
-  char * script_data = script_installer.data;
+  char * script_data = aui_script.data;
   
-  if (script_installer.sz > 3) {
+  if (aui_script.sz > 3) {
     //-- Check UTF-8 File Header
     if ((script_data[0] == 0xEF) &&
         (script_data[1] == 0xBB) &&
@@ -3578,6 +3871,29 @@ byte aui_start() {
     }
   }
   
+  //-- PARSE CONFIG SCRIPT
+  int error_count = 0;
+  yy_scan_bytes(script_data, aui_script.sz - (script_data - aui_script.data));
+  int error = yyparse(&aui_script_root, &error_count);
+  aui_script_data = script_data;
+  
+  if (error != 0 || error_count > 0) {
+    aui_script_err = 1;
+  }
+  else {
+    ResolveExpr(aui_script_root, 1);
+  }
+  
+  return 1;
+}
+
+byte aui_start() {
+  if ((aui_script_data == NULL) && (aui_script_root == NULL)) {
+    return 0;
+  }
+  
+  char * script_data = aui_script_data;
+  Expr * root        = aui_script_root;
   //-- CLEANUP THEME:
   int i = 0;
   
@@ -3586,17 +3902,7 @@ byte aui_start() {
     acfg()->theme_9p[i] = 0;
   }
   
-  //-- EDIFY REGISTRATION:
-  RegisterBuiltins();
-  RegisterAroma();
-  FinishRegistration();
-  //-- PARSE CONFIG SCRIPT
-  Expr * root;
-  int error_count = 0;
-  yy_scan_string(script_data);
-  int error = yyparse(&root, &error_count);
-  
-  if (error != 0 || error_count > 0) {
+  if (aui_script_err) {
     vibrate(50);
     fprintf(apipe(), "ui_print\n");
     fprintf(apipe(), "ui_print SYNTAX ERROR!!! aroma-config on line %d col %d\n", yyErrLine(), yyErrCol());
@@ -3606,6 +3912,11 @@ byte aui_start() {
     return 0;
   }
   
+  //-- Pages of the script, for the look-ahead
+  AUIPAGES pages;
+  memset(&pages, 0, sizeof(AUIPAGES));
+  aui_pages_scan(&pages, root, 0);
+  aui_pages = &pages;
   //-- EVALUATE CONFIG SCRIPT
   State state;
   state.cookie = NULL;
@@ -3636,10 +3947,19 @@ byte aui_start() {
     aparse_current_position = 0;
     snprintf(aroma_theme_request, 64, "");
     aroma_theme_new_request = 1;
+    
+    //-- First pages, going back they are queued by the page shown
+    if (aparse_startpos == 0) {
+      aui_prefetch_from(&pages, 0);
+    }
+    
     result = Evaluate(&state, root);
   }
   while (aparse_isback);
   
+  aui_pages = NULL;
+  aui_pages_free(&pages);
+  aprefetch_release();
   aui_release_cached_icons();
   ag_ccanvas(&aui_win_bg);
   ag_ccanvas(&aui_bg);
@@ -3659,18 +3979,22 @@ byte aui_start() {
       vibrate(50);
     }
     
-    free(script_installer.data);
+    az_unmap(&aui_script);
     free(state.errmsg);
     alang_release();
     atheme_releaseall();
+    aprop_cache_release();
+    alib_automount_release();
     return res;
   }
   else {
-    free(script_installer.data);
+    az_unmap(&aui_script);
     free(result);
   }
   
   alang_release();
   atheme_releaseall();
+  aprop_cache_release();
+  alib_automount_release();
   return 1;
 }